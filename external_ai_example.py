@@ -1,54 +1,151 @@
+import selectors
 import socket
 import struct
 import random
 
 
+PROTOCOL_VERSION = 2
+
+
+def recv_exactly(clientsocket, size):
+    r = b""
+    while len(r) < size:
+        chunk = clientsocket.recv(size - len(r))
+        if not chunk:
+            raise ConnectionError("connection closed")
+        r += chunk
+    return r
+
+
+def legacy_session(clientsocket):
+    """One step at a time protocol of AiProcessorSetup/AiProcessorStep."""
+    num_state = 0
+    num_actions = 0
+    act = 0
+    long_size = struct.calcsize('!l')
+
+    while(True):
+        command = clientsocket.recv(1)
+        if not command:
+            break
+        print(command)
+        if command == b"I":
+            num_state = ord(clientsocket.recv(1))
+            num_actions = ord(clientsocket.recv(1))
+            state_unpack_fmt = "!" + "l" * num_state
+            print("setup", num_state, num_actions)
+        elif command == b"R":
+            r = recv_exactly(clientsocket, long_size)
+            reward = struct.unpack("!l", r)[0]
+            print("reward", reward)
+        elif command == b"S":
+            r = recv_exactly(clientsocket, long_size * num_state)
+            args = struct.unpack(state_unpack_fmt, r)
+            print("step", args)
+            # act = random.choice(range(num_actions))
+            act = act % num_actions
+            print("action", act)
+            clientsocket.sendall(bytearray([act]))
+            act += 1
+        elif command == b"E":
+            e = ord(clientsocket.recv(1))
+            print("end", e)
+
+
+class Instance:
+    """A game connected with the pipelined protocol (AiProcessorConnect)."""
+
+    def __init__(self, clientsocket, address):
+        self.sock = clientsocket
+        self.address = address
+        self.buffer = b""
+        self.instance = None
+        self.num_actions = 0
+        self.delay = 0
+        self.observations = []
+
+    def feed(self, data):
+        self.buffer += data
+        while len(self.buffer) >= 5:
+            kind, size = struct.unpack("!cI", self.buffer[:5])
+            if len(self.buffer) < 5 + size:
+                break
+            payload = self.buffer[5:5 + size]
+            self.buffer = self.buffer[5 + size:]
+            self.handle(kind, payload)
+
+    def send(self, kind, payload):
+        self.sock.sendall(struct.pack("!cI", kind, len(payload)) + payload)
+
+    def handle(self, kind, payload):
+        if kind == b"H":
+            version, self.instance, self.num_actions, self.delay, name_size = struct.unpack("!HIIIH", payload[:16])
+            name = payload[16:16 + name_size].decode()
+            print("instance", self.instance, name, "version", version, "actions", self.num_actions, "delay", self.delay)
+            self.send(b"H", struct.pack("!H", PROTOCOL_VERSION))
+        elif kind == b"O":
+            step, cycle, reward, n = struct.unpack("!IIiI", payload[:16])
+            pos = 16
+            state = struct.unpack("!" + "i" * n, payload[pos:pos + 4 * n])
+            pos += 4 * n
+            planes = {}
+            for _ in range(payload[pos]):
+                plane, cell_size, width, height = struct.unpack("!BBHH", payload[pos + 1:pos + 7])
+                pos += 6
+                planes[plane] = (width, height, payload[pos + 1:pos + 1 + cell_size * width * height])
+                pos += cell_size * width * height
+            pos += 1
+            (unit_count,) = struct.unpack("!I", payload[pos:pos + 4])
+            units = [struct.unpack("!IBHHHiB", payload[pos + 4 + 16 * i:pos + 4 + 16 * (i + 1)]) for i in range(unit_count)]
+            self.observations.append((step, cycle, reward, state, planes, units))
+        elif kind == b"E":
+            step, reward = struct.unpack("!Ii", payload)
+            print("instance", self.instance, "end at step", step, "reward", reward)
+
+
+def policy(batch):
+    """Choose the actions of all the observations received together."""
+    return [[random.randrange(max(instance.num_actions, 1))] for instance, _ in batch]
+
+
 if __name__ == "__main__":
-    # Listen for incoming datagrams
     localIP = "127.0.0.1"
     localPort = 9292
-    buffersize = 1024
     sock = socket.socket(family=socket.AF_INET)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
     sock.bind((localIP, localPort))
-    sock.listen(5)
+    sock.listen(64)
+    selector = selectors.DefaultSelector()
+    selector.register(sock, selectors.EVENT_READ)
+    print("TCP server up and listening on", localIP, localPort)
 
     while True:
-        print("TCP server up and listening on", localIP, localPort)
-        (clientsocket, address) = sock.accept()
-        print("connection", address)
-        num_state = 0
-        num_actions = 0
-        act = 0
-        long_size = struct.calcsize('!l')
-
-        while(True):
-            command = clientsocket.recv(1)
-            if not command:
-                break
-            print(command)
-            if command == b"I":
-                num_state = ord(clientsocket.recv(1))
-                num_actions = ord(clientsocket.recv(1))
-                state_unpack_fmt = "!" + "l" * num_state
-                print("setup", num_state, num_actions)
-            elif command == b"R":
-                r = b""
-                while len(r) < long_size:
-                    r += clientsocket.recv(long_size - len(r))
-                reward = struct.unpack("!l", r)[0]
-                print("reward", reward)
-            elif command == b"S":
-                r = b""
-                expected = long_size * num_state
-                while len(r) < expected:
-                    r += clientsocket.recv(expected - len(r))
-                args = struct.unpack(state_unpack_fmt, r)
-                print("step", args)
-                # act = random.choice(range(num_actions))
-                act = act % num_actions
-                print("action", act)
-                clientsocket.sendall(bytearray([act]))
-                act += 1
-            elif command == b"E":
-                e = ord(clientsocket.recv(1))
-                print("end", e)
+        for key, _ in selector.select():
+            if key.fileobj is sock:
+                (clientsocket, address) = sock.accept()
+                print("connection", address)
+                if clientsocket.recv(1, socket.MSG_PEEK) == b"I":
+                    legacy_session(clientsocket)
+                    clientsocket.close()
+                else:
+                    selector.register(clientsocket, selectors.EVENT_READ, Instance(clientsocket, address))
+                continue
+            instance = key.data
+            data = instance.sock.recv(1 << 16)
+            if not data:
+                print("instance", instance.instance, "disconnected")
+                selector.unregister(instance.sock)
+                instance.sock.close()
+                continue
+            instance.feed(data)
+
+        # Answer every pending observation of every game in one batch
+        batch = [(key.data, observation)
+                 for key in selector.get_map().values() if key.data
+                 for observation in key.data.observations]
+        if batch:
+            for (instance, observation), actions in zip(batch, policy(batch)):
+                payload = struct.pack("!IH", observation[0], len(actions)) + struct.pack("!" + "i" * len(actions), *actions)
+                instance.send(b"A", payload)
+            for instance, _ in batch:
+                instance.observations.clear()
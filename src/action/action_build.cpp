@@ -49,6 +49,7 @@
 #include "translate.h"
 #include "ui.h"
 #include "unit.h"
+#include "unit_area_count.h"
 #include "unittype.h"
 #include "video.h"
 
@@ -293,6 +294,7 @@ bool COrder_Build::StartBuilding(CUnit &unit, CUnit &ontop)
 	}
 	build->Constructed = 1;
 	build->CurrentSightRange = 0;
+	UnitAreaCount.Update(*build);
 
 	// Building on top of something, may remove what is beneath it
 	if (&ontop != &unit) {
@@ -334,7 +336,7 @@ bool COrder_Build::StartBuilding(CUnit &unit, CUnit &ontop)
 	build->Place(this->goalPos);
 
 	// HACK: the building is not ready yet
-	build->Player->UnitTypesCount[type.Slot]--;
+	build->Player->ChangeUnitTypeCount(type, -1);
 	if (build->Active) {
 		build->Player->UnitTypesAiActiveCount[type.Slot]--;
 	}
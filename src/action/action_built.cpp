@@ -44,6 +44,7 @@
 #include "sound.h"
 #include "translate.h"
 #include "unit.h"
+#include "unit_area_count.h"
 #include "unittype.h"
 
 /// How many resources the player gets back if canceling building
@@ -150,11 +151,12 @@ static void Finish(COrder_Built &order, CUnit &unit)
 	DebugPrint("%d: Building %s(%s) ready.\n", player.Index, type.Ident.c_str(), type.Name.c_str());
 
 	// HACK: the building is ready now
-	player.UnitTypesCount[type.Slot]++;
+	player.ChangeUnitTypeCount(type, 1);
 	if (unit.Active) {
 		player.UnitTypesAiActiveCount[type.Slot]++;
 	}
 	unit.Constructed = 0;
+	UnitAreaCount.Update(unit);
 	if (unit.Frame < 0) {
 		unit.Frame = -1;
 	} else {
@@ -124,7 +124,7 @@ void COrder_Die::Execute(CUnit &unit) /* override */
 	// Always do that, since types can have different vision properties.
 
 	unit.Remove(nullptr);
-	unit.Type = &corpseType;
+	unit.SetType(corpseType);
 	unit.Stats = const_cast<CUnitStats *>(&corpseType.Stats[unit.Player->Index]);
 	UpdateUnitSightRange(unit);
 	unit.Place(unit.tilePos);
@@ -245,7 +245,7 @@ int DoActionMove(CUnit &unit)
 		UnitHeadingFromDeltaXY(unit, posd);
 	} else {
 		const auto direction =
-			unit.pathFinderData->output.Path[unit.pathFinderData->output.Length - 1];
+			unit.pathFinderData->output.GetPath()[unit.pathFinderData->output.Length - 1];
 		posd.x = Heading2X[direction];
 		posd.y = Heading2Y[direction];
 		d = unit.pathFinderData->output.Length;
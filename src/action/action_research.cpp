@@ -144,6 +144,10 @@ void COrder_Research::Execute(CUnit &unit) /* override */
 		this->Finished = true;
 		return;
 	}
+	if (player.UpgradeTimers.Upgrades[upgrade.ID] == 0) {
+		// the research starts
+		player.AvailabilityChanged();
+	}
 	player.UpgradeTimers.Upgrades[upgrade.ID] += std::max(1, player.SpeedResearch / SPEEDUP_FACTOR);
 	if (player.UpgradeTimers.Upgrades[upgrade.ID] >= upgrade.Costs[TimeCost]) {
 		if (upgrade.Name.empty()) {
@@ -173,6 +177,7 @@ void COrder_Research::Cancel(CUnit &unit) /* override */
 {
 	const CUpgrade &upgrade = this->GetUpgrade();
 	unit.Player->UpgradeTimers.Upgrades[upgrade.ID] = 0;
+	unit.Player->AvailabilityChanged();
 
 	unit.Player->AddCostsFactor(upgrade.Costs, CancelResearchCostsFactor);
 }
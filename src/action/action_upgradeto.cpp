@@ -117,8 +117,8 @@ static int TransformUnitIntoType(CUnit &unit, const CUnitType &newtype)
 		}
 	}
 	CPlayer &player = *unit.Player;
-	player.UnitTypesCount[oldtype.Slot]--;
-	player.UnitTypesCount[newtype.Slot]++;
+	player.ChangeUnitTypeCount(oldtype, -1);
+	player.ChangeUnitTypeCount(newtype, 1);
 	if (unit.Active) {
 		player.UnitTypesAiActiveCount[oldtype.Slot]--;
 		player.UnitTypesAiActiveCount[newtype.Slot]++;
@@ -155,7 +155,7 @@ static int TransformUnitIntoType(CUnit &unit, const CUnitType &newtype)
 		}
 	}
 
-	unit.Type = const_cast<CUnitType *>(&newtype);
+	unit.SetType(newtype);
 	unit.Stats = const_cast<CUnitStats *>(&unit.Type->Stats[player.Index]);
 
 	if (!newtype.CanCastSpell.empty() && unit.AutoCastSpell.empty()) {
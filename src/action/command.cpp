@@ -42,6 +42,7 @@
 #include "action/action_train.h"
 #include "action/action_upgradeto.h"
 #include "commands.h"
+#include "influence_map.h"
 #include "map.h"
 #include "pathfinder.h"
 #include "player.h"
@@ -946,6 +947,7 @@ void CommandSharedVision(int playerIndex, bool state, int opponentIndex)
 				}
 			}
 		}
+		InfluenceMap.InvalidateExplored();
 	} else {
 		player->ShareVisionWith(*opponent);
 	}
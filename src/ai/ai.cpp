@@ -392,6 +392,23 @@ static void SaveAiPlayer(CFile &file, int plynr, const PlayerAi &ai)
 	}
 	file.printf("},\n");
 
+	//  Plans computed ahead, the planner thread is waited for
+	if (!ai.PendingPlans.empty()) {
+		file.printf("  \"pending-plans\", {");
+		for (const AiPendingPlan &plan : ai.PendingPlans) {
+			file.printf("{%lu, ", plan.Cycle);
+			for (const AiPlanCommand &command : plan.Result.get()) {
+				switch (command.Action) {
+					case AiPlanCommand::EAction::Explore:
+						file.printf("\"explore\", %d, %d, %d, ", command.UnitSlot, command.Pos.x, command.Pos.y);
+						break;
+				}
+			}
+			file.printf("}, ");
+		}
+		file.printf("},\n");
+	}
+
 	file.printf("  \"repair-building\", %u\n", ai.LastRepairBuilding);
 
 	file.printf(")\n\n");
@@ -493,6 +510,7 @@ void CleanAi()
 void FreeAi()
 {
 	CleanAi();
+	AiStopPlanner();
 
 	//  Free AiTypes.
 	AiTypes.clear();
@@ -1008,6 +1026,9 @@ void AiResearchComplete(CUnit &unit, const CUpgrade *what)
 void AiEachCycle(CPlayer &player)
 {
 	AiPlayer = player.Ai.get();
+	if (AiPlayer) {
+		AiApplyPlans();
+	}
 }
 
 /**
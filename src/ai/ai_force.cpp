@@ -42,6 +42,7 @@
 #include "action/action_board.h"
 #include "commands.h"
 #include "depend.h"
+#include "influence_map.h"
 #include "map.h"
 #include "pathfinder.h"
 #include "tileset.h"
@@ -68,12 +69,16 @@ class EnemyUnitFinder
 
 	static CUnit *find(const CUnit &unit, EAttackFindType find_type)
 	{
+		EnemyUnitFinder enemyUnitFinder(unit, find_type);
+		const Vec2i mapMax(Map.Info.MapWidth - 1, Map.Info.MapHeight - 1);
+		if (!InfluenceMap.HasUnits(enemyUnitFinder.enemies, Vec2i(0, 0), mapMax)) {
+			return nullptr;
+		}
 		// Terrain traversal by Andrettin
 		TerrainTraversal terrainTraversal;
 		terrainTraversal.SetSize(Map.Info.MapWidth, Map.Info.MapHeight);
 		terrainTraversal.Init();
 		terrainTraversal.PushUnitPosAndNeighboor(unit);
-		EnemyUnitFinder enemyUnitFinder(unit, find_type);
 		terrainTraversal.Run(enemyUnitFinder);
 		return enemyUnitFinder.result_unit;
 	}
@@ -83,7 +88,8 @@ class EnemyUnitFinder
 		unit(unit),
 		movemask(unit.Type->MovementMask & ~(MapFieldLandUnit | MapFieldAirUnit | MapFieldSeaUnit)),
 		attackrange(unit.Stats->Variables[ATTACKRANGE_INDEX].Max),
-		find_type(find_type)
+		find_type(find_type),
+		enemies(AiEnemyPlayersMask(*unit.Player))
 	{
 	}
 	VisitResult Visit(TerrainTraversal &terrainTraversal, const Vec2i &pos, const Vec2i &from);
@@ -92,6 +98,7 @@ class EnemyUnitFinder
 	unsigned int movemask;
 	const int attackrange;
 	const EAttackFindType find_type;
+	const unsigned int enemies; /// Owners of the units to look for
 	CUnit *result_unit = nullptr;
 };
 
@@ -103,6 +110,9 @@ VisitResult EnemyUnitFinder::Visit(TerrainTraversal &terrainTraversal, const Vec
 
 	Vec2i minpos = pos - Vec2i(attackrange, attackrange);
 	Vec2i maxpos = pos + Vec2i(unit.Type->TileWidth - 1 + attackrange, unit.Type->TileHeight - 1 + attackrange);
+	if (!InfluenceMap.HasUnits(enemies, minpos, maxpos)) {
+		return VisitResult::Ok;
+	}
 	std::vector<CUnit *> table = Select(minpos, maxpos, HasNotSamePlayerAs(Players[PlayerNumNeutral]));
 	for (CUnit *dest : table) {
 		const CUnitType &dtype = *dest->Type;
@@ -256,7 +266,7 @@ std::vector<int> AiFindAvailableUnitTypeEquiv(const CUnitType &unittype)
 	auto usableTypes = AiFindUnitTypeEquiv(unittype);
 	// 2 - Remove unavailable unittypes
 	ranges::erase_if(usableTypes, [&](int typeIndex) {
-		return !CheckDependByIdent(*AiPlayer->Player, getUnitTypes()[typeIndex]->Ident);
+		return !CheckDependByType(*AiPlayer->Player, *getUnitTypes()[typeIndex]);
 	});
 	// 3 - Sort by level
 	ranges::sort(usableTypes, std::greater<>(), [](int index) {
@@ -37,6 +37,9 @@
 ----------------------------------------------------------------------------*/
 
 #include <array>
+#include <deque>
+#include <functional>
+#include <future>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -273,6 +276,34 @@ class AiExplorationRequest
 	int Mask;           /// mask ( ex: MapFieldLandUnit )
 };
 
+/**
+**  Decision taken by a plan computed on the planner thread.
+**
+**  Units are designated by their slot: a released slot is not reused
+**  before many more cycles than the plan delay.
+*/
+struct AiPlanCommand
+{
+	enum class EAction {
+		Explore /// Move the unit to the position to explore it
+	};
+
+	EAction Action = EAction::Explore;
+	int UnitSlot = -1; /// Slot of the unit which receives the order
+	Vec2i Pos{-1, -1}; /// Target position of the order
+};
+
+using AiPlan = std::vector<AiPlanCommand>;
+
+/**
+**  Plan submitted to the planner, waiting to be applied.
+*/
+struct AiPendingPlan
+{
+	unsigned long Cycle = 0;          /// Game cycle the plan is applied at
+	std::shared_future<AiPlan> Result; /// Commands computed by the planner thread
+};
+
 /**
 **  AI variables.
 */
@@ -308,6 +339,7 @@ class PlayerAi
 	std::vector<CUpgrade *> ResearchRequests;     /// Upgrades requested and priority list
 	std::vector<AiBuildQueue> UnitTypeBuilt;      /// What the resource manager should build
 	int LastRepairBuilding = 0;                   /// Last building checked for repair in this turn
+	std::deque<AiPendingPlan> PendingPlans;       /// Plans computed ahead, in the order of their cycle
 };
 
 /**
@@ -451,6 +483,12 @@ extern bool AiFindWall(AiForce &force);
 /// Plan the an attack
 /// Send explorers around the map
 extern void AiSendExplorers();
+/// Mask of the owners of the units which are enemies of player
+extern unsigned int AiHostilePlayersMask(const CPlayer &player);
+/// Mask of the players player is enemy of
+extern unsigned int AiEnemyPlayersMask(const CPlayer &player);
+/// Check if the enemies around a location are stronger than the player and its allies
+extern bool AiIsThreatened(const CPlayer &player, const Vec2i &pos, unsigned range);
 /// Check if there are enemy units in a given range (optionally of type)
 extern bool AiEnemyUnitsInDistance(const CPlayer &player, const CUnitType *type,
 								  const Vec2i &pos, unsigned range);
@@ -461,6 +499,24 @@ extern bool AiEnemyUnitsInDistance(const CPlayer &player, const CUnitType *type,
 /// Check for magic
 extern void AiCheckMagic();
 
+//
+// Planner
+//
+/// Number of game cycles between the submission of a plan and its application
+constexpr unsigned long AiPlanDelay = CYCLES_PER_SECOND / 2;
+/// Compute a plan on the planner thread, it is applied AiPlanDelay cycles later
+extern void AiSubmitPlan(std::function<AiPlan()> job);
+/// Apply the plans of the current AI which are due
+extern void AiApplyPlans();
+/// Stop the planner thread
+extern void AiStopPlanner();
+
+//
+// External processors
+//
+/// Register ccl features of the pipelined external AI processors
+extern void AiProcessorCclRegister();
+
 //@}
 
 #endif // !__AI_LOCAL_H__
@@ -39,6 +39,7 @@
 
 #include "actions.h"
 #include "commands.h"
+#include "influence_map.h"
 #include "map.h"
 #include "missile.h"
 #include "pathfinder.h"
@@ -248,7 +249,8 @@ class EnemyFinderWithTransporter
 	EnemyFinderWithTransporter(const CUnit &unit, const TerrainTraversal &terrainTransporter) :
 		unit(unit),
 		terrainTransporter(terrainTransporter),
-		movemask(unit.Type->MovementMask & ~(MapFieldLandUnit | MapFieldAirUnit | MapFieldSeaUnit))
+		movemask(unit.Type->MovementMask & ~(MapFieldLandUnit | MapFieldAirUnit | MapFieldSeaUnit)),
+		enemies(AiEnemyPlayersMask(*unit.Player))
 	{}
 	VisitResult Visit(TerrainTraversal &terrainTraversal, const Vec2i &pos, const Vec2i &from);
 private:
@@ -258,6 +260,7 @@ class EnemyFinderWithTransporter
 	const CUnit &unit;
 	const TerrainTraversal &terrainTransporter;
 	unsigned int movemask;
+	unsigned int enemies; /// Owners of the units to look for
 	Vec2i resultPos{-1, -1};
 };
 
@@ -268,7 +271,8 @@ VisitResult EnemyFinderWithTransporter::Visit(TerrainTraversal &terrainTraversal
 		return VisitResult::DeadEnd;
 	}
 #endif
-	if (EnemyOnMapTile(unit, pos) && CanMoveToMask(from, movemask)) {
+	if (InfluenceMap.HasUnits(enemies, pos, pos)
+	    && EnemyOnMapTile(unit, pos) && CanMoveToMask(from, movemask)) {
 		DebugPrint("Target found %d,%d\n", pos.x, pos.y);
 		resultPos = pos;
 		return VisitResult::Finished;
@@ -402,17 +406,41 @@ bool AiForce::PlanAttack()
 	return false;
 }
 
-static std::optional<Vec2i> ChooseRandomUnexploredPositionNear(const Vec2i &center)
+/// Number of positions tried by SearchUnexploredPositionNear
+static constexpr int UnexploredSearchTryCount = 8;
+
+/**
+**  Largest distance from the center of the positions tried by
+**  SearchUnexploredPositionNear.
+*/
+static constexpr int UnexploredSearchMaxRay()
+{
+	int maxRay = 3;
+	for (int i = 1; i != UnexploredSearchTryCount; ++i) {
+		maxRay = 3 * maxRay / 2;
+	}
+	return maxRay;
+}
+
+/**
+**  Try random positions around a center, farther at each try.
+**
+**  @param center      Center of the search.
+**  @param random      Give the next random number, called twice per try.
+**  @param unexplored  Tell if a position is on the map and unexplored.
+**
+**  @return  The first unexplored position tried, if any.
+*/
+template <typename Random, typename Unexplored>
+static std::optional<Vec2i> SearchUnexploredPositionNear(const Vec2i &center, Random &&random, Unexplored &&unexplored)
 {
 	int ray = 3;
-	const int maxTryCount = 8;
-	for (int i = 0; i != maxTryCount; ++i) {
+	for (int i = 0; i != UnexploredSearchTryCount; ++i) {
 		Vec2i pos;
-		pos.x = center.x + SyncRand() % (2 * ray + 1) - ray;
-		pos.y = center.y + SyncRand() % (2 * ray + 1) - ray;
+		pos.x = center.x + random() % (2 * ray + 1) - ray;
+		pos.y = center.y + random() % (2 * ray + 1) - ray;
 
-		if (Map.Info.IsPointOnMap(pos)
-			&& Map.Field(pos)->playerInfo.IsExplored(*AiPlayer->Player) == false) {
+		if (unexplored(pos)) {
 			return pos;
 		}
 		ray = 3 * ray / 2;
@@ -420,6 +448,21 @@ static std::optional<Vec2i> ChooseRandomUnexploredPositionNear(const Vec2i &cent
 	return std::nullopt;
 }
 
+static std::optional<Vec2i> ChooseRandomUnexploredPositionNear(const Vec2i &center)
+{
+	const Vec2i maxOffset(UnexploredSearchMaxRay(), UnexploredSearchMaxRay());
+	if (InfluenceMap.IsExplored(*AiPlayer->Player, center - maxOffset, center + maxOffset)) {
+		return std::nullopt;
+	}
+	return SearchUnexploredPositionNear(
+		center,
+		[]() { return SyncRand(); },
+		[](const Vec2i &pos) {
+			return Map.Info.IsPointOnMap(pos)
+			    && Map.Field(pos)->playerInfo.IsExplored(*AiPlayer->Player) == false;
+		});
+}
+
 static std::pair<CUnit *, Vec2i> GetBestExplorer(const AiExplorationRequest &request)
 {
 	// Choose a target, "near"
@@ -470,6 +513,147 @@ static std::pair<CUnit *, Vec2i> GetBestExplorer(const AiExplorationRequest &req
 	return {bestunit, *pos};
 }
 
+namespace
+{
+/**
+**  What the exploration plan reads of the game.
+*/
+struct ExplorationSnapshot
+{
+	struct Explorer
+	{
+		int Slot;
+		Vec2i Pos;
+		EMovement MoveType;
+	};
+	struct Try
+	{
+		int Mask;                   /// Mask of the request chosen
+		Vec2i Center;               /// Position of the request chosen
+		Vec2i AreaMin;              /// Top left of the area searched, clipped to the map
+		Vec2i AreaMax;              /// Bottom right of the area searched, clipped to the map
+		std::vector<bool> Explored; /// Explored tiles of the area row by row, empty if all are explored
+		std::vector<int> Random;    /// Random numbers used by the search
+	};
+	std::vector<Explorer> Explorers; /// Idle units able to move, in the player unit order
+	std::vector<Try> Tries;
+};
+} // namespace
+
+/**
+**  Same choice as GetBestExplorer, from the snapshot.
+*/
+static const ExplorationSnapshot::Explorer *
+GetBestExplorer(const ExplorationSnapshot &snapshot, int mask, const Vec2i &pos)
+{
+	const ExplorationSnapshot::Explorer *best = nullptr;
+	bool flyeronly = false;
+	int bestSquareDistance = -1;
+	for (const auto &explorer : snapshot.Explorers) {
+		if (explorer.MoveType != EMovement::Fly) {
+			if (flyeronly) {
+				continue;
+			}
+			if ((mask & MapFieldLandUnit) && explorer.MoveType != EMovement::Land) {
+				continue;
+			}
+			if ((mask & MapFieldSeaUnit) && explorer.MoveType != EMovement::Naval) {
+				continue;
+			}
+		} else {
+			flyeronly = true;
+		}
+
+		const int sqDistance = SquareDistance(explorer.Pos, pos);
+		if (bestSquareDistance == -1 || sqDistance <= bestSquareDistance
+		    || (best->MoveType != EMovement::Fly && explorer.MoveType == EMovement::Fly)) {
+			bestSquareDistance = sqDistance;
+			best = &explorer;
+		}
+	}
+	return best;
+}
+
+/**
+**  Same search as ChooseRandomUnexploredPositionNear, from the snapshot.
+*/
+static std::optional<Vec2i> ChooseRandomUnexploredPositionNear(const ExplorationSnapshot::Try &attempt)
+{
+	if (attempt.Explored.empty()) {
+		return std::nullopt;
+	}
+	const int areaWidth = attempt.AreaMax.x - attempt.AreaMin.x + 1;
+	size_t nextRandom = 0;
+	return SearchUnexploredPositionNear(
+		attempt.Center,
+		[&]() { return attempt.Random[nextRandom++]; },
+		[&](const Vec2i &pos) {
+			return attempt.AreaMin.x <= pos.x && pos.x <= attempt.AreaMax.x
+			    && attempt.AreaMin.y <= pos.y && pos.y <= attempt.AreaMax.y
+			    && !attempt.Explored[(pos.x - attempt.AreaMin.x) + (pos.y - attempt.AreaMin.y) * areaWidth];
+		});
+}
+
+/**
+**  Exploration plan, run on the planner thread.
+*/
+static AiPlan PlanExplorers(const ExplorationSnapshot &snapshot)
+{
+	for (const auto &attempt : snapshot.Tries) {
+		const auto pos = ChooseRandomUnexploredPositionNear(attempt);
+		if (!pos) {
+			continue;
+		}
+		if (const auto *explorer = GetBestExplorer(snapshot, attempt.Mask, *pos)) {
+			return {{AiPlanCommand::EAction::Explore, explorer->Slot, *pos}};
+		}
+	}
+	return {};
+}
+
+/**
+**  Copy what the exploration plan needs and submit it to the planner.
+**
+**  The explored state of the area around each request chosen is copied,
+**  unless the influence map already tells it is all explored. The random
+**  numbers of the searches are all drawn here, as many whatever the search
+**  finds, so the plan doesn't touch the synchronized random generator.
+*/
+static void AiSubmitExplorers(int maxTryCount)
+{
+	ExplorationSnapshot snapshot;
+
+	for (const CUnit *unit : AiPlayer->Player->GetUnits()) {
+		if (unit->IsIdle() && Map.Info.IsPointOnMap(unit->tilePos) && unit->CanMove()) {
+			snapshot.Explorers.push_back({UnitNumber(*unit), unit->tilePos, unit->Type->MoveType});
+		}
+	}
+	const int requestcount = AiPlayer->FirstExplorationRequest.size();
+	for (int i = 0; i != maxTryCount; ++i) {
+		const AiExplorationRequest &request = AiPlayer->FirstExplorationRequest[SyncRand() % requestcount];
+
+		ExplorationSnapshot::Try &attempt = snapshot.Tries.emplace_back();
+		attempt.Mask = request.Mask;
+		attempt.Center = request.pos;
+
+		const Vec2i maxOffset(UnexploredSearchMaxRay(), UnexploredSearchMaxRay());
+		if (InfluenceMap.IsExplored(*AiPlayer->Player, request.pos - maxOffset, request.pos + maxOffset)) {
+			continue;
+		}
+		attempt.AreaMin = request.pos - maxOffset;
+		attempt.AreaMax = request.pos + maxOffset;
+		Map.FixSelectionArea(attempt.AreaMin, attempt.AreaMax);
+		for (int y = attempt.AreaMin.y; y <= attempt.AreaMax.y; ++y) {
+			for (int x = attempt.AreaMin.x; x <= attempt.AreaMax.x; ++x) {
+				attempt.Explored.push_back(Map.Field(Vec2i(x, y))->playerInfo.IsExplored(*AiPlayer->Player));
+			}
+		}
+		for (int j = 0; j != 2 * UnexploredSearchTryCount; ++j) {
+			attempt.Random.push_back(SyncRand());
+		}
+	}
+	AiSubmitPlan([snapshot = std::move(snapshot)]() { return PlanExplorers(snapshot); });
+}
 
 /**
 **  Respond to ExplorationRequests
@@ -484,6 +668,11 @@ void AiSendExplorers()
 		return;
 	}
 	const int maxTryCount = 5;
+	if (GameSettings.AiPlansAhead) {
+		AiSubmitExplorers(maxTryCount);
+		AiPlayer->FirstExplorationRequest.clear();
+		return;
+	}
 	for (int i = 0; i != maxTryCount; ++i) {
 		// Choose a request
 		const int requestid = SyncRand() % requestcount;
@@ -0,0 +1,220 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name ai_planner.cpp - The AI planner thread. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+/*
+**  When GameSettings.AiPlansAhead is set, the AI copies what a plan
+**  reads into a snapshot and computes the plan on the planner thread.
+**  The commands of the plan are applied AiPlanDelay cycles after the
+**  submission, the same way network commands are delayed by the
+**  network lag: if the planner is late the game waits for it, so the
+**  commands are always applied at the same cycle and the game stays
+**  in sync whatever the speed of the computer.
+**
+**  A plan job must only read its snapshot, never the game state, and
+**  draw its random numbers (SyncRand) before the submission.
+**  Plans still pending are saved with the game once computed, and
+**  loaded back as computed plans applied at the same cycle.
+**
+**  Only the exploration is planned here: the explored state around the
+**  requests is copied, then the unexplored positions are searched and
+**  the explorers chosen on the planner thread. The resource, force and
+**  magic managers stay on the game thread, they change the AI, force and
+**  unit state and call Lua while deciding.
+*/
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "stratagus.h"
+
+#include "ai_local.h"
+
+#include "commands.h"
+#include "player.h"
+#include "unit.h"
+#include "unit_manager.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/*----------------------------------------------------------------------------
+--  Declarations
+----------------------------------------------------------------------------*/
+
+namespace
+{
+
+/**
+**  Thread computing the submitted plans in order.
+*/
+class CAiPlanner
+{
+public:
+	~CAiPlanner() { Stop(); }
+
+	std::future<AiPlan> Submit(std::function<AiPlan()> job);
+	void Stop();
+
+private:
+	void Run();
+
+	std::mutex Mutex;
+	std::condition_variable Wake;
+	std::deque<std::packaged_task<AiPlan()>> Jobs; /// Plans not computed yet
+	std::thread Worker;
+	bool Stopping = false;
+};
+
+} // namespace
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+static CAiPlanner Planner;
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+/**
+**  Queue a plan job, start the thread the first time.
+*/
+std::future<AiPlan> CAiPlanner::Submit(std::function<AiPlan()> job)
+{
+	std::packaged_task<AiPlan()> task(std::move(job));
+	std::future<AiPlan> result = task.get_future();
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		if (!Worker.joinable()) {
+			Stopping = false;
+			Worker = std::thread([this]() { Run(); });
+		}
+		Jobs.push_back(std::move(task));
+	}
+	Wake.notify_one();
+	return result;
+}
+
+/**
+**  Compute the queued plans until stopped.
+*/
+void CAiPlanner::Run()
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+	while (true) {
+		Wake.wait(lock, [this]() { return Stopping || !Jobs.empty(); });
+		if (Jobs.empty()) {
+			return;
+		}
+		std::packaged_task<AiPlan()> task = std::move(Jobs.front());
+		Jobs.pop_front();
+		lock.unlock();
+		task();
+		lock.lock();
+	}
+}
+
+/**
+**  Finish the queued plans and stop the thread.
+*/
+void CAiPlanner::Stop()
+{
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		if (!Worker.joinable()) {
+			return;
+		}
+		Stopping = true;
+	}
+	Wake.notify_one();
+	Worker.join();
+}
+
+/**
+**  Compute a plan of the current AI on the planner thread.
+**
+**  @param job  Function computing the plan from the snapshot it owns.
+*/
+void AiSubmitPlan(std::function<AiPlan()> job)
+{
+	AiPlayer->PendingPlans.push_back({GameCycle + AiPlanDelay, Planner.Submit(std::move(job)).share()});
+}
+
+/**
+**  Apply a command of the current AI if it still makes sense.
+*/
+static void AiApplyCommand(const AiPlanCommand &command)
+{
+	if (command.UnitSlot < 0 || command.UnitSlot >= static_cast<int>(UnitManager->GetUsedSlotCount())) {
+		return;
+	}
+	CUnit &unit = UnitManager->GetSlotUnit(command.UnitSlot);
+
+	if (unit.Destroyed || unit.Player != AiPlayer->Player || !unit.IsAliveOnMap()) {
+		return;
+	}
+	switch (command.Action) {
+		case AiPlanCommand::EAction::Explore:
+			if (unit.IsIdle() && unit.CanMove()) {
+				CommandMove(unit, command.Pos, EFlushMode::On);
+				AiPlayer->LastExplorationGameCycle = GameCycle;
+			}
+			break;
+	}
+}
+
+/**
+**  Apply the plans of the current AI which are due, wait for the
+**  planner thread when it has not computed them yet.
+*/
+void AiApplyPlans()
+{
+	auto &plans = AiPlayer->PendingPlans;
+
+	while (!plans.empty() && plans.front().Cycle <= GameCycle) {
+		const AiPlan plan = plans.front().Result.get();
+		plans.pop_front();
+		for (const AiPlanCommand &command : plan) {
+			AiApplyCommand(command);
+		}
+	}
+}
+
+/**
+**  Stop the planner thread, the plans still queued are computed first.
+*/
+void AiStopPlanner()
+{
+	Planner.Stop();
+}
+
+//@}
@@ -0,0 +1,613 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name ai_processor.cpp - The pipelined external AI processor protocol. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+/*
+**  Protocol version 2, all numbers are big endian.
+**
+**  Every message is a frame: u8 type, u32 payload size, payload.
+**
+**  Game to agent:
+**    'H' hello:       u16 version, u32 instance, u32 number of actions,
+**                     u32 delay in cycles, u16 name size, name
+**    'O' observation: u32 step, u32 cycle, i32 reward,
+**                     u32 n, i32 state[n],
+**                     u8 plane count, per plane: u8 plane id, u8 bytes per tile,
+**                     u16 width, u16 height, tiles (row major),
+**                     u32 unit count, per unit: u32 slot, u8 player,
+**                     u16 type, u16 x, u16 y, i32 hp, u8 action
+**                     (only the units on the map and alive)
+**    'E' end:         u32 step, i32 reward
+**
+**  Agent to game:
+**    'H' hello:       u16 version accepted
+**    'A' actions:     u32 step, u16 n, i32 action[n]
+**
+**  The game doesn't wait for the actions of an observation: they are
+**  handed out Delay cycles after the observation was sent, which keeps
+**  the game deterministic whatever the agent latency. Only when they
+**  are not there at that cycle the game blocks until they come, or
+**  until the connection is closed.
+**  A frame larger than AiMaxPayload, or too short for its type, is a
+**  protocol error and closes the connection.
+**  Each game instance opens its own connection, an agent can serve
+**  many instances and batch their observations.
+*/
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "stratagus.h"
+
+#include "ai_local.h"
+
+#include "map.h"
+#include "network.h"
+#include "network/netsockets.h"
+#include "player.h"
+#include "script.h"
+#include "unit.h"
+#include "unit_manager.h"
+#include "unittype.h"
+
+#include <chrono>
+#include <deque>
+#include <map>
+
+/*----------------------------------------------------------------------------
+--  Declarations
+----------------------------------------------------------------------------*/
+
+static constexpr uint16_t AiProcessorVersion = 2;
+/// Largest payload accepted from the agent: an 'A' frame of 64K actions
+static constexpr size_t AiMaxPayload = 6 + 4 * 0xFFFF;
+
+/// Map feature planes sent with the observations
+enum class EAiPlane : uint8_t {
+	Flags = 1,      /// tile flags, u32
+	Visibility = 2, /// 0 unexplored, 1 explored, 2 visible by the player, u8
+	UnitCount = 3   /// number of units on the tile, u8
+};
+
+/**
+**  Build a frame in network byte order.
+*/
+class CAiFrame
+{
+public:
+	explicit CAiFrame(char type) : Data{static_cast<uint8_t>(type), 0, 0, 0, 0} {}
+
+	void U8(uint8_t value) { Data.push_back(value); }
+	void U16(uint16_t value) { U8(value >> 8); U8(value & 0xFF); }
+	void U32(uint32_t value) { U16(value >> 16); U16(value & 0xFFFF); }
+	void I32(int32_t value) { U32(static_cast<uint32_t>(value)); }
+
+	/// Get the frame with its size filled in
+	const std::vector<uint8_t> &Finish()
+	{
+		const uint32_t size = Data.size() - 5;
+		Data[1] = size >> 24;
+		Data[2] = (size >> 16) & 0xFF;
+		Data[3] = (size >> 8) & 0xFF;
+		Data[4] = size & 0xFF;
+		return Data;
+	}
+
+private:
+	std::vector<uint8_t> Data;
+};
+
+static uint32_t ReadU32(const uint8_t *data)
+{
+	return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3];
+}
+
+static uint16_t ReadU16(const uint8_t *data)
+{
+	return (uint16_t(data[0]) << 8) | data[1];
+}
+
+/**
+**  Connection to an external AI agent.
+*/
+class CAiProcessor
+{
+public:
+	bool Connect(const CHost &host, std::string_view name);
+	uint32_t Observe(int reward, const std::vector<int32_t> &state);
+	std::optional<std::vector<int32_t>> TakeActions();
+	void End(int reward);
+
+	unsigned int Instance = 0;  /// Tells the game instances apart for the agent
+	unsigned int ActionCount = 0;
+	unsigned int Delay = 0;     /// Cycles between an observation and its actions
+	int Timeout = 10000;        /// Time to wait for the hello, and between warnings about late actions (ms)
+	std::vector<EAiPlane> Planes;
+	bool SendUnits = false;
+	int Player = 0;             /// Player the visibility plane is computed for
+
+private:
+	struct Waiting
+	{
+		uint32_t Step;
+		unsigned long Cycle;  /// Game cycle the actions are due
+	};
+
+	bool Send(const std::vector<uint8_t> &frame);
+	bool Receive(int timeout);
+	bool ParseFrames();
+	void AddPlanes(CAiFrame &frame) const;
+	void AddUnits(CAiFrame &frame) const;
+
+	CTCPSocket Socket;
+	bool Connected = false;
+	uint16_t Version = 0;   /// Version accepted by the agent, 0 until known
+	uint32_t NextStep = 0;
+	std::deque<Waiting> Pending;
+	std::map<uint32_t, std::vector<int32_t>> Received;
+	std::vector<uint8_t> Input;
+};
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+/// Open connections, the Lua handle is the index + 1
+static std::vector<std::unique_ptr<CAiProcessor>> AiProcessors;
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+bool CAiProcessor::Send(const std::vector<uint8_t> &frame)
+{
+	size_t sent = 0;
+	while (Connected && sent != frame.size()) {
+		const int res = Socket.Send(frame.data() + sent, frame.size() - sent);
+		if (res <= 0) {
+			ErrorPrint("AI processor %u: connection lost\n", Instance);
+			Connected = false;
+			return false;
+		}
+		sent += res;
+	}
+	return Connected;
+}
+
+/**
+**  Read what the agent sent, waiting at most timeout ms for it.
+**
+**  @return  false if the connection is closed.
+*/
+bool CAiProcessor::Receive(int timeout)
+{
+	if (!Connected) {
+		return false;
+	}
+	if (Socket.HasDataToRead(timeout) <= 0) {
+		return true;
+	}
+	uint8_t buf[4096];
+	const int res = Socket.Recv(buf, sizeof(buf));
+	if (res <= 0) {
+		ErrorPrint("AI processor %u: connection closed by the agent\n", Instance);
+		Socket.Close();
+		Connected = false;
+		return false;
+	}
+	Input.insert(Input.end(), buf, buf + res);
+	if (!ParseFrames()) {
+		Socket.Close();
+		Connected = false;
+		Input.clear();
+		return false;
+	}
+	return true;
+}
+
+/**
+**  Handle the complete frames of the input.
+**
+**  @return  false on a protocol error.
+*/
+bool CAiProcessor::ParseFrames()
+{
+	size_t pos = 0;
+	while (Input.size() - pos >= 5) {
+		const uint8_t *frame = Input.data() + pos;
+		const size_t size = ReadU32(frame + 1);
+		if (size > AiMaxPayload) {
+			ErrorPrint("AI processor %u: frame '%c' too large (%zu bytes)\n", Instance, frame[0], size);
+			return false;
+		}
+		if (Input.size() - pos < 5 + size) {
+			break;
+		}
+		const uint8_t *payload = frame + 5;
+		if (frame[0] == 'H' && size >= 2) {
+			Version = ReadU16(payload);
+		} else if (frame[0] == 'A' && size >= 6) {
+			const uint32_t step = ReadU32(payload);
+			const size_t count = ReadU16(payload + 4);
+			if (size < 6 + 4 * count) {
+				ErrorPrint("AI processor %u: truncated actions of step %u\n", Instance, step);
+				return false;
+			}
+			std::vector<int32_t> actions(count);
+			for (size_t i = 0; i != count; ++i) {
+				actions[i] = static_cast<int32_t>(ReadU32(payload + 6 + 4 * i));
+			}
+			Received[step] = std::move(actions);
+		} else {
+			ErrorPrint("AI processor %u: bad message '%c' of %zu bytes\n", Instance, frame[0], size);
+			return false;
+		}
+		pos += 5 + size;
+	}
+	Input.erase(Input.begin(), Input.begin() + pos);
+	return true;
+}
+
+/**
+**  Connect to the agent and agree on the protocol version.
+*/
+bool CAiProcessor::Connect(const CHost &host, std::string_view name)
+{
+	Socket.Open(CHost());
+	Connected = Socket.Connect(host);
+	if (!Connected) {
+		return false;
+	}
+	CAiFrame hello('H');
+	hello.U16(AiProcessorVersion);
+	hello.U32(Instance);
+	hello.U32(ActionCount);
+	hello.U32(Delay);
+	hello.U16(name.size());
+	for (char c : name) {
+		hello.U8(c);
+	}
+	if (!Send(hello.Finish())) {
+		return false;
+	}
+	const auto start = std::chrono::steady_clock::now();
+	while (Version == 0 && Receive(100)) {
+		if (std::chrono::steady_clock::now() - start > std::chrono::milliseconds(Timeout)) {
+			break;
+		}
+	}
+	if (Version != AiProcessorVersion) {
+		ErrorPrint("AI processor %u: the agent doesn't speak version %d (answer %d)\n",
+		           Instance, AiProcessorVersion, Version);
+		Socket.Close();
+		Connected = false;
+	}
+	return Connected;
+}
+
+void CAiProcessor::AddPlanes(CAiFrame &frame) const
+{
+	frame.U8(Planes.size());
+	const CPlayer &player = Players[Player];
+	const int tiles = Map.Info.MapWidth * Map.Info.MapHeight;
+
+	for (EAiPlane plane : Planes) {
+		frame.U8(static_cast<uint8_t>(plane));
+		frame.U8(plane == EAiPlane::Flags ? 4 : 1);
+		frame.U16(Map.Info.MapWidth);
+		frame.U16(Map.Info.MapHeight);
+		for (int i = 0; i != tiles; ++i) {
+			const CMapField &mf = *Map.Field(i);
+			switch (plane) {
+				case EAiPlane::Flags: frame.U32(mf.getFlags()); break;
+				case EAiPlane::Visibility: frame.U8(mf.playerInfo.TeamVisibilityState(player)); break;
+				case EAiPlane::UnitCount: frame.U8(std::min<size_t>(mf.UnitCache.size(), 255)); break;
+			}
+		}
+	}
+}
+
+void CAiProcessor::AddUnits(CAiFrame &frame) const
+{
+	if (!SendUnits) {
+		frame.U32(0);
+		return;
+	}
+	// Removed and dying units aren't on the map, constructions are
+	std::vector<const CUnit *> units;
+	for (const CUnit *unit : UnitManager->GetUnits()) {
+		if (!unit->Destroyed && !unit->IsUnusable(true)) {
+			units.push_back(unit);
+		}
+	}
+	frame.U32(units.size());
+	for (const CUnit *unit : units) {
+		frame.U32(UnitNumber(*unit));
+		frame.U8(unit->Player->Index);
+		frame.U16(unit->Type->Slot);
+		frame.U16(unit->tilePos.x);
+		frame.U16(unit->tilePos.y);
+		frame.I32(unit->Variable[HP_INDEX].Value);
+		frame.U8(static_cast<uint8_t>(unit->CurrentAction()));
+	}
+}
+
+/**
+**  Send the state of this cycle, its actions are due Delay cycles later.
+*/
+uint32_t CAiProcessor::Observe(int reward, const std::vector<int32_t> &state)
+{
+	const uint32_t step = NextStep++;
+	Pending.push_back({step, GameCycle + Delay});
+
+	CAiFrame frame('O');
+	frame.U32(step);
+	frame.U32(GameCycle);
+	frame.I32(reward);
+	frame.U32(state.size());
+	for (int32_t value : state) {
+		frame.I32(value);
+	}
+	AddPlanes(frame);
+	AddUnits(frame);
+	Send(frame.Finish());
+	return step;
+}
+
+/**
+**  Get the actions due this cycle.
+**
+**  Blocks until the agent answers if they are due and not there yet,
+**  so the actions never depend on the agent latency.
+**
+**  @return  The actions of the oldest due observation, nothing if none
+**           is due or the connection is closed.
+*/
+std::optional<std::vector<int32_t>> CAiProcessor::TakeActions()
+{
+	Receive(0);
+	if (Pending.empty() || Pending.front().Cycle > GameCycle) {
+		return std::nullopt;
+	}
+	const uint32_t step = Pending.front().Step;
+	Pending.pop_front();
+
+	auto lastWarning = std::chrono::steady_clock::now();
+	while (!Received.count(step)) {
+		if (!Receive(100)) {
+			ErrorPrint("AI processor %u: no actions for step %u\n", Instance, step);
+			return std::nullopt;
+		}
+		if (std::chrono::steady_clock::now() - lastWarning > std::chrono::milliseconds(Timeout)) {
+			LogPrint("AI processor %u: still waiting for the actions of step %u\n", Instance, step);
+			lastWarning = std::chrono::steady_clock::now();
+		}
+	}
+	auto it = Received.find(step);
+	std::vector<int32_t> actions = std::move(it->second);
+	Received.erase(Received.begin(), std::next(it)); // older answers are late, drop them
+	return actions;
+}
+
+void CAiProcessor::End(int reward)
+{
+	CAiFrame frame('E');
+	frame.U32(NextStep);
+	frame.I32(reward);
+	Send(frame.Finish());
+	Socket.Close();
+	Connected = false;
+}
+
+static CAiProcessor &GetAiProcessor(lua_State *l, int index)
+{
+	const size_t handle = LuaToNumber(l, index);
+	if (handle == 0 || handle > AiProcessors.size() || AiProcessors[handle - 1] == nullptr) {
+		LuaError(l, "bad AI processor handle: %d", (int)handle);
+	}
+	return *AiProcessors[handle - 1];
+}
+
+static std::vector<int32_t> GetAiProcessorState(lua_State *l, int index)
+{
+	if (!lua_istable(l, index)) {
+		LuaError(l, "the state must be a table");
+	}
+	const int size = lua_rawlen(l, index);
+	std::vector<int32_t> state(size);
+	for (int i = 0; i != size; ++i) {
+		state[i] = LuaToNumber(l, index, i + 1);
+	}
+	return state;
+}
+
+/**
+** <b>Description</b>
+**
+**  Connect to an external AI agent with the pipelined protocol.
+**
+**  @param l  Lua state.
+**
+** Example:
+**
+** <div class="example"><code>local ai = <strong>AiProcessorConnect</strong>("127.0.0.1", 9292, 4,
+**        {Instance = 3, Delay = 8, Planes = {"flags", "visibility"}, Units = true})</code></div>
+**
+**  Options are Instance, Delay (cycles between an observation and its
+**  actions), Timeout (ms to wait for the agent hello), Player, Name, Planes ("flags", "visibility",
+**  "unit-count") and Units.
+**
+**  @return  A handle, nil if the agent can't be reached.
+*/
+static int CclAiProcessorConnect(lua_State *l)
+{
+	const int args = lua_gettop(l);
+	if (args != 3 && args != 4) {
+		LuaError(l, "incorrect argument");
+	}
+	InitNetwork1();
+	const std::string host{LuaToString(l, 1)};
+	const int port = LuaToNumber(l, 2);
+	auto processor = std::make_unique<CAiProcessor>();
+	processor->ActionCount = LuaToNumber(l, 3);
+	processor->Player = ThisPlayer ? ThisPlayer->Index : 0;
+	std::string name;
+
+	if (args == 4) {
+		if (!lua_istable(l, 4)) {
+			LuaError(l, "incorrect argument");
+		}
+		for (lua_pushnil(l); lua_next(l, 4); lua_pop(l, 1)) {
+			const std::string_view key = LuaToString(l, -2);
+
+			if (key == "Instance") {
+				processor->Instance = LuaToNumber(l, -1);
+			} else if (key == "Delay") {
+				processor->Delay = LuaToNumber(l, -1);
+			} else if (key == "Timeout") {
+				processor->Timeout = LuaToNumber(l, -1);
+			} else if (key == "Player") {
+				processor->Player = LuaToNumber(l, -1);
+				if (processor->Player < 0 || processor->Player >= PlayerMax) {
+					LuaError(l, "bad player: %d", processor->Player);
+				}
+			} else if (key == "Name") {
+				name = LuaToString(l, -1);
+			} else if (key == "Units") {
+				processor->SendUnits = LuaToBoolean(l, -1);
+			} else if (key == "Planes") {
+				if (!lua_istable(l, -1)) {
+					LuaError(l, "incorrect argument");
+				}
+				const int planeCount = lua_rawlen(l, -1);
+				for (int i = 0; i != planeCount; ++i) {
+					const std::string_view plane = LuaToString(l, -1, i + 1);
+					if (plane == "flags") {
+						processor->Planes.push_back(EAiPlane::Flags);
+					} else if (plane == "visibility") {
+						processor->Planes.push_back(EAiPlane::Visibility);
+					} else if (plane == "unit-count") {
+						processor->Planes.push_back(EAiPlane::UnitCount);
+					} else {
+						LuaError(l, "Unsupported plane: %s", plane.data());
+					}
+				}
+			} else {
+				LuaError(l, "Unsupported tag: %s", key.data());
+			}
+		}
+	}
+	if (!processor->Connect(CHost(host, port), name)) {
+		lua_pushnil(l);
+		return 1;
+	}
+	AiProcessors.push_back(std::move(processor));
+	lua_pushnumber(l, AiProcessors.size());
+	return 1;
+}
+
+/**
+** <b>Description</b>
+**
+**  Send the state of the game, without waiting for the agent.
+**
+**  AiProcessorObserve(handle, reward_since_last_call, table_of_state_variables)
+**
+**  @param l  Lua state.
+**
+**  @return  The step number of the observation.
+*/
+static int CclAiProcessorObserve(lua_State *l)
+{
+	LuaCheckArgs(l, 3);
+	CAiProcessor &processor = GetAiProcessor(l, 1);
+	const int reward = LuaToNumber(l, 2);
+
+	lua_pushnumber(l, processor.Observe(reward, GetAiProcessorState(l, 3)));
+	return 1;
+}
+
+/**
+** <b>Description</b>
+**
+**  Get the actions chosen for the observation sent Delay cycles ago.
+**
+**  AiProcessorActions(handle)
+**
+**  @param l  Lua state.
+**
+**  @return  Table of actions (1-based), nil if no observation is due.
+*/
+static int CclAiProcessorActions(lua_State *l)
+{
+	LuaCheckArgs(l, 1);
+	const auto actions = GetAiProcessor(l, 1).TakeActions();
+
+	if (!actions) {
+		lua_pushnil(l);
+		return 1;
+	}
+	lua_createtable(l, actions->size(), 0);
+	for (size_t i = 0; i != actions->size(); ++i) {
+		lua_pushnumber(l, (*actions)[i] + 1); // +1 since lua tables are 1-indexed
+		lua_rawseti(l, -2, i + 1);
+	}
+	return 1;
+}
+
+/**
+** <b>Description</b>
+**
+**  Send the final reward and close the connection.
+**
+**  AiProcessorClose(handle, reward_since_last_call)
+**
+**  @param l  Lua state.
+*/
+static int CclAiProcessorClose(lua_State *l)
+{
+	LuaCheckArgs(l, 2);
+	CAiProcessor &processor = GetAiProcessor(l, 1);
+	processor.End(LuaToNumber(l, 2));
+	AiProcessors[LuaToNumber(l, 1) - 1].reset();
+	return 0;
+}
+
+/**
+**  Register CCL features for the external AI processors.
+*/
+void AiProcessorCclRegister()
+{
+	lua_register(Lua, "AiProcessorConnect", CclAiProcessorConnect);
+	lua_register(Lua, "AiProcessorObserve", CclAiProcessorObserve);
+	lua_register(Lua, "AiProcessorActions", CclAiProcessorActions);
+	lua_register(Lua, "AiProcessorClose", CclAiProcessorClose);
+}
+
+//@}
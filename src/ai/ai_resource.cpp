@@ -44,6 +44,7 @@
 #include "action/action_resource.h"
 #include "commands.h"
 #include "depend.h"
+#include "influence_map.h"
 #include "map.h"
 #include "pathfinder.h"
 #include "player.h"
@@ -189,6 +190,55 @@ class IsAEnemyUnitWhichCanCounterAttackOf
 	const CUnitType *type;
 };
 
+/**
+**  Mask of the owners of the units which are enemies of player.
+*/
+unsigned int AiHostilePlayersMask(const CPlayer &player)
+{
+	unsigned int mask = 0;
+	for (int i = 0; i != PlayerMax; ++i) {
+		if (Players[i].IsEnemy(player)) {
+			mask |= 1 << i;
+		}
+	}
+	return mask;
+}
+
+/**
+**  Mask of the players player is enemy of.
+*/
+unsigned int AiEnemyPlayersMask(const CPlayer &player)
+{
+	unsigned int mask = 0;
+	for (int i = 0; i != PlayerMax; ++i) {
+		if (player.IsEnemy(i)) {
+			mask |= 1 << i;
+		}
+	}
+	return mask;
+}
+
+/**
+**  Check if the enemies around a location are stronger than the player and its allies.
+**
+**  @param player  Player to protect.
+**  @param pos     location
+**  @param range   Distance range to look.
+*/
+bool AiIsThreatened(const CPlayer &player, const Vec2i &pos, unsigned range)
+{
+	const Vec2i offset(range, range);
+	unsigned int friends = 1 << player.Index;
+
+	for (int i = 0; i != PlayerMax; ++i) {
+		if (player.IsAllied(i)) {
+			friends |= 1 << i;
+		}
+	}
+	return InfluenceMap.GetStrength(AiHostilePlayersMask(player), pos - offset, pos + offset)
+	     > InfluenceMap.GetStrength(friends, pos - offset, pos + offset);
+}
+
 /**
 **  Check if there are enemy units in a given range.
 **
@@ -203,12 +253,19 @@ bool AiEnemyUnitsInDistance(const CPlayer &player,
 						    const CUnitType *type, const Vec2i &pos, unsigned range)
 {
 	const Vec2i offset(range, range);
+	const unsigned int hostiles = AiHostilePlayersMask(player);
 
 	if (type == nullptr) {
+		if (!InfluenceMap.HasUnits(hostiles, pos - offset, pos + offset)) {
+			return false;
+		}
 		std::vector<CUnit *> units = Select<1>(pos - offset, pos + offset, IsAEnemyUnitOf<true>(player));
 		return !units.empty();
 	} else {
 		const Vec2i typeSize(type->TileWidth - 1, type->TileHeight - 1);
+		if (!InfluenceMap.HasUnits(hostiles, pos - offset, pos + typeSize + offset)) {
+			return false;
+		}
 		const IsAEnemyUnitWhichCanCounterAttackOf<true> pred(player, *type);
 
 		std::vector<CUnit *> units = Select<1>(pos - offset, pos + typeSize + offset, pred);
@@ -464,7 +521,9 @@ std::pair<CUnit *, CUnit *> AiGetSuitableDepot(const CUnit &worker, const CUnit
 		if (unit.Refs > tooManyWorkers) {
 			continue;
 		}
-		if (AiEnemyUnitsInDistance(worker, range)) {
+		// Keep harvesting where our forces outmatch the enemies around
+		if (AiEnemyUnitsInDistance(worker, range)
+		    && AiIsThreatened(*worker.Player, worker.tilePos, range)) {
 			continue;
 		}
 		CUnit *res = UnitFindResource(worker, unit, range, resource, unit.Player->AiEnabled);
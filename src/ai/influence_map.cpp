@@ -0,0 +1,381 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name influence_map.cpp - The influence map of the AI. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "stratagus.h"
+
+#include "influence_map.h"
+
+#include "map.h"
+#include "player.h"
+#include "unit.h"
+#include "unittype.h"
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+CInfluenceMap InfluenceMap;  /// Influence map of the AI
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+/**
+**  Reset all the cells for a map of the given size.
+*/
+void CInfluenceGrid::Init(int mapWidth, int mapHeight)
+{
+	MapWidth = mapWidth;
+	MapHeight = mapHeight;
+	Width = (mapWidth + CellSize - 1) / CellSize;
+	Height = (mapHeight + CellSize - 1) / CellSize;
+	Values.assign(Width * Height * PlayerMax, 0);
+	NonZero.assign(Width * Height, 0);
+}
+
+void CInfluenceGrid::AddCell(int player, int cell, int delta)
+{
+	int &value = Values[cell * PlayerMax + player];
+
+	value += delta;
+	if (value) {
+		NonZero[cell] |= 1 << player;
+	} else {
+		NonZero[cell] &= ~(1 << player);
+	}
+}
+
+/**
+**  Add delta to the cell of the tile pos.
+*/
+void CInfluenceGrid::Add(int player, const Vec2i &pos, int delta)
+{
+	Assert(0 <= pos.x && pos.x < MapWidth && 0 <= pos.y && pos.y < MapHeight);
+	AddCell(player, CellIndex(pos), delta);
+}
+
+/**
+**  Cells overlapping the tile rectangle, bounds included.
+**
+**  @return  false if the rectangle is out of the map.
+*/
+bool CInfluenceGrid::ClipToCells(const Vec2i &minPos, const Vec2i &maxPos, Vec2i &minCell, Vec2i &maxCell) const
+{
+	minCell.x = std::max<int>(minPos.x, 0) / CellSize;
+	minCell.y = std::max<int>(minPos.y, 0) / CellSize;
+	maxCell.x = std::min<int>(maxPos.x, MapWidth - 1) / CellSize;
+	maxCell.y = std::min<int>(maxPos.y, MapHeight - 1) / CellSize;
+	return minPos.x <= maxPos.x && minPos.y <= maxPos.y
+	    && minPos.x < MapWidth && minPos.y < MapHeight && maxPos.x >= 0 && maxPos.y >= 0;
+}
+
+/**
+**  Number of tiles of the map in a cell, the last row and column can be partial.
+*/
+int CInfluenceGrid::CellArea(int x, int y) const
+{
+	return (std::min<int>(MapWidth - x * CellSize, CellSize)) * (std::min<int>(MapHeight - y * CellSize, CellSize));
+}
+
+/**
+**  Check if one of the players has a value in the cells overlapping the rectangle.
+*/
+bool CInfluenceGrid::Any(unsigned int playerMask, const Vec2i &minPos, const Vec2i &maxPos) const
+{
+	Vec2i minCell;
+	Vec2i maxCell;
+	if (!ClipToCells(minPos, maxPos, minCell, maxCell)) {
+		return false;
+	}
+	for (int y = minCell.y; y <= maxCell.y; ++y) {
+		for (int x = minCell.x; x <= maxCell.x; ++x) {
+			if (NonZero[y * Width + x] & playerMask) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/**
+**  Sum of the values of the players in the cells overlapping the rectangle.
+*/
+int CInfluenceGrid::Sum(unsigned int playerMask, const Vec2i &minPos, const Vec2i &maxPos) const
+{
+	Vec2i minCell;
+	Vec2i maxCell;
+	if (!ClipToCells(minPos, maxPos, minCell, maxCell)) {
+		return 0;
+	}
+	int res = 0;
+	for (int y = minCell.y; y <= maxCell.y; ++y) {
+		for (int x = minCell.x; x <= maxCell.x; ++x) {
+			const int cell = y * Width + x;
+			const unsigned int mask = NonZero[cell] & playerMask;
+			for (int p = 0; mask >> p; ++p) {
+				if (mask & (1 << p)) {
+					res += Values[cell * PlayerMax + p];
+				}
+			}
+		}
+	}
+	return res;
+}
+
+/**
+**  Check if the value of the player is the number of tiles of the cell,
+**  in all the cells overlapping the rectangle.
+*/
+bool CInfluenceGrid::IsFull(int player, const Vec2i &minPos, const Vec2i &maxPos) const
+{
+	Vec2i minCell;
+	Vec2i maxCell;
+	if (!ClipToCells(minPos, maxPos, minCell, maxCell)) {
+		return true;
+	}
+	for (int y = minCell.y; y <= maxCell.y; ++y) {
+		for (int x = minCell.x; x <= maxCell.x; ++x) {
+			if (Values[(y * Width + x) * PlayerMax + player] != CellArea(x, y)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+**  Forget all units and grids, done when the units are cleaned.
+*/
+void CInfluenceMap::Clear()
+{
+	Entries.clear();
+	UnitCells = {};
+	StrengthCells = {};
+	ExploredCells = {};
+	ExploredValid = 0;
+	MapWidth = 0;
+	MapHeight = 0;
+}
+
+CInfluenceMap::Entry CInfluenceMap::MakeEntry(const CUnit &unit, bool onMap) const
+{
+	Entry entry;
+	entry.OnMap = onMap && unit.Type && unit.Player;
+	if (entry.OnMap) {
+		entry.Player = unit.Player->Index;
+		entry.Width = unit.Type->TileWidth;
+		entry.Height = unit.Type->TileHeight;
+		entry.Pos = unit.tilePos;
+		if (unit.Type->CanAttack && unit.IsAlive()) {
+			entry.Strength = unit.Stats->Variables[BASICDAMAGE_INDEX].Value
+			               + unit.Stats->Variables[PIERCINGDAMAGE_INDEX].Value;
+		}
+	}
+	return entry;
+}
+
+bool CInfluenceMap::Entry::operator==(const Entry &rhs) const
+{
+	return OnMap == rhs.OnMap && Player == rhs.Player && Width == rhs.Width
+	    && Height == rhs.Height && Strength == rhs.Strength && Pos == rhs.Pos;
+}
+
+/**
+**  Replace what the map knows of the unit.
+*/
+void CInfluenceMap::Set(const CUnit &unit, const Entry &entry)
+{
+	const int slot = UnitNumber(unit);
+	if (slot < 0) {
+		return;
+	}
+	if (slot >= static_cast<int>(Entries.size())) {
+		Entries.resize(slot + 1);
+	}
+	Entry &old = Entries[slot];
+	if (old == entry) {
+		return;
+	}
+	CheckMapSize();
+	Apply(old, -1);
+	Apply(entry, 1);
+	old = entry;
+}
+
+/**
+**  Add the unit described by entry to the unit and strength layers.
+*/
+void CInfluenceMap::Apply(const Entry &entry, int delta)
+{
+	if (!entry.OnMap) {
+		return;
+	}
+	// The unit is in the cache of its tiles on the map, so in all their cells
+	const int cellSize = CInfluenceGrid::CellSize;
+	const int maxX = std::min<int>(entry.Pos.x + entry.Width, MapWidth) - 1;
+	const int maxY = std::min<int>(entry.Pos.y + entry.Height, MapHeight) - 1;
+	for (int y = entry.Pos.y / cellSize; y <= maxY / cellSize; ++y) {
+		for (int x = entry.Pos.x / cellSize; x <= maxX / cellSize; ++x) {
+			UnitCells.AddCell(entry.Player, y * UnitCells.GetWidth() + x, delta);
+		}
+	}
+	if (entry.Strength) {
+		StrengthCells.Add(entry.Player, entry.Pos, delta * entry.Strength);
+	}
+}
+
+/**
+**  Called when the unit is inserted in the map unit cache.
+*/
+void CInfluenceMap::OnMapInsert(const CUnit &unit)
+{
+	Set(unit, MakeEntry(unit, true));
+}
+
+/**
+**  Called when the unit is removed from the map unit cache.
+*/
+void CInfluenceMap::OnMapRemove(const CUnit &unit)
+{
+	Set(unit, MakeEntry(unit, false));
+}
+
+/**
+**  Called when the owner or the type of the unit change.
+*/
+void CInfluenceMap::Update(const CUnit &unit)
+{
+	const int slot = UnitNumber(unit);
+	const bool onMap = 0 <= slot && slot < static_cast<int>(Entries.size()) && Entries[slot].OnMap;
+
+	Set(unit, MakeEntry(unit, onMap));
+}
+
+/**
+**  Called when the player explores the tile for the first time.
+*/
+void CInfluenceMap::OnTileExplored(const CPlayer &player, unsigned int index)
+{
+	if (!(ExploredValid & (1 << player.Index))) {
+		return;
+	}
+	CheckMapSize();
+	if (ExploredValid & (1 << player.Index)) {
+		ExploredCells.Add(player.Index, Vec2i(index % MapWidth, index / MapWidth), 1);
+	}
+}
+
+/**
+**  Called when many tiles are explored at once, they are counted again when needed.
+*/
+void CInfluenceMap::InvalidateExplored()
+{
+	ExploredValid = 0;
+}
+
+void CInfluenceMap::CountExplored(int player)
+{
+	for (int cell = 0; cell != ExploredCells.GetWidth() * ExploredCells.GetHeight(); ++cell) {
+		ExploredCells.AddCell(player, cell, -ExploredCells.GetCell(player, cell));
+	}
+	for (int y = 0; y != MapHeight; ++y) {
+		for (int x = 0; x != MapWidth; ++x) {
+			const Vec2i pos(x, y);
+			if (Map.Field(pos)->playerInfo.IsExplored(Players[player])) {
+				ExploredCells.Add(player, pos, 1);
+			}
+		}
+	}
+	ExploredValid |= 1 << player;
+}
+
+/**
+**  Build the grids again for another map size.
+*/
+void CInfluenceMap::CheckMapSize()
+{
+	if (MapWidth == Map.Info.MapWidth && MapHeight == Map.Info.MapHeight) {
+		return;
+	}
+	MapWidth = Map.Info.MapWidth;
+	MapHeight = Map.Info.MapHeight;
+	UnitCells.Init(MapWidth, MapHeight);
+	StrengthCells.Init(MapWidth, MapHeight);
+	ExploredCells.Init(MapWidth, MapHeight);
+	ExploredValid = 0;
+	for (const Entry &entry : Entries) {
+		Apply(entry, 1);
+	}
+}
+
+/**
+**  Check if units of the players may be in the rectangle.
+**
+**  @param playerMask  Mask of the owners of the units.
+**  @param minPos      Top left tile of the rectangle.
+**  @param maxPos      Bottom right tile of the rectangle.
+**
+**  @return            false when no unit of the players is in the map unit
+**                     cache of the tiles of the rectangle.
+*/
+bool CInfluenceMap::HasUnits(unsigned int playerMask, const Vec2i &minPos, const Vec2i &maxPos)
+{
+	CheckMapSize();
+	return UnitCells.Any(playerMask, minPos, maxPos);
+}
+
+/**
+**  Damage the alive units of the players around the rectangle can deal.
+**
+**  The units are counted by cell of their top left tile, the cells
+**  overlapping the rectangle are counted entirely.
+*/
+int CInfluenceMap::GetStrength(unsigned int playerMask, const Vec2i &minPos, const Vec2i &maxPos)
+{
+	CheckMapSize();
+	return StrengthCells.Sum(playerMask, minPos, maxPos);
+}
+
+/**
+**  Check if the player explored all the cells overlapping the rectangle.
+*/
+bool CInfluenceMap::IsExplored(const CPlayer &player, const Vec2i &minPos, const Vec2i &maxPos)
+{
+	CheckMapSize();
+	if (!(ExploredValid & (1 << player.Index))) {
+		CountExplored(player.Index);
+	}
+	return ExploredCells.IsFull(player.Index, minPos, maxPos);
+}
+
+//@}
@@ -1310,16 +1310,10 @@ static int CclAiSleep(lua_State *l)
 static int CclAiResearch(lua_State *l)
 {
 	LuaCheckArgs(l, 1);
-	const std::string_view str = LuaToString(l, 1);
-	CUpgrade *upgrade;
-
-	if (!str.empty()) {
-		upgrade = CUpgrade::Get(str);
-	} else {
+	if (lua_isstring(l, 1) && LuaToString(l, 1).empty()) {
 		LuaError(l, "Upgrade needed");
-		upgrade = nullptr;
 	}
-	InsertResearchRequests(upgrade);
+	InsertResearchRequests(CclGetUpgrade(l));
 	lua_pushboolean(l, 0);
 	return 1;
 }
@@ -1789,6 +1783,36 @@ static int CclDefineAiPlayer(lua_State *l)
 				AiExplorationRequest queue(pos, mask);
 				ai.FirstExplorationRequest.push_back(queue);
 			}
+		} else if (value == "pending-plans") {
+			if (!lua_istable(l, j + 1)) {
+				LuaError(l, "incorrect argument");
+			}
+			const int subargs = lua_rawlen(l, j + 1);
+			for (int k = 0; k < subargs; ++k) {
+				lua_rawgeti(l, j + 1, k + 1);
+				if (!lua_istable(l, -1)) {
+					LuaError(l, "incorrect argument");
+				}
+				const int planargs = lua_rawlen(l, -1);
+				const unsigned long cycle = LuaToNumber(l, -1, 1);
+				AiPlan plan;
+				for (int m = 1; m < planargs; m += 4) {
+					const std::string_view action = LuaToString(l, -1, m + 1);
+					if (action != "explore") {
+						LuaError(l, "Unsupported plan action: %s", action.data());
+					}
+					AiPlanCommand command;
+					command.Action = AiPlanCommand::EAction::Explore;
+					command.UnitSlot = LuaToNumber(l, -1, m + 2);
+					command.Pos.x = LuaToNumber(l, -1, m + 3);
+					command.Pos.y = LuaToNumber(l, -1, m + 4);
+					plan.push_back(command);
+				}
+				lua_pop(l, 1);
+				std::promise<AiPlan> result;
+				result.set_value(std::move(plan));
+				ai.PendingPlans.push_back({cycle, result.get_future().share()});
+			}
 		} else if (value == "last-exploration-cycle") {
 			ai.LastExplorationGameCycle = LuaToNumber(l, j + 1);
 		} else if (value == "last-can-not-move-cycle") {
@@ -1984,6 +2008,7 @@ void AiCclRegister()
 	lua_register(Lua, "AiProcessorSetup", CclAiProcessorSetup);
 	lua_register(Lua, "AiProcessorStep", CclAiProcessorStep);
 	lua_register(Lua, "AiProcessorEnd", CclAiProcessorEnd);
+	AiProcessorCclRegister();
 }
 
 //@}
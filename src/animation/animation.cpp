@@ -81,6 +81,8 @@ static std::vector<LabelsLaterStruct> LabelsLater;
 
 static std::vector<std::vector<std::unique_ptr<CAnimation>>*> AnimationsArray;
 static std::map<std::string, std::unique_ptr<CAnimations>, std::less<>> AnimationMap;/// Animation map
+/// Compiled animation sequences
+static std::map<const std::vector<std::unique_ptr<CAnimation>> *, CAnimProgram> AnimationPrograms;
 
 /*----------------------------------------------------------------------------
 --  Animation
@@ -141,6 +143,40 @@ void modifyValue(SetVar_ModifyTypes mod, int &value, int rop)
 	}
 }
 
+/**
+**  Compile an animation sequence.
+**
+**  @param anims  Animation sequence, its labels must be resolved.
+**
+**  @return  The compiled sequence.
+*/
+static CAnimProgram CompileAnimProgram(const std::vector<std::unique_ptr<CAnimation>> &anims)
+{
+	CAnimProgram program;
+	program.Source = &anims;
+	program.Ops.reserve(anims.size());
+	for (const auto &anim : anims) {
+		program.Ops.push_back(anim->Compile());
+	}
+	return program;
+}
+
+/**
+**  Get the compiled form of an animation sequence, compile it on first use.
+**
+**  @param anims  Animation sequence.
+**
+**  @return  The compiled sequence, valid until the animations are freed.
+*/
+const CAnimProgram &GetAnimProgram(const std::vector<std::unique_ptr<CAnimation>> &anims)
+{
+	auto it = AnimationPrograms.find(&anims);
+	if (it == AnimationPrograms.end()) {
+		it = AnimationPrograms.emplace(&anims, CompileAnimProgram(anims)).first;
+	}
+	return it->second;
+}
+
 /**
 **  Show unit animation.
 **
@@ -154,29 +190,40 @@ int UnitShowAnimation(CUnit &unit, const std::vector<std::unique_ptr<CAnimation>
 	return UnitShowAnimationScaled(unit, anim, 8);
 }
 
+EAnimVarComponent toAnimVarComponent(std::string_view s)
+{
+	if (s == "Value") {
+		return EAnimVarComponent::Value;
+	} else if (s == "Max") {
+		return EAnimVarComponent::Max;
+	} else if (s == "Increase") {
+		return EAnimVarComponent::Increase;
+	} else if (s == "Enable") {
+		return EAnimVarComponent::Enable;
+	} else if (s == "Percent") {
+		return EAnimVarComponent::Percent;
+	}
+	return EAnimVarComponent::Unknown;
+}
+
 /**
-**  Parse player number in animation frame
-**
-**  @param unit      Unit of the animation.
-**  @param parseint  Integer to parse.
-**
-**  @return  The parsed value.
+**  Compile the player operand of p. and l., "this" is the unit's player.
 */
-
-static int ParseAnimPlayer(const CUnit &unit, std::string_view parseint)
+void CAnimOperand::CompilePlayer(std::string_view s)
 {
-	if (parseint == "this") {
-		return unit.Player->Index;
+	Player = std::make_unique<CAnimOperand>();
+	if (s == "this") {
+		Player->Kind = EKind::ThisPlayer;
+		Player->Text = s;
+	} else {
+		Player->Compile(s);
 	}
-	return ParseAnimInt(unit, parseint);
 }
 
-
 /**
-**  Parse integer in animation frame.
+**  Compile an animation operand.
 **
-**  @param unit      Unit of the animation.
-**  @param s         Integer to parse.
+**  @param s  Operand text.
 **         either:
 **           - v.UnitVar.Value // own value
 **           - t.UnitVar.Value // target value
@@ -196,87 +243,48 @@ static int ParseAnimPlayer(const CUnit &unit, std::string_view parseint)
 **           - R // unit rotation
 **           - W // remaining way
 **           - number
-**
-**  @return  The parsed value.
 */
-int ParseAnimInt(const CUnit &unit, const std::string_view s)
+void CAnimOperand::Compile(std::string_view s)
 {
-	const CUnit *goal = &unit;
-
+	*this = CAnimOperand();
+	Text = s;
 	if (s.empty()) {
-		return 0;
+		return;
 	}
 	if (s[0] == 'v' || s[0] == 't') { //unit variable detected
-		if (s[0] == 't') {
-			if (unit.CurrentOrder()->HasGoal()) {
-				goal = unit.CurrentOrder()->GetGoal();
-			} else if (unit.CurrentOrder()->Action == UnitAction::Build) {
-				goal = static_cast<const COrder_Build *>(unit.CurrentOrder())->GetBuildingUnit();
-			} else {
-				return 0;
-			}
-		}
+		Goal = s[0] == 't' ? EGoal::Target : EGoal::Self;
 		auto dot_pos = s.find('.', 2);
 		if (dot_pos == std::string_view::npos) {
 			ErrorPrint("Need also specify the variable '%s' tag \n", s.substr(2).data());
 			ExitFatal(1);
 		}
 		auto cur = s.substr(2, dot_pos - 2);
-		auto next = s.substr(dot_pos + 1);
-		const int index = UnitTypeVar.VariableNameLookup[cur];// User variables
-		if (index == -1) {
+		Kind = EKind::Variable;
+		Component = toAnimVarComponent(s.substr(dot_pos + 1));
+		Index = UnitTypeVar.VariableNameLookup[cur];// User variables
+		if (Index == -1) {
 			if (cur == "ResourcesHeld") {
-				return goal->ResourcesHeld;
+				Kind = EKind::ResourcesHeld;
 			} else if (cur == "ResourceActive") {
-				return goal->Resource.Active;
+				Kind = EKind::ResourceActive;
 			} else if (cur == "_Distance") {
-				return unit.MapDistanceTo(*goal);
-			}
-			ErrorPrint("Bad variable name '%s'\n", cur.data());
-			ExitFatal(1);
-		}
-		if (next == "Value") {
-			return goal->Variable[index].Value;
-		} else if (next == "Max") {
-			return goal->Variable[index].Max;
-		} else if (next == "Increase") {
-			return goal->Variable[index].Increase;
-		} else if (next == "Enable") {
-			return goal->Variable[index].Enable;
-		} else if (next == "Percent") {
-			return goal->Variable[index].Value * 100 / goal->Variable[index].Max;
-		}
-		return 0;
-	} else if (s[0] == 'b' || s[0] == 'g') { //unit bool flag detected
-		if (s[0] == 'g') {
-			if (unit.CurrentOrder()->HasGoal()) {
-				goal = unit.CurrentOrder()->GetGoal();
+				Kind = EKind::Distance;
 			} else {
-				return 0;
+				// May be defined after the animations
+				Name = cur;
+				Resolved = false;
 			}
 		}
-		auto cur = s.substr(2);
-		const int index = UnitTypeVar.BoolFlagNameLookup[cur]; // User bool flags
-		if (index == -1) {
-			ErrorPrint("Bad bool-flag name '%s'\n", cur.data());
-			ExitFatal(1);
-		}
-		return goal->Type->BoolFlag[index].value;
-	} else if (s[0] == 's') { //spell type detected
-		Assert(goal->CurrentAction() == UnitAction::SpellCast);
-		const COrder_SpellCast &order = *static_cast<COrder_SpellCast *>(goal->CurrentOrder());
-		const SpellType &spell = order.GetSpell();
-		if (spell.Ident == s.substr(2)) {
-			return 1;
-		}
-		return 0;
-	} else if (s[0] == 'S') { // check if autocast for this spell available
-		auto cur = s.substr(2);
-		const SpellType &spell = SpellTypeByIdent(cur);
-		if (unit.AutoCastSpell[spell.Slot]) {
-			return 1;
-		}
-		return 0;
+	} else if (s[0] == 'b' || s[0] == 'g') { //unit bool flag detected
+		Kind = EKind::BoolFlag;
+		Goal = s[0] == 'g' ? EGoal::OrderGoal : EGoal::Self;
+		Name = s.substr(2);
+		Index = UnitTypeVar.BoolFlagNameLookup[Name]; // User bool flags
+		Resolved = Index != -1;
+	} else if (s[0] == 's' || s[0] == 'S') { //spell type detected, or autocast
+		Kind = s[0] == 's' ? EKind::SpellCast : EKind::AutoCast;
+		Name = s.substr(2);
+		Resolved = false;
 	} else if (s[0] == 'p') { //player variable detected
 		auto cur = s.substr(2);
 		std::string_view next;
@@ -301,37 +309,189 @@ int ParseAnimInt(const CUnit &unit, const std::string_view s)
 			}
 		}
 		auto dot_pos = next.find('.');
-		auto arg = dot_pos == std::string_view::npos ? "" : next.substr(dot_pos + 1);
-		next = next.substr(0, dot_pos);
-		return GetPlayerData(ParseAnimPlayer(unit, cur), next, arg);
+		Kind = EKind::PlayerData;
+		Name = dot_pos == std::string_view::npos ? "" : next.substr(dot_pos + 1);
+		Prop = PlayerDataByName(next.substr(0, dot_pos));
+		Resolved = false;
+		CompilePlayer(cur);
 	} else if (s[0] == 'r') { //random value
 		auto cur = s.substr(2);
 		auto dot_pos = cur.find('.');
 
+		Kind = EKind::Random;
 		if (dot_pos == std::string_view::npos) {
-			return SyncRand(to_number(cur) + 1);
+			Max = to_number(cur);
 		} else {
-			const int min = to_number(cur);
-			return min + SyncRand(to_number(cur.substr(dot_pos + 1)) - min + 1);
+			Value = to_number(cur);
+			Max = to_number(cur.substr(dot_pos + 1));
 		}
 	} else if (s[0] == 'l') { //player number
-		return ParseAnimPlayer(unit, s.substr(2));
+		Kind = EKind::PlayerNumber;
+		CompilePlayer(s.substr(2));
 	} else if (s[0] == 'U') { //unit itself
-		return UnitNumber(unit);
+		Kind = EKind::UnitSlot;
 	} else if (s[0] == 'G') { //goal
-		if (unit.CurrentOrder()->HasGoal()) {
-			return UnitNumber(*unit.CurrentOrder()->GetGoal());
-		} else {
-			return 0;
-		}
+		Kind = EKind::GoalSlot;
 	} else if (s[0] == 'R') { //pending rotational value
-		return unit.Anim.Rotate;
+		Kind = EKind::Rotation;
 	} else if (s[0] == 'W') { //remaining way
-		return unit.pathFinderData->output.Length + 1 + unit.pathFinderData->output.OverflowLength;
+		Kind = EKind::RemainingWay;
+	} else {
+		// Check if we trying to parse a number
+		Assert(isdigit(s[0]) || s[0] == '-');
+		Value = to_number(s);
 	}
-	// Check if we trying to parse a number
-	Assert(isdigit(s[0]) || s[0] == '-');
-	return to_number(s);
+}
+
+/**
+**  Resolve the names which were not defined when the operand was compiled.
+*/
+void CAnimOperand::Resolve() const
+{
+	switch (Kind) {
+		case EKind::Variable:
+			Index = UnitTypeVar.VariableNameLookup[Name];
+			if (Index == -1) {
+				ErrorPrint("Bad variable name '%s'\n", Name.c_str());
+				ExitFatal(1);
+			}
+			break;
+		case EKind::BoolFlag:
+			Index = UnitTypeVar.BoolFlagNameLookup[Name];
+			if (Index == -1) {
+				ErrorPrint("Bad bool-flag name '%s'\n", Name.c_str());
+				ExitFatal(1);
+			}
+			break;
+		case EKind::SpellCast: {
+			// An unknown spell is never cast
+			const auto it = ranges::find_if(SpellTypeTable, [&](const auto &spell) { return spell->Ident == Name; });
+			Index = it == SpellTypeTable.end() ? -1 : (*it)->Slot;
+			break;
+		}
+		case EKind::AutoCast:
+			Index = SpellTypeByIdent(Name).Slot;
+			break;
+		case EKind::PlayerData:
+			Index = PlayerDataArgument(Prop, Name);
+			break;
+		default:
+			break;
+	}
+	Resolved = true;
+}
+
+/**
+**  Get the unit read by a variable or a bool flag operand.
+**
+**  @return  The unit, or null if the order has no such goal.
+*/
+const CUnit *CAnimOperand::GetGoal(const CUnit &unit) const
+{
+	switch (Goal) {
+		case EGoal::Self:
+			return &unit;
+		case EGoal::Target:
+			if (unit.CurrentOrder()->HasGoal()) {
+				return unit.CurrentOrder()->GetGoal();
+			} else if (unit.CurrentOrder()->Action == UnitAction::Build) {
+				return static_cast<const COrder_Build *>(unit.CurrentOrder())->GetBuildingUnit();
+			}
+			return nullptr;
+		case EGoal::OrderGoal:
+			return unit.CurrentOrder()->HasGoal() ? unit.CurrentOrder()->GetGoal() : nullptr;
+	}
+	return nullptr;
+}
+
+/**
+**  Evaluate the operand for a unit.
+**
+**  @param unit  Unit of the animation.
+**
+**  @return  The value.
+*/
+int CAnimOperand::Eval(const CUnit &unit) const
+{
+	if (!Resolved) {
+		Resolve();
+	}
+	switch (Kind) {
+		case EKind::Number:
+			return Value;
+		case EKind::Variable: {
+			const CUnit *goal = GetGoal(unit);
+			if (goal == nullptr) {
+				return 0;
+			}
+			const CVariable &var = goal->Variable[Index];
+			switch (Component) {
+				case EAnimVarComponent::Value: return var.Value;
+				case EAnimVarComponent::Max: return var.Max;
+				case EAnimVarComponent::Increase: return var.Increase;
+				case EAnimVarComponent::Enable: return var.Enable;
+				case EAnimVarComponent::Percent: return var.Value * 100 / var.Max;
+				case EAnimVarComponent::Unknown: return 0;
+			}
+			return 0;
+		}
+		case EKind::ResourcesHeld: {
+			const CUnit *goal = GetGoal(unit);
+			return goal ? goal->ResourcesHeld : 0;
+		}
+		case EKind::ResourceActive: {
+			const CUnit *goal = GetGoal(unit);
+			return goal ? goal->Resource.Active : 0;
+		}
+		case EKind::Distance: {
+			const CUnit *goal = GetGoal(unit);
+			return goal ? unit.MapDistanceTo(*goal) : 0;
+		}
+		case EKind::BoolFlag: {
+			const CUnit *goal = GetGoal(unit);
+			return goal ? goal->Type->BoolFlag[Index].value : 0;
+		}
+		case EKind::SpellCast: {
+			Assert(unit.CurrentAction() == UnitAction::SpellCast);
+			const COrder_SpellCast &order = *static_cast<COrder_SpellCast *>(unit.CurrentOrder());
+			return order.GetSpell().Slot == Index;
+		}
+		case EKind::AutoCast:
+			return unit.AutoCastSpell[Index] ? 1 : 0;
+		case EKind::PlayerData:
+			return GetPlayerData(Player->Eval(unit), Prop, Index);
+		case EKind::Random:
+			return Value + SyncRand(Max - Value + 1);
+		case EKind::PlayerNumber:
+			return Player->Eval(unit);
+		case EKind::ThisPlayer:
+			return unit.Player->Index;
+		case EKind::UnitSlot:
+			return UnitNumber(unit);
+		case EKind::GoalSlot:
+			if (unit.CurrentOrder()->HasGoal()) {
+				return UnitNumber(*unit.CurrentOrder()->GetGoal());
+			}
+			return 0;
+		case EKind::Rotation:
+			return unit.Anim.Rotate;
+		case EKind::RemainingWay:
+			return unit.pathFinderData->output.Length + 1 + unit.pathFinderData->output.OverflowLength;
+	}
+	return 0;
+}
+
+/**
+**  Parse integer in animation frame.
+**
+**  @param unit      Unit of the animation.
+**  @param s         Integer to parse, see CAnimOperand::Compile.
+**
+**  @return  The parsed value.
+*/
+int ParseAnimInt(const CUnit &unit, const std::string_view s)
+{
+	return CAnimOperand(s).Eval(unit);
 }
 
 /**
@@ -376,19 +536,64 @@ int UnitShowAnimationScaled(CUnit &unit, const std::vector<std::unique_ptr<CAnim
 		}
 		return 0;
 	}
+	if (unit.Anim.Program == nullptr || unit.Anim.Program->Source != unit.Anim.CurrAnim) {
+		unit.Anim.Program = &GetAnimProgram(*unit.Anim.CurrAnim);
+	}
 	int move = 0;
+	const CAnimOp *ops = unit.Anim.Program->Ops.data();
+	std::size_t size = unit.Anim.Program->Ops.size();
 	while (!unit.Anim.Wait) {
-		(*unit.Anim.CurrAnim)[unit.Anim.Anim]->Action(unit, move, scale);
+		const CAnimOp &op = ops[unit.Anim.Anim];
+		switch (op.Op) {
+			case EAnimOp::Nop:
+				break;
+			case EAnimOp::Frame:
+				UnitSetAnimFrame(unit, op.Arg);
+				break;
+			case EAnimOp::ExactFrame:
+				unit.Frame = op.Arg;
+				break;
+			case EAnimOp::Wait:
+				UnitSetAnimWait(unit, op.Arg, scale);
+				break;
+			case EAnimOp::Move:
+				Assert(!move);
+				move = op.Arg;
+				break;
+			case EAnimOp::Goto:
+				unit.Anim.Anim = op.Arg;
+				break;
+			case EAnimOp::Unbreakable:
+				Assert(unit.Anim.Unbreakable ^ op.Arg);
+				unit.Anim.Unbreakable = op.Arg;
+				break;
+			case EAnimOp::Call:
+				op.Animation->Action(unit, move, scale);
+				if (unit.Anim.CurrAnim != unit.Anim.Program->Source) {
+					// The step switched to another sequence
+					if (unit.Anim.CurrAnim == nullptr) {
+						return move;
+					}
+					unit.Anim.Program = &GetAnimProgram(*unit.Anim.CurrAnim);
+					ops = unit.Anim.Program->Ops.data();
+					size = unit.Anim.Program->Ops.size();
+				}
+				break;
+		}
 		if (!unit.Anim.Wait) {
 			// Advance to next frame
-			unit.Anim.Anim = (unit.Anim.Anim + 1) % unit.Anim.CurrAnim->size();
+			if (++unit.Anim.Anim == size) {
+				unit.Anim.Anim = 0;
+			}
 		}
 	}
 
 	--unit.Anim.Wait;
 	if (!unit.Anim.Wait) {
 		// Advance to next frame
-		unit.Anim.Anim = (unit.Anim.Anim + 1) % unit.Anim.CurrAnim->size();
+		if (++unit.Anim.Anim == size) {
+			unit.Anim.Anim = 0;
+		}
 	}
 	return move;
 }
@@ -413,6 +618,7 @@ CAnimations &AnimationsByIdent(std::string_view ident)
 
 void FreeAnimations()
 {
+	AnimationPrograms.clear();
 	AnimationMap.clear();
 	AnimationsArray.clear();
 }
@@ -615,6 +821,20 @@ static std::vector<std::unique_ptr<CAnimation>> ParseAnimation(lua_State *l, int
 	return animations;
 }
 
+/**
+**  Parse an animation sequence into an existing one.
+**
+**  A sequence already compiled is recompiled in place, so units keep
+**  valid CAnimProgram pointers when animations are redefined.
+*/
+static void ParseAnimation(lua_State *l, int idx, std::vector<std::unique_ptr<CAnimation>> &anims)
+{
+	anims = ParseAnimation(l, idx);
+	if (auto it = AnimationPrograms.find(&anims); it != AnimationPrograms.end()) {
+		it->second = CompileAnimProgram(anims);
+	}
+}
+
 /**
 **  Add animation to AnimationsArray
 */
@@ -649,42 +869,42 @@ static int CclDefineAnimations(lua_State *l)
 		const std::string_view value = LuaToString(l, -2);
 
 		if (value == "Start") {
-			anims->Start = ParseAnimation(l, -1);
+			ParseAnimation(l, -1, anims->Start);
 		} else if (starts_with(value, "Still")) {
-			anims->Still = ParseAnimation(l, -1);
+			ParseAnimation(l, -1, anims->Still);
 		} else if (starts_with(value, "Death")) {
 			anims->hasDeathAnimation = true;
 			if (value.size() > 5) {
 				const int death = ExtraDeathIndex(value.substr(6));
 				if (death == ANIMATIONS_DEATHTYPES) {
-					anims->Death[ANIMATIONS_DEATHTYPES] = ParseAnimation(l, -1);
+					ParseAnimation(l, -1, anims->Death[ANIMATIONS_DEATHTYPES]);
 				} else {
-					anims->Death[death] = ParseAnimation(l, -1);
+					ParseAnimation(l, -1, anims->Death[death]);
 				}
 			} else {
-				anims->Death[ANIMATIONS_DEATHTYPES] = ParseAnimation(l, -1);
+				ParseAnimation(l, -1, anims->Death[ANIMATIONS_DEATHTYPES]);
 			}
 		} else if (value == "Attack") {
-			anims->Attack = ParseAnimation(l, -1);
+			ParseAnimation(l, -1, anims->Attack);
 		} else if (value == "RangedAttack") {
-			anims->RangedAttack = ParseAnimation(l, -1);
+			ParseAnimation(l, -1, anims->RangedAttack);
 		} else if (value == "SpellCast") {
-			anims->SpellCast = ParseAnimation(l, -1);
+			ParseAnimation(l, -1, anims->SpellCast);
 		} else if (value == "Move") {
-			anims->Move = ParseAnimation(l, -1);
+			ParseAnimation(l, -1, anims->Move);
 		} else if (value == "Repair") {
-			anims->Repair = ParseAnimation(l, -1);
+			ParseAnimation(l, -1, anims->Repair);
 		} else if (value == "Train") {
-			anims->Train = ParseAnimation(l, -1);
+			ParseAnimation(l, -1, anims->Train);
 		} else if (value == "Research") {
-			anims->Research = ParseAnimation(l, -1);
+			ParseAnimation(l, -1, anims->Research);
 		} else if (value == "Upgrade") {
-			anims->Upgrade = ParseAnimation(l, -1);
+			ParseAnimation(l, -1, anims->Upgrade);
 		} else if (value == "Build") {
-			anims->Build = ParseAnimation(l, -1);
+			ParseAnimation(l, -1, anims->Build);
 		} else if (starts_with(value, "Harvest_")) {
 			const int res = GetResourceIdByName(l, value.substr(8));
-			anims->Harvest[res] = ParseAnimation(l, -1);
+			ParseAnimation(l, -1, anims->Harvest[res]);
 		} else {
 			LuaError(l, "Unsupported animation: %s", value.data());
 		}
@@ -46,9 +46,17 @@ void CAnimation_ExactFrame::Action(CUnit &unit, int & /*move*/, int /*scale*/) c
 	unit.Frame = ParseAnimInt(&unit);
 }
 
+CAnimOp CAnimation_ExactFrame::Compile() const /* override */
+{
+	if (this->frame.IsConstant()) {
+		return {EAnimOp::ExactFrame, this->frame.GetConstant(), this};
+	}
+	return CAnimation::Compile();
+}
+
 void CAnimation_ExactFrame::Init(std::string_view s, lua_State *) /* override */
 {
-	this->frame = s;
+	this->frame.Compile(s);
 }
 
 std::optional<int> CAnimation_ExactFrame::GetStillFrame(const CUnitType &type) /* override */
@@ -59,9 +67,9 @@ std::optional<int> CAnimation_ExactFrame::GetStillFrame(const CUnitType &type) /
 int CAnimation_ExactFrame::ParseAnimInt(const CUnit *unit) const
 {
 	if (unit == nullptr) {
-		return to_number(this->frame);
+		return to_number(this->frame.GetText());
 	} else {
-		return ::ParseAnimInt(*unit, this->frame);
+		return this->frame.Eval(*unit);
 	}
 }
 
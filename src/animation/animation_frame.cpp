@@ -40,20 +40,38 @@
 #include "ui.h"
 #include "unit.h"
 
-void CAnimation_Frame::Action(CUnit &unit, int &/*move*/, int /*scale*/) const /* override */
+/**
+**  Set the frame of the unit animation.
+**
+**  Mirrored fancy buildings keep their frame.
+*/
+void UnitSetAnimFrame(CUnit &unit, int frame)
 {
-	Assert(unit.Anim.CurrAnim);
-	Assert((*unit.Anim.CurrAnim)[unit.Anim.Anim].get() == this);
 	if (unit.Type->Building && unit.Type->NumDirections == 1 && FancyBuildings && unit.Type->BoolFlag[NORANDOMPLACING_INDEX].value == false && unit.Frame < 0) {
 	} else {
-		unit.Frame = ParseAnimInt(&unit);
+		unit.Frame = frame;
 	}
 	UnitUpdateHeading(unit);
 }
 
+void CAnimation_Frame::Action(CUnit &unit, int &/*move*/, int /*scale*/) const /* override */
+{
+	Assert(unit.Anim.CurrAnim);
+	Assert((*unit.Anim.CurrAnim)[unit.Anim.Anim].get() == this);
+	UnitSetAnimFrame(unit, ParseAnimInt(&unit));
+}
+
+CAnimOp CAnimation_Frame::Compile() const /* override */
+{
+	if (this->frame.IsConstant()) {
+		return {EAnimOp::Frame, this->frame.GetConstant(), this};
+	}
+	return CAnimation::Compile();
+}
+
 void CAnimation_Frame::Init(std::string_view s, lua_State *) /* override */
 {
-	this->frame = s;
+	this->frame.Compile(s);
 }
 
 std::optional<int> CAnimation_Frame::GetStillFrame(const CUnitType &type) /* override */
@@ -64,9 +82,9 @@ std::optional<int> CAnimation_Frame::GetStillFrame(const CUnitType &type) /* ove
 int CAnimation_Frame::ParseAnimInt(const CUnit *unit) const
 {
 	if (unit == nullptr) {
-		return to_number(this->frame);
+		return to_number(this->frame.GetText());
 	} else {
-		return ::ParseAnimInt(*unit, this->frame);
+		return this->frame.Eval(*unit);
 	}
 }
 
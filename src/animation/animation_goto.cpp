@@ -47,6 +47,11 @@ void CAnimation_Goto::Action(CUnit &unit, int & /*move*/, int /*scale*/) const /
 	unit.Anim.Anim = this->gotoLabel;
 }
 
+CAnimOp CAnimation_Goto::Compile() const /* override */
+{
+	return {EAnimOp::Goto, static_cast<int>(this->gotoLabel), this};
+}
+
 void CAnimation_Goto::Init(std::string_view s, lua_State *) /* override */
 {
 	FindLabelLater(&this->gotoLabel, std::string(s));
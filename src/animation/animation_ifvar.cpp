@@ -72,8 +72,8 @@ void CAnimation_IfVar::Action(CUnit &unit, int & /*move*/, int /*scale*/) const
 	Assert(unit.Anim.CurrAnim);
 	Assert((*unit.Anim.CurrAnim)[unit.Anim.Anim].get() == this);
 
-	const int lop = ParseAnimInt(unit, this->leftVar);
-	const int rop = ParseAnimInt(unit, this->rightVar);
+	const int lop = this->leftVar.Eval(unit);
+	const int rop = this->rightVar.Eval(unit);
 	const bool cond = this->binOpFunc(lop, rop);
 
 	if (cond) {
@@ -88,9 +88,13 @@ void CAnimation_IfVar::Init(std::string_view s, lua_State *) /* override */
 {
 	std::stringstream is{std::string(s)};
 
+	std::string leftStr;
 	std::string op;
+	std::string rightStr;
 	std::string label;
-	is >> this->leftVar >> op >> this->rightVar >> label;
+	is >> leftStr >> op >> rightStr >> label;
+	this->leftVar.Compile(leftStr);
+	this->rightVar.Compile(rightStr);
 
 	if (op == ">=") {
 		this->binOpFunc = binOpGreaterEqual;
@@ -45,6 +45,11 @@ void CAnimation_Label::Action(CUnit &unit, int & /*move*/, int /*scale*/) const
 	Assert((*unit.Anim.CurrAnim)[unit.Anim.Anim].get() == this);
 }
 
+CAnimOp CAnimation_Label::Compile() const /* override */
+{
+	return {EAnimOp::Nop, 0, this};
+}
+
 void CAnimation_Label::Init(std::string_view s, lua_State *) /* override */
 {
 	name = s;
@@ -40,7 +40,6 @@
 #include "script.h"
 #include "unit.h"
 
-#include <iterator>
 #include <sstream>
 
 void CAnimation_LuaCallback::Action(CUnit &unit, int & /*move*/, int /*scale*/) const /* override */
@@ -50,9 +49,8 @@ void CAnimation_LuaCallback::Action(CUnit &unit, int & /*move*/, int /*scale*/)
 	Assert(cb);
 
 	cb.pushPreamble();
-	for (const std::string &str : cbArgs) {
-		const int arg = ParseAnimInt(unit, str);
-		cb.pushInteger(arg);
+	for (const CAnimOperand &op : cbArgs) {
+		cb.pushInteger(op.Eval(unit));
 	}
 	cb.run();
 }
@@ -74,9 +72,10 @@ void CAnimation_LuaCallback::Init(std::string_view s, lua_State *l) /* override
 	}
 
 	std::istringstream iss{std::string(s.substr(space_pos + 1))};
-	std::copy(std::istream_iterator<std::string>(iss),
-	          std::istream_iterator<std::string>(),
-	          std::back_inserter(this->cbArgs));
+	std::string arg;
+	while (iss >> arg) {
+		this->cbArgs.emplace_back(arg);
+	}
 }
 
 //@}
@@ -45,12 +45,20 @@ void CAnimation_Move::Action(CUnit &unit, int &move, int /*scale*/) const /* ove
 	Assert((*unit.Anim.CurrAnim)[unit.Anim.Anim].get() == this);
 	Assert(!move);
 
-	move = ParseAnimInt(unit, this->moveStr);
+	move = this->move.Eval(unit);
+}
+
+CAnimOp CAnimation_Move::Compile() const /* override */
+{
+	if (this->move.IsConstant()) {
+		return {EAnimOp::Move, this->move.GetConstant(), this};
+	}
+	return CAnimation::Compile();
 }
 
 void CAnimation_Move::Init(std::string_view s, lua_State *) /* override */
 {
-	this->moveStr = s;
+	this->move.Compile(s);
 }
 
 //@}
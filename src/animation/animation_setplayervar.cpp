@@ -40,8 +40,117 @@
 #include "unit.h"
 
 #include <cstdio>
+#include <map>
 #include <sstream>
 
+/**
+**  Get the player property from its name.
+**
+**  @param prop  Name of the property.
+**
+**  @return  The property, EPlayerData::Invalid if unknown.
+*/
+EPlayerData PlayerDataByName(std::string_view prop)
+{
+	static const std::map<std::string_view, EPlayerData> names = {
+		{"RaceName", EPlayerData::RaceName},
+		{"Resources", EPlayerData::Resources},
+		{"StoredResources", EPlayerData::StoredResources},
+		{"MaxResources", EPlayerData::MaxResources},
+		{"Incomes", EPlayerData::Incomes},
+		{"UnitTypesCount", EPlayerData::UnitTypesCount},
+		{"UnitTypesAiActiveCount", EPlayerData::UnitTypesAiActiveCount},
+		{"AiEnabled", EPlayerData::AiEnabled},
+		{"TotalNumUnits", EPlayerData::TotalNumUnits},
+		{"NumBuildings", EPlayerData::NumBuildings},
+		{"Supply", EPlayerData::Supply},
+		{"Demand", EPlayerData::Demand},
+		{"UnitLimit", EPlayerData::UnitLimit},
+		{"BuildingLimit", EPlayerData::BuildingLimit},
+		{"TotalUnitLimit", EPlayerData::TotalUnitLimit},
+		{"Score", EPlayerData::Score},
+		{"TotalUnits", EPlayerData::TotalUnits},
+		{"TotalBuildings", EPlayerData::TotalBuildings},
+		{"TotalResources", EPlayerData::TotalResources},
+		{"TotalRazings", EPlayerData::TotalRazings},
+		{"TotalKills", EPlayerData::TotalKills}};
+	const auto it = names.find(prop);
+	return it == names.end() ? EPlayerData::Invalid : it->second;
+}
+
+/**
+**  Resolve the additional argument of a player property.
+**
+**  @param prop  Player's property.
+**  @param arg   Resource name or unit type ident, ignored by the other properties.
+**
+**  @return  Resource index or unit type slot, 0 if the property has no argument.
+*/
+int PlayerDataArgument(EPlayerData prop, std::string_view arg)
+{
+	switch (prop) {
+		case EPlayerData::Resources:
+		case EPlayerData::StoredResources:
+		case EPlayerData::MaxResources:
+		case EPlayerData::Incomes:
+		case EPlayerData::TotalResources: {
+			const int resId = GetResourceIdByName(arg);
+			if (resId == -1) {
+				ErrorPrint("Invalid resource \"%s\"", arg.data());
+				Exit(1);
+			}
+			return resId;
+		}
+		case EPlayerData::UnitTypesCount:
+		case EPlayerData::UnitTypesAiActiveCount:
+			return UnitTypeByIdent(arg).Slot;
+		default:
+			return 0;
+	}
+}
+
+/**
+**  Gets the player data.
+**
+**  @param player  Player number.
+**  @param prop    Player's property.
+**  @param arg     Resolved additional argument (see PlayerDataArgument).
+**
+**  @return  Returning value (only integer).
+*/
+int GetPlayerData(int player, EPlayerData prop, int arg)
+{
+	const CPlayer &p = Players[player];
+
+	switch (prop) {
+		case EPlayerData::RaceName: return p.Race;
+		case EPlayerData::Resources: return p.Resources[arg] + p.StoredResources[arg];
+		case EPlayerData::StoredResources: return p.StoredResources[arg];
+		case EPlayerData::MaxResources: return p.MaxResources[arg];
+		case EPlayerData::Incomes: return p.Incomes[arg];
+		case EPlayerData::UnitTypesCount: return p.UnitTypesCount[arg];
+		case EPlayerData::UnitTypesAiActiveCount: return p.UnitTypesAiActiveCount[arg];
+		case EPlayerData::AiEnabled: return p.AiEnabled;
+		case EPlayerData::TotalNumUnits: return p.GetUnitCount();
+		case EPlayerData::NumBuildings: return p.NumBuildings;
+		case EPlayerData::Supply: return p.Supply;
+		case EPlayerData::Demand: return p.Demand;
+		case EPlayerData::UnitLimit: return p.UnitLimit;
+		case EPlayerData::BuildingLimit: return p.BuildingLimit;
+		case EPlayerData::TotalUnitLimit: return p.TotalUnitLimit;
+		case EPlayerData::Score: return p.Score;
+		case EPlayerData::TotalUnits: return p.TotalUnits;
+		case EPlayerData::TotalBuildings: return p.TotalBuildings;
+		case EPlayerData::TotalResources: return p.TotalResources[arg];
+		case EPlayerData::TotalRazings: return p.TotalRazings;
+		case EPlayerData::TotalKills: return p.TotalKills;
+		case EPlayerData::Invalid: break;
+	}
+	ErrorPrint("Invalid player field\n");
+	Exit(1);
+	return 0;
+}
+
 /**
 **  Gets the player data.
 **
@@ -53,127 +162,37 @@
 */
 int GetPlayerData(int player, std::string_view prop, std::string_view arg)
 {
-	if (prop == "RaceName") {
-		return Players[player].Race;
-	} else if (prop == "Resources") {
-		const int resId = GetResourceIdByName(arg);
-		if (resId == -1) {
-			ErrorPrint("Invalid resource \"%s\"", arg.data());
-			Exit(1);
-		}
-		return Players[player].Resources[resId] + Players[player].StoredResources[resId];
-	} else if (prop == "StoredResources") {
-		const int resId = GetResourceIdByName(arg);
-		if (resId == -1) {
-			ErrorPrint("Invalid resource \"%s\"", arg.data());
-			Exit(1);
-		}
-		return Players[player].StoredResources[resId];
-	} else if (prop == "MaxResources") {
-		const int resId = GetResourceIdByName(arg);
-		if (resId == -1) {
-			ErrorPrint("Invalid resource \"%s\"", arg.data());
-			Exit(1);
-		}
-		return Players[player].MaxResources[resId];
-	} else if (prop == "Incomes") {
-		const int resId = GetResourceIdByName(arg);
-		if (resId == -1) {
-			ErrorPrint("Invalid resource \"%s\"", arg.data());
-			Exit(1);
-		}
-		return Players[player].Incomes[resId];
-	} else if (prop == "UnitTypesCount") {
-		return Players[player].UnitTypesCount[UnitTypeByIdent(arg).Slot];
-	} else if (prop == "UnitTypesAiActiveCount") {
-		return Players[player].UnitTypesAiActiveCount[UnitTypeByIdent(arg).Slot];
-	} else if (prop == "AiEnabled") {
-		return Players[player].AiEnabled;
-	} else if (prop == "TotalNumUnits") {
-		return Players[player].GetUnitCount();
-	} else if (prop == "NumBuildings") {
-		return Players[player].NumBuildings;
-	} else if (prop == "Supply") {
-		return Players[player].Supply;
-	} else if (prop == "Demand") {
-		return Players[player].Demand;
-	} else if (prop == "UnitLimit") {
-		return Players[player].UnitLimit;
-	} else if (prop == "BuildingLimit") {
-		return Players[player].BuildingLimit;
-	} else if (prop == "TotalUnitLimit") {
-		return Players[player].TotalUnitLimit;
-	} else if (prop == "Score") {
-		return Players[player].Score;
-	} else if (prop == "TotalUnits") {
-		return Players[player].TotalUnits;
-	} else if (prop == "TotalBuildings") {
-		return Players[player].TotalBuildings;
-	} else if (prop == "TotalResources") {
-		const int resId = GetResourceIdByName(arg);
-		if (resId == -1) {
-			ErrorPrint("Invalid resource \"%s\"", arg.data());
-			Exit(1);
-		}
-		return Players[player].TotalResources[resId];
-	} else if (prop == "TotalRazings") {
-		return Players[player].TotalRazings;
-	} else if (prop == "TotalKills") {
-		return Players[player].TotalKills;
-	} else {
+	const EPlayerData data = PlayerDataByName(prop);
+	if (data == EPlayerData::Invalid) {
 		ErrorPrint("Invalid field: %s", prop.data());
 		Exit(1);
 	}
-	return 0;
+	return GetPlayerData(player, data, PlayerDataArgument(data, arg));
 }
 
 /**
 **  Sets the player data.
 */
-static void SetPlayerData(const int player, std::string_view prop, std::string_view arg, int value)
+static void SetPlayerData(const int player, EPlayerData prop, int arg, int value)
 {
-	if (prop == "RaceName") {
-		Players[player].Race = value;
-	} else if (prop == "Resources") {
-		const int resId = GetResourceIdByName(arg);
-		if (resId == -1) {
-			ErrorPrint("Invalid resource \"%s\"", arg.data());
-			Exit(1);
-		}
-		Players[player].SetResource(resId, value, EStoreType::Both);
-	} else if (prop == "StoredResources") {
-		const int resId = GetResourceIdByName(arg);
-		if (resId == -1) {
-			ErrorPrint("Invalid resource \"%s\"", arg.data());
-			Exit(1);
-		}
-		Players[player].SetResource(resId, value, EStoreType::Building);
-	} else if (prop == "UnitLimit") {
-		Players[player].UnitLimit = value;
-	} else if (prop == "BuildingLimit") {
-		Players[player].BuildingLimit = value;
-	} else if (prop == "TotalUnitLimit") {
-		Players[player].TotalUnitLimit = value;
-	} else if (prop == "Score") {
-		Players[player].Score = value;
-	} else if (prop == "TotalUnits") {
-		Players[player].TotalUnits = value;
-	} else if (prop == "TotalBuildings") {
-		Players[player].TotalBuildings = value;
-	} else if (prop == "TotalResources") {
-		const int resId = GetResourceIdByName(arg);
-		if (resId == -1) {
-			ErrorPrint("Invalid resource \"%s\"", arg.data());
+	CPlayer &p = Players[player];
+
+	switch (prop) {
+		case EPlayerData::RaceName: p.Race = value; break;
+		case EPlayerData::Resources: p.SetResource(arg, value, EStoreType::Both); break;
+		case EPlayerData::StoredResources: p.SetResource(arg, value, EStoreType::Building); break;
+		case EPlayerData::UnitLimit: p.UnitLimit = value; break;
+		case EPlayerData::BuildingLimit: p.BuildingLimit = value; break;
+		case EPlayerData::TotalUnitLimit: p.TotalUnitLimit = value; break;
+		case EPlayerData::Score: p.Score = value; break;
+		case EPlayerData::TotalUnits: p.TotalUnits = value; break;
+		case EPlayerData::TotalBuildings: p.TotalBuildings = value; break;
+		case EPlayerData::TotalResources: p.TotalResources[arg] = value; break;
+		case EPlayerData::TotalRazings: p.TotalRazings = value; break;
+		case EPlayerData::TotalKills: p.TotalKills = value; break;
+		default:
+			ErrorPrint("Player field %d can't be set\n", static_cast<int>(prop));
 			Exit(1);
-		}
-		Players[player].TotalResources[resId] = value;
-	} else if (prop == "TotalRazings") {
-		Players[player].TotalRazings = value;
-	} else if (prop == "TotalKills") {
-		Players[player].TotalKills = value;
-	} else {
-		ErrorPrint("Invalid field: %s", prop.data());
-		Exit(1);
 	}
 }
 
@@ -184,12 +203,20 @@ void CAnimation_SetPlayerVar::Action(CUnit &unit,
 	Assert(unit.Anim.CurrAnim);
 	Assert((*unit.Anim.CurrAnim)[unit.Anim.Anim].get() == this);
 
-	const int playerId = ParseAnimInt(unit, this->playerStr);
-	const int rop = ParseAnimInt(unit, this->valueStr);
-	int data = GetPlayerData(playerId, this->varStr, this->argStr);
+	if (this->var == EPlayerData::Invalid) {
+		ErrorPrint("Invalid field: %s", this->varStr.c_str());
+		Exit(1);
+		return;
+	}
+	if (this->argIndex == -1) {
+		this->argIndex = PlayerDataArgument(this->var, this->argStr);
+	}
+	const int playerId = this->player.Eval(unit);
+	const int rop = this->value.Eval(unit);
+	int data = GetPlayerData(playerId, this->var, this->argIndex);
 
 	modifyValue(this->mod, data, rop);
-	SetPlayerData(playerId, this->varStr, this->argStr, data);
+	SetPlayerData(playerId, this->var, this->argIndex, data);
 }
 
 /*
@@ -199,9 +226,19 @@ void CAnimation_SetPlayerVar::Init(std::string_view s, lua_State *) /* override
 {
 	std::istringstream is{std::string(s)};
 
+	std::string playerStr;
+	std::string varStr;
 	std::string modStr;
-	is >> this->playerStr >> this->varStr >> modStr >> this->valueStr >> this->argStr;
+	std::string valueStr;
+	is >> playerStr >> varStr >> modStr >> valueStr >> this->argStr;
+	this->player.Compile(playerStr);
+	this->var = PlayerDataByName(varStr);
+	if (this->var == EPlayerData::Invalid) {
+		// Reported when the animation is played
+		this->varStr = varStr;
+	}
 	this->mod = toSetVar_ModifyTypes(modStr);
+	this->value.Compile(valueStr);
 }
 
 //@}
@@ -49,78 +49,81 @@ void CAnimation_SetVar::Action(CUnit &unit, int & /*move*/, int /*scale*/) const
 	Assert((*unit.Anim.CurrAnim)[unit.Anim.Anim].get() == this);
 
 	CUnit *goal = &unit;
-	if (this->unitSlotStr.empty() == false) {
-		switch (this->unitSlotStr[0]) {
-			case 'l': // last created unit
-				goal = UnitManager->lastCreatedUnit();
-				break;
-			case 't': // target unit
-				goal = unit.CurrentOrder()->GetGoal();
-				break;
-			case 's': // unit self (no use)
-				goal = &unit;
-				break;
-		}
+	switch (this->unitSlot) {
+		case EUnitSlot::LastCreated:
+			goal = UnitManager->lastCreatedUnit();
+			break;
+		case EUnitSlot::Target:
+			goal = unit.CurrentOrder()->GetGoal();
+			break;
+		case EUnitSlot::Self:
+			break;
 	}
 	if (!goal) {
 		return;
 	}
-	auto dot_pos = this->varStr.find('.');
-	auto arg1 = std::string_view{this->varStr.c_str(), dot_pos};
-	if (dot_pos == std::string_view::npos) {
-		// Special case for non-CVariable variables
-		if (arg1 == "DamageType") {
-			int death = ExtraDeathIndex(this->valueStr);
-			if (death == ANIMATIONS_DEATHTYPES) {
-				ErrorPrint("Incorrect death type: %s\n", this->valueStr.c_str());
+	// Special case for non-CVariable variables
+	if (this->isDamageType) {
+		if (!this->damageTypeChecked) {
+			if (ExtraDeathIndex(this->damageType) == ANIMATIONS_DEATHTYPES) {
+				ErrorPrint("Incorrect death type: %s\n", this->damageType.c_str());
 				Exit(1);
 				return;
 			}
-			goal->Type->DamageType = this->valueStr;
-			return;
+			this->damageTypeChecked = true;
 		}
-		ErrorPrint("Need also specify the variable '%s' tag\n", arg1.data());
-		Exit(1);
+		goal->Type->DamageType = this->damageType;
 		return;
 	}
-	const int index = UnitTypeVar.VariableNameLookup[arg1];// User variables
-	if (index == -1) {
-		ErrorPrint("Bad variable name '%s'\n", arg1.data());
-		Exit(1);
-		return;
+	if (this->index == -1) {
+		// User variables may be defined after the animations
+		this->index = UnitTypeVar.VariableNameLookup[this->varName];
+		if (this->index == -1) {
+			ErrorPrint("Bad variable name '%s'\n", this->varName.c_str());
+			Exit(1);
+			return;
+		}
 	}
 
-	const int rop = ParseAnimInt(unit, this->valueStr);
-	const auto next = std::string_view{this->varStr.c_str() + dot_pos + 1};
+	const int rop = this->value.Eval(unit);
+	CVariable &var = goal->Variable[this->index];
 	int value = 0;
-	if (next == "Value") {
-		value = goal->Variable[index].Value;
-		modifyValue(this->mod, value, rop);
-		goal->Variable[index].Value = value;
-	} else if (next == "Max") {
-		value = goal->Variable[index].Max;
-		modifyValue(this->mod, value, rop);
-		goal->Variable[index].Max = value;
-		// Special case: when adjusting the sight range, we need to update the visibility
-		if (index == SIGHTRANGE_INDEX) {
-			MapUnmarkUnitSight(unit);
-			unit.CurrentSightRange = value;
-			MapMarkUnitSight(unit);
-		}
-	} else if (next == "Increase") {
-		value = goal->Variable[index].Increase;
-		modifyValue(this->mod, value, rop);
-		goal->Variable[index].Increase = value;
-	} else if (next == "Enable") {
-		value = goal->Variable[index].Enable;
-		modifyValue(this->mod, value, rop);
-		goal->Variable[index].Enable = value;
-	} else if (next == "Percent") {
-		value = goal->Variable[index].Value * 100 / goal->Variable[index].Max;
-		modifyValue(this->mod, value, rop);
-		goal->Variable[index].Value = goal->Variable[index].Max * value / 100;
+	switch (this->component) {
+		case EAnimVarComponent::Value:
+			value = var.Value;
+			modifyValue(this->mod, value, rop);
+			var.Value = value;
+			break;
+		case EAnimVarComponent::Max:
+			value = var.Max;
+			modifyValue(this->mod, value, rop);
+			var.Max = value;
+			// Special case: when adjusting the sight range, we need to update the visibility
+			if (this->index == SIGHTRANGE_INDEX) {
+				MapUnmarkUnitSight(unit);
+				unit.CurrentSightRange = value;
+				MapMarkUnitSight(unit);
+			}
+			break;
+		case EAnimVarComponent::Increase:
+			value = var.Increase;
+			modifyValue(this->mod, value, rop);
+			var.Increase = value;
+			break;
+		case EAnimVarComponent::Enable:
+			value = var.Enable;
+			modifyValue(this->mod, value, rop);
+			var.Enable = value;
+			break;
+		case EAnimVarComponent::Percent:
+			value = var.Value * 100 / var.Max;
+			modifyValue(this->mod, value, rop);
+			var.Value = var.Max * value / 100;
+			break;
+		case EAnimVarComponent::Unknown:
+			break;
 	}
-	clamp(&goal->Variable[index].Value, 0, goal->Variable[index].Max);
+	clamp(&var.Value, 0, var.Max);
 }
 
 /*
@@ -130,9 +133,40 @@ void CAnimation_SetVar::Init(std::string_view s, lua_State *) /* override */
 {
 	std::istringstream is{std::string(s)};
 
+	std::string varStr;
 	std::string modStr;
-	is >> this->varStr >> modStr >> this->valueStr >> this->unitSlotStr;
+	std::string valueStr;
+	std::string unitSlotStr;
+	is >> varStr >> modStr >> valueStr >> unitSlotStr;
 	this->mod = toSetVar_ModifyTypes(modStr);
+
+	switch (unitSlotStr.empty() ? 's' : unitSlotStr[0]) {
+		case 'l': // last created unit
+			this->unitSlot = EUnitSlot::LastCreated;
+			break;
+		case 't': // target unit
+			this->unitSlot = EUnitSlot::Target;
+			break;
+		default: // unit self
+			this->unitSlot = EUnitSlot::Self;
+			break;
+	}
+
+	const auto dot_pos = varStr.find('.');
+	if (dot_pos == std::string::npos) {
+		if (varStr == "DamageType") {
+			// Extra death types may be defined after the animations
+			this->isDamageType = true;
+			this->damageType = valueStr;
+			return;
+		}
+		ErrorPrint("Need also specify the variable '%s' tag\n", varStr.c_str());
+		ExitFatal(1);
+	}
+	this->varName = varStr.substr(0, dot_pos);
+	this->index = UnitTypeVar.VariableNameLookup[this->varName];
+	this->component = toAnimVarComponent(std::string_view(varStr).substr(dot_pos + 1));
+	this->value.Compile(valueStr);
 }
 
 //@}
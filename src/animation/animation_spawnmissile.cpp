@@ -103,12 +103,12 @@ void CAnimation_SpawnMissile::Action(CUnit &unit, int &/*move*/, int /*scale*/)
 	Assert(unit.Anim.CurrAnim);
 	Assert((*unit.Anim.CurrAnim)[unit.Anim.Anim].get() == this);
 
-	const int startx = ParseAnimInt(unit, this->startXStr);
-	const int starty = ParseAnimInt(unit, this->startYStr);
-	const int destx = ParseAnimInt(unit, this->destXStr);
-	const int desty = ParseAnimInt(unit, this->destYStr);
-	const SpawnMissile_Flags flags = ParseAnimFlags(this->flagsStr);
-	const int offsetnum = ParseAnimInt(unit, this->offsetNumStr);
+	const int startx = this->startX.Eval(unit);
+	const int starty = this->startY.Eval(unit);
+	const int destx = this->destX.Eval(unit);
+	const int desty = this->destY.Eval(unit);
+	const auto flags = static_cast<SpawnMissile_Flags>(this->flags);
+	const int offsetnum = this->offsetNum.Eval(unit);
 	const CUnit *goal = flags & SM_RelTarget ? unit.CurrentOrder()->GetGoal() : &unit;
 	if (!goal || goal->Destroyed) {
 		return;
@@ -120,7 +120,11 @@ void CAnimation_SpawnMissile::Action(CUnit &unit, int &/*move*/, int /*scale*/)
 	if (this->missileTypeStr.empty()) {
 		return;
 	}
-	MissileType &mtype = MissileTypeByIdent(this->missileTypeStr);
+	if (this->missileType == nullptr) {
+		// Missile types may be defined after the animations
+		this->missileType = &MissileTypeByIdent(this->missileTypeStr);
+	}
+	MissileType &mtype = *this->missileType;
 	if ((flags & SM_Pixel)) {
 		start.x = goal->tilePos.x * PixelTileSize.x + goal->IX + moff.x + startx;
 		start.y = goal->tilePos.y * PixelTileSize.y + goal->IY + moff.y + starty;
@@ -201,8 +205,20 @@ void CAnimation_SpawnMissile::Init(std::string_view s, lua_State *) /* override
 {
 	std::istringstream is{std::string(s)};
 
-	is >> this->missileTypeStr >> this->startXStr >> this->startYStr >> this->destXStr
-		>> this->destYStr >> this->flagsStr >> this->offsetNumStr;
+	std::string startXStr;
+	std::string startYStr;
+	std::string destXStr;
+	std::string destYStr;
+	std::string flagsStr;
+	std::string offsetNumStr;
+	is >> this->missileTypeStr >> startXStr >> startYStr >> destXStr >> destYStr >> flagsStr
+		>> offsetNumStr;
+	this->startX.Compile(startXStr);
+	this->startY.Compile(startYStr);
+	this->destX.Compile(destXStr);
+	this->destY.Compile(destYStr);
+	this->flags = ParseAnimFlags(flagsStr);
+	this->offsetNum.Compile(offsetNumStr);
 }
 
 //@}
@@ -86,15 +86,19 @@ void CAnimation_SpawnUnit::Action(CUnit &unit, int & /*move*/, int /*scale*/) co
 	Assert(unit.Anim.CurrAnim);
 	Assert((*unit.Anim.CurrAnim)[unit.Anim.Anim].get() == this);
 
-	const int offX = ParseAnimInt(unit, this->offXStr);
-	const int offY = ParseAnimInt(unit, this->offYStr);
-	const int range = ParseAnimInt(unit, this->rangeStr);
-	const int playerId = ParseAnimInt(unit, this->playerStr);
-	const SpawnUnit_Flags flags = ParseAnimFlags(this->flagsStr);
+	const int offX = this->offX.Eval(unit);
+	const int offY = this->offY.Eval(unit);
+	const int range = this->range.Eval(unit);
+	const int playerId = this->player.Eval(unit);
+	const auto flags = static_cast<SpawnUnit_Flags>(this->flags);
 
 	CPlayer &player = Players[playerId];
 	const Vec2i pos(unit.tilePos.x + offX, unit.tilePos.y + offY);
-	CUnitType &type = UnitTypeByIdent(this->unitTypeStr);
+	if (this->unitType == nullptr) {
+		// Unit types are defined after the animations
+		this->unitType = &UnitTypeByIdent(this->unitTypeStr);
+	}
+	CUnitType &type = *this->unitType;
 	Vec2i resPos;
 	DebugPrint("Creating a %s\n", type.Name.c_str());
 	FindNearestDrop(type, pos, resPos, LookingW);
@@ -126,8 +130,17 @@ void CAnimation_SpawnUnit::Action(CUnit &unit, int & /*move*/, int /*scale*/) co
 void CAnimation_SpawnUnit::Init(std::string_view s, lua_State *) /* override */
 {
 	std::istringstream is{std::string(s)};
-	is >> this->unitTypeStr >> this->offXStr >> this->offYStr >> this->rangeStr >> this->playerStr
-		>> this->flagsStr;
+	std::string offXStr;
+	std::string offYStr;
+	std::string rangeStr;
+	std::string playerStr;
+	std::string flagsStr;
+	is >> this->unitTypeStr >> offXStr >> offYStr >> rangeStr >> playerStr >> flagsStr;
+	this->offX.Compile(offXStr);
+	this->offY.Compile(offYStr);
+	this->range.Compile(rangeStr);
+	this->player.Compile(playerStr);
+	this->flags = ParseAnimFlags(flagsStr);
 }
 
 //@}
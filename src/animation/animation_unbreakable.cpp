@@ -48,6 +48,11 @@ void CAnimation_Unbreakable::Action(CUnit &unit, int & /*move*/, int /*scale*/)
 	unit.Anim.Unbreakable = this->state;
 }
 
+CAnimOp CAnimation_Unbreakable::Compile() const /* override */
+{
+	return {EAnimOp::Unbreakable, this->state, this};
+}
+
 void CAnimation_Unbreakable::Init(std::string_view s, lua_State *) /* override */
 {
 	if (s == "begin") {
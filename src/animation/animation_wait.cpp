@@ -39,11 +39,16 @@
 
 #include "unit.h"
 
-void CAnimation_Wait::Action(CUnit &unit, int & /*move*/, int scale) const /* override */
+/**
+**  Set the wait time of the unit animation.
+**
+**  @param unit   Animated unit.
+**  @param wait   Wait time of the animation step.
+**  @param scale  Scale of the animation (8 is unscaled).
+*/
+void UnitSetAnimWait(CUnit &unit, int wait, int scale)
 {
-	Assert(unit.Anim.CurrAnim);
-	Assert((*unit.Anim.CurrAnim)[unit.Anim.Anim].get() == this);
-	unit.Anim.Wait = ParseAnimInt(unit, this->wait) << scale >> 8;
+	unit.Anim.Wait = wait << scale >> 8;
 	if (unit.Variable[SLOW_INDEX].Value) { // unit is slowed down
 		unit.Anim.Wait <<= 1;
 	}
@@ -55,9 +60,24 @@ void CAnimation_Wait::Action(CUnit &unit, int & /*move*/, int scale) const /* ov
 	}
 }
 
+void CAnimation_Wait::Action(CUnit &unit, int & /*move*/, int scale) const /* override */
+{
+	Assert(unit.Anim.CurrAnim);
+	Assert((*unit.Anim.CurrAnim)[unit.Anim.Anim].get() == this);
+	UnitSetAnimWait(unit, this->wait.Eval(unit), scale);
+}
+
+CAnimOp CAnimation_Wait::Compile() const /* override */
+{
+	if (this->wait.IsConstant()) {
+		return {EAnimOp::Wait, this->wait.GetConstant(), this};
+	}
+	return CAnimation::Compile();
+}
+
 void CAnimation_Wait::Init(std::string_view s, lua_State *) /* override */
 {
-	this->wait = s;
+	this->wait.Compile(s);
 }
 
 //@}
@@ -57,6 +57,7 @@
 #include "parameters.h"
 #include "pathfinder.h"
 #include "player.h"
+#include "profiler.h"
 #include "replay.h"
 #include "results.h"
 #include "settings.h"
@@ -982,6 +983,7 @@ void CreateGame(const fs::path &filename, CMap *map)
 	//
 	LoadUnitSounds();
 	MapUnitSounds();
+	PrefetchUnitSounds();
 	if (SoundEnabled()) {
 		InitSoundClient();
 	}
@@ -1583,6 +1585,7 @@ void LuaRegisterModules()
 	NetworkCclRegister();
 	PathfinderCclRegister();
 	PlayerCclRegister();
+	ProfilerCclRegister();
 	ReplayCclRegister();
 	ScriptRegister();
 	SelectionCclRegister();
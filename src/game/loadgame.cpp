@@ -165,6 +165,7 @@ void LoadModules()
 
 	LoadUnitSounds();
 	MapUnitSounds();
+	PrefetchUnitSounds();
 	if (SoundEnabled()) {
 		InitSoundClient();
 	}
@@ -544,7 +544,8 @@ static int CclReplayLog(lua_State *l)
 			replay->Network[1] = LuaToNumber(l, -1, 2);
 			replay->Network[2] = LuaToNumber(l, -1, 3);
 		} else {
-			if (!replay->ReplaySettings.SetField({value.data(), value.size()}, LuaToNumber(l, -1))) {
+			const int fieldValue = lua_isboolean(l, -1) ? LuaToBoolean(l, -1) : LuaToNumber(l, -1);
+			if (!replay->ReplaySettings.SetField({value.data(), value.size()}, fieldValue)) {
 				LuaError(l, "Unsupported key: %s", value.data());
 			}
 		}
@@ -44,9 +44,12 @@
 #include "results.h"
 #include "script.h"
 #include "unit.h"
+#include "unit_area_count.h"
 #include "unit_find.h"
 #include "unittype.h"
 
+#include <algorithm>
+#include <chrono>
 #include <vector>
 
 /*----------------------------------------------------------------------------
@@ -56,6 +59,34 @@
 CTimer GameTimer;               /// The game timer
 static std::vector<bool> ActiveTriggers;
 
+/**
+**  When a trigger condition is evaluated, and what it cost so far.
+**
+**  Indexed like the triggers in _triggers_.
+*/
+struct TriggerSchedule
+{
+	std::string Name;         /// Name, or location of the condition
+	int Interval = 1;         /// Evaluate every Interval cycles, 0 to wait for events only
+	unsigned int Events = 0;  /// ETriggerEvent mask the trigger waits for
+	bool HasArea = false;     /// AreaEntered is limited to the area
+	Vec2i AreaMin;            /// Top left tile of the area
+	Vec2i AreaMax;            /// Bottom right tile of the area
+	bool AreaEntered = false; /// A unit entered the area since the last evaluation
+
+	unsigned long Calls = 0;  /// Number of condition evaluations
+	unsigned long Actions = 0; /// Number of action runs
+	double Time = 0;          /// Time spent in condition and actions (ms)
+	double MaxTime = 0;       /// Longest evaluation (ms)
+};
+static std::vector<TriggerSchedule> TriggerSchedules;
+/// Indexes of the triggers limited to an area
+static std::vector<int> AreaTriggers;
+/// ETriggerEvent mask of events raised since the triggers were last run
+static unsigned int PendingTriggerEvents = 0;
+/// Triggers whose area was entered when the game was saved, by index
+static std::vector<bool> LoadedAreaEntered;
+
 /// Some data accessible for script during the game.
 TriggerDataType TriggerData;
 
@@ -69,47 +100,86 @@ TriggerDataType TriggerData;
 **
 **  @param l  Lua state.
 **
-**  @return   The unit-player validator.
+**  @return   The player number, -1 for any player.
 */
-std::function<bool(const CUnit &)> TriggerGetPlayer(lua_State *l)
+static int TriggerGetPlayerIndex(lua_State *l)
 {
 	if (lua_isnumber(l, -1)) {
 		const int plynr = LuaToNumber(l, -1);
 		if (plynr < 0 || plynr > PlayerMax) {
 			LuaError(l, "bad player: %d", plynr);
 		}
-		return [plynr](const CUnit &unit) { return plynr == unit.Player->Index; };
+		return plynr;
 	}
 	const std::string_view player = LuaToString(l, -1);
 	if (player == "any") {
-		return [](const CUnit &) { return true; };
+		return -1;
 	} else if (player == "this") {
 		Assert(ThisPlayer);
-		return [plynr = ThisPlayer->Index](const CUnit &unit) { return plynr == unit.Player->Index; };
+		return ThisPlayer->Index;
 	}
 	LuaError(l, "bad player: %s", player.data());
 	ExitFatal(0);
 }
 
 /**
-**  Get the unit-type.
+**  Get player number.
 **
 **  @param l  Lua state.
 **
-**  @return   The unit-type validator.
+**  @return   The unit-player validator.
 */
-std::function<bool(const CUnit &)> TriggerGetUnitType(lua_State *l)
+std::function<bool(const CUnit &)> TriggerGetPlayer(lua_State *l)
+{
+	const int plynr = TriggerGetPlayerIndex(l);
+
+	if (plynr == -1) {
+		return [](const CUnit &) { return true; };
+	}
+	return [plynr](const CUnit &unit) { return plynr == unit.Player->Index; };
+}
+
+/**
+**  Get the unit-type as a unit count selection.
+**
+**  @param l     Lua state.
+**  @param type  Set to the unit type for EUnitCountKind::Type.
+**
+**  @return      The units counted.
+*/
+static EUnitCountKind TriggerGetUnitCountKind(lua_State *l, const CUnitType *&type)
 {
 	const std::string_view unit = LuaToString(l, -1);
 
+	type = nullptr;
 	if (unit == "any") {
-		return [](const CUnit &) { return true; };
+		return EUnitCountKind::Any;
 	} else if (unit == "units") {
-		return [](const CUnit &unit) { return !unit.Type->Building; };
+		return EUnitCountKind::Units;
 	} else if (unit == "buildings") {
-		return [](const CUnit &unit) { return unit.Type->Building; };
+		return EUnitCountKind::Buildings;
+	}
+	type = CclGetUnitType(l);
+	return EUnitCountKind::Type;
+}
+
+/**
+**  Get the unit-type.
+**
+**  @param l  Lua state.
+**
+**  @return   The unit-type validator.
+*/
+std::function<bool(const CUnit &)> TriggerGetUnitType(lua_State *l)
+{
+	const CUnitType *expectedType = nullptr;
+
+	switch (TriggerGetUnitCountKind(l, expectedType)) {
+		case EUnitCountKind::Any: return [](const CUnit &) { return true; };
+		case EUnitCountKind::Units: return [](const CUnit &unit) { return !unit.Type->Building; };
+		case EUnitCountKind::Buildings: return [](const CUnit &unit) { return unit.Type->Building; };
+		case EUnitCountKind::Type: break;
 	}
-	const CUnitType *expectedType = CclGetUnitType(l);
 	return [=](const CUnit &unit) { return expectedType == unit.Type && !unit.Constructed; };
 }
 
@@ -160,16 +230,20 @@ static CompareFunction GetCompareFunction(std::string_view op)
 ** <div class="example"><code>-- Get the number of knights from player 1 from position 0,0 to 20,15
 **			num_units = <strong>GetNumUnitsAt</strong>(1,"unit-knight",{0,0},{20,15})
 **			print(num_units)</code></div>
+**
+**  The count comes from an index kept up to date as units move, so it
+**  is cheap enough to be polled every cycle.
 */
 static int CclGetNumUnitsAt(lua_State *l)
 {
 	LuaCheckArgs(l, 4);
 
 	lua_pushvalue(l, 1);
-	const auto unitPlayerValidator = TriggerGetPlayer(l);
+	const int plynr = TriggerGetPlayerIndex(l);
 	lua_pushvalue(l, 2);
-	auto unitValidator = TriggerGetUnitType(l);
-	lua_pop(l, 1);
+	const CUnitType *type = nullptr;
+	const EUnitCountKind kind = TriggerGetUnitCountKind(l, type);
+	lua_pop(l, 2);
 
 	Vec2i minPos;
 	Vec2i maxPos;
@@ -183,12 +257,7 @@ static int CclGetNumUnitsAt(lua_State *l)
 		std::swap(minPos.y, maxPos.y);
 	}
 
-	std::vector<CUnit *> units = Select(minPos, maxPos);
-
-	const int s = ranges::count_if(units, [&](const CUnit *unit) {
-		return unitValidator(*unit) && unitPlayerValidator(*unit) && unit->IsAlive();
-	});
-	lua_pushnumber(l, s);
+	lua_pushnumber(l, UnitAreaCount.Count(plynr, kind, type, minPos, maxPos));
 	return 1;
 }
 
@@ -210,12 +279,13 @@ static int CclIfNearUnit(lua_State *l)
 {
 	LuaCheckArgs(l, 5);
 	lua_pushvalue(l, 1);
-	const auto unitPlayerValidator = TriggerGetPlayer(l);
+	const int plynr = TriggerGetPlayerIndex(l);
 	lua_pop(l, 1);
 	const std::string_view op = LuaToString(l, 2);
 	const int q = LuaToNumber(l, 3);
 	lua_pushvalue(l, 4);
-	const auto unitValidator = TriggerGetUnitType(l);
+	const CUnitType *type = nullptr;
+	const EUnitCountKind kind = TriggerGetUnitCountKind(l, type);
 	lua_pop(l, 1);
 	const CUnitType *ut2 = CclGetUnitType(l);
 	if (!ut2) {
@@ -230,14 +300,14 @@ static int CclIfNearUnit(lua_State *l)
 	// Get all unit types 'near'.
 	//
 
-	std::vector<CUnit *> unitsOfType = FindUnitsByType(*ut2);
-	for (const CUnit *centerUnit : unitsOfType) {
-		std::vector<CUnit *> around = SelectAroundUnit(*centerUnit, 1);
-
-		// Count the requested units
-		const int s = ranges::count_if(around, [&](const CUnit *unit) {
-			return unitValidator(*unit) && unitPlayerValidator(*unit);
-		});
+	const Vec2i offset(1, 1);
+	const Vec2i typeSize(ut2->TileWidth - 1, ut2->TileHeight - 1);
+	for (const CUnit *centerUnit : FindUnitsByType(*ut2)) {
+		// Count the requested units around, but not the center unit itself
+		int s = UnitAreaCount.Count(plynr, kind, type, centerUnit->tilePos - offset, centerUnit->tilePos + typeSize + offset);
+		if (UnitAreaCount.IsCounted(*centerUnit, plynr, kind, type)) {
+			--s;
+		}
 		if (compare(s, q)) {
 			lua_pushboolean(l, 1);
 			return 1;
@@ -371,6 +441,7 @@ void ActionSetTimer(int cycles, bool increasing)
 	GameTimer.Increasing = increasing;
 	GameTimer.Init = true;
 	GameTimer.LastUpdate = GameCycle;
+	TriggerNotifyEvent(ETriggerEvent::Timer);
 }
 
 /**
@@ -380,6 +451,7 @@ void ActionStartTimer()
 {
 	GameTimer.Running = true;
 	GameTimer.Init = true;
+	TriggerNotifyEvent(ETriggerEvent::Timer);
 }
 
 /**
@@ -388,6 +460,135 @@ void ActionStartTimer()
 void ActionStopTimer()
 {
 	GameTimer.Running = false;
+	TriggerNotifyEvent(ETriggerEvent::Timer);
+}
+
+/**
+**  Wake up the triggers waiting for an engine event.
+**
+**  They are evaluated when the triggers run next.
+*/
+void TriggerNotifyEvent(ETriggerEvent event)
+{
+	PendingTriggerEvents |= static_cast<unsigned int>(event);
+}
+
+/**
+**  Wake up the triggers watching an area the unit is now in.
+**
+**  @param unit  Unit placed on the map or moved.
+*/
+void TriggerNotifyUnitEntered(const CUnit &unit)
+{
+	PendingTriggerEvents |= static_cast<unsigned int>(ETriggerEvent::AreaEntered);
+	if (AreaTriggers.empty()) {
+		return;
+	}
+	const Vec2i unitMin = unit.tilePos;
+	const Vec2i unitMax(unitMin.x + unit.Type->TileWidth - 1, unitMin.y + unit.Type->TileHeight - 1);
+	for (int trigger : AreaTriggers) {
+		TriggerSchedule &schedule = TriggerSchedules[trigger];
+		if (unitMax.x >= schedule.AreaMin.x && unitMin.x <= schedule.AreaMax.x
+			&& unitMax.y >= schedule.AreaMin.y && unitMin.y <= schedule.AreaMax.y) {
+			schedule.AreaEntered = true;
+		}
+	}
+}
+
+/**
+**  Parse the name of an engine event.
+*/
+static ETriggerEvent TriggerEventByName(lua_State *l, std::string_view name)
+{
+	if (name == "unit-created") {
+		return ETriggerEvent::UnitCreated;
+	} else if (name == "unit-died") {
+		return ETriggerEvent::UnitDied;
+	} else if (name == "area-entered") {
+		return ETriggerEvent::AreaEntered;
+	} else if (name == "timer") {
+		return ETriggerEvent::Timer;
+	} else if (name == "resource-changed") {
+		return ETriggerEvent::ResourceChanged;
+	}
+	LuaError(l, "Unsupported trigger event: %s", name.data());
+	return ETriggerEvent::UnitCreated;
+}
+
+/**
+**  Get the name of an engine event, as parsed by TriggerEventByName.
+*/
+static const char *TriggerEventName(ETriggerEvent event)
+{
+	switch (event) {
+		case ETriggerEvent::UnitCreated: return "unit-created";
+		case ETriggerEvent::UnitDied: return "unit-died";
+		case ETriggerEvent::AreaEntered: return "area-entered";
+		case ETriggerEvent::Timer: return "timer";
+		case ETriggerEvent::ResourceChanged: return "resource-changed";
+	}
+	return "";
+}
+
+/**
+**  Parse the schedule of a trigger.
+**
+**  @param l         Lua state.
+**  @param index     Stack index of the options table.
+**  @param schedule  Schedule to fill.
+*/
+static void ParseTriggerSchedule(lua_State *l, int index, TriggerSchedule &schedule)
+{
+	if (!lua_istable(l, index)) {
+		LuaError(l, "incorrect argument");
+	}
+	lua_pushnil(l);
+	while (lua_next(l, index)) {
+		const std::string_view value = LuaToString(l, -2);
+
+		if (value == "Name") {
+			schedule.Name = LuaToString(l, -1);
+		} else if (value == "Interval") {
+			schedule.Interval = LuaToNumber(l, -1);
+			if (schedule.Interval < 0) {
+				LuaError(l, "Trigger interval must be positive, or 0 for events only");
+			}
+		} else if (value == "Events") {
+			if (!lua_istable(l, -1)) {
+				LuaError(l, "incorrect argument");
+			}
+			const int subargs = lua_rawlen(l, -1);
+			for (int k = 0; k < subargs; ++k) {
+				schedule.Events |= static_cast<unsigned int>(TriggerEventByName(l, LuaToString(l, -1, k + 1)));
+			}
+		} else if (value == "Area") {
+			if (!lua_istable(l, -1) || lua_rawlen(l, -1) != 4) {
+				LuaError(l, "incorrect argument");
+			}
+			schedule.HasArea = true;
+			schedule.AreaMin.x = LuaToNumber(l, -1, 1);
+			schedule.AreaMin.y = LuaToNumber(l, -1, 2);
+			schedule.AreaMax.x = LuaToNumber(l, -1, 3);
+			schedule.AreaMax.y = LuaToNumber(l, -1, 4);
+			if (schedule.AreaMin.x > schedule.AreaMax.x) {
+				std::swap(schedule.AreaMin.x, schedule.AreaMax.x);
+			}
+			if (schedule.AreaMin.y > schedule.AreaMax.y) {
+				std::swap(schedule.AreaMin.y, schedule.AreaMax.y);
+			}
+		} else {
+			LuaError(l, "Unsupported tag: %s", value.data());
+		}
+		lua_pop(l, 1);
+	}
+	// Waiting for events only, unless an interval is given
+	if (schedule.Events != 0 || schedule.HasArea) {
+		lua_getfield(l, index, "Interval");
+		if (lua_isnil(l, -1)) {
+			schedule.Interval = 0;
+		}
+		lua_pop(l, 1);
+	}
 }
 
 /**
@@ -414,21 +615,41 @@ static void TriggerRemoveTrigger(lua_State *l, int trig)
 **  trigger is removed and never runs again. Otherwise, it is kept and may run
 **  again next cycle.
 **
+**  An optional third table limits when the condition runs:
+**  <code>Interval</code> runs it every that many cycles,
+**  <code>Events</code> runs it after one of "unit-created", "unit-died",
+**  "area-entered", "timer" or "resource-changed" happened,
+**  <code>Area</code> = {x1, y1, x2, y2} limits "area-entered" to that area and
+**  <code>Name</code> names the trigger in GetTriggerStatistics.
+**  With events and no interval, the condition only runs after the events.
+**
 ** Example:
 **
 ** <div class="example"><code><strong>AddTrigger</strong>(
 **			function() return (GetPlayerData(1,"UnitTypesCount","unit-farm") >= 4) end,
-**			function() return ActionVictory() end
+**			function() return ActionVictory() end,
+**			{Events = {"unit-created"}, Name = "four farms"}
 **		)</code></div>
 */
 static int CclAddTrigger(lua_State *l)
 {
-	LuaCheckArgs(l, 2);
-	if (!lua_isfunction(l, 1)
+	const int args = lua_gettop(l);
+	if ((args != 2 && args != 3) || !lua_isfunction(l, 1)
 		|| (!lua_isfunction(l, 2) && !lua_istable(l, 2))) {
 		LuaError(l, "incorrect argument");
 	}
 
+	TriggerSchedule schedule;
+	if (args == 3) {
+		ParseTriggerSchedule(l, 3, schedule);
+	}
+	if (schedule.Name.empty()) {
+		lua_Debug ar;
+		lua_pushvalue(l, 1);
+		lua_getinfo(l, ">S", &ar);
+		schedule.Name = Format("%s:%d", ar.short_src, ar.linedefined);
+	}
+
 	// Make a list of all triggers.
 	// A trigger is a pair of condition and action
 	lua_getglobal(l, "_triggers_");
@@ -457,6 +678,14 @@ static int CclAddTrigger(lua_State *l)
 	}
 	lua_pop(l, 1);
 
+	TriggerSchedules.resize(i / 2);
+	if (i / 2 < LoadedAreaEntered.size()) {
+		schedule.AreaEntered = schedule.HasArea && LoadedAreaEntered[i / 2];
+	}
+	if (schedule.HasArea) {
+		AreaTriggers.push_back(i / 2);
+	}
+	TriggerSchedules.push_back(std::move(schedule));
 	return 0;
 }
 
@@ -492,6 +721,55 @@ static int CclSetActiveTriggers(lua_State *l)
 	return 0;
 }
 
+/**
+**  Set the events raised but not yet seen by the triggers (for saved games).
+**
+**  @param l  Lua state.
+**
+**  The first table holds event names, the optional second one the indexes of
+**  the triggers whose area was entered.
+*/
+static int CclSetPendingTriggerEvents(lua_State *l)
+{
+	const int args = lua_gettop(l);
+	if (args != 1 && args != 2) {
+		LuaError(l, "incorrect argument");
+	}
+	if (!lua_istable(l, 1)) {
+		LuaError(l, "incorrect argument");
+	}
+	PendingTriggerEvents = 0;
+	const int events = lua_rawlen(l, 1);
+	for (int j = 0; j < events; ++j) {
+		const std::string_view name = LuaToString(l, 1, j + 1);
+		PendingTriggerEvents |= static_cast<unsigned int>(TriggerEventByName(l, name));
+	}
+
+	LoadedAreaEntered.clear();
+	if (args == 2) {
+		if (!lua_istable(l, 2)) {
+			LuaError(l, "incorrect argument");
+		}
+		const int triggers = lua_rawlen(l, 2);
+		for (int j = 0; j < triggers; ++j) {
+			const int trigger = LuaToNumber(l, 2, j + 1);
+			if (trigger < 0) {
+				LuaError(l, "Invalid trigger index: %d", trigger);
+			}
+			if (trigger >= static_cast<int>(LoadedAreaEntered.size())) {
+				LoadedAreaEntered.resize(trigger + 1);
+			}
+			LoadedAreaEntered[trigger] = true;
+		}
+	}
+	// Triggers already defined take the state now, the others when added
+	for (size_t j = 0; j != TriggerSchedules.size(); ++j) {
+		TriggerSchedules[j].AreaEntered = TriggerSchedules[j].HasArea
+			&& j < LoadedAreaEntered.size() && LoadedAreaEntered[j];
+	}
+	return 0;
+}
+
 /**
 **  Execute a trigger action
 **
@@ -521,11 +799,38 @@ static bool TriggerExecuteAction(lua_State *l, int trig)
 }
 
 /**
-**  Check trigger each game cycle.
+**  Check if the trigger condition has to be evaluated this cycle.
+**
+**  @param trigger  Index of the trigger.
+**  @param events   ETriggerEvent mask raised since the last cycle.
+*/
+static bool TriggerIsDue(int trigger, unsigned int events)
+{
+	if (trigger >= static_cast<int>(TriggerSchedules.size())) {
+		return true;
+	}
+	TriggerSchedule &schedule = TriggerSchedules[trigger];
+	bool due = schedule.Interval != 0 && (GameCycle + trigger) % schedule.Interval == 0;
+	if (schedule.HasArea) {
+		due |= schedule.AreaEntered;
+		schedule.AreaEntered = false;
+		events &= ~static_cast<unsigned int>(ETriggerEvent::AreaEntered);
+	}
+	return due || (schedule.Events & events) != 0;
+}
+
+/**
+**  Test the trigger conditions and run the actions of the true ones.
+**
+**  Triggers with an interval or waiting for events are skipped on the other
+**  cycles. The time spent in each trigger is accounted for.
 */
 void TriggersEachCycle()
 {
 	const int base = lua_gettop(Lua);
+	// Events raised by the actions wake up triggers next cycle
+	const unsigned int events = PendingTriggerEvents;
+	PendingTriggerEvents = 0;
 
 	lua_getglobal(Lua, "_triggers_");
 	const int triggerSize = lua_rawlen(Lua, -1) / 2;
@@ -536,21 +841,86 @@ void TriggersEachCycle()
 		}
 
 		lua_rawgeti(Lua, -1, trigger * 2 + 1);
-		if (!lua_isnumber(Lua, -1)) {
+		if (!lua_isnumber(Lua, -1) && TriggerIsDue(trigger, events)) {
+			const auto start = std::chrono::steady_clock::now();
+			bool action = false;
 			LuaCall(0, 0);
 			// If condition is true execute action
 			if (lua_gettop(Lua) > base + 1 && lua_toboolean(Lua, -1)) {
 				lua_settop(Lua, base + 1);
+				action = true;
 				if (TriggerExecuteAction(Lua, trigger)) {
 					TriggerRemoveTrigger(Lua, trigger);
 				}
 			}
+			if (trigger < static_cast<int>(TriggerSchedules.size())) {
+				const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+				TriggerSchedule &schedule = TriggerSchedules[trigger];
+				++schedule.Calls;
+				schedule.Actions += action;
+				schedule.Time += time.count();
+				schedule.MaxTime = std::max(schedule.MaxTime, time.count());
+			}
 		}
 		lua_settop(Lua, base + 1);
 	}
 	lua_pop(Lua, 1);
 }
 
+/**
+**  Get the cost of the triggers.
+**
+**  @param l  Lua state.
+**
+**  @return   A table with Name, Calls, Actions, Time and MaxTime (in ms) of each trigger.
+*/
+static int CclGetTriggerStatistics(lua_State *l)
+{
+	LuaCheckArgs(l, 0);
+	lua_createtable(l, TriggerSchedules.size(), 0);
+	for (size_t i = 0; i != TriggerSchedules.size(); ++i) {
+		const TriggerSchedule &schedule = TriggerSchedules[i];
+		lua_createtable(l, 0, 5);
+		lua_pushstring(l, schedule.Name.c_str());
+		lua_setfield(l, -2, "Name");
+		lua_pushnumber(l, schedule.Calls);
+		lua_setfield(l, -2, "Calls");
+		lua_pushnumber(l, schedule.Actions);
+		lua_setfield(l, -2, "Actions");
+		lua_pushnumber(l, schedule.Time);
+		lua_setfield(l, -2, "Time");
+		lua_pushnumber(l, schedule.MaxTime);
+		lua_setfield(l, -2, "MaxTime");
+		lua_rawseti(l, -2, i + 1);
+	}
+	return 1;
+}
+
+/**
+**  Print the most expensive triggers.
+**
+**  @param l  Lua state.
+*/
+static int CclPrintTriggerStatistics(lua_State *l)
+{
+	LuaCheckArgs(l, 0);
+	std::vector<const TriggerSchedule *> sorted;
+	for (const auto &schedule : TriggerSchedules) {
+		sorted.push_back(&schedule);
+	}
+	ranges::sort(sorted, [](const auto *lhs, const auto *rhs) { return lhs->Time > rhs->Time; });
+	ErrorPrint("TRIGGERS: %-40s %10s %10s %12s %10s\n", "trigger", "calls", "actions", "total ms", "max ms");
+	for (const auto *schedule : sorted) {
+		ErrorPrint("TRIGGERS: %-40s %10lu %10lu %12.2f %10.3f\n",
+		           schedule->Name.c_str(),
+		           schedule->Calls,
+		           schedule->Actions,
+		           schedule->Time,
+		           schedule->MaxTime);
+	}
+	return 0;
+}
+
 /**
 **  Register CCL features for triggers.
 */
@@ -558,6 +928,9 @@ void TriggerCclRegister()
 {
 	lua_register(Lua, "AddTrigger", CclAddTrigger);
 	lua_register(Lua, "SetActiveTriggers", CclSetActiveTriggers);
+	lua_register(Lua, "SetPendingTriggerEvents", CclSetPendingTriggerEvents);
+	lua_register(Lua, "GetTriggerStatistics", CclGetTriggerStatistics);
+	lua_register(Lua, "PrintTriggerStatistics", CclPrintTriggerStatistics);
 	// Conditions
 	lua_register(Lua, "GetNumUnitsAt", CclGetNumUnitsAt);
 	lua_register(Lua, "IfNearUnit", CclIfNearUnit);
@@ -593,6 +966,25 @@ void SaveTriggers(CFile &file)
 	}
 	file.printf(")\n");
 
+	// Events raised since the triggers last ran, so no trigger misses them
+	file.printf("SetPendingTriggerEvents({");
+	bool first = true;
+	for (unsigned int event = 1; event <= static_cast<unsigned int>(ETriggerEvent::ResourceChanged); event <<= 1) {
+		if (PendingTriggerEvents & event) {
+			file.printf("%s\"%s\"", first ? "" : ", ", TriggerEventName(static_cast<ETriggerEvent>(event)));
+			first = false;
+		}
+	}
+	file.printf("}, {");
+	first = true;
+	for (int trigger : AreaTriggers) {
+		if (TriggerSchedules[trigger].AreaEntered) {
+			file.printf("%s%d", first ? "" : ", ", trigger);
+			first = false;
+		}
+	}
+	file.printf("})\n");
+
 	if (GameTimer.Init) {
 		file.printf("ActionSetTimer(%ld, %s)\n",
 					GameTimer.Cycles, (GameTimer.Increasing ? "true" : "false"));
@@ -633,6 +1025,10 @@ void CleanTriggers()
 	lua_setglobal(Lua, "Triggers");
 
 	ActiveTriggers.clear();
+	TriggerSchedules.clear();
+	AreaTriggers.clear();
+	PendingTriggerEvents = 0;
+	LoadedAreaEntered.clear();
 
 	GameTimer.Reset();
 }
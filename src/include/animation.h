@@ -33,9 +33,11 @@
 //@{
 
 #include <map>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "upgrade_structs.h" // MaxCost
 #define ANIMATIONS_DEATHTYPES 40
@@ -71,6 +73,144 @@ enum class SetVar_ModifyTypes {
 SetVar_ModifyTypes toSetVar_ModifyTypes(std::string_view s);
 void modifyValue(SetVar_ModifyTypes mod, int &value, int rop);
 
+/// Component of a unit variable used by animations
+enum class EAnimVarComponent : unsigned char {
+	Value,    /// Value of the variable
+	Max,      /// Max of the variable
+	Increase, /// Increase of the variable
+	Enable,   /// Enable flag of the variable
+	Percent,  /// 100 * Value / Max
+	Unknown   /// Unknown tag, reads as 0
+};
+
+EAnimVarComponent toAnimVarComponent(std::string_view s);
+
+/// Player properties readable by animations and scripts
+enum class EPlayerData : unsigned char {
+	Invalid,
+	RaceName,
+	Resources,
+	StoredResources,
+	MaxResources,
+	Incomes,
+	UnitTypesCount,
+	UnitTypesAiActiveCount,
+	AiEnabled,
+	TotalNumUnits,
+	NumBuildings,
+	Supply,
+	Demand,
+	UnitLimit,
+	BuildingLimit,
+	TotalUnitLimit,
+	Score,
+	TotalUnits,
+	TotalBuildings,
+	TotalResources,
+	TotalRazings,
+	TotalKills
+};
+
+/**
+**  Integer operand of an animation, see ParseAnimInt for the syntax.
+**
+**  The text is compiled when the animation is defined, evaluating it
+**  is a switch over the resolved fields.
+**  Names not known yet (unit types and spells are defined after the
+**  animations) are resolved on the first evaluation.
+*/
+class CAnimOperand
+{
+public:
+	CAnimOperand() = default;
+	explicit CAnimOperand(std::string_view s) { Compile(s); }
+
+	void Compile(std::string_view s);
+	int Eval(const CUnit &unit) const;
+
+	bool IsEmpty() const { return Text.empty(); }
+	bool IsConstant() const { return Kind == EKind::Number; }
+	int GetConstant() const { return Value; }
+	const std::string &GetText() const { return Text; }
+
+private:
+	enum class EKind : unsigned char {
+		Number,         /// Constant
+		Variable,       /// Component of a unit variable
+		ResourcesHeld,  /// Resources held by the unit
+		ResourceActive, /// Resource activity of the unit
+		Distance,       /// Distance between the unit and its goal
+		BoolFlag,       /// Bool flag of the unit type
+		SpellCast,      /// 1 if the spell is being cast
+		AutoCast,       /// 1 if the autocast of the spell is on
+		PlayerData,     /// Property of a player
+		Random,         /// Synchronized random value
+		PlayerNumber,   /// Player number
+		ThisPlayer,     /// Player of the unit
+		UnitSlot,       /// Slot of the unit
+		GoalSlot,       /// Slot of the goal of the current order
+		Rotation,       /// Pending rotation
+		RemainingWay    /// Remaining path length
+	};
+	/// Which unit a variable or bool flag is read from
+	enum class EGoal : unsigned char {
+		Self,      /// The animated unit
+		Target,    /// Goal of the order, or the building being built
+		OrderGoal  /// Goal of the order
+	};
+
+	void CompilePlayer(std::string_view s);
+	const CUnit *GetGoal(const CUnit &unit) const;
+	void Resolve() const;
+
+	EKind Kind = EKind::Number;
+	EGoal Goal = EGoal::Self;
+	EAnimVarComponent Component = EAnimVarComponent::Value;
+	EPlayerData Prop = EPlayerData::Invalid;
+	int Value = 0;                /// Constant, or minimum of the random value
+	int Max = 0;                  /// Maximum of the random value
+	mutable bool Resolved = true; /// Index is resolved from Name
+	mutable int Index = -1;       /// Variable, bool flag or spell slot, or argument of the player property
+	std::string Name;             /// Name Index is resolved from
+	std::unique_ptr<CAnimOperand> Player; /// Player operand of the player data
+	std::string Text;             /// Source text
+};
+
+class CAnimation;
+
+/// Operation of a compiled animation step
+enum class EAnimOp : unsigned char {
+	Call,        /// Run CAnimation::Action of the step
+	Nop,         /// Label
+	Frame,       /// Set the frame and update the heading
+	ExactFrame,  /// Set the frame
+	Wait,        /// Wait a constant time
+	Move,        /// Move a constant number of pixels
+	Goto,        /// Jump to Arg
+	Unbreakable  /// Set the unbreakable state to Arg
+};
+
+/// Step of a compiled animation sequence
+struct CAnimOp
+{
+	EAnimOp Op = EAnimOp::Call;
+	int Arg = 0;                           /// Inline constant operand or jump target
+	const CAnimation *Animation = nullptr; /// Front end step
+};
+
+/**
+**  Animation sequence compiled to a contiguous array of steps.
+**
+**  Step i of Ops is step i of Source, so CUnit::Anim.Anim indexes both.
+**  Simple steps with constant operands are run inline by the interpreter,
+**  the others call back into their CAnimation.
+*/
+struct CAnimProgram
+{
+	const std::vector<std::unique_ptr<CAnimation>> *Source = nullptr;
+	std::vector<CAnimOp> Ops;
+};
+
 class CAnimation
 {
 public:
@@ -78,6 +218,8 @@ class CAnimation
 	virtual ~CAnimation() {}
 
 	virtual void Action(CUnit &unit, int &move, int scale) const = 0;
+	/// Translate the step for CAnimProgram, steps which can't be inlined are called
+	virtual CAnimOp Compile() const { return {EAnimOp::Call, 0, this}; }
 	virtual void Init(std::string_view s, lua_State *l = nullptr) {}
 	virtual void MapSound() {}
 	virtual std::optional<int> GetStillFrame(const CUnitType &type) { return std::nullopt; }
@@ -123,10 +265,13 @@ extern void AnimationCclRegister();
 extern int UnitShowAnimationScaled(CUnit &unit,
                                    const std::vector<std::unique_ptr<CAnimation>> *anims,
                                    int scale);
+/// Get the compiled form of an animation sequence
+extern const CAnimProgram &GetAnimProgram(const std::vector<std::unique_ptr<CAnimation>> &anims);
 /// Handle the animation of a unit
 extern int UnitShowAnimation(CUnit &unit, const std::vector<std::unique_ptr<CAnimation>> *anims);
 
 
+/// Parse and evaluate an animation operand, prefer CAnimOperand for repeated use
 extern int ParseAnimInt(const CUnit &unit, std::string_view parseint);
 
 extern void FindLabelLater(std::size_t *labelIndex, std::string name);
@@ -40,12 +40,13 @@ class CAnimation_ExactFrame : public CAnimation
 public:
 	void Action(CUnit &unit, int &move, int scale) const override;
 	void Init(std::string_view s, lua_State *l) override;
+	CAnimOp Compile() const override;
 	std::optional<int> GetStillFrame(const CUnitType &type) override;
 
 	int ParseAnimInt(const CUnit *unit) const;
 
 private:
-	std::string frame;
+	CAnimOperand frame;
 };
 
 //@}
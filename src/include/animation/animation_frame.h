@@ -40,13 +40,17 @@ class CAnimation_Frame : public CAnimation
 public:
 	void Action(CUnit &unit, int &move, int scale) const override;
 	void Init(std::string_view s, lua_State *l) override;
+	CAnimOp Compile() const override;
 	std::optional<int> GetStillFrame(const CUnitType &type) override;
 
 	int ParseAnimInt(const CUnit *unit) const;
 private:
-	std::string frame;
+	CAnimOperand frame;
 };
 
+/// Set the frame of the unit animation and update its heading
+extern void UnitSetAnimFrame(CUnit &unit, int frame);
+
 //@}
 
 #endif // ANIMATION_FRAME_H
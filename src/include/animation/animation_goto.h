@@ -40,6 +40,7 @@ class CAnimation_Goto : public CAnimation
 public:
 	void Action(CUnit &unit, int &move, int scale) const override;
 	void Init(std::string_view s, lua_State *l) override;
+	CAnimOp Compile() const override;
 
 private:
 	std::size_t gotoLabel = 0;
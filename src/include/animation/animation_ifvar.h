@@ -45,8 +45,8 @@ class CAnimation_IfVar : public CAnimation
 	using BinOpFunc = bool (int lhs, int rhs);
 
 private:
-	std::string leftVar;
-	std::string rightVar;
+	CAnimOperand leftVar;
+	CAnimOperand rightVar;
 	BinOpFunc *binOpFunc = nullptr;
 	std::size_t gotoLabel = 0;
 };
@@ -40,9 +40,10 @@ class CAnimation_Move : public CAnimation
 public:
 	void Action(CUnit &unit, int &move, int scale) const override;
 	void Init(std::string_view s, lua_State *l) override;
+	CAnimOp Compile() const override;
 
 private:
-	std::string moveStr;
+	CAnimOperand move;
 };
 
 //@}
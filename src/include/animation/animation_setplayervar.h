@@ -43,12 +43,17 @@ class CAnimation_SetPlayerVar : public CAnimation
 
 private:
 	SetVar_ModifyTypes mod;
-	std::string playerStr;
-	std::string varStr;
+	CAnimOperand player;
+	EPlayerData var = EPlayerData::Invalid;
+	std::string varStr;         /// Name of an unknown var, kept for the error
 	std::string argStr;
-	std::string valueStr;
+	mutable int argIndex = -1; /// argStr resolved on first use
+	CAnimOperand value;
 };
 
+extern EPlayerData PlayerDataByName(std::string_view prop);
+extern int PlayerDataArgument(EPlayerData prop, std::string_view arg);
+extern int GetPlayerData(int player, EPlayerData prop, int arg);
 extern int GetPlayerData(int player, std::string_view prop, std::string_view arg);
 
 //@}
@@ -42,10 +42,22 @@ class CAnimation_SetVar : public CAnimation
 	void Init(std::string_view s, lua_State *l) override;
 
 private:
+	/// Unit whose variable is modified
+	enum class EUnitSlot : unsigned char {
+		Self,        /// The animated unit
+		LastCreated, /// Last created unit
+		Target       /// Goal of the current order
+	};
+
 	SetVar_ModifyTypes mod;
-	std::string varStr;
-	std::string valueStr;
-	std::string unitSlotStr;
+	EUnitSlot unitSlot = EUnitSlot::Self;
+	bool isDamageType = false;  /// Set the damage type instead of a variable
+	std::string damageType;
+	mutable bool damageTypeChecked = false; /// damageType validated on first use
+	std::string varName;
+	mutable int index = -1;     /// Variable index, resolved from varName on first use if needed
+	EAnimVarComponent component = EAnimVarComponent::Value;
+	CAnimOperand value;
 };
 
 //@}
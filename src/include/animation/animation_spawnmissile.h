@@ -35,6 +35,8 @@
 #include <string>
 #include "animation.h"
 
+class MissileType;
+
 class CAnimation_SpawnMissile : public CAnimation
 {
 public:
@@ -43,12 +45,13 @@ class CAnimation_SpawnMissile : public CAnimation
 
 private:
 	std::string missileTypeStr;
-	std::string startXStr;
-	std::string startYStr;
-	std::string destXStr;
-	std::string destYStr;
-	std::string flagsStr;
-	std::string offsetNumStr;
+	mutable MissileType *missileType = nullptr; /// missileTypeStr resolved on first use
+	CAnimOperand startX;
+	CAnimOperand startY;
+	CAnimOperand destX;
+	CAnimOperand destY;
+	unsigned int flags = 0;
+	CAnimOperand offsetNum;
 };
 
 //@}
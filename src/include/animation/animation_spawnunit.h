@@ -43,11 +43,12 @@ class CAnimation_SpawnUnit : public CAnimation
 
 private:
 	std::string unitTypeStr;
-	std::string offXStr;
-	std::string offYStr;
-	std::string rangeStr;
-	std::string playerStr;
-	std::string flagsStr;
+	mutable CUnitType *unitType = nullptr; /// unitTypeStr resolved on first use
+	CAnimOperand offX;
+	CAnimOperand offY;
+	CAnimOperand range;
+	CAnimOperand player;
+	unsigned int flags = 0;
 };
 
 //@}
@@ -40,11 +40,15 @@ class CAnimation_Wait : public CAnimation
 public:
 	void Action(CUnit &unit, int &move, int scale) const override;
 	void Init(std::string_view s, lua_State *l) override;
+	CAnimOp Compile() const override;
 
 private:
-	std::string wait;
+	CAnimOperand wait;
 };
 
+/// Set the wait time of the unit animation, with slow and haste applied
+extern void UnitSetAnimWait(CUnit &unit, int wait, int scale);
+
 //@}
 
 #endif // ANIMATION_WAIT_H
@@ -42,11 +42,11 @@ class CAnimation_Wiggle : public CAnimation
 	void Init(std::string_view s, lua_State *l) override;
 
 private:
-	std::string x;
-	std::string y;
+	CAnimOperand x;
+	CAnimOperand y;
 	bool isHeading = false;
 	bool isZDisplacement = false;
-	std::string speed;
+	CAnimOperand speed;
 	std::size_t ifNotReached = 0;
 };
 
@@ -40,6 +40,7 @@
 
 class CPlayer;
 class CUnitType;
+class CUpgrade;
 class ButtonAction;
 
 /*----------------------------------------------------------------------------
@@ -59,6 +60,15 @@ extern std::string PrintDependencies(const CPlayer &player, const ButtonAction &
 extern bool CheckDependByIdent(const CPlayer &player, std::string_view target);
 /// Check a dependency by unit type
 extern bool CheckDependByType(const CPlayer &player, const CUnitType &type);
+/// Check a dependency by upgrade
+extern bool CheckDependByUpgrade(const CPlayer &player, const CUpgrade &upgrade);
+
+/// Evaluate again the availability of all unit types and upgrades for a player
+extern void UpdateAvailability(const CPlayer &player);
+/// Evaluate again what depends on the count or the allow of a unit type
+extern void UpdateUnitTypeAvailability(const CPlayer &player, int slot);
+/// Evaluate again what depends on the allow of an upgrade
+extern void UpdateUpgradeAvailability(const CPlayer &player, int id);
 
 //@}
 
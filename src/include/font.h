@@ -103,7 +103,7 @@ class CFont : public gcn::Font
 	std::shared_ptr<CGraphic> GetGraphic() const;
 
 	template<bool CLIP>
-	unsigned int DrawChar(CGraphic &g, int utf8, int x, int y, const CFontColor &fc) const;
+	unsigned int DrawChar(SDL_Surface *target, int utf8, int x, int y, const CFontColor &fc) const;
 
 	void DynamicLoad() const;
 
@@ -89,6 +89,8 @@ class CFogOfWar
     void Draw(CViewport &viewport);
 
     uint8_t GetVisibilityForTile(const Vec2i tilePos) const;
+    bool GetVisibilityChanges(const uint16_t row, uint16_t &firstCol, uint16_t &lastCol) const;
+    void ClearVisibilityChanges();
 
 private:
     void InitEnhanced();
@@ -158,6 +160,13 @@ class CFogOfWar
     std::vector<uint8_t> VisTable;            /// vision table for whole map + 1 tile around (for simplification of upscale algorithm purposes)
     size_t               VisTable_Index0 {0}; /// index in the vision table for [0:0] map tile
     size_t               VisTableWidth   {0}; /// width of the vision table
+    /// Columns of a map row whose visibility changed, First > Last if none
+    struct ChangedColumns
+    {
+        uint16_t First {0xFFFF};
+        uint16_t Last  {0};
+    };
+    std::vector<ChangedColumns> VisChanges;   /// changes of the vision table per map row, since ClearVisibilityChanges()
     CEasedTexture        FogTexture;          /// Upscaled fog texture (alpha-channel values only) for whole map
                                               /// + 1 tile to the left and up (for simplification of upscale algorithm purposes).
     std::vector<uint8_t> RenderedFog;         /// Back buffer for bilinear upscaling in to viewports
@@ -261,4 +270,25 @@ inline uint8_t CFogOfWar::GetVisibilityForTile(const Vec2i tilePos) const
 {
     return VisTable[VisTable_Index0 + tilePos.x + VisTableWidth * tilePos.y];
 }
+
+/**
+**  Get the columns of a map row whose visibility changed since the last
+**  ClearVisibilityChanges().
+**
+**  @return false if no tile of the row changed.
+*/
+inline bool CFogOfWar::GetVisibilityChanges(const uint16_t row, uint16_t &firstCol, uint16_t &lastCol) const
+{
+    if (row >= VisChanges.size() || VisChanges[row].First > VisChanges[row].Last) {
+        return false;
+    }
+    firstCol = VisChanges[row].First;
+    lastCol  = VisChanges[row].Last;
+    return true;
+}
+
+inline void CFogOfWar::ClearVisibilityChanges()
+{
+    ranges::fill(VisChanges, ChangedColumns{});
+}
 #endif // !__FOW_H__
@@ -0,0 +1,90 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name ident_table.h - The interned identifiers header file. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+
+#ifndef __IDENT_TABLE_H__
+#define __IDENT_TABLE_H__
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include <array>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*----------------------------------------------------------------------------
+--  Declarations
+----------------------------------------------------------------------------*/
+
+/// Kinds of engine objects found by their identifier
+enum class EIdentKind {
+	UnitType,    /// Handle is CUnitType::Slot
+	Upgrade,     /// Handle is CUpgrade::ID
+	MissileType, /// Handle is MissileType::Slot
+	SpellType,   /// Handle is SpellType::Slot
+	Count
+};
+
+/**
+**  Interned identifiers of the unit types, upgrades, missile types and
+**  spells.
+**
+**  An identifier gets its handle when its object is defined, the handle
+**  is the index of the object in the table of its kind and doesn't
+**  change until the objects of this kind are cleaned. The identifiers are
+**  kept here, so a lookup hashes the string without copying it and
+**  callers may keep the handle instead of the string.
+*/
+class CIdentTable
+{
+public:
+	void Add(EIdentKind kind, std::string_view ident, int handle);
+	int Find(EIdentKind kind, std::string_view ident) const;
+	void Clear(EIdentKind kind);
+
+private:
+	struct Table
+	{
+		std::deque<std::string> Idents;                 /// Storage of the interned identifiers
+		std::unordered_map<std::string_view, int> Handles; /// Handle by identifier
+	};
+	std::array<Table, static_cast<size_t>(EIdentKind::Count)> Tables;
+};
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+extern CIdentTable IdentTable;  /// Interned identifiers of the engine objects
+
+//@}
+
+#endif // !__IDENT_TABLE_H__
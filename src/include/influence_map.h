@@ -0,0 +1,148 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name influence_map.h - The influence map header file. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#ifndef __INFLUENCE_MAP_H__
+#define __INFLUENCE_MAP_H__
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "settings.h"
+#include "vec2i.h"
+
+#include <vector>
+
+/*----------------------------------------------------------------------------
+--  Declarations
+----------------------------------------------------------------------------*/
+
+class CPlayer;
+class CUnit;
+
+/**
+**  Values per player summed over cells of CellSize * CellSize tiles.
+**
+**  A mask of the players having a non zero value is kept per cell, so
+**  checking if some players have something in an area doesn't look at
+**  each player.
+*/
+class CInfluenceGrid
+{
+public:
+	static constexpr int CellSize = 8;
+
+	void Init(int mapWidth, int mapHeight);
+
+	void Add(int player, const Vec2i &pos, int delta);
+	void AddCell(int player, int cell, int delta);
+	bool Any(unsigned int playerMask, const Vec2i &minPos, const Vec2i &maxPos) const;
+	int Sum(unsigned int playerMask, const Vec2i &minPos, const Vec2i &maxPos) const;
+	bool IsFull(int player, const Vec2i &minPos, const Vec2i &maxPos) const;
+
+	int GetCell(int player, int cell) const { return Values[cell * PlayerMax + player]; }
+	int CellIndex(const Vec2i &pos) const { return (pos.y / CellSize) * Width + pos.x / CellSize; }
+	int GetWidth() const { return Width; }
+	int GetHeight() const { return Height; }
+
+private:
+	bool ClipToCells(const Vec2i &minPos, const Vec2i &maxPos, Vec2i &minCell, Vec2i &maxCell) const;
+	int CellArea(int x, int y) const;
+
+	int Width = 0;   /// Number of cells in a row
+	int Height = 0;  /// Number of cells in a column
+	int MapWidth = 0;
+	int MapHeight = 0;
+	std::vector<int> Values;            /// [cell * PlayerMax + player]
+	std::vector<unsigned int> NonZero;  /// Mask of the players with a value per cell
+};
+
+/**
+**  Coarse view of the map for the AI: where the units of each player
+**  are, how strong they are and how much each player explored.
+**
+**  The unit layers are kept per owner, the AI combines them with the
+**  diplomacy of its player when it asks, as alliances change in game.
+**  Units are added and removed when they enter and leave the map unit
+**  cache, so the layers follow moves, deaths and changes of owner.
+**  The explored layer follows the tiles explored by the fog of war,
+**  it is counted again after a change of many tiles at once.
+*/
+class CInfluenceMap
+{
+public:
+	void Clear();
+
+	void OnMapInsert(const CUnit &unit);
+	void OnMapRemove(const CUnit &unit);
+	void Update(const CUnit &unit);
+	void OnTileExplored(const CPlayer &player, unsigned int index);
+	void InvalidateExplored();
+
+	bool HasUnits(unsigned int playerMask, const Vec2i &minPos, const Vec2i &maxPos);
+	int GetStrength(unsigned int playerMask, const Vec2i &minPos, const Vec2i &maxPos);
+	bool IsExplored(const CPlayer &player, const Vec2i &minPos, const Vec2i &maxPos);
+
+private:
+	/// What the map knows of a unit
+	struct Entry
+	{
+		bool OnMap = false;  /// The unit is in the map unit cache
+		int Player = -1;
+		int Width = 1;
+		int Height = 1;
+		int Strength = 0;    /// Damage the unit deals, 0 when it can't attack or is dead
+		Vec2i Pos;
+
+		bool operator==(const Entry &rhs) const;
+	};
+
+	Entry MakeEntry(const CUnit &unit, bool onMap) const;
+	void Set(const CUnit &unit, const Entry &entry);
+	void Apply(const Entry &entry, int delta);
+	void CountExplored(int player);
+	void CheckMapSize();
+
+	std::vector<Entry> Entries;   /// Indexed by unit slot
+	CInfluenceGrid UnitCells;     /// Units in the map cache overlapping each cell
+	CInfluenceGrid StrengthCells; /// Strength of the alive units by cell of their top left tile
+	CInfluenceGrid ExploredCells; /// Explored tiles of each cell
+	unsigned int ExploredValid = 0; /// Mask of the players whose explored layer is up to date
+	int MapWidth = 0;             /// Map size the grids were built for
+	int MapHeight = 0;
+};
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+extern CInfluenceMap InfluenceMap;  /// Influence map of the AI
+
+//@}
+
+#endif // !__INFLUENCE_MAP_H__
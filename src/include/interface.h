@@ -50,6 +50,7 @@
 --  Declarations
 ----------------------------------------------------------------------------*/
 
+class CPanelState;
 class CUIButton;
 class CUnit;
 struct EventCallback;
@@ -282,6 +283,8 @@ extern void AddButton(int pos, int level, const std::string &IconIdent,
 					  const std::string &popup, bool alwaysShow);
 // Check if the button is allowed for the unit.
 extern bool IsButtonAllowed(const CUnit &unit, const ButtonAction &buttonaction);
+// Get the buttons of CurrentButtons which a selected unit can't use.
+extern const std::vector<bool> &GetGrayButtons();
 
 //
 // in mouse.cpp
@@ -369,12 +372,18 @@ extern void CancelBuildingMode();
 extern void DrawMenuButtonArea();
 /// Draw user defined buttons
 extern void DrawUserDefinedButtons();
+/// Get the area and the key of the menu button area
+extern CPanelState GetMenuButtonAreaState();
+/// Get the area and the key of the user defined buttons
+extern CPanelState GetUserDefinedButtonsState();
 /// Update messages
 extern void UpdateMessages();
 /// Draw messages as overlay over of the map
 extern void DrawMessages();
 /// Draw the player resource in resource line
 extern void DrawResources();
+/// Get the area and the key of the resource line
+extern CPanelState GetResourcesState();
 /// Set message to display
 extern void SetMessage(const char *fmt, ...) PRINTF_VAARG_ATTRIBUTE(1, 2);
 /// Set message to display with event point
@@ -35,8 +35,12 @@
 #include "color.h"
 #include "vec2i.h"
 
+class CPanelState;
+class CPlayer;
+class CUnit;
 class CViewport;
 
+struct SDL_Rect;
 struct SDL_Surface;
 
 /*----------------------------------------------------------------------------
@@ -54,6 +58,11 @@ class CMinimap
 	template <const int BPP>
 	void UpdateSeen(void *const pixels, const int pitch);
 
+	void Invalidate();
+	void MarkDirty(int x, int y, int w, int h);
+	void UpdateFog();
+	void RedrawArea(const SDL_Rect &rect, int red_phase);
+
 public:
 	CMinimap() = default;
 
@@ -61,12 +70,14 @@ class CMinimap
 
 	void UpdateXY(const Vec2i &pos);
 	void UpdateSeenXY(const Vec2i &) {}
+	void UpdateUnit(const CUnit &unit);
 	void Update();
 	void Create();
 	void Destroy();
 	void Draw() const;
 	void DrawViewportArea(const CViewport &viewport, int alpha) const;
 	void AddEvent(const Vec2i &pos, IntColor color);
+	CPanelState GetState() const;
 
 	Vec2i ScreenToTilePos(const PixelPos &screenPos) const;
 	PixelPos TilePosToScreenPos(const Vec2i &tilePos) const;
@@ -91,6 +102,14 @@ class CMinimap
 	int MinimapScaleX = 0;                  /// Minimap scale to fit into window
 	int MinimapScaleY = 0;                  /// Minimap scale to fit into window
 
+	// Layer state used to detect changes which require a full repaint
+	bool LastWithTerrain = false;
+	bool LastTransparent = false;
+	bool LastShowSelected = false;
+	bool LastRevealMap = false;
+	const CPlayer *LastThisPlayer = nullptr;
+	unsigned int Version = 0;               /// Incremented when the minimap surface changes
+
 private:
 	struct MinimapSettings
 	{
@@ -361,6 +361,7 @@ class MissileType
 
 	//private:
 	std::string Ident;         /// missile name
+	int Slot = 0;              /// missile type numeric identifier
 	int Transparency = 0;      /// missile transparency
 	PixelSize size{0, 0};      /// missile size in pixels
 	int DrawLevel = 0;         /// Level to draw missile at
@@ -589,6 +590,8 @@ extern std::vector<BurningBuildingFrame> BurningBuildingFrames;  /// Burning bui
 
 /// register ccl features
 extern void MissileCclRegister();
+/// Access missile-type object
+extern MissileType *CclGetMissileType(lua_State *l);
 
 // In missile.c
 
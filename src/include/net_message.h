@@ -116,7 +116,7 @@ class CServerSetup
 		return \
 		1 + // DefeatReveal
 		1 + // Difficulty
-		1 + // FoV
+		1 + // FoV and AiPlansAhead
 		1 + // GameType
 		1 + // NumUnits
 		1 + // Opponents
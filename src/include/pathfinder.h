@@ -43,9 +43,10 @@ void DrawLastAStar(const class CViewport &vp);
 --  Declarations
 ----------------------------------------------------------------------------*/
 
-#include <queue>
+#include <memory>
 #include <sys/types.h>
 #include <utility>
+#include <vector>
 #include "vec2i.h"
 
 class CUnit;
@@ -100,24 +101,43 @@ class PathFinderInput
 	bool isRecalculatePathNeeded = true;
 };
 
+/**
+**  Path found for a unit, the next direction is the last one stored.
+**
+**  Paths longer than MAX_PATH_LENGTH are stored in a buffer taken from
+**  a pool, see AStarStoredPathLength, and given back when the unit is
+**  destroyed or stores a short path again.
+*/
 class PathFinderOutput
 {
 public:
 	enum {
 		MAX_PATH_LENGTH = 28,
+		MAX_STORED_PATH_LENGTH = 255, /// max length of a pooled path, fits in Length
 		MAX_FAST = 10,
 		MAX_OVERFLOW = 15           /// max length of precalculated path
 	};
 public:
 	PathFinderOutput();
+	~PathFinderOutput();
+	PathFinderOutput(const PathFinderOutput &) = delete;
+	PathFinderOutput &operator=(const PathFinderOutput &) = delete;
+
 	void Save(CFile &file) const;
 	void Load(lua_State *l);
+
+	char *GetPath() { return LongPath.empty() ? Path : LongPath.data(); }
+	const char *GetPath() const { return LongPath.empty() ? Path : LongPath.data(); }
+	int GetCapacity() const { return LongPath.empty() ? MAX_PATH_LENGTH : LongPath.size(); }
+	void SetCapacity(int capacity);
 public:
-	uint16_t Cycles;               /// how much Cycles we move.
+	uint16_t Cycles = 0;           /// how much Cycles we move.
 	unsigned Fast:4; /// Flag fast move (one step). Fits at most MAX_FAST
 	unsigned OverflowLength:4;      /// overflow length not stored in Path (may be more). Fits at most MAX_OVERFLOW
-	uint8_t Length;                /// stored path length
-	char Path[MAX_PATH_LENGTH];     /// directions of stored path
+	uint8_t Length = 0;            /// stored path length
+	char Path[MAX_PATH_LENGTH]{};   /// directions of stored path
+private:
+	std::vector<char> LongPath;    /// directions of a stored path longer than MAX_PATH_LENGTH
 };
 
 class PathFinderData
@@ -139,11 +159,24 @@ enum class VisitResult {
 	Cancel
 };
 
+/**
+**  Breadth first traversal of the map.
+**
+**  The buffers of a traversal come from a pool and go back to it when
+**  the traversal is destroyed, so a search doesn't allocate them again.
+**  The values are stamped with the search which wrote them: Init only
+**  starts a new search and marks the border, it doesn't clear the map.
+*/
 class TerrainTraversal
 {
 public:
 	using dataType = short int;
 public:
+	TerrainTraversal();
+	~TerrainTraversal();
+	TerrainTraversal(const TerrainTraversal &) = delete;
+	TerrainTraversal &operator=(const TerrainTraversal &) = delete;
+
 	void SetSize(unsigned int width, unsigned int height);
 	void Init();
 
@@ -163,6 +196,7 @@ class TerrainTraversal
 
 private:
 	void Set(const Vec2i &pos, dataType value);
+	void SetIndex(unsigned int index, dataType value);
 
 	struct PosNode {
 		PosNode(const Vec2i &pos, const Vec2i &from) : pos(pos), from(from) {}
@@ -170,9 +204,19 @@ class TerrainTraversal
 		Vec2i from;
 	};
 
+public:
+	/// Buffers kept in the pool between searches
+	struct Buffers
+	{
+		std::vector<dataType> values;
+		std::vector<unsigned int> generations; /// Search which wrote each value
+		unsigned int generation = 0;           /// Current search
+		std::vector<PosNode> queue;            /// Each tile is queued at most once by search
+	};
+
 private:
-	std::vector<dataType> m_values;
-	std::queue<PosNode> m_queue;
+	std::unique_ptr<Buffers> m_buffers;
+	size_t m_queueHead = 0;
 	unsigned int m_extented_width = 0;
 	unsigned int m_height = 0;
 };
@@ -180,8 +224,11 @@ class TerrainTraversal
 template <typename T>
 bool TerrainTraversal::Run(T &context)
 {
-	for (; m_queue.empty() == false; m_queue.pop()) {
-		const PosNode &posNode = m_queue.front();
+	const auto &queue = m_buffers->queue;
+
+	for (; m_queueHead != queue.size(); ++m_queueHead) {
+		// Copy, visiting the node adds nodes to the queue
+		const PosNode posNode = queue[m_queueHead];
 
 		switch (context.Visit(*this, posNode.pos, posNode.from)) {
 			case VisitResult::Finished: return true;
@@ -209,6 +256,11 @@ extern bool AStarKnowUnseenTerrain;
 extern int AStarUnknownTerrainCost;
 /// Maximum number of iterations of A* before giving up.
 extern int AStarMaxSearchIterations;
+/// Number of directions stored for the path of a unit, more than
+/// PathFinderOutput::MAX_PATH_LENGTH also repairs blocked paths locally
+extern int AStarStoredPathLength;
+/// Whether A* goes straight over uniform terrain without searching
+extern bool AStarUniformShortcut;
 
 //
 //  Convert heading into direction.
@@ -137,6 +137,11 @@ class CPlayer
 	void AddUnit(CUnit &unit);
 	void RemoveUnit(CUnit &unit);
 
+	/// Units of this player of the given type (no specific order)
+	const std::vector<CUnit *> &GetUnitsOfType(const CUnitType &type) const;
+	void AddUnitOfType(CUnit &unit);
+	void RemoveUnitOfType(CUnit &unit);
+
 	const std::vector<CUnit *> &GetFreeWorkers() const { return FreeWorkers; }
 	void UpdateFreeWorkers();
 
@@ -154,6 +159,13 @@ class CPlayer
 
 	/// Returns count of specified unittype
 	int GetUnitTotalCount(const CUnitType &type) const;
+	/// Change the count of units of a type
+	void ChangeUnitTypeCount(const CUnitType &type, int delta);
+
+	/// Note a change of the counts, the allows or the upgrade timers
+	void AvailabilityChanged() { ++AvailabilityEpoch; }
+	/// Incremented each time the availability of buttons may have changed
+	unsigned int GetAvailabilityEpoch() const { return AvailabilityEpoch; }
 	/// Check if the unit-type didn't break any unit limits and supply/demand
 	ECheckLimit CheckLimits(const CUnitType &type) const;
 
@@ -292,6 +304,8 @@ class CPlayer
 private:
 	CUnitColors UnitColors;            /// Unit colors for new units
 	std::vector<CUnit *> Units;        /// units of this player
+	std::vector<std::vector<CUnit *>> UnitsByType; /// units of this player by type slot
+	unsigned int AvailabilityEpoch = 0; /// Incremented by AvailabilityChanged
 	std::vector<CUnit *> FreeWorkers;  /// Container for free workers
 	unsigned int Enemy = 0;            /// enemy bit field for this player
 	unsigned int Allied = 0;           /// allied bit field for this player
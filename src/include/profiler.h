@@ -0,0 +1,184 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name profiler.h - The frame time profiler header file. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "filesystem.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*----------------------------------------------------------------------------
+--  Declarations
+----------------------------------------------------------------------------*/
+
+/**
+**  Timing of one instrumented section of the main loop.
+**
+**  Sections are identified by their name and their parent, so the same
+**  name used from two places shows up twice.
+*/
+struct ProfileSection
+{
+	const char *Name = nullptr; /// Name of the section (string literal)
+	int Parent = -1;            /// Index of the enclosing section, -1 for top level
+	int Depth = 0;              /// Nesting depth of the section
+	double Last = 0;            /// Time spent in the last frame (ms)
+	double Average = 0;         /// Mean time per frame during the last second (ms)
+	double Max = 0;             /// Highest time per frame during the last second (ms)
+	double Total = 0;           /// Time spent since the statistics were cleared (ms)
+	unsigned int Calls = 0;     /// Number of calls in the last frame
+
+	double Current = 0;         /// Time accumulated in the running frame (ms)
+	unsigned int CurrentCalls = 0; /// Calls in the running frame
+	double WindowSum = 0;       /// Time accumulated in the running second (ms)
+	double WindowMax = 0;       /// Highest time per frame of the running second (ms)
+};
+
+/**
+**  Scoped timer instrumentation of the main loop.
+**
+**  Timings are only taken while the overlay is shown, a trace is
+**  recorded or the benchmark mode is active.
+*/
+class CProfiler
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	bool IsEnabled() const { return Enabled; }
+	void SetOverlay(bool show) { ShowOverlay = show; UpdateEnabled(); }
+	bool IsOverlayShown() const { return ShowOverlay; }
+	void SetCollect(bool collect) { Collect = collect; UpdateEnabled(); }
+
+	void BeginFrame();
+	void EndFrame();
+
+	void Begin(const char *name);
+	void End();
+
+	void StartTrace(const fs::path &filename);
+	void StopTrace();
+	bool IsTracing() const { return Tracing; }
+	std::string TraceToJson() const;
+
+	const std::vector<ProfileSection> &GetSections() const { return Sections; }
+	double GetFrameTime() const { return FrameTime; }
+	void Print() const;
+	void Draw() const;
+	void Clear();
+
+private:
+	struct TraceEvent
+	{
+		const char *Name;
+		int64_t Start;     /// Start time in microseconds since the trace start
+		int64_t Duration;  /// Duration in microseconds
+	};
+	struct OpenScope
+	{
+		int Section;
+		Clock::time_point Start;
+	};
+
+	void UpdateEnabled() { Enabled = ShowOverlay || Collect || Tracing; }
+	int FindSection(const char *name, int parent);
+	void AddTraceEvent(const char *name, Clock::time_point start, Clock::time_point end);
+
+	bool Enabled = false;
+	bool ShowOverlay = false;
+	bool Collect = false;
+	bool Tracing = false;
+
+	std::vector<ProfileSection> Sections;
+	std::vector<OpenScope> Stack;
+	Clock::time_point FrameStart;
+	bool InFrame = false;
+	double FrameTime = 0;     /// Mean time of a whole frame during the last second (ms)
+	double FrameWindowSum = 0;
+	unsigned int FramesInWindow = 0;
+	unsigned long Frames = 0; /// Frames since the statistics were cleared
+
+	fs::path TraceFile;
+	Clock::time_point TraceStart;
+	std::vector<TraceEvent> TraceEvents;
+};
+
+/**
+**  Time the enclosing scope as a section of the profiler.
+*/
+class CProfileScope
+{
+public:
+	explicit CProfileScope(const char *name);
+	~CProfileScope();
+
+	CProfileScope(const CProfileScope &) = delete;
+	CProfileScope &operator=(const CProfileScope &) = delete;
+
+private:
+	bool Active;
+};
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+extern CProfiler Profiler;  /// Main loop profiler
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+inline CProfileScope::CProfileScope(const char *name) : Active(Profiler.IsEnabled())
+{
+	if (Active) {
+		Profiler.Begin(name);
+	}
+}
+
+inline CProfileScope::~CProfileScope()
+{
+	if (Active) {
+		Profiler.End();
+	}
+}
+
+/// Register ccl functions related to the profiler
+extern void ProfilerCclRegister();
+
+//@}
+
+#endif // !__PROFILER_H__
@@ -0,0 +1,152 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name retained_ui.h - The retained mode of the user interface header file. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#ifndef __RETAINED_UI_H__
+#define __RETAINED_UI_H__
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "sdl2_helper.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/*----------------------------------------------------------------------------
+--  Declarations
+----------------------------------------------------------------------------*/
+
+class CUIButton;
+
+/**
+**  Screen area of a panel and key of everything it shows.
+**
+**  Two states with the same area and key draw the same pixels.
+*/
+class CPanelState
+{
+public:
+	void AddArea(int x, int y, int w, int h);
+	void AddArea(const CUIButton &button);
+
+	template <typename T>
+	CPanelState &operator<<(const T &value)
+	{
+		static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>);
+		Mix(&value, sizeof(value));
+		return *this;
+	}
+	CPanelState &operator<<(std::string_view text)
+	{
+		*this << text.size();
+		Mix(text.data(), text.size());
+		return *this;
+	}
+	CPanelState &operator<<(const std::string &text) { return *this << std::string_view(text); }
+	CPanelState &operator<<(const char *text) { return *this << std::string_view(text); }
+
+	const SDL_Rect &GetArea() const { return Area; }
+	uint64_t GetKey() const { return Key; }
+
+private:
+	void Mix(const void *data, size_t size);
+
+	SDL_Rect Area{0, 0, 0, 0};
+	uint64_t Key = 0xcbf29ce484222325ULL;
+};
+
+/**
+**  Pixels of a panel kept from the last time it was drawn.
+*/
+class CRetainedPanel
+{
+public:
+	void Invalidate() { Valid = false; }
+
+private:
+	friend class CRetainedUI;
+
+	sdl2::SurfacePtr Surface;    /// Copy of the area of the screen
+	SDL_Rect Area{0, 0, 0, 0};   /// Area of the screen kept
+	uint64_t Key = 0;            /// Key of the state drawn
+	unsigned long PaintFrame = 0; /// Frame of the last paint
+	unsigned int Generation = 0;  /// Generation of the retained mode when painted
+	bool Valid = false;
+	bool SetsStatusLine = false; /// Status line text set when painted
+	std::string StatusLine;
+};
+
+/**
+**  Retained mode of the user interface.
+**
+**  The panels are drawn once in the screen, then copied back from their
+**  cache as long as their state doesn't change. Only the viewports, the
+**  panels drawn again and what is drawn over them are sent to the
+**  renderer.
+*/
+class CRetainedUI
+{
+public:
+	bool IsActive() const { return Active; }
+
+	void BeginFrame(bool active);
+	void DrawPanel(CRetainedPanel &panel, const std::function<CPanelState()> &getState,
+	               const std::function<void()> &draw);
+	void AddDamage(int x, int y, int w, int h);
+	void AddDamage(const SDL_Rect &rect) { AddDamage(rect.x, rect.y, rect.w, rect.h); }
+	void PresentAll() { FullPresent = true; }
+	void EndFrame();
+	void Reset();
+	bool TakePartialPresent();
+
+private:
+	bool Overlaps(const SDL_Rect &rect) const;
+
+	bool Active = false;       /// Retained mode used in this frame
+	bool FullPresent = true;   /// The whole screen must be presented
+	bool PartialPresent = false; /// The last frame only invalidated its damaged areas
+	std::vector<SDL_Rect> Damage;     /// Areas to present in this frame
+	std::vector<SDL_Rect> LastDamage; /// Areas presented in the last frame
+	std::vector<SDL_Rect> Painted;    /// Areas drawn again in this frame
+	unsigned int Generation = 1;      /// Incremented when all the panels are forgotten
+};
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+extern CRetainedUI RetainedUI;  /// Retained mode of the user interface
+
+//@}
+
+#endif // !__RETAINED_UI_H__
@@ -68,7 +68,9 @@ struct LuaUserData {
 
 enum {
 	LuaUnitType = 100,
-	LuaSoundType
+	LuaSoundType,
+	LuaUpgradeType,
+	LuaMissileType
 };
 
 /**
@@ -491,6 +493,15 @@ class StringDescPlayerName : public IStringDesc
 	std::unique_ptr<INumberDesc> playerIndex;
 };
 
+/// Statistics of the lua collector
+struct LuaGCStatistics
+{
+	int HeapKB = 0;          /// Size of the lua heap (KB)
+	double LastTime = 0;     /// Time of the last idle collection (ms)
+	double TotalTime = 0;    /// Time of all the idle collections (ms)
+	unsigned int Cycles = 0; /// Cycles completed in the idle time
+};
+
 /*----------------------------------------------------------------------------
 --  Variables
 ----------------------------------------------------------------------------*/
@@ -513,6 +524,10 @@ extern unsigned int LuaToUnsignedNumber(lua_State *l, int index, int subIndex);
 extern bool LuaToBoolean(lua_State *l, int index, int subIndex);
 
 extern void LuaGarbageCollect();  /// Perform garbage collection
+extern void LuaGarbageCollectBeginGame(); /// Stop the automatic collection in frame mode
+extern void LuaGarbageCollectEndGame();   /// Restart the automatic collection
+extern void LuaGarbageCollectStep(unsigned int idleMs); /// Collect in the idle time of a frame
+extern const LuaGCStatistics &GetLuaGCStatistics();
 extern void InitLua();                /// Initialise Lua
 extern void LoadCcl(const fs::path &filename, const std::string &luaArgStr = "");  /// Load ccl config file
 extern void SavePreferences();        /// Save user preferences
@@ -249,6 +249,7 @@ struct Settings {
 	unsigned AiChecksDependencies:1; /// If false, the AI can do upgrades even if the dependencies are not met. This can be desirable to simplify AI scripting.
 	unsigned AllyDepositsAllowed:1; /// If false, the AI does not consider allied player's townhalls as deposits, so it will prefer harvesting gold closer to their own base
 	unsigned UserGameSettings:26; /// A bitfield for use by games and their settings
+	unsigned AiPlansAhead:1;      /// If true, the AI plans on a worker thread and its decisions are applied some cycles later, not in the bitfield
 
 	bool GetUserGameSetting(int i) {
 		return std::bitset<26>(UserGameSettings).test(i);
@@ -293,7 +294,8 @@ struct Settings {
 			FoV == other.FoV &&
 			RevealMap == other.RevealMap &&
 			DefeatReveal == other.DefeatReveal &&
-			getBitfield() == other.getBitfield();
+			getBitfield() == other.getBitfield() &&
+			AiPlansAhead == other.AiPlansAhead;
 	}
 
 	void Save(const std::function <void (std::string)>& f, bool withPlayers = true) {
@@ -314,6 +316,7 @@ struct Settings {
 		f(std::string("RevealMap = ") + std::to_string(static_cast<int>(RevealMap)));
 		f(std::string("DefeatReveal = ") + std::to_string(static_cast<int>(DefeatReveal)));
 		f(std::string("Flags = ") + std::to_string(getBitfield()));
+		f(std::string("AiPlansAhead = ") + (AiPlansAhead ? "true" : "false"));
 	}
 
 	bool SetField(std::string field, int value) {
@@ -337,6 +340,8 @@ struct Settings {
 			DefeatReveal = static_cast<RevealTypes>(value);
 		} else if (field == "Flags") {
 			setBitfield(value);
+		} else if (field == "AiPlansAhead") {
+			AiPlansAhead = value != 0;
 		} else {
 			return false;
 		}
@@ -362,6 +367,7 @@ struct Settings {
 		AiExplores = 1;
 		AiChecksDependencies = 0;
 		AllyDepositsAllowed = 0;
+		AiPlansAhead = 0;
 		SimplifiedAutoTargeting = 0;
 		UserGameSettings = 0;
 	}
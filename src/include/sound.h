@@ -193,6 +193,9 @@ extern std::shared_ptr<CSound> RegisterSound(const std::vector<std::string> &fil
 ///  Create a special sound group with two sounds
 extern std::shared_ptr<CSound> RegisterTwoGroups(CSound *first, CSound *second);
 
+/// Decode the samples of a sound in the background
+extern void PrefetchSound(const CSound *sound);
+
 /// Initialize client side of the sound layer.
 extern void InitSoundClient();
 
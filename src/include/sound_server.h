@@ -68,6 +68,8 @@ extern bool SampleIsPlaying(Mix_Chunk *sample);
 extern Mix_Music *LoadMusic(const std::string &name);
 /// Load a sample
 extern sdl2::ChunkPtr LoadSample(const std::string &name);
+/// Decode a not yet loaded sample in the background
+extern void PrefetchSample(Mix_Chunk *sample);
 /// Play a sample
 extern int PlaySample(Mix_Chunk *sample, Origin *origin = nullptr);
 /// Play a sample, registering a "finished" callback
@@ -58,6 +58,15 @@ class CTimer
 	unsigned long LastUpdate = 0; /// GameCycle of last update
 };
 
+/// Engine events a trigger condition can wait for
+enum class ETriggerEvent : unsigned int {
+	UnitCreated = 1 << 0,     /// A unit was created
+	UnitDied = 1 << 1,        /// A unit died
+	AreaEntered = 1 << 2,     /// A unit was placed or moved (in the trigger area)
+	Timer = 1 << 3,           /// The game timer was set, started, stopped, ticked a second or expired
+	ResourceChanged = 1 << 4  /// Resources of a player changed
+};
+
 /**
 **  Data to refer game info when game running.
 */
@@ -84,6 +93,8 @@ extern TriggerDataType TriggerData;
 std::function<bool(const CUnit &)> TriggerGetPlayer(lua_State *l); /// get the unit-player validator
 std::function<bool(const CUnit &)> TriggerGetUnitType(lua_State *l); /// get the unit-type validator
 void TriggersEachCycle();    /// test triggers
+void TriggerNotifyEvent(ETriggerEvent event); /// wake up the triggers waiting for an event
+void TriggerNotifyUnitEntered(const CUnit &unit); /// wake up the triggers watching the unit's area
 
 void TriggerCclRegister();   /// Register ccl features
 void SaveTriggers(CFile &file); /// Save the trigger module
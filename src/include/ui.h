@@ -67,6 +67,7 @@
 ----------------------------------------------------------------------------*/
 
 class CContentType;
+class CPanelState;
 class CUnit;
 class CFile;
 class CFont;
@@ -263,6 +264,9 @@ class CButtonPanel
 	CButtonPanel() = default;
 
 	void Draw();
+	void DrawButtons();
+	void DrawHoveredButton();
+	CPanelState GetState() const;
 	void Update();
 	void DoClicked(int button);
 	bool DoKey(int key);
@@ -339,6 +343,7 @@ class CInfoPanel
 	CInfoPanel() = default;
 
 	void Draw();
+	CPanelState GetState() const;
 
 	std::shared_ptr<CGraphic> G;
 	int X = 0;
@@ -37,6 +37,7 @@
 #include "upgrade_structs.h"
 
 class CFont;
+class CPanelState;
 
 class CStatusLine
 {
@@ -45,9 +46,11 @@ class CStatusLine
 
 	void Draw();
 	void DrawCosts();
+	CPanelState GetState() const;
 	void Set(const std::string &status);
 	void SetCosts(int mana, int food, const int *costs);
 	const std::string &Get() const { return this->StatusLine; }
+	unsigned int GetSetCount() const { return this->SetCount; }
 	void Clear();
 	void ClearCosts();
 
@@ -60,6 +63,7 @@ class CStatusLine
 
 private:
 	std::string StatusLine;
+	unsigned int SetCount = 0; /// Number of times the text was set
 };
 
 //@}
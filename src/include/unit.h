@@ -58,6 +58,7 @@
 ----------------------------------------------------------------------------*/
 
 class CAnimation;
+struct CAnimProgram;
 class CBuildRestrictionOnTop;
 class CConstructionFrame;
 class CFile;
@@ -161,6 +162,8 @@ class CUnit
 	void Init(const CUnitType &type);
 	/// Assign unit to player
 	void AssignToPlayer(CPlayer &player);
+	/// Change the type of the unit, keeping the per-type unit lists up to date
+	void SetType(const CUnitType &type);
 
 	/// Draw a single unit
 	void Draw(const CViewport &vp) const;
@@ -316,6 +319,7 @@ class CUnit
 	private:
 		int slot = -1;     /// index in UnitManager::unitSlots
 		int unitSlot = -1; /// index in UnitManager::units
+		int typeSlot = -1; /// index in UnitManager::unitsByType[Type->Slot]
 	};
 public:
 	// @note int is faster than shorts
@@ -323,6 +327,7 @@ class CUnit
 	unsigned int     ReleaseCycle = 0; /// When this unit could be recycled
 	CUnitManagerData UnitManagerData;
 	size_t PlayerSlot = 0;  /// index in Player->Units
+	size_t PlayerTypeSlot = static_cast<size_t>(-1); /// index in Player->UnitsByType[Type->Slot]
 
 	std::vector<CUnit *> InsideUnits; /// Units inside.
 	CUnit *Container = nullptr;     /// Pointer to the unit containing it (or 0)
@@ -413,6 +418,7 @@ class CUnit
 
 	struct _unit_anim_ {
 		const std::vector<std::unique_ptr<CAnimation>>* CurrAnim = nullptr;  /// CurrAnim
+		const CAnimProgram *Program = nullptr; /// Compiled CurrAnim, refreshed when CurrAnim changes
 		std::size_t Anim = 0; /// Anim
 		short Wait = 0;                  /// Wait time
 		signed char Rotate = 0;          /// Rotation target and direction
@@ -460,6 +466,7 @@ class CPreference
 	bool HardwareCursor = false;       /// If true, uses the hardware to draw the cursor. Shaders do no longer apply to the cursor, but this way it's decoupled from the game refresh rate
 	bool SelectionRectangleIndicatesDamage = false; /// If true, the selection rectangle interpolates color to indicate damage
 	bool FormationMovement = true; /// If true, player controlled units stay in formation
+	bool RetainedUI = false;       /// If true, the panels are redrawn only when they change and only the changed areas are presented
 
 	int FrameSkip = 0;          /// Mask used to skip rendering frames (useful for slow renderers that keep up with the game logic, but not the rendering to screen like e.g. original Raspberry Pi)
 
@@ -480,12 +487,14 @@ class CPreference
 		s.SimplifiedAutoTargeting = SimplifiedAutoTargeting;
 		s.AiChecksDependencies = AiChecksDependencies;
 		s.AllyDepositsAllowed = AllyDepositsAllowed;
+		s.AiPlansAhead = AiPlansAhead;
 	}
 private:
 	bool AiExplores = true;
 	bool SimplifiedAutoTargeting = false;
 	bool AiChecksDependencies = false;
 	bool AllyDepositsAllowed = false;
+	bool AiPlansAhead = false;
 
 #if USING_TOLUAPP
 public:
@@ -509,6 +518,11 @@ class CPreference
 		AllyDepositsAllowed = v;
 		GameSettings.AllyDepositsAllowed = v;
 	}
+	bool get_AiPlansAhead() const { return AiPlansAhead; }
+	void set_AiPlansAhead(bool v) {
+		AiPlansAhead = v;
+		GameSettings.AiPlansAhead = v;
+	}
 #endif
 };
 
@@ -0,0 +1,158 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name unit_area_count.h - The unit area count index header file. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+
+#ifndef __UNIT_AREA_COUNT_H__
+#define __UNIT_AREA_COUNT_H__
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "vec2i.h"
+
+#include <memory>
+#include <vector>
+
+/*----------------------------------------------------------------------------
+--  Declarations
+----------------------------------------------------------------------------*/
+
+class CUnit;
+class CUnitType;
+
+/**
+**  Binary indexed tree counting points on a grid.
+**
+**  Adding a point and counting the points of a rectangle both take
+**  O(log(width) * log(height)).
+*/
+class CAreaCountTree
+{
+public:
+	CAreaCountTree(int width, int height);
+
+	void Add(const Vec2i &pos, int delta);
+	int Count(Vec2i minPos, Vec2i maxPos) const;
+
+	int GetWidth() const { return Width; }
+	int GetHeight() const { return Height; }
+
+private:
+	int Prefix(int x, int y) const;
+
+	int Width;
+	int Height;
+	std::vector<int> Cells;
+};
+
+/// Units selected by an area count
+enum class EUnitCountKind {
+	Any,       /// all units and buildings
+	Units,     /// everything but buildings
+	Buildings, /// buildings, also the ones under construction
+	Type       /// finished units of one type
+};
+
+/**
+**  Number of alive units on the map per player and unit type.
+**
+**  The index of a player and unit type (or unit category) is built
+**  the first time it is queried and then kept up to date when units
+**  are inserted in or removed from the map.
+**  All units of a tree have the same size, so the units overlapping a
+**  rectangle are the ones with their top left tile in the rectangle
+**  extended by the unit size.
+*/
+class CUnitAreaCount
+{
+public:
+	void Clear();
+
+	void OnMapInsert(const CUnit &unit);
+	void OnMapRemove(const CUnit &unit);
+	void Update(const CUnit &unit);
+
+	int Count(int player, EUnitCountKind kind, const CUnitType *type, const Vec2i &minPos, const Vec2i &maxPos);
+	bool IsCounted(const CUnit &unit, int player, EUnitCountKind kind, const CUnitType *type) const;
+
+private:
+	/// What the index knows of a unit
+	struct Entry
+	{
+		bool OnMap = false;       /// The unit is in the map unit cache
+		bool Counted = false;     /// The unit is on the map and alive
+		bool Building = false;
+		bool Constructed = false;
+		int Player = -1;
+		int TypeSlot = -1;
+		int Width = 1;
+		int Height = 1;
+		Vec2i Pos;
+
+		bool operator==(const Entry &rhs) const;
+	};
+	/// Units of a category and size of a player
+	struct SizeTree
+	{
+		int Width;
+		int Height;
+		CAreaCountTree Tree;
+	};
+	struct Category
+	{
+		bool Tracked = false;
+		std::vector<SizeTree> Sizes;
+	};
+
+	Entry MakeEntry(const CUnit &unit, bool onMap) const;
+	void Set(const CUnit &unit, const Entry &entry);
+	void Apply(const Entry &entry, int delta);
+	CAreaCountTree *FindTypeTree(int player, int typeSlot) const;
+	CAreaCountTree &FindSizeTree(Category &category, int width, int height);
+	CAreaCountTree &TrackType(int player, const CUnitType &type);
+	Category &TrackCategory(int player, bool building);
+	int CountCategory(int player, bool building, const Vec2i &minPos, const Vec2i &maxPos);
+	void CheckMapSize();
+
+	std::vector<Entry> Entries;   /// Indexed by unit slot
+	std::vector<std::vector<std::unique_ptr<CAreaCountTree>>> TypeTrees; /// [player][type slot]
+	std::vector<Category> Categories; /// [player * 2 + building]
+	bool Tracking = false;        /// At least one tree exists
+	int MapWidth = 0;             /// Map size the trees were built for
+	int MapHeight = 0;
+};
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+extern CUnitAreaCount UnitAreaCount;  /// Unit counts of map areas
+
+//@}
+
+#endif // !__UNIT_AREA_COUNT_H__
@@ -44,6 +44,7 @@
 ----------------------------------------------------------------------------*/
 
 class CUnit;
+class CUnitType;
 class CFile;
 struct lua_State;
 
@@ -61,6 +62,9 @@ class CUnitManager
 	// Following is for already allocated Unit (no specific order)
 	void Add(CUnit *unit);
 	const std::vector<CUnit *> &GetUnits() const { return units; }
+	const std::vector<CUnit *> &GetUnitsOfType(const CUnitType &type) const;
+	void AddUnitOfType(CUnit &unit);
+	void RemoveUnitOfType(CUnit &unit);
 
 	bool empty() const;
 
@@ -72,6 +76,7 @@ class CUnitManager
 
 private:
 	std::vector<CUnit *> units;
+	std::vector<std::vector<CUnit *>> unitsByType; /// units indexed by their type slot
 	std::vector<CUnit *> unitSlots;
 	std::list<CUnit *> releasedUnits;
 	CUnit *lastCreated = nullptr;
@@ -107,6 +107,11 @@ extern void LoadUnitSounds();
 */
 extern void MapUnitSounds();
 
+/**
+**  Decodes in the background the voices of the unit types on the map.
+*/
+extern void PrefetchUnitSounds();
+
 //@}
 
 #endif // !__UNITSOUND_H__
@@ -44,6 +44,7 @@ class CPlayer;
 class CUpgrade;
 class CUnit;
 class CUpgradeModifier;
+struct lua_State;
 
 /*----------------------------------------------------------------------------
 --  Variables
@@ -69,6 +70,8 @@ extern void CleanUpgrades();
 
 /// Register CCL features for upgrades
 extern void UpgradesCclRegister();
+/// Access upgrade object
+extern CUpgrade *CclGetUpgrade(lua_State *l);
 
 /*----------------------------------------------------------------------------
 --  General/Map functions
@@ -176,6 +176,10 @@ class CUpgradeModifier
 	char ChangeUpgrades[UpgradeMax]{}; /// allow/forbid upgrades
 	char ApplyTo[UnitTypeMax]{};       /// which unit types are affected
 
+	std::vector<int> ChangedUnitTypes; /// unit types whose ChangeUnits is set
+	std::vector<int> ChangedUpgrades;  /// upgrades whose ChangeUpgrades is set
+	std::vector<int> ApplyToTypes;     /// unit types whose ApplyTo is 'X'
+
 	CUnitType *ConvertTo = nullptr;    /// convert to this unit-type.
 };
 
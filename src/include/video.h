@@ -179,15 +179,33 @@ class CGraphic : public gcn::SDLImage
 	int getWidth() const override { return Width; }
 	int getHeight() const override { return Height; }
 
-	void setSurface(SDL_Surface *surface) { mSurface = surface; }
+	void setSurface(SDL_Surface *surface)
+	{
+		mSurface = surface;
+		DrawSurface.reset();
+		DrawSurfaceFlip.reset();
+		TransDrawSurface.reset();
+		TransDrawSurfaceFlip.reset();
+	}
 
 	int GetGraphicWidth() const { return mSurface ? mSurface->w : 0; }
 	int GetGraphicHeight() const { return mSurface ? mSurface->h : 0; }
 
 	int GetFrameCountPerRow() const { return mSurface ? mSurface->w / Width : 0; }
 
+	const char *GetBlitConversion() const;
+
 private:
 	void ExpandFor(const uint16_t numOfFramesToAdd);
+	void PrepareDrawSurfaces();
+	SDL_Surface *GetDrawSurface(bool flipped = false) const;
+	void BlitTrans(SDL_Rect &srect, SDL_Rect &drect, unsigned char alpha, SDL_Surface *surface,
+	               bool flipped = false) const;
+
+	sdl2::SurfacePtr DrawSurface;     /// Surface converted to the screen layout, if needed
+	sdl2::SurfacePtr DrawSurfaceFlip; /// Flipped surface converted to the screen layout, if needed
+	mutable sdl2::SurfacePtr TransDrawSurface;     /// Not RLE encoded DrawSurface, for the translucent draws
+	mutable sdl2::SurfacePtr TransDrawSurfaceFlip; /// Not RLE encoded DrawSurfaceFlip, for the translucent draws
 
 public:
 	fs::path File;         /// Filename
@@ -202,6 +220,7 @@ class CGraphic : public gcn::SDLImage
 	int OriginWidth = 0;   /// Origin graphic width
 	int OriginHeight = 0;  /// Origin graphic height
 	bool Resized = false;  /// Image has been resized
+	bool KeepPalette = false; /// Palette is changed before drawing, draw the paletted surface
 
 	friend class CFont;
 };
@@ -209,7 +228,7 @@ class CGraphic : public gcn::SDLImage
 class CPlayerColorGraphic : public CGraphic
 {
 public:
-	CPlayerColorGraphic() = default;
+	CPlayerColorGraphic() { KeepPalette = true; }
 
 	void DrawPlayerColorFrameClipX(int colorIndex, unsigned frame, int x, int y,
 								   SDL_Surface *surface = TheScreen);
@@ -542,6 +561,8 @@ inline int GetColorIndexByName(std::string_view colorName) {
 }
 
 extern void FreeGraphics();
+/// Print the loaded graphics which are blitted with a pixel format conversion
+extern void PrintGraphicBlitConversions();
 
 //
 //  Color Cycling stuff
@@ -553,6 +574,7 @@ extern void ClearAllColorCyclingRange();
 extern void AddColorCyclingRange(unsigned int begin, unsigned int end);
 extern unsigned int SetColorCycleSpeed(unsigned int speed);
 extern void SetColorCycleAll(bool value);
+extern bool IsSurfaceColorCycled(const SDL_Surface &surface);
 extern void RestoreColorCyclingSurface();
 
 /// Does ColorCycling..
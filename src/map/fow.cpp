@@ -102,6 +102,9 @@ void CFogOfWar::Init()
 
     VisTable_Index0 = VisTableWidth + 1;
 
+    VisChanges.clear();
+    VisChanges.resize(Map.Info.MapHeight);
+
     switch (Settings.Type) {
         case FogOfWarTypes::cTiled:
         case FogOfWarTypes::cTiledLegacy:
@@ -201,6 +204,7 @@ void CFogOfWar::Clean(const bool isHardClean /*= false*/)
     VisTable.clear();
     VisTableWidth   = 0;
     VisTable_Index0 = 0;
+    VisChanges.clear();
 
     switch (Settings.Type) {
         case FogOfWarTypes::cTiled:
@@ -316,11 +320,11 @@ void CFogOfWar::GenerateFog()
 
             const size_t visIndex = VisTable_Index0 + row * VisTableWidth;
             const size_t mapIndex = size_t(row) * Map.Info.MapWidth;
+            ChangedColumns &changes = VisChanges[row]; /// each row is written by one thread only
 
             for (uint16_t col = 0; col < Map.Info.MapWidth; col++) {
 
-                uint8_t &visCell = VisTable[visIndex + col];
-                visCell = 0; /// Clear it before check for players
+                uint8_t visCell = 0;
                 const CMapField *mapField = Map.Field(mapIndex + col);
                 for (const uint8_t player : playersToRenderView) {
                     visCell = std::max<uint8_t>(visCell, mapField->playerInfo.Visible[player]);
@@ -329,6 +333,12 @@ void CFogOfWar::GenerateFog()
                         break;
                     }
                 }
+                uint8_t &oldCell = VisTable[visIndex + col];
+                if (oldCell != visCell) {
+                    oldCell = visCell;
+                    changes.First = std::min(changes.First, col);
+                    changes.Last  = std::max(changes.Last, col);
+                }
             }
         }
     }
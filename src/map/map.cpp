@@ -39,10 +39,12 @@
 #include "map.h"
 
 #include "fov.h"
+#include "influence_map.h"
 #include "iolib.h"
 #include "player.h"
 #include "tileset.h"
 #include "unit.h"
+#include "unit_area_count.h"
 #include "unit_manager.h"
 #include "ui.h"
 #include "version.h"
@@ -148,6 +150,7 @@ void CMap::Reveal(MapRevealModes mode /* = MapRevealModes::cKnown */ )
 			}
 			MarkSeenTile(mf);
 		}
+		InfluenceMap.InvalidateExplored();
 	}
 
 	//  Global seen recount. Simple and effective.
@@ -696,6 +699,7 @@ void CMap::Insert(CUnit &unit)
 	const int h = unit.Type->TileHeight;
 	int i = h;
 
+	UI.Minimap.UpdateUnit(unit);
 	do {
 		CMapField *mf = Field(index);
 		int j = w;
@@ -705,6 +709,8 @@ void CMap::Insert(CUnit &unit)
 		} while (--j && unit.tilePos.x + (j - w) < Info.MapWidth);
 		index += Info.MapWidth;
 	} while (--i && unit.tilePos.y + (i - h) < Info.MapHeight);
+	UnitAreaCount.OnMapInsert(unit);
+	InfluenceMap.OnMapInsert(unit);
 }
 
 /**
@@ -720,6 +726,7 @@ void CMap::Remove(CUnit &unit)
 	const int h = unit.Type->TileHeight;
 	int i = h;
 
+	UI.Minimap.UpdateUnit(unit);
 	do {
 		CMapField *mf = Field(index);
 		int j = w;
@@ -729,6 +736,8 @@ void CMap::Remove(CUnit &unit)
 		} while (--j && unit.tilePos.x + (j - w) < Info.MapWidth);
 		index += Info.MapWidth;
 	} while (--i && unit.tilePos.y + (i - h) < Info.MapHeight);
+	UnitAreaCount.OnMapRemove(unit);
+	InfluenceMap.OnMapRemove(unit);
 }
 
 void CMap::Clamp(Vec2i &pos) const
@@ -41,6 +41,7 @@
 
 #include "actions.h"
 #include "fov.h"
+#include "influence_map.h"
 #include "minimap.h"
 #include "player.h"
 #include "tileset.h"
@@ -222,6 +223,9 @@ void MapMarkTileSight(const CPlayer &player, const unsigned int index)
 		if (!Map.NoFogOfWar || *v == 0) {
 			UnitsOnTileMarkSeen(player, mf, 0);
 		}
+		if (*v == 0) {
+			InfluenceMap.OnTileExplored(player, index);
+		}
 		*v = 2;
 		if (mf.playerInfo.IsTeamVisible(*ThisPlayer)) {
 			Map.MarkSeenTile(mf);
@@ -40,10 +40,12 @@
 #include "editor.h"
 #include "map.h"
 #include "player.h"
+#include "retained_ui.h"
 #include "settings.h"
 #include "unit.h"
 #include "unit_manager.h"
 #include "ui.h"
+#include "unit_find.h"
 #include "unittype.h"
 #include "video.h"
 
@@ -62,6 +64,9 @@ static constexpr int ATTACK_BLINK_DURATION {7 * CYCLES_PER_SECOND};
 
 static constexpr int SCALE_PRECISION       {100};
 
+/// size (in minimap pixels) of the blocks used to track changed minimap areas
+static constexpr int MINIMAP_BLOCK_SIZE    {16};
+
 /*----------------------------------------------------------------------------
 --  Variables
 ----------------------------------------------------------------------------*/
@@ -69,12 +74,37 @@ static constexpr int SCALE_PRECISION       {100};
 SDL_Surface        *MinimapSurface{nullptr};        /// generated minimap
 static SDL_Surface *MinimapTerrainSurface{nullptr}; /// generated minimap terrain
 static SDL_Surface *MinimapFogSurface{nullptr};     /// generated minimap fog of war
+static SDL_Surface *MinimapUnitsSurface{nullptr};   /// generated minimap unit dots
 
 static std::vector<int> Minimap2MapX;      /// fast conversion table
 static std::vector<int> Minimap2MapY;      /// fast conversion table
 static int Map2MinimapX[MaxMapWidth];      /// fast conversion table
 static int Map2MinimapY[MaxMapHeight];     /// fast conversion table
 
+/// Map row or column shown on the minimap with the range of minimap pixels it covers
+struct MinimapSpan {
+	int Tile;
+	int First;
+	int Count;
+};
+static std::vector<MinimapSpan> MinimapSampledX; /// map columns shown on the minimap
+static std::vector<MinimapSpan> MinimapSampledY; /// map rows shown on the minimap
+static std::vector<uint16_t> MinimapFogAlpha; /// fog alpha last drawn for each map tile
+static bool MinimapFogFullUpdate;             /// walk all tiles on the next fog update
+static uint8_t MinimapFogUnseenAlpha;         /// alpha of the unseen tiles on the last fog update
+
+static int MinimapBlocksX;                 /// number of dirty blocks in a minimap row
+static int MinimapBlocksY;                 /// number of dirty blocks in a minimap column
+static std::vector<uint8_t> MinimapDirtyBlocks; /// blocks to recompose on next update
+
+/// Area of an attacked unit of ThisPlayer which blinks on the minimap
+struct MinimapBlinkArea {
+	Vec2i pos;
+	Vec2i size;
+	unsigned long until;
+};
+static std::vector<MinimapBlinkArea> MinimapBlinkAreas;
+
 #define MAX_MINIMAP_EVENTS 8
 
 struct MinimapEvent {
@@ -131,23 +161,83 @@ void CMinimap::Create()
 	for (int i = 0; i < Map.Info.MapHeight; ++i) {
 		Map2MinimapY[i] = (i * MinimapScaleY) / MINIMAP_FAC;
 	}
+	MinimapSampledX.clear();
+	for (int i = XOffset; i < W - XOffset; ++i) {
+		if (MinimapSampledX.empty() || MinimapSampledX.back().Tile != Minimap2MapX[i]) {
+			MinimapSampledX.push_back({Minimap2MapX[i], i, 0});
+		}
+		++MinimapSampledX.back().Count;
+	}
+	MinimapSampledY.clear();
+	for (int i = YOffset; i < H - YOffset; ++i) {
+		const int y = Minimap2MapY[i] / Map.Info.MapWidth;
+		if (MinimapSampledY.empty() || MinimapSampledY.back().Tile != y) {
+			MinimapSampledY.push_back({y, i, 0});
+		}
+		++MinimapSampledY.back().Count;
+	}
+	// Force the first fog update to draw every tile
+	MinimapFogAlpha.assign(Map.Info.MapWidth * Map.Info.MapHeight, 0xFFFF);
+	MinimapFogFullUpdate = true;
+	MinimapBlinkAreas.clear();
+
+	MinimapBlocksX = (W + MINIMAP_BLOCK_SIZE - 1) / MINIMAP_BLOCK_SIZE;
+	MinimapBlocksY = (H + MINIMAP_BLOCK_SIZE - 1) / MINIMAP_BLOCK_SIZE;
 
 	// Palette updated from UpdateMinimapTerrain()
 	SDL_PixelFormat *f    = Map.TileGraphic->getSurface()->format;
 	MinimapTerrainSurface = SDL_CreateRGBSurface(SDL_SWSURFACE, W, H, f->BitsPerPixel, f->Rmask, f->Gmask, f->Bmask, f->Amask);
 	MinimapSurface 		  = SDL_CreateRGBSurface(SDL_SWSURFACE, W, H, 32, RMASK, GMASK, BMASK, 0);
 	MinimapFogSurface 	  = SDL_CreateRGBSurface(SDL_SWSURFACE, W, H, 32, RMASK, GMASK, BMASK, AMASK);
+	MinimapUnitsSurface   = SDL_CreateRGBSurface(SDL_SWSURFACE, W, H, 32, RMASK, GMASK, BMASK, AMASK);
 
     SDL_SetSurfaceBlendMode(MinimapFogSurface, SDL_BLENDMODE_BLEND);
+	SDL_SetSurfaceBlendMode(MinimapUnitsSurface, SDL_BLENDMODE_BLEND);
+	SDL_FillRect(MinimapUnitsSurface, nullptr, 0);
 
 	const uint32_t fogColorSolid = FogOfWar->GetFogColorSDL() | (uint32_t(0xFF) << ASHIFT);
 	SDL_FillRect(MinimapFogSurface, nullptr, fogColorSolid);
 
 	UpdateTerrain();
+	Invalidate();
+	++Version;
 
 	NumMinimapEvents = 0;
 }
 
+/**
+**  Mark the whole minimap to be recomposed on the next update.
+*/
+void CMinimap::Invalidate()
+{
+	MinimapDirtyBlocks.assign(MinimapBlocksX * MinimapBlocksY, 1);
+}
+
+/**
+**  Mark a minimap area to be recomposed on the next update.
+**
+**  @param x  Left side of the area in minimap pixels.
+**  @param y  Top side of the area in minimap pixels.
+**  @param w  Width of the area in minimap pixels.
+**  @param h  Height of the area in minimap pixels.
+*/
+void CMinimap::MarkDirty(int x, int y, int w, int h)
+{
+	if (MinimapDirtyBlocks.empty() || w <= 0 || h <= 0) {
+		return;
+	}
+	const int bx0 = std::clamp(x / MINIMAP_BLOCK_SIZE, 0, MinimapBlocksX - 1);
+	const int by0 = std::clamp(y / MINIMAP_BLOCK_SIZE, 0, MinimapBlocksY - 1);
+	const int bx1 = std::clamp((x + w - 1) / MINIMAP_BLOCK_SIZE, 0, MinimapBlocksX - 1);
+	const int by1 = std::clamp((y + h - 1) / MINIMAP_BLOCK_SIZE, 0, MinimapBlocksY - 1);
+
+	for (int by = by0; by <= by1; ++by) {
+		for (int bx = bx0; bx <= bx1; ++bx) {
+			MinimapDirtyBlocks[bx + by * MinimapBlocksX] = 1;
+		}
+	}
+}
+
 /**
 **  Calculate the tile graphic pixel
 */
@@ -227,6 +317,7 @@ void CMinimap::SetFogOpacityLevels(const uint8_t explored, const uint8_t reveale
     this->Settings.FogExploredOpacity = explored;
     this->Settings.FogRevealedOpacity = revealed;
     this->Settings.FogUnseenOpacity   = unseen;
+    MinimapFogFullUpdate = true;
 }
 
 /**
@@ -258,6 +349,8 @@ void CMinimap::UpdateXY(const Vec2i &pos)
 
 	const int ty = pos.y * Map.Info.MapWidth;
 	const int tx = pos.x;
+	MarkDirty(XOffset + Map2MinimapX[tx], YOffset + Map2MinimapY[pos.y],
+	          Map2MinimapX[1] + 1, Map2MinimapY[1] + 1);
 	for (int my = YOffset; my < H - YOffset; ++my) {
 		const int y = Minimap2MapY[my];
 		if (y < ty) {
@@ -303,9 +396,13 @@ void CMinimap::UpdateXY(const Vec2i &pos)
 }
 
 /**
-**  Draw a unit on the minimap.
+**  Draw a unit on the minimap units layer.
+**
+**  @param unit       Unit to draw.
+**  @param red_phase  Blink phase for attacked units.
+**  @param clip       Minimap area to draw into.
 */
-static void DrawUnitOn(const CUnit &unit, int red_phase)
+static void DrawUnitOn(const CUnit &unit, int red_phase, const SDL_Rect &clip)
 {
 	const CUnitType *type;
 
@@ -336,84 +433,214 @@ static void DrawUnitOn(const CUnit &unit, int red_phase)
 		color = PlayerColorsRGB[GameSettings.Presets[unit.Player->Index].PlayerColor][0];
 	}
 
-	int mx = 1 + UI.Minimap.XOffset + Map2MinimapX[unit.tilePos.x];
-	int my = 1 + UI.Minimap.YOffset + Map2MinimapY[unit.tilePos.y];
-	int w = Map2MinimapX[type->TileWidth];
-	if (mx + w >= UI.Minimap.W) { // clip right side
-		w = UI.Minimap.W - mx;
-	}
-	int h0 = Map2MinimapY[type->TileHeight];
-	if (my + h0 >= UI.Minimap.H) { // clip bottom side
-		h0 = UI.Minimap.H - my;
-	}
-	int bpp = 0;
-	SDL_Color c;
-	bpp = MinimapSurface->format->BytesPerPixel;
-	SDL_GetRGB(color, TheScreen->format, &c.r, &c.g, &c.b);
-	while (w-- >= 0) {
-		int h = h0;
-		while (h-- >= 0) {
-			const unsigned int index = (mx + w) * bpp + (my + h) * MinimapSurface->pitch;
-			if (bpp == 2) {
-				*(Uint16 *)&((Uint8 *)MinimapSurface->pixels)[index] = color;
-			} else {
-				*(Uint32 *)&((Uint8 *)MinimapSurface->pixels)[index] = color;
+	const int mx = 1 + UI.Minimap.XOffset + Map2MinimapX[unit.tilePos.x];
+	const int my = 1 + UI.Minimap.YOffset + Map2MinimapY[unit.tilePos.y];
+	const int x0 = std::max<int>(mx - 1, clip.x);
+	const int y0 = std::max<int>(my - 1, clip.y);
+	const int x1 = std::min<int>(mx + Map2MinimapX[type->TileWidth], clip.x + clip.w);
+	const int y1 = std::min<int>(my + Map2MinimapY[type->TileHeight], clip.y + clip.h);
+	if (x0 >= x1 || y0 >= y1) {
+		return;
+	}
+	SDL_Rect dot {x0, y0, x1 - x0, y1 - y0};
+	SDL_FillRect(MinimapUnitsSurface, &dot, (color & ~AMASK) | (uint32_t(0xFF) << ASHIFT));
+}
+
+/**
+**  Mark the minimap area covered by a unit for redraw.
+**
+**  Called whenever a unit is inserted into or removed from the map, changes
+**  its owner, gets attacked or (un)selected, so that the units layer only
+**  redraws what changed.
+**
+**  @param unit  Unit which changed.
+*/
+void CMinimap::UpdateUnit(const CUnit &unit)
+{
+	if (!MinimapUnitsSurface) {
+		return;
+	}
+	const Vec2i size(unit.Type->TileWidth, unit.Type->TileHeight);
+	MarkDirty(XOffset + Map2MinimapX[unit.tilePos.x], YOffset + Map2MinimapY[unit.tilePos.y],
+	          Map2MinimapX[size.x] + 1, Map2MinimapY[size.y] + 1);
+
+	if (unit.Player == ThisPlayer && unit.Attacked && unit.Attacked + ATTACK_BLINK_DURATION > GameCycle) {
+		for (MinimapBlinkArea &area : MinimapBlinkAreas) {
+			if (area.pos == unit.tilePos && area.size == size) {
+				area.until = unit.Attacked + ATTACK_BLINK_DURATION;
+				return;
 			}
 		}
+		MinimapBlinkAreas.push_back({unit.tilePos, size, unit.Attacked + ATTACK_BLINK_DURATION});
 	}
 }
 
 /**
-**  Update the minimap with the current game information
+**  Update the fog layer for the map tiles whose visibility changed.
+**
+**  Only the sampled tiles of the rows and columns the fog of war reports as
+**  changed since the last update are visited, unless the whole layer has to
+**  be redrawn (new minimap, opacity levels or map reveal mode changed).
 */
-void CMinimap::Update()
+void CMinimap::UpdateFog()
 {
-	static int red_phase;
+	const uint32_t fogColorSDL = FogOfWar->GetFogColorSDL();
+	const uint8_t unseenAlpha = GameSettings.RevealMap != MapRevealModes::cHidden ? Settings.FogRevealedOpacity
+	                                                                              : Settings.FogUnseenOpacity;
+	uint32_t *const minimapFog = static_cast<uint32_t *>(MinimapFogSurface->pixels);
+	const int fogPitch = MinimapFogSurface->pitch / sizeof(uint32_t);
+
+	const auto updateTile = [&](const MinimapSpan &spanX, const MinimapSpan &spanY) {
+		const uint8_t vis = FogOfWar->GetVisibilityForTile(Vec2i(spanX.Tile, spanY.Tile));
+		const uint8_t fogAlpha = vis == 0 ? unseenAlpha
+		                       : vis == 1 ? Settings.FogExploredOpacity
+		                                  : Settings.FogVisibleOpacity;
+		uint16_t &lastAlpha = MinimapFogAlpha[spanX.Tile + spanY.Tile * Map.Info.MapWidth];
+		if (lastAlpha == fogAlpha) {
+			return;
+		}
+		lastAlpha = fogAlpha;
 
-	int red_phase_changed = red_phase != (int)((FrameCounter / CYCLES_PER_SECOND) & 1);
-	if (red_phase_changed) {
-		red_phase = !red_phase;
+		const uint32_t pixel = fogColorSDL | (uint32_t(fogAlpha) << ASHIFT);
+		for (int my = spanY.First; my < spanY.First + spanY.Count; ++my) {
+			for (int mx = spanX.First; mx < spanX.First + spanX.Count; ++mx) {
+				minimapFog[mx + my * fogPitch] = pixel;
+			}
+		}
+		// Units may appear or vanish under the changed fog too
+		MarkDirty(spanX.First - 1, spanY.First - 1, spanX.Count + 2, spanY.Count + 2);
+	};
+
+	if (MinimapFogFullUpdate || MinimapFogUnseenAlpha != unseenAlpha) {
+		MinimapFogFullUpdate = false;
+		MinimapFogUnseenAlpha = unseenAlpha;
+		for (const MinimapSpan &spanY : MinimapSampledY) {
+			for (const MinimapSpan &spanX : MinimapSampledX) {
+				updateTile(spanX, spanY);
+			}
+		}
+	} else {
+		for (const MinimapSpan &spanY : MinimapSampledY) {
+			uint16_t firstCol;
+			uint16_t lastCol;
+			if (!FogOfWar->GetVisibilityChanges(spanY.Tile, firstCol, lastCol)) {
+				continue;
+			}
+			auto it = std::lower_bound(MinimapSampledX.begin(), MinimapSampledX.end(), firstCol,
+			                           [](const MinimapSpan &span, int col) { return span.Tile < col; });
+			for (; it != MinimapSampledX.end() && it->Tile <= lastCol; ++it) {
+				updateTile(*it, spanY);
+			}
+		}
 	}
+	FogOfWar->ClearVisibilityChanges();
+}
 
-	// Clear Minimap background if not transparent
-	if (!Transparent) {
-		SDL_FillRect(MinimapSurface, nullptr, SDL_MapRGB(MinimapSurface->format, 0, 0, 0));
+/**
+**  Recompose a minimap area from the terrain, fog and units layers.
+**
+**  @param rect       Minimap area to recompose.
+**  @param red_phase  Blink phase for attacked units.
+*/
+void CMinimap::RedrawArea(const SDL_Rect &rect, int red_phase)
+{
+	//
+	// Redraw the unit dots of the area
+	//
+	SDL_Rect unitsRect = rect;
+	SDL_FillRect(MinimapUnitsSurface, &unitsRect, 0);
+
+	Vec2i minPos((rect.x - 1 - XOffset) * MINIMAP_FAC / MinimapScaleX - 1,
+	             (rect.y - 1 - YOffset) * MINIMAP_FAC / MinimapScaleY - 1);
+	Vec2i maxPos((rect.x + rect.w - XOffset) * MINIMAP_FAC / MinimapScaleX + 1,
+	             (rect.y + rect.h - YOffset) * MINIMAP_FAC / MinimapScaleY + 1);
+	Map.FixSelectionArea(minPos, maxPos);
+	if (minPos.x <= maxPos.x && minPos.y <= maxPos.y) {
+		for (const CUnit *unit : SelectFixed(minPos, maxPos)) {
+			if (unit->IsVisibleOnMinimap() && !unit->Removed && !unit->Type->BoolFlag[REVEALER_INDEX].value) {
+				DrawUnitOn(*unit, red_phase, rect);
+			}
+		}
 	}
 
 	//
-	// Draw the terrain
+	// Compose the layers
 	//
+	SDL_Rect drect = rect;
+	if (!Transparent) {
+		SDL_FillRect(MinimapSurface, &drect, SDL_MapRGB(MinimapSurface->format, 0, 0, 0));
+	}
 	if (WithTerrain) {
-		SDL_BlitSurface(MinimapTerrainSurface, nullptr, MinimapSurface, nullptr);
+		SDL_Rect srect = rect;
+		SDL_BlitSurface(MinimapTerrainSurface, &srect, MinimapSurface, &drect);
 	}
-	const uint32_t fogColorSDL = FogOfWar->GetFogColorSDL();
 	if (!ReplayRevealMap) {
-		uint32_t *const minimapFog = static_cast<uint32_t *>(MinimapFogSurface->pixels);
-		size_t index = 0;
-		for (uint16_t my = 0; my < H; ++my) {
-			for (uint16_t mx = 0; mx < W; ++mx) {
+		/// Alpha blending the fog of war texture to minimap
+		/// TODO: switch to hardware rendering
+		BlitSurfaceAlphaBlending_32bpp(MinimapFogSurface, &rect, MinimapSurface, &rect, false);
+	}
+	drect = rect;
+	SDL_BlitSurface(MinimapUnitsSurface, &unitsRect, MinimapSurface, &drect);
+	++Version;
+}
 
-				const Vec2i tilePos(Minimap2MapX[mx], Minimap2MapY[my] / Map.Info.MapWidth);
-				const uint8_t vis = FogOfWar->GetVisibilityForTile(tilePos);
+/**
+**  Update the minimap with the current game information
+**
+**  Only the minimap blocks touched by terrain, fog or unit changes since
+**  the last update are recomposed.
+*/
+void CMinimap::Update()
+{
+	static int red_phase;
 
-				const uint32_t fogAlpha = vis == 0 ? (GameSettings.RevealMap != MapRevealModes::cHidden ? Settings.FogRevealedOpacity : Settings.FogUnseenOpacity)
-											   	   : vis == 1 ? Settings.FogExploredOpacity
-										   		   			  : Settings.FogVisibleOpacity;
+	int red_phase_changed = red_phase != (int)((FrameCounter / CYCLES_PER_SECOND) & 1);
+	if (red_phase_changed) {
+		red_phase = !red_phase;
+	}
 
-				minimapFog[index++] = fogColorSDL | (fogAlpha << ASHIFT);
-			}
-		}
-		/// Alpha blending the fog of war texture to minimap
-		/// TODO: switch to hardware rendering
-		const SDL_Rect fogRect {0, 0, W, H};
-		BlitSurfaceAlphaBlending_32bpp(MinimapFogSurface, &fogRect, MinimapSurface, &fogRect);
+	const bool revealMap = ReplayRevealMap;
+	if (LastWithTerrain != WithTerrain || LastTransparent != Transparent || LastShowSelected != ShowSelected
+		|| LastRevealMap != revealMap || LastThisPlayer != ThisPlayer) {
+		LastWithTerrain = WithTerrain;
+		LastTransparent = Transparent;
+		LastShowSelected = ShowSelected;
+		LastRevealMap = revealMap;
+		LastThisPlayer = ThisPlayer;
+		MinimapFogFullUpdate = true;
+		Invalidate();
 	}
+
+	if (!ReplayRevealMap) {
+		UpdateFog();
+	}
+
 	//
-	// Draw units on map
+	// Attacked units blink
 	//
-	for (const CUnit *unit : UnitManager->GetUnits()) {
-		if (unit->IsVisibleOnMinimap() && !unit->Removed && !unit->Type->BoolFlag[REVEALER_INDEX].value) {
-			DrawUnitOn(*unit, red_phase);
+	for (auto it = MinimapBlinkAreas.begin(); it != MinimapBlinkAreas.end();) {
+		if (red_phase_changed || it->until <= GameCycle) {
+			MarkDirty(XOffset + Map2MinimapX[it->pos.x], YOffset + Map2MinimapY[it->pos.y],
+			          Map2MinimapX[it->size.x] + 1, Map2MinimapY[it->size.y] + 1);
+		}
+		if (it->until <= GameCycle) {
+			it = MinimapBlinkAreas.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for (int by = 0; by < MinimapBlocksY; ++by) {
+		for (int bx = 0; bx < MinimapBlocksX; ++bx) {
+			uint8_t &dirty = MinimapDirtyBlocks[bx + by * MinimapBlocksX];
+			if (!dirty) {
+				continue;
+			}
+			dirty = 0;
+			const int x = bx * MINIMAP_BLOCK_SIZE;
+			const int y = by * MINIMAP_BLOCK_SIZE;
+			const SDL_Rect rect {x, y, std::min(MINIMAP_BLOCK_SIZE, W - x), std::min(MINIMAP_BLOCK_SIZE, H - y)};
+			RedrawArea(rect, red_phase);
 		}
 	}
 }
@@ -497,8 +724,17 @@ void CMinimap::Destroy()
 		SDL_FreeSurface(MinimapFogSurface);
 		MinimapFogSurface = nullptr;
 	}
+	if (MinimapUnitsSurface) {
+		SDL_FreeSurface(MinimapUnitsSurface);
+		MinimapUnitsSurface = nullptr;
+	}
 	Minimap2MapX.clear();
 	Minimap2MapY.clear();
+	MinimapSampledX.clear();
+	MinimapSampledY.clear();
+	MinimapFogAlpha.clear();
+	MinimapDirtyBlocks.clear();
+	MinimapBlinkAreas.clear();
 }
 
 /**
@@ -531,6 +767,28 @@ void CMinimap::AddEvent(const Vec2i &pos, Uint32 color)
 	++NumMinimapEvents;
 }
 
+/**
+**  Get the area and the key of the minimap with its events and the
+**  rectangles of the viewports.
+*/
+CPanelState CMinimap::GetState() const
+{
+	CPanelState state;
+
+	state.AddArea(X, Y, W, H);
+	state << Version << NumMinimapEvents;
+	if (NumMinimapEvents) {
+		// the events shrink at each draw
+		state << FrameCounter;
+	}
+	for (std::size_t i = 0; i != UI.NumViewports; ++i) {
+		const CViewport &viewport = UI.Viewports[i];
+		state << viewport.MapPos.x << viewport.MapPos.y << viewport.MapWidth << viewport.MapHeight
+		      << (UI.SelectedViewport == &viewport);
+	}
+	return state;
+}
+
 bool CMinimap::Contains(const PixelPos &screenPos) const
 {
 	return this->X <= screenPos.x && screenPos.x < this->X + this->W
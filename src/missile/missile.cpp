@@ -39,6 +39,7 @@
 #include "actions.h"
 #include "animation.h"
 #include "font.h"
+#include "ident_table.h"
 #include "iolib.h"
 #include "luacallback.h"
 #include "map.h"
@@ -54,6 +55,7 @@
 #include "video.h"
 
 #include <cmath>
+#include <set>
 
 /*----------------------------------------------------------------------------
 --  Declarations
@@ -64,9 +66,29 @@ unsigned int Missile::Count = 0;
 static std::vector<std::unique_ptr<Missile>> GlobalMissiles;    /// all global missiles on map
 static std::vector<std::unique_ptr<Missile>> LocalMissiles;     /// all local missiles on map
 
+/**
+**  Order in which missiles are drawn: by DrawLevel, then by creation.
+*/
+struct MissileDrawLevelLess
+{
+	bool operator()(const Missile *l, const Missile *r) const
+	{
+		if (l->Type->DrawLevel == r->Type->DrawLevel) {
+			return l->Slot < r->Slot;
+		} else {
+			return l->Type->DrawLevel < r->Type->DrawLevel;
+		}
+	}
+};
+
+/// All global and local missiles in draw order
+static std::set<Missile *, MissileDrawLevelLess> MissileDrawOrder;
+
 /// lookup table for missile names
 using MissileTypeMap = std::map<std::string, std::unique_ptr<MissileType>, std::less<>>;
 static MissileTypeMap MissileTypes;
+/// missile types by slot
+static std::vector<MissileType *> MissileTypeSlots;
 
 std::vector<BurningBuildingFrame> BurningBuildingFrames; /// Burning building frames
 
@@ -137,9 +159,8 @@ void LoadMissileSprites()
 */
 MissileType &MissileTypeByIdent(std::string_view ident)
 {
-	MissileTypeMap::iterator it = MissileTypes.find(ident);
-	if (it != MissileTypes.end()) {
-		return *it->second;
+	if (const int slot = IdentTable.Find(EIdentKind::MissileType, ident); slot != -1) {
+		return *MissileTypeSlots[slot];
 	}
 	ErrorPrint("Unknown missiletype '%s'\n", ident.data());
 	ExitFatal(1);
@@ -158,6 +179,9 @@ MissileType *NewMissileTypeSlot(const std::string &ident)
 
 	if (res == nullptr) {
 		res = std::make_unique<MissileType>(ident);
+		res->Slot = MissileTypeSlots.size();
+		MissileTypeSlots.push_back(res.get());
+		IdentTable.Add(EIdentKind::MissileType, ident, res->Slot);
 	} else {
 		DebugPrint("Redefining missile-type '%s'\n", ident.c_str());
 	}
@@ -226,6 +250,7 @@ Missile *MakeMissile(const MissileType &mtype, const PixelPos &startPos, const P
 {
 	auto missile = Missile::Init(mtype, startPos, destPos);
 
+	MissileDrawOrder.insert(missile.get());
 	GlobalMissiles.push_back(std::move(missile));
 	return GlobalMissiles.back().get();
 }
@@ -244,6 +269,7 @@ Missile *MakeLocalMissile(const MissileType &mtype, const PixelPos &startPos, co
 	auto missile = Missile::Init(mtype, startPos, destPos);
 
 	missile->Local = 1;
+	MissileDrawOrder.insert(missile.get());
 	LocalMissiles.push_back(std::move(missile));
 	return LocalMissiles.back().get();
 }
@@ -527,45 +553,27 @@ void Missile::DrawMissile(const CViewport &vp) const
 	}
 }
 
-static bool MissileDrawLevelCompare(const Missile *const l, const Missile *const r)
-{
-	if (l->Type->DrawLevel == r->Type->DrawLevel) {
-		return l->Slot < r->Slot;
-	} else {
-		return l->Type->DrawLevel < r->Type->DrawLevel;
-	}
-}
-
 /**
 **  Sort visible missiles on map for display.
 **
+**  Missiles are kept in draw order while they are created and removed,
+**  so this only walks them in order.
+**
 **  @param vp         Viewport pointer.
 **  @return array of missile to display sorted by DrawLevel.
 */
 std::vector<Missile *> FindAndSortMissiles(const CViewport &vp)
 {
 	std::vector<Missile *> table;
-	// Loop through global missiles, then through locals.
-	for (auto& missilePtr : GlobalMissiles) {
-		Missile &missile = *missilePtr;
-		if (missile.Delay || missile.Hidden) {
+	for (Missile *missile : MissileDrawOrder) {
+		if (missile->Delay || missile->Hidden) {
 			continue;  // delayed or hidden -> aren't shown
 		}
-		// Draw only visible missiles
-		if (MissileVisibleInViewport(vp, missile)) {
-			table.push_back(&missile);
-		}
-	}
-
-	for (auto& missilePtr : LocalMissiles) {
-		Missile &missile = *missilePtr;
-		if (missile.Delay || missile.Hidden) {
-			continue;  // delayed or hidden -> aren't shown
+		// Local missile are visible, draw only visible global missiles.
+		if (missile->Local || MissileVisibleInViewport(vp, *missile)) {
+			table.push_back(missile);
 		}
-		// Local missile are visible.
-		table.push_back(&missile);
 	}
-	ranges::sort(table, MissileDrawLevelCompare);
 	return table;
 }
 
@@ -1138,6 +1146,7 @@ static void MissilesActionLoop(std::vector<std::unique_ptr<Missile>> &missiles)
 			missile.TTL--;  // overall time to live if specified
 		}
 		if (missile.TTL == 0) {
+			MissileDrawOrder.erase(&missile);
 			missiles.erase(missiles.begin() + i);
 			continue;
 		}
@@ -1148,6 +1157,7 @@ static void MissilesActionLoop(std::vector<std::unique_ptr<Missile>> &missiles)
 		}
 		missile.Action(); // may create other missiles, and so modifies the array
 		if (missile.TTL == 0) {
+			MissileDrawOrder.erase(&missile);
 			missiles.erase(missiles.begin() + i);
 			continue;
 		}
@@ -1292,6 +1302,8 @@ void InitMissileTypes()
 void CleanMissileTypes()
 {
 	MissileTypes.clear();
+	MissileTypeSlots.clear();
+	IdentTable.Clear(EIdentKind::MissileType);
 }
 
 /**
@@ -1306,6 +1318,7 @@ void InitMissiles()
 */
 void CleanMissiles()
 {
+	MissileDrawOrder.clear();
 	GlobalMissiles.clear();
 	LocalMissiles.clear();
 }
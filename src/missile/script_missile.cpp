@@ -376,8 +376,9 @@ static int CclCreateMissile(lua_State *l)
 		LuaError(l, "incorrect argument");
 	}
 
-	const std::string_view name = LuaToString(l, 1);
-	const MissileType &mtype = MissileTypeByIdent(name);
+	lua_pushvalue(l, 1);
+	const MissileType &mtype = *CclGetMissileType(l);
+	lua_pop(l, 1);
 	PixelPos startpos, endpos;
 	CclGetPos(l, &startpos, 2);
 	CclGetPos(l, &endpos, 3);
@@ -409,6 +410,46 @@ static int CclCreateMissile(lua_State *l)
 	return 0;
 }
 
+/**
+**  Access missile-type object
+**
+**  @param l  Lua state.
+*/
+MissileType *CclGetMissileType(lua_State *l)
+{
+	// Be kind allow also strings or symbols
+	if (lua_isstring(l, -1)) {
+		return &MissileTypeByIdent(LuaToString(l, -1));
+	} else if (lua_isuserdata(l, -1)) {
+		LuaUserData *data = (LuaUserData *)lua_touserdata(l, -1);
+		if (data->Type == LuaMissileType) {
+			return (MissileType *)data->Data;
+		}
+	}
+	LuaError(l, "CclGetMissileType: not a missile-type");
+	return nullptr;
+}
+
+/**
+**  Get missile-type structure.
+**
+**  Scripts may keep it instead of the identifier, to skip its lookup.
+**
+**  @param l  Lua state.
+**
+**  @return   Missile-type structure.
+*/
+static int CclMissileType(lua_State *l)
+{
+	LuaCheckArgs(l, 1);
+
+	MissileType &mtype = MissileTypeByIdent(LuaToString(l, 1));
+	LuaUserData *data = (LuaUserData *)lua_newuserdata(l, sizeof(LuaUserData));
+	data->Type = LuaMissileType;
+	data->Data = &mtype;
+	return 1;
+}
+
 /**
 **  Register CCL features for missile-type.
 */
@@ -418,6 +459,7 @@ void MissileCclRegister()
 	lua_register(Lua, "Missile", CclMissile);
 	lua_register(Lua, "DefineBurningBuilding", CclDefineBurningBuilding);
 	lua_register(Lua, "CreateMissile", CclCreateMissile);
+	lua_register(Lua, "MissileType", CclMissileType);
 }
 
 //@}
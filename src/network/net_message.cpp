@@ -251,7 +251,9 @@ size_t CServerSetup::Serialize(unsigned char *buf) const
 
 	p += serialize8(p, static_cast<int8_t>(this->ServerGameSettings.DefeatReveal));
 	p += serialize8(p, static_cast<int8_t>(this->ServerGameSettings.Difficulty));
-	p += serialize8(p, static_cast<int8_t>(this->ServerGameSettings.FoV));
+	// AiPlansAhead is in the spare high bit of FoV, the bitfield is full
+	p += serialize8(p, static_cast<uint8_t>(static_cast<uint8_t>(this->ServerGameSettings.FoV)
+	                                        | (this->ServerGameSettings.AiPlansAhead << 7)));
 	p += serialize8(p, static_cast<int8_t>(this->ServerGameSettings.GameType));
 	// Inside is part of the bitfield
 	// NetGameType is not needed
@@ -283,7 +285,10 @@ size_t CServerSetup::Deserialize(const unsigned char *p)
 	const unsigned char *buf = p;
 	p += deserialize8(p, reinterpret_cast<int8_t*>(&this->ServerGameSettings.DefeatReveal));
 	p += deserialize8(p, reinterpret_cast<int8_t*>(&this->ServerGameSettings.Difficulty));
-	p += deserialize8(p, reinterpret_cast<int8_t*>(&this->ServerGameSettings.FoV));
+	uint8_t fov = 0;
+	p += deserialize8(p, &fov);
+	this->ServerGameSettings.FoV = static_cast<FieldOfViewTypes>(fov & 0x7F);
+	this->ServerGameSettings.AiPlansAhead = (fov >> 7) & 0x1;
 	p += deserialize8(p, reinterpret_cast<int8_t*>(&this->ServerGameSettings.GameType));
 	// Inside is part of the bitfield
 	// NetGameType is not needed
@@ -61,6 +61,7 @@
 #endif
 
 #include <cstdio>
+#include <mutex>
 
 /*----------------------------------------------------------------------------
 --  Declarations
@@ -114,9 +115,6 @@ const int Heading2Y[9] = { -1, -1, 0, +1, +1, +1, 0, -1, 0 };
 int Heading2O[9];//heading to offset
 const int XY2Heading[3][3] = { {7, 6, 5}, {0, 0, 4}, {1, 2, 3}};
 
-/// cost matrix
-static std::vector<Node> AStarMatrix;
-
 /// a list of close nodes, helps to speed up the matrix cleaning
 #define MAX_CLOSE_SET_RATIO 4
 #define MAX_OPEN_SET_RATIO 8 // 10,16 to small
@@ -127,27 +125,86 @@ int AStarMovingUnitCrossingCost = 5;
 int AStarMaxSearchIterations = 1024 * 5;
 bool AStarKnowUnseenTerrain = false;
 int AStarUnknownTerrainCost = 2;
-/// Used to temporary make enemy units unpassable (needs for correct path length calculating for automatic targeting algorithm)
-static bool AStarFixedEnemyUnitsUnpassable = false;
+bool AStarUniformShortcut = false;
 
 static int AStarMapWidth;
 static int AStarMapHeight;
 
-static int AStarGoalX;
-static int AStarGoalY;
+static constexpr int CacheNotSet = -1;
 
 /**
-**  The Open set is handled by a stored array
-**  the end of the array holds the item with the smallest cost.
+**  State of one A* search: the node matrix, the open set and the cost
+**  cache.
+**
+**  Each thread searches with its own context and reads the live map, unit
+**  cache and unit positions without any lock or snapshot. Independent paths
+**  can thus be computed at the same time by several threads only while the
+**  thread running the game waits for them, so that nothing modifies the map
+**  meanwhile. The context of the thread which called InitAStar is the only
+**  one allowed to write the debug information of the map fields.
+**
+**  The contexts are registered in AStarContexts for FreeAStar to release
+**  the memory of all of them, not only the one of its calling thread.
 */
+class AStarContext
+{
+public:
+	AStarContext();
+	~AStarContext();
 
-/// The set of Open nodes
-static std::vector<Open> OpenSet;
-/// The size of the open node set
-static int OpenSetSize;
+	void Init(int mapWidth, int mapHeight);
+	void Free();
 
-static std::vector<int32_t> CostMoveToCache;
-static constexpr int CacheNotSet = -1;
+	int FindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
+	             int tilesizex, int tilesizey, int minrange, int maxrange,
+	             char *path, int pathlen, const CUnit &unit,
+	             int window = 0, int maxIterations = AStarMaxSearchIterations);
+
+	int CostMoveTo(unsigned int index, const CUnit &unit);
+	const std::vector<Node> &GetMatrix() const { return Matrix; }
+
+	/// Used to temporary make enemy units unpassable (needs for correct path length calculating for automatic targeting algorithm)
+	bool FixedEnemyUnitsUnpassable = false;
+	bool IsMain = false; /// Context of the thread which called InitAStar
+
+private:
+	void CleanUp();
+	void MarkDirty(int minX, int minY, int maxX, int maxY);
+	void RemoveMinimum(int pos);
+	int AddNode(const Vec2i &pos, int64_t costs);
+	void ReplaceNode(int pos);
+	int FindNode(int eo) const;
+	int CostMoveToCallBack(unsigned int index, const CUnit &unit) const;
+	bool MarkGoal(const Vec2i &goal, int gw, int gh, int tilesizex, int tilesizey,
+	              int minrange, int maxrange, const CUnit &unit);
+	int SavePath(const Vec2i &startPos, const Vec2i &endPos, char *path, int pathLen) const;
+	int FindSimplePath(const Vec2i &startPos, const Vec2i &goal, int gw, int gh,
+	                   int minrange, int maxrange, char *path, const CUnit &unit);
+	int FindUniformPath(const Vec2i &startPos, const Vec2i &goal, int tilesizex, int tilesizey,
+	                    char *path, int pathLen, const CUnit &unit) const;
+
+	std::vector<Node> Matrix;           /// cost matrix
+	std::vector<int32_t> CostMoveToCache;
+	/**
+	**  The Open set is handled by a stored array
+	**  the end of the array holds the item with the smallest cost.
+	*/
+	std::vector<Open> OpenSet;
+	int OpenSetSize = 0;                /// The size of the open node set
+	int GoalX = 0;
+	int GoalY = 0;
+	/// Tiles of Matrix and CostMoveToCache written since the last clean up, empty if max < min
+	int DirtyMinX = 0;
+	int DirtyMinY = 0;
+	int DirtyMaxX = -1;
+	int DirtyMaxY = -1;
+};
+
+static std::mutex AStarContextsMutex;             /// Protects AStarContexts
+static std::vector<AStarContext *> AStarContexts; /// Search contexts of all the living threads
+
+/// Search context of each thread
+static thread_local AStarContext AStarThreadContext;
 
 /*----------------------------------------------------------------------------
 --  Profile
@@ -331,69 +388,132 @@ uint32_t Open::GetOffset() const {
 */
 void InitAStar(int mapWidth, int mapHeight)
 {
-	// Should only be called once
-	Assert(AStarMatrix.empty());
-
 	AStarMapWidth = mapWidth;
 	AStarMapHeight = mapHeight;
 
-	AStarMatrix.resize(AStarMapWidth * AStarMapHeight);
-#ifdef DEBUG
-	for (auto& node : AStarMatrix) {
-		node.SetDirection(-1);
-	}
-#endif
-	OpenSet.resize(AStarMapWidth * AStarMapHeight / MAX_OPEN_SET_RATIO);
-	CostMoveToCache.resize(AStarMapWidth * AStarMapHeight, CacheNotSet);
-
 	for (int i = 0; i < 9; ++i) {
 		Heading2O[i] = Heading2Y[i] * AStarMapWidth;
 	}
 
+	AStarThreadContext.Init(mapWidth, mapHeight);
+	AStarThreadContext.IsMain = true;
+
 	ProfileInit();
 }
 
 /**
 **  Free A* data structure
+**
+**  The contexts of all the threads are freed, no search may run meanwhile.
 */
 void FreeAStar()
 {
-	AStarMatrix.clear();
-	OpenSet.clear();
-	OpenSetSize = 0;
-	CostMoveToCache.clear();
+	{
+		std::lock_guard<std::mutex> lock(AStarContextsMutex);
+		for (AStarContext *context : AStarContexts) {
+			context->Free();
+			context->IsMain = false;
+		}
+	}
 
 	ProfilePrint();
 }
 
+AStarContext::AStarContext()
+{
+	std::lock_guard<std::mutex> lock(AStarContextsMutex);
+	AStarContexts.push_back(this);
+}
+
+AStarContext::~AStarContext()
+{
+	std::lock_guard<std::mutex> lock(AStarContextsMutex);
+	AStarContexts.erase(ranges::find(AStarContexts, this));
+}
+
 /**
-**  Prepare pathfinder.
+**  Allocate the context for a map.
 */
-static void AStarPrepare()
+void AStarContext::Init(int mapWidth, int mapHeight)
 {
-	ranges::fill(AStarMatrix, Node{});
+	// Should only be called once
+	Assert(Matrix.empty());
+
+	Matrix.resize(mapWidth * mapHeight);
 #ifdef DEBUG
-	for (auto& node : AStarMatrix) {
+	for (auto& node : Matrix) {
 		node.SetDirection(-1);
 	}
 #endif
+	OpenSet.resize(mapWidth * mapHeight / MAX_OPEN_SET_RATIO);
+	OpenSetSize = 0;
+	CostMoveToCache.resize(mapWidth * mapHeight, CacheNotSet);
+	DirtyMaxX = DirtyMaxY = -1;
+}
+
+/**
+**  Free the context.
+*/
+void AStarContext::Free()
+{
+	Matrix.clear();
+	OpenSet.clear();
+	OpenSetSize = 0;
+	CostMoveToCache.clear();
 }
 
 /**
 **  Clean up A*
+**
+**  Only the tiles written since the last clean up are reset, so a search
+**  limited to a small window (path repair) doesn't cost the whole map.
 */
-static void CostMoveToCacheCleanUp();
-static void AStarCleanUp()
+void AStarContext::CleanUp()
 {
 	ProfileBegin("AStarCleanUp");
-	AStarPrepare();
-	CostMoveToCacheCleanUp();
+	for (int y = DirtyMinY; y <= DirtyMaxY; ++y) {
+		const int first = y * AStarMapWidth + DirtyMinX;
+		const int last = y * AStarMapWidth + DirtyMaxX + 1;
+		std::fill(Matrix.begin() + first, Matrix.begin() + last, Node{});
+#ifdef DEBUG
+		for (int i = first; i != last; ++i) {
+			Matrix[i].SetDirection(-1);
+		}
+#endif
+		std::fill(CostMoveToCache.begin() + first, CostMoveToCache.begin() + last, CacheNotSet);
+	}
+	DirtyMaxX = DirtyMaxY = -1;
+	DirtyMinX = DirtyMinY = 0;
+	OpenSetSize = 0;
 	ProfileEnd("AStarCleanUp");
 }
 
-static void CostMoveToCacheCleanUp()
+/**
+**  Remember that a rectangle of tiles is written by the search and has to
+**  be reset by the next clean up.
+**
+**  @param minX  Left side of the rectangle, inclusive.
+**  @param minY  Top side of the rectangle, inclusive.
+**  @param maxX  Right side of the rectangle, inclusive.
+**  @param maxY  Bottom side of the rectangle, inclusive.
+*/
+void AStarContext::MarkDirty(int minX, int minY, int maxX, int maxY)
 {
-	ranges::fill(CostMoveToCache, CacheNotSet);
+	minX = std::max(minX, 0);
+	minY = std::max(minY, 0);
+	maxX = std::min(maxX, AStarMapWidth - 1);
+	maxY = std::min(maxY, AStarMapHeight - 1);
+	if (DirtyMaxX < DirtyMinX || DirtyMaxY < DirtyMinY) {
+		DirtyMinX = minX;
+		DirtyMinY = minY;
+		DirtyMaxX = maxX;
+		DirtyMaxY = maxY;
+		return;
+	}
+	DirtyMinX = std::min(DirtyMinX, minX);
+	DirtyMinY = std::min(DirtyMinY, minY);
+	DirtyMaxX = std::max(DirtyMaxX, maxX);
+	DirtyMaxY = std::max(DirtyMaxY, maxY);
 }
 
 /**
@@ -406,7 +526,7 @@ static void CostMoveToCacheCleanUp()
 /**
 **  Remove the minimum from the open node set
 */
-static void AStarRemoveMinimum(int pos)
+void AStarContext::RemoveMinimum(int pos)
 {
 	Assert(pos == OpenSetSize - 1);
 
@@ -418,7 +538,7 @@ static void AStarRemoveMinimum(int pos)
 **
 **  @return  0 or PF_FAILED
 */
-static inline int AStarAddNode(const Vec2i &pos, int64_t costs)
+inline int AStarContext::AddNode(const Vec2i &pos, int64_t costs)
 {
 	ProfileBegin("AStarAddNode");
 
@@ -437,7 +557,7 @@ static inline int AStarAddNode(const Vec2i &pos, int64_t costs)
 	}
 
 	const int costToGoal = costs;
-	const int dist = std::abs(pos.x - AStarGoalX) + std::abs(pos.y - AStarGoalY);
+	const int dist = std::abs(pos.x - GoalX) + std::abs(pos.y - GoalY);
 
 	// find where we should insert this node.
 	// binary search where to insert the new node
@@ -445,8 +565,8 @@ static inline int AStarAddNode(const Vec2i &pos, int64_t costs)
 		midi = (smalli + bigi) >> 1;
 		open = &OpenSet[midi];
 		midcost = open->GetCosts();
-		midCostToGoal = AStarMatrix[open->GetOffset()].GetCostToGoal();
-		midDist = std::abs(open->pos.x - AStarGoalX) + std::abs(open->pos.y - AStarGoalY);
+		midCostToGoal = Matrix[open->GetOffset()].GetCostToGoal();
+		midDist = std::abs(open->pos.x - GoalX) + std::abs(open->pos.y - GoalY);
 		if (costs > midcost || (costs == midcost
 								&& (costToGoal > midCostToGoal || (costToGoal == midCostToGoal
 																   && dist > midDist)))) {
@@ -485,7 +605,7 @@ static inline int AStarAddNode(const Vec2i &pos, int64_t costs)
 **  Can be further optimized knowing that the new cost MUST BE LOWER
 **  than the old one.
 */
-static void AStarReplaceNode(int pos)
+void AStarContext::ReplaceNode(int pos)
 {
 	ProfileBegin("AStarReplaceNode");
 
@@ -497,7 +617,7 @@ static void AStarReplaceNode(int pos)
 	memmove(&OpenSet[pos], &OpenSet[pos+1], sizeof(Open) * (OpenSetSize-pos));
 
 	// Re-add the node with the new cost
-	AStarAddNode(node.pos, node.GetCosts());
+	AddNode(node.pos, node.GetCosts());
 	ProfileEnd("AStarReplaceNode");
 }
 
@@ -507,7 +627,7 @@ static void AStarReplaceNode(int pos)
 **
 **  @return  -1 if not found and the position of the node in the table if found.
 */
-static int AStarFindNode(int eo)
+int AStarContext::FindNode(int eo) const
 {
 	ProfileBegin("AStarFindNode");
 
@@ -523,15 +643,31 @@ static int AStarFindNode(int eo)
 
 #define GetIndex(x, y) (x) + (y) * AStarMapWidth
 
+/**
+**  Remember the last cost computed for a field, to debug the pathfinder.
+**  Only the main context writes it, the map is read only for the others.
+*/
+#ifdef DEBUG
+# define AStarSetLastCost(mf, cost) \
+	do { \
+		if (IsMain) { \
+			const_cast<CMapField *>(mf)->lastAStarCost = (cost); \
+		} \
+	} while (0)
+#else
+# define AStarSetLastCost(mf, cost)
+#endif
+
 /* build-in costmoveto code */
-static int CostMoveToCallBack_Default(unsigned int index, const CUnit &unit)
+int AStarContext::CostMoveToCallBack(unsigned int index, const CUnit &unit) const
 {
+	const CMap &map = Map;
 #ifdef DEBUG
 	{
 		Vec2i pos;
-		pos.y = index / Map.Info.MapWidth;
-		pos.x = index - pos.y * Map.Info.MapWidth;
-		Assert(Map.Info.IsPointOnMap(pos));
+		pos.y = index / map.Info.MapWidth;
+		pos.x = index - pos.y * map.Info.MapWidth;
+		Assert(map.Info.IsPointOnMap(pos));
 	}
 #endif
 	int cost = 0;
@@ -542,16 +678,14 @@ static int CostMoveToCallBack_Default(unsigned int index, const CUnit &unit)
 	int h = unit.Type->TileHeight;
 	const int w = unit.Type->TileWidth;
 	do {
-		const CMapField *mf = Map.Field(index);
+		const CMapField *mf = map.Field(index);
 		int i = w;
 		do {
 			const int flag = mf->Flags & mask;
 			if (flag && (AStarKnowUnseenTerrain || mf->playerInfo.IsExplored(*unit.Player))) {
 				if (flag & ~(MapFieldLandUnit | MapFieldAirUnit | MapFieldSeaUnit)) {
 					// we can't cross fixed units and other unpassable things
-#ifdef DEBUG
-					const_cast<CMapField *>(mf)->lastAStarCost = -1;
-#endif
+					AStarSetLastCost(mf, -1);
 					return -1;
 				}
 				auto it = ranges::find_if(mf->UnitCache, unit_finder);
@@ -559,9 +693,7 @@ static int CostMoveToCallBack_Default(unsigned int index, const CUnit &unit)
 				if (!goal) {
 					// Shouldn't happen, mask says there is something on this tile
 					Assert(0);
-#ifdef DEBUG
-					const_cast<CMapField *>(mf)->lastAStarCost = -1;
-#endif
+					AStarSetLastCost(mf, -1);
 					return -1;
 				}
 				if (goal->Moving)  {
@@ -570,10 +702,8 @@ static int CostMoveToCallBack_Default(unsigned int index, const CUnit &unit)
 				} else {
 					// for non moving unit Always Fail unless goal is unit, or unit can attack the target
 					if (&unit != goal) {
-						if (GetAStarFixedEnemyUnitsUnpassable() == true) {
-#ifdef DEBUG
-							const_cast<CMapField *>(mf)->lastAStarCost = -1;
-#endif
+						if (FixedEnemyUnitsUnpassable) {
+							AStarSetLastCost(mf, -1);
 							return -1;
 						}
 						if (goal->Player->IsEnemy(unit) && unit.IsAggressive() && CanTarget(*unit.Type, *goal->Type)
@@ -581,9 +711,7 @@ static int CostMoveToCallBack_Default(unsigned int index, const CUnit &unit)
 								cost += 2 * AStarMovingUnitCrossingCost;
 						} else {
 						// FIXME: Need support for moving a fixed unit to add cost
-#ifdef DEBUG
-							const_cast<CMapField *>(mf)->lastAStarCost = -1;
-#endif
+							AStarSetLastCost(mf, -1);
 							return -1;
 						}
 						//cost += AStarFixedUnitCrossingCost;
@@ -597,9 +725,7 @@ static int CostMoveToCallBack_Default(unsigned int index, const CUnit &unit)
 			}
 			// Add tile movement cost
 			cost += mf->getMoveCost();
-#ifdef DEBUG
-			const_cast<CMapField *>(mf)->lastAStarCost = cost;
-#endif
+			AStarSetLastCost(mf, cost);
 			++mf;
 		} while (--i);
 		index += AStarMapWidth;
@@ -619,7 +745,7 @@ static int CostMoveToCallBack_Default(unsigned int index, const CUnit &unit)
 **                0 -> no induced cost, except move
 **               >0 -> costly tile
 */
-static inline int CostMoveTo(unsigned int index, const CUnit &unit)
+inline int AStarContext::CostMoveTo(unsigned int index, const CUnit &unit)
 {
 	int32_t *c = &CostMoveToCache[index];
 	if (*c != CacheNotSet) {
@@ -629,7 +755,7 @@ static inline int CostMoveTo(unsigned int index, const CUnit &unit)
 		// store everything +1
 		return *c - 1;
 	}
-	*c = CostMoveToCallBack_Default(index, unit) + 1;
+	*c = CostMoveToCallBack(index, unit) + 1;
 #ifdef DEBUG
 	Assert(*c >= 0);
 #endif
@@ -639,12 +765,14 @@ static inline int CostMoveTo(unsigned int index, const CUnit &unit)
 class AStarGoalMarker
 {
 public:
-	AStarGoalMarker(const CUnit &unit) : unit(unit) {}
+	AStarGoalMarker(AStarContext &context, std::vector<Node> &matrix, const CUnit &unit) :
+		context(context), matrix(matrix), unit(unit)
+	{}
 
 	void operator()(int offset)
 	{
-		if (CostMoveTo(offset, unit) >= 0) {
-			AStarMatrix[offset].SetInGoal();
+		if (context.CostMoveTo(offset, unit) >= 0) {
+			matrix[offset].SetInGoal();
 			goal_reachable = true;
 		}
 	}
@@ -652,6 +780,8 @@ class AStarGoalMarker
 	bool isGoalReachable() const { return goal_reachable; }
 
 private:
+	AStarContext &context;
+	std::vector<Node> &matrix;
 	const CUnit &unit;
 	bool goal_reachable = false;
 };
@@ -814,14 +944,14 @@ class MinMaxRangeVisitor
 /**
 **  MarkAStarGoal
 */
-static bool AStarMarkGoal(const Vec2i &goal,
-                          int gw,
-                          int gh,
-                          int tilesizex,
-                          int tilesizey,
-                          int minrange,
-                          int maxrange,
-                          const CUnit &unit)
+bool AStarContext::MarkGoal(const Vec2i &goal,
+                            int gw,
+                            int gh,
+                            int tilesizex,
+                            int tilesizey,
+                            int minrange,
+                            int maxrange,
+                            const CUnit &unit)
 {
 	ProfileBegin("AStarMarkGoal");
 
@@ -831,8 +961,9 @@ static bool AStarMarkGoal(const Vec2i &goal,
 			return false;
 		}
 		unsigned int offset = GetIndex(goal.x, goal.y);
+		MarkDirty(goal.x, goal.y, goal.x, goal.y);
 		if (CostMoveTo(offset, unit) >= 0) {
-			AStarMatrix[offset].SetInGoal();
+			Matrix[offset].SetInGoal();
 			ProfileEnd("AStarMarkGoal");
 			return true;
 		} else {
@@ -844,7 +975,10 @@ static bool AStarMarkGoal(const Vec2i &goal,
 	gw = std::max(gw, 1);
 	gh = std::max(gh, 1);
 
-	AStarGoalMarker aStarGoalMarker(unit);
+	MarkDirty(goal.x - maxrange - (tilesizex - 1), goal.y - maxrange - (tilesizey - 1),
+	          goal.x + gw - 1 + maxrange, goal.y + gh - 1 + maxrange);
+
+	AStarGoalMarker aStarGoalMarker(*this, Matrix, unit);
 	MinMaxRangeVisitor<AStarGoalMarker> visitor(aStarGoalMarker);
 
 	const Vec2i goalBottomRigth(goal.x + gw - 1, goal.y + gh - 1);
@@ -866,7 +1000,7 @@ static bool AStarMarkGoal(const Vec2i &goal,
 **
 **  @return  The length of the path
 */
-static int AStarSavePath(const Vec2i &startPos, const Vec2i &endPos, char *path, int pathLen)
+int AStarContext::SavePath(const Vec2i &startPos, const Vec2i &endPos, char *path, int pathLen) const
 {
 	ProfileBegin("AStarSavePath");
 
@@ -879,7 +1013,7 @@ static int AStarSavePath(const Vec2i &startPos, const Vec2i &endPos, char *path,
 	Vec2i curr = endPos;
 	int currO = curr.y * AStarMapWidth;
 	while (curr != startPos) {
-		direction = AStarMatrix[currO + curr.x].GetDirection();
+		direction = Matrix[currO + curr.x].GetDirection();
 #ifdef DEBUG
 		Assert(direction >= 0 && direction < 8);
 #endif
@@ -896,7 +1030,7 @@ static int AStarSavePath(const Vec2i &startPos, const Vec2i &endPos, char *path,
 		curr = endPos;
 		currO = curr.y * AStarMapWidth;
 		while (curr != startPos) {
-			direction = AStarMatrix[currO + curr.x].GetDirection();
+			direction = Matrix[currO + curr.x].GetDirection();
 #ifdef DEBUG
 			Assert(direction >= 0 && direction < 8);
 #endif
@@ -918,9 +1052,9 @@ static int AStarSavePath(const Vec2i &startPos, const Vec2i &endPos, char *path,
 **  Optimization to find a simple path
 **  Check if we're at the goal or if it's 1 tile away
 */
-static int AStarFindSimplePath(const Vec2i &startPos, const Vec2i &goal, int gw, int gh,
-							   int, int, int minrange, int maxrange,
-							   char *path, const CUnit &unit)
+int AStarContext::FindSimplePath(const Vec2i &startPos, const Vec2i &goal, int gw, int gh,
+								  int minrange, int maxrange,
+								  char *path, const CUnit &unit)
 {
 	ProfileBegin("AStarFindSimplePath");
 	// At exact destination point already
@@ -962,22 +1096,81 @@ static int AStarFindSimplePath(const Vec2i &startPos, const Vec2i &goal, int gw,
 	return PF_FAILED;
 }
 
+/**
+**  Shortcut for the paths over uniform terrain.
+**
+**  Go diagonally then straight to the goal, as the search would on
+**  uniform terrain, if all the tiles on the way cost the same. Near units,
+**  blocked tiles or tiles of other costs, the search is needed.
+**  Neither the matrix nor the cost cache are used, so they don't need to
+**  be cleaned up.
+**
+**  @return  The length of the path, or PF_FAILED to search.
+*/
+int AStarContext::FindUniformPath(const Vec2i &startPos, const Vec2i &goal, int tilesizex, int tilesizey,
+								  char *path, int pathLen, const CUnit &unit) const
+{
+	if (goal.x + tilesizex > AStarMapWidth || goal.y + tilesizey > AStarMapHeight) {
+		return PF_FAILED;
+	}
+	ProfileBegin("AStarFindUniformPath");
+
+	const int length = std::max(std::abs(goal.x - startPos.x), std::abs(goal.y - startPos.y));
+	const int saved = std::min(length, pathLen);
+	int cost = -1;
+	Vec2i pos = startPos;
+
+	for (int step = 0; step < length; ++step) {
+		const int dx = goal.x > pos.x ? 1 : (goal.x < pos.x ? -1 : 0);
+		const int dy = goal.y > pos.y ? 1 : (goal.y < pos.y ? -1 : 0);
+		pos.x += dx;
+		pos.y += dy;
+
+		const int tileCost = CostMoveToCallBack(GetIndex(pos.x, pos.y), unit);
+		if (tileCost == -1 || (cost != -1 && tileCost != cost)) {
+			ProfileEnd("AStarFindUniformPath");
+			return PF_FAILED;
+		}
+		cost = tileCost;
+		if (path && step < saved) {
+			path[saved - step - 1] = XY2Heading[dx + 1][dy + 1];
+		}
+	}
+	ProfileEnd("AStarFindUniformPath");
+	return length;
+}
+
 #ifdef DEBUG
 extern bool DumpNextAStar;
 void AStarDumpStats();
 #endif
 
 /**
-**  Find path.
+**  Find a path with the A* search.
+**
+**  @param window         If not 0, only search the tiles at most this far
+**                        from the rectangle around the start and the goal.
+**  @param maxIterations  Nodes to look at before giving up. Without a
+**                        window the best path found so far is returned,
+**                        with one the search fails.
+**
+**  @return  The length of the path, or PF_xxx.
 */
-int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPosIn, int gw, int gh,
-				  int tilesizex, int tilesizey, int minrange, int maxrange,
-				  char *path, int pathlen, const CUnit &unit)
+int AStarContext::FindPath(const Vec2i &startPos, const Vec2i &goalPosIn, int gw, int gh,
+						   int tilesizex, int tilesizey, int minrange, int maxrange,
+						   char *path, int pathlen, const CUnit &unit,
+						   int window, int maxIterations)
 {
 	Assert(Map.Info.IsPointOnMap(startPos));
 
 	ProfileBegin("AStarFindPath");
 
+	if (Matrix.size() != static_cast<size_t>(AStarMapWidth * AStarMapHeight)) {
+		// Context of another thread used for the first time on this map
+		Free();
+		Init(AStarMapWidth, AStarMapHeight);
+	}
+
 	Vec2i goalPos = goalPosIn;
 	/*
 	// possible optimization: never search farther than to the next N tiles
@@ -990,28 +1183,41 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPosIn, int gw, int gh,
 	goalPos.x = std::min(maxMapX, std::max(minMapX, static_cast<int>(goalPos.x)));
 	goalPos.y = std::min(maxMapY, std::max(minMapY, static_cast<int>(goalPos.y)));
 	*/
-	const int minMapX = 0;
-	const int minMapY = 0;
-	const int maxMapX = AStarMapWidth + 1 - tilesizex;
-	const int maxMapY = AStarMapHeight + 1 - tilesizey;
+	int minMapX = 0;
+	int minMapY = 0;
+	int maxMapX = AStarMapWidth + 1 - tilesizex;
+	int maxMapY = AStarMapHeight + 1 - tilesizey;
+	if (window) {
+		minMapX = std::max<int>(minMapX, std::min(startPos.x, goalPos.x) - window);
+		minMapY = std::max<int>(minMapY, std::min(startPos.y, goalPos.y) - window);
+		maxMapX = std::min<int>(maxMapX, std::max(startPos.x, goalPos.x) + window + 1);
+		maxMapY = std::min<int>(maxMapY, std::max(startPos.y, goalPos.y) + window + 1);
+	}
 
-	AStarGoalX = goalPos.x;
-	AStarGoalY = goalPos.y;
+	GoalX = goalPos.x;
+	GoalY = goalPos.y;
 
-	//  Check for simple cases first
-	int ret = AStarFindSimplePath(startPos, goalPos, gw, gh, tilesizex, tilesizey,
-								  minrange, maxrange, path, unit);
+	//  Check for simple cases first, it may cache the cost of the goal
+	MarkDirty(std::min(startPos.x, goalPos.x), std::min(startPos.y, goalPos.y),
+	          std::max(startPos.x, goalPos.x), std::max(startPos.y, goalPos.y));
+	int ret = FindSimplePath(startPos, goalPos, gw, gh, minrange, maxrange, path, unit);
 	if (ret != PF_FAILED) {
 		ProfileEnd("AStarFindPath");
 		return ret;
 	}
 
-	//  Initialize
-	AStarCleanUp();
+	if (AStarUniformShortcut && minrange == 0 && maxrange == 0 && gw == 0 && gh == 0) {
+		ret = FindUniformPath(startPos, goalPos, tilesizex, tilesizey, path, pathlen, unit);
+		if (ret != PF_FAILED) {
+			ProfileEnd("AStarFindPath");
+			return ret;
+		}
+	}
 
-	OpenSetSize = 0;
+	//  Initialize
+	CleanUp();
 
-	if (!AStarMarkGoal(goalPos, gw, gh, tilesizex, tilesizey, minrange, maxrange, unit)) {
+	if (!MarkGoal(goalPos, gw, gh, tilesizex, tilesizey, minrange, maxrange, unit)) {
 		// goal is not reachable
 		ret = PF_UNREACHABLE;
 		ProfileEnd("AStarFindPath");
@@ -1019,34 +1225,35 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPosIn, int gw, int gh,
 	}
 
 	int eo = startPos.y * AStarMapWidth + startPos.x;
+	MarkDirty(startPos.x, startPos.y, startPos.x, startPos.y);
 	// it is quite important to start from 1 rather than 0, because we use
 	// 0 as a way to represent nodes that we have not visited yet.
-	AStarMatrix[eo].SetCostFromStart(1);
+	Matrix[eo].SetCostFromStart(1);
 	// 8 to say we are came from nowhere.
-	AStarMatrix[eo].SetDirection(8);
+	Matrix[eo].SetDirection(8);
 
 	// place start point in open, it that failed, try another pathfinder
 	int costToGoal = AStarCosts(startPos, goalPos);
-	AStarMatrix[eo].SetCostToGoal(costToGoal);
-	if (AStarAddNode(startPos, 1 + costToGoal) == PF_FAILED) {
+	Matrix[eo].SetCostToGoal(costToGoal);
+	if (AddNode(startPos, 1 + costToGoal) == PF_FAILED) {
 		ret = PF_FAILED;
 		ProfileEnd("AStarFindPath");
 		return ret;
 	}
-	if (AStarMatrix[eo].IsInGoal()) {
+	if (Matrix[eo].IsInGoal()) {
 		ret = PF_REACHED;
 		ProfileEnd("AStarFindPath");
 		return ret;
 	}
 	Vec2i endPos;
 
-	int counter = AStarMaxSearchIterations;
+	int counter = maxIterations;
 
 	//  Begin search
 	while (1) {
 		// Find the best node of from the open set
 #ifdef DEBUG
-		if (DumpNextAStar) {
+		if (DumpNextAStar && IsMain) {
 			AStarDumpStats();
 		}
 #endif
@@ -1055,10 +1262,12 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPosIn, int gw, int gh,
 		const int y = OpenSet[shortest].pos.y;
 		const int o = OpenSet[shortest].GetOffset();
 
-		AStarRemoveMinimum(shortest);
+		RemoveMinimum(shortest);
+		// Successors written below are around this node
+		MarkDirty(x - 1, y - 1, x + 1, y + 1);
 
 		// If we have reached the goal, then exit.
-		if (AStarMatrix[o].IsInGoal()) {
+		if (Matrix[o].IsInGoal()) {
 			endPos.x = x;
 			endPos.y = y;
 			break;
@@ -1068,6 +1277,9 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPosIn, int gw, int gh,
 		if (counter <= 0) {
 			AstarDebugPrint("way too long\n");
 			ProfileEnd("AStarFindPath");
+			if (window) {
+				return PF_FAILED;
+			}
 			// return current best
 			// see http://theory.stanford.edu/~amitp/GameProgramming/ImplementationNotes.html#early-exit
 			endPos.x = x;
@@ -1079,10 +1291,10 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPosIn, int gw, int gh,
 
 		// Node that this node was generated from.
 #ifdef DEBUG
-		Assert(AStarMatrix[o].GetDirection() >= 0 && (AStarMatrix[o].GetDirection() < 8 || (x == startPos.x && y == startPos.y)));
+		Assert(Matrix[o].GetDirection() >= 0 && (Matrix[o].GetDirection() < 8 || (x == startPos.x && y == startPos.y)));
 #endif
-		const int px = x - Heading2X[(int)AStarMatrix[o].GetDirection()];
-		const int py = y - Heading2Y[(int)AStarMatrix[o].GetDirection()];
+		const int px = x - Heading2X[(int)Matrix[o].GetDirection()];
+		const int py = y - Heading2Y[(int)Matrix[o].GetDirection()];
 
 		for (int i = 0; i < 8; ++i) {
 			endPos.x = x + Heading2X[i];
@@ -1120,39 +1332,39 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPosIn, int gw, int gh,
 
 			// Add a cost for walking to make paths more realistic for the user.
 			new_cost++;
-			new_cost += AStarMatrix[o].GetCostFromStart();
-			if (AStarMatrix[eo].GetCostFromStart() == 0) {
+			new_cost += Matrix[o].GetCostFromStart();
+			if (Matrix[eo].GetCostFromStart() == 0) {
 				--counter;
 				// we are sure the current node has not been already visited
-				AStarMatrix[eo].SetCostFromStart(new_cost);
-				AStarMatrix[eo].SetDirection(i);
+				Matrix[eo].SetCostFromStart(new_cost);
+				Matrix[eo].SetDirection(i);
 				costToGoal = AStarCosts(endPos, goalPos);
-				AStarMatrix[eo].SetCostToGoal(costToGoal);
-				if (AStarAddNode(endPos, new_cost + costToGoal) == PF_FAILED) {
+				Matrix[eo].SetCostToGoal(costToGoal);
+				if (AddNode(endPos, new_cost + costToGoal) == PF_FAILED) {
 					ret = PF_FAILED;
 					ProfileEnd("AStarFindPath");
 					return ret;
 				}
-			} else if (new_cost < AStarMatrix[eo].GetCostFromStart()) {
+			} else if (new_cost < Matrix[eo].GetCostFromStart()) {
 				--counter;
 				// Already visited node, but we have here a better path
 				// I know, it's redundant (but simpler like this)
-				AStarMatrix[eo].SetCostFromStart(new_cost);
-				AStarMatrix[eo].SetDirection(i);
+				Matrix[eo].SetCostFromStart(new_cost);
+				Matrix[eo].SetDirection(i);
 				// this point might be already in the OpenSet
-				const int j = AStarFindNode(eo);
+				const int j = FindNode(eo);
 				if (j == -1) {
 					costToGoal = AStarCosts(endPos, goalPos);
-					AStarMatrix[eo].SetCostToGoal(costToGoal);
-					if (AStarAddNode(endPos, new_cost + costToGoal) == PF_FAILED) {
+					Matrix[eo].SetCostToGoal(costToGoal);
+					if (AddNode(endPos, new_cost + costToGoal) == PF_FAILED) {
 						ret = PF_FAILED;
 						ProfileEnd("AStarFindPath");
 						return ret;
 					}
 				} else {
 					costToGoal = AStarCosts(endPos, goalPos);
-					AStarMatrix[eo].SetCostToGoal(costToGoal);
-					AStarReplaceNode(j);
+					Matrix[eo].SetCostToGoal(costToGoal);
+					ReplaceNode(j);
 				}
 				// we don't have to add this point to the close set
 			}
@@ -1165,10 +1377,12 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPosIn, int gw, int gh,
 	}
 
 #ifdef DEBUG
-	DumpNextAStar = false;
+	if (IsMain) {
+		DumpNextAStar = false;
+	}
 #endif
-	AstarDebugPrint("AStar counter %d/%d\n", counter, AStarMaxSearchIterations);
-	const int path_length = AStarSavePath(startPos, endPos, path, pathlen);
+	AstarDebugPrint("AStar counter %d/%d\n", counter, maxIterations);
+	const int path_length = SavePath(startPos, endPos, path, pathlen);
 
 	ret = path_length;
 
@@ -1176,14 +1390,39 @@ int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPosIn, int gw, int gh,
 	return ret;
 }
 
+/**
+**  Find path with the search context of the calling thread.
+*/
+int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, int gh,
+				  int tilesizex, int tilesizey, int minrange, int maxrange,
+				  char *path, int pathlen, const CUnit &unit)
+{
+	return AStarThreadContext.FindPath(startPos, goalPos, gw, gh, tilesizex, tilesizey,
+	                                   minrange, maxrange, path, pathlen, unit);
+}
+
+/**
+**  Find a short path to a tile near the start, looking only at the tiles
+**  around both and at most at maxIterations nodes.
+**
+**  @return  The length of the path, or PF_xxx if none was found.
+*/
+int AStarFindLocalPath(const Vec2i &startPos, const Vec2i &goalPos, int tilesizex, int tilesizey,
+					   int window, int maxIterations, char *path, int pathlen, const CUnit &unit)
+{
+	return AStarThreadContext.FindPath(startPos, goalPos, 0, 0, tilesizex, tilesizey, 0, 0,
+	                                   path, pathlen, unit, window, maxIterations);
+}
+
 void AStarDumpStats()
 {
 	int32_t maxCostFromHome = 0;
 	int32_t minCostFromHome = INT_MAX;
 	int32_t maxCostToGoal = 0;
 	int32_t minCostToGoal = INT_MAX;
+	const std::vector<Node> &matrix = AStarThreadContext.GetMatrix();
 
-	for (const Node &m : AStarMatrix) {
+	for (const Node &m : matrix) {
 		
 		maxCostFromHome = std::max(maxCostFromHome, m.GetCostFromStart());
 		maxCostToGoal = std::max(maxCostToGoal, m.GetCostToGoal());
@@ -1196,7 +1435,7 @@ void AStarDumpStats()
 	if (minCostFromHome) minCostFromHome--;
 
 	int i = 0;
-	for (const Node &m : AStarMatrix) {
+	for (const Node &m : matrix) {
 		int r = 0;
 		int g = 0;
 		if (m.GetCostFromStart() && maxCostFromHome - minCostFromHome) {
@@ -1253,7 +1492,7 @@ void DrawLastAStar(const CViewport& vp)
 #if defined(DEBUG_ASTAR)
 	for (auto y = vp.MapPos.y; y != vp.MapPos.y + vp.MapHeight; ++y) {
 		for (auto x = vp.MapPos.x; x != vp.MapPos.x + vp.MapWidth; ++x) {
-			const auto &node = AStarMatrix[GetIndex(x, y)];
+			const auto &node = AStarThreadContext.GetMatrix()[GetIndex(x, y)];
 			const auto direction = node.GetDirection();
 			if (direction == 255) {
 				continue;
@@ -1317,11 +1556,11 @@ int GetAStarUnknownTerrainCost()
 
 void SetAStarFixedEnemyUnitsUnpassable(const bool value)
 {
-	AStarFixedEnemyUnitsUnpassable = value;
+	AStarThreadContext.FixedEnemyUnitsUnpassable = value;
 }
 
 bool GetAStarFixedEnemyUnitsUnpassable()
 {
-	return AStarFixedEnemyUnitsUnpassable;
+	return AStarThreadContext.FixedEnemyUnitsUnpassable;
 }
 //@}
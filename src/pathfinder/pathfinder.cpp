@@ -44,6 +44,8 @@
 #include "unittype.h"
 #include "unit.h"
 
+#include <mutex>
+
 //astar.cpp
 
 /// Init the a* data structures
@@ -57,36 +59,94 @@ extern int AStarFindPath(const Vec2i &startPos, const Vec2i &goalPos, int gw, in
 						 int tilesizex, int tilesizey, int minrange,
 						 int maxrange, char *path, int pathlen, const CUnit &unit);
 
+/// Find a short a* path around the start for a unit
+extern int AStarFindLocalPath(const Vec2i &startPos, const Vec2i &goalPos, int tilesizex, int tilesizey,
+							  int window, int maxIterations, char *path, int pathlen, const CUnit &unit);
+
 /*----------------------------------------------------------------------------
 --  Variables
 ----------------------------------------------------------------------------*/
 
+int AStarStoredPathLength = PathFinderOutput::MAX_PATH_LENGTH;
+
+/// Steps of the stored path a repair goes around
+static constexpr int PathRepairLookAhead = 8;
+/// Longest detour of a repair
+static constexpr int PathRepairMaxLength = 3 * PathRepairLookAhead;
+/// Tiles around the blocked steps a repair looks at
+static constexpr int PathRepairWindow = PathRepairLookAhead / 2;
+/// Nodes a repair looks at before giving up
+static constexpr int PathRepairMaxIterations = 256;
+
+/// Buffers of the long paths not used by a unit
+static std::vector<std::vector<char>> PathBufferPool;
+
+static std::mutex TerrainTraversalPoolMutex;
+static std::vector<std::unique_ptr<TerrainTraversal::Buffers>> TerrainTraversalPool;
+
+TerrainTraversal::TerrainTraversal()
+{
+	std::unique_lock<std::mutex> lock(TerrainTraversalPoolMutex);
+
+	if (TerrainTraversalPool.empty()) {
+		m_buffers = std::make_unique<Buffers>();
+	} else {
+		m_buffers = std::move(TerrainTraversalPool.back());
+		TerrainTraversalPool.pop_back();
+	}
+}
+
+TerrainTraversal::~TerrainTraversal()
+{
+	std::unique_lock<std::mutex> lock(TerrainTraversalPoolMutex);
+
+	TerrainTraversalPool.push_back(std::move(m_buffers));
+}
+
 void TerrainTraversal::SetSize(unsigned int width, unsigned int height)
 {
-	m_values.resize((width + 2) * (height + 2));
+	const size_t size = (width + 2) * (height + 2);
+
+	if (m_buffers->values.size() != size) {
+		m_buffers->values.assign(size, 0);
+		m_buffers->generations.assign(size, 0);
+	}
 	m_extented_width = width + 2;
 	m_height = height;
 }
 
+/**
+**  Start a new search: forget the values of the previous one and mark
+**  the border around the map as invalid.
+*/
 void TerrainTraversal::Init()
 {
 	const unsigned int height = m_height;
 	const unsigned int width = m_extented_width - 2;
 	const unsigned int width_ext = m_extented_width;
+	Buffers &buffers = *m_buffers;
 
-	memset(&m_values[0], '\xFF', width_ext * sizeof(dataType));
+	if (++buffers.generation == 0) {
+		std::fill(buffers.generations.begin(), buffers.generations.end(), 0);
+		buffers.generation = 1;
+	}
+	buffers.queue.clear();
+	m_queueHead = 0;
+
+	for (unsigned i = 0; i != width_ext; ++i) {
+		SetIndex(i, -1);
+		SetIndex((height + 1) * width_ext + i, -1);
+	}
 	for (unsigned i = 1; i < 1 + height; ++i) {
-		m_values[i * width_ext] = -1;
-		memset(&m_values[i * width_ext + 1], '\0', width * sizeof(dataType));
-		m_values[i * width_ext + width + 1] = -1;
+		SetIndex(i * width_ext, -1);
+		SetIndex(i * width_ext + width + 1, -1);
 	}
-	memset(&m_values[(height + 1) * width_ext], '\xFF', width_ext * sizeof(dataType));
 }
 
 void TerrainTraversal::PushPos(const Vec2i &pos)
 {
 	if (IsVisited(pos) == false) {
-		m_queue.push(PosNode(pos, pos));
+		m_buffers->queue.push_back(PosNode(pos, pos));
 		Set(pos, 1);
 	}
 }
@@ -101,7 +161,7 @@ void TerrainTraversal::PushNeighboor(const Vec2i &pos)
 		const Vec2i newPos = pos + offsets[i];
 
 		if (IsVisited(newPos) == false) {
-			m_queue.push(PosNode(newPos, pos));
+			m_buffers->queue.push_back(PosNode(newPos, pos));
 			Set(newPos, Get(pos) + 1);
 		}
 	}
@@ -139,12 +199,21 @@ bool TerrainTraversal::IsInvalid(const Vec2i &pos) const
 
 TerrainTraversal::dataType TerrainTraversal::Get(const Vec2i &pos) const
 {
-	return m_values[m_extented_width + 1 + pos.y * m_extented_width + pos.x];
+	const unsigned int index = m_extented_width + 1 + pos.y * m_extented_width + pos.x;
+	const Buffers &buffers = *m_buffers;
+
+	return buffers.generations[index] == buffers.generation ? buffers.values[index] : 0;
+}
+
+void TerrainTraversal::SetIndex(unsigned int index, TerrainTraversal::dataType value)
+{
+	m_buffers->generations[index] = m_buffers->generation;
+	m_buffers->values[index] = value;
 }
 
 void TerrainTraversal::Set(const Vec2i &pos, TerrainTraversal::dataType value)
 {
-	m_values[m_extented_width + 1 + pos.y * m_extented_width + pos.x] = value;
+	SetIndex(m_extented_width + 1 + pos.y * m_extented_width + pos.x, value);
 }
 
 /*----------------------------------------------------------------------------
@@ -366,9 +435,51 @@ void PathFinderInput::PathRecalculated()
 }
 
 
-PathFinderOutput::PathFinderOutput()
+PathFinderOutput::PathFinderOutput() : Fast(0), OverflowLength(0)
+{
+}
+
+PathFinderOutput::~PathFinderOutput()
+{
+	SetCapacity(MAX_PATH_LENGTH);
+}
+
+/**
+**  Set the number of directions the path can store.
+**
+**  A path longer than MAX_PATH_LENGTH takes a buffer from the pool, a
+**  shorter one gives it back. The stored directions which fit are kept.
+*/
+void PathFinderOutput::SetCapacity(int capacity)
+{
+	const int kept = std::min<int>(Length, std::max(capacity, 0));
+
+	if (capacity <= MAX_PATH_LENGTH) {
+		if (!LongPath.empty()) {
+			std::copy_n(LongPath.begin(), kept, Path);
+			PathBufferPool.push_back(std::move(LongPath));
+			LongPath.clear();
+		}
+		return;
+	}
+	if (LongPath.empty()) {
+		if (!PathBufferPool.empty()) {
+			LongPath = std::move(PathBufferPool.back());
+			PathBufferPool.pop_back();
+		}
+		LongPath.resize(capacity);
+		std::copy_n(Path, std::min<int>(kept, MAX_PATH_LENGTH), LongPath.begin());
+		return;
+	}
+	LongPath.resize(capacity);
+}
+
+/**
+**  Check if the paths are repaired when blocked instead of searched again.
+*/
+static bool IsPathRepairEnabled()
 {
-	memset(this, 0, sizeof(*this));
+	return AStarStoredPathLength > PathFinderOutput::MAX_PATH_LENGTH;
 }
 
 /**
@@ -386,13 +497,14 @@ PathFinderOutput::PathFinderOutput()
 */
 static int NewPath(PathFinderInput &input, PathFinderOutput &output)
 {
-	char *path = output.Path;
+	output.SetCapacity(AStarStoredPathLength);
+	char *path = output.GetPath();
 	int i = AStarFindPath(input.GetUnitPos(),
 						  input.GetGoalPos(),
 						  input.GetGoalSize().x, input.GetGoalSize().y,
 						  input.GetUnitSize().x, input.GetUnitSize().y,
 						  input.GetMinRange(), input.GetMaxRange(),
-						  path, PathFinderOutput::MAX_PATH_LENGTH,
+						  path, output.GetCapacity(),
 						  *input.GetUnit());
 	input.PathRecalculated();
 	if (i == PF_FAILED) {
@@ -403,7 +515,7 @@ static int NewPath(PathFinderInput &input, PathFinderOutput &output)
 	// to know if there exists a path.
 	if (path != nullptr) {
 		if (i >= 0) {
-			output.Length = std::min<int>(i, PathFinderOutput::MAX_PATH_LENGTH);
+			output.Length = std::min<int>(i, output.GetCapacity());
 			output.OverflowLength = std::min<int>(i - output.Length, PathFinderOutput::MAX_OVERFLOW);
 			if (output.Length == 0) {
 				++output.Length;
@@ -412,10 +524,82 @@ static int NewPath(PathFinderInput &input, PathFinderOutput &output)
 			output.Length = 0;
 			output.OverflowLength = 0;
 		}
+		if (output.Length <= PathFinderOutput::MAX_PATH_LENGTH) {
+			// Give the buffer back to the pool
+			output.SetCapacity(PathFinderOutput::MAX_PATH_LENGTH);
+		}
 	}
 	return i;
 }
 
+/**
+**  Go around an obstacle on the stored path.
+**
+**  Search a path to the tile a few steps further on the stored path and
+**  splice it in place of the steps before, instead of searching the
+**  whole path again. The search only looks at the tiles around these
+**  steps, and gives up after a few nodes.
+**
+**  @return  The stored path length, or PF_FAILED if it can't be repaired.
+*/
+static int RepairPath(PathFinderInput &input, PathFinderOutput &output)
+{
+	const char *path = output.GetPath();
+	const int skipped = std::min<int>(output.Length, PathRepairLookAhead);
+	const int kept = output.Length - skipped;
+	Vec2i rejoinPos = input.GetUnitPos();
+
+	for (int i = 0; i < skipped; ++i) {
+		const int direction = path[output.Length - 1 - i];
+		rejoinPos.x += Heading2X[direction];
+		rejoinPos.y += Heading2Y[direction];
+	}
+
+	char detour[PathRepairMaxLength];
+	const int length = AStarFindLocalPath(input.GetUnitPos(), rejoinPos,
+										  input.GetUnitSize().x, input.GetUnitSize().y,
+										  PathRepairWindow, PathRepairMaxIterations,
+										  detour, PathRepairMaxLength, *input.GetUnit());
+	if (length <= 0 || length > PathRepairMaxLength || kept + length > AStarStoredPathLength) {
+		return PF_FAILED;
+	}
+	if (kept + length > output.GetCapacity()) {
+		output.SetCapacity(AStarStoredPathLength);
+	}
+	// Both are stored from their end, the detour goes after the kept steps
+	std::copy(detour, detour + length, output.GetPath() + kept);
+	output.Length = kept + length;
+	return output.Length;
+}
+
+/**
+**  Returns the next element of a path whose next step is blocked,
+**  when the paths are repaired.
+**
+**  Go around the obstacle if possible, else wait for it to move, trying
+**  the same step again, and search the whole path again at last.
+*/
+static std::pair<int, Vec2i> RepairedPathElement(CUnit &unit, PathFinderInput &input, PathFinderOutput &output)
+{
+	if (RepairPath(input, output) > 0) {
+		const char direction = output.GetPath()[output.Length - 1];
+		const Vec2i dir(Heading2X[(int)direction], Heading2Y[(int)direction]);
+
+		if (UnitCanBeAt(unit, unit.tilePos + dir)) {
+			output.Fast = 0;
+			return {output.Length, dir};
+		}
+	}
+	if (output.Fast == 1) {
+		AstarDebugPrint("WAIT expired\n");
+		output.Fast = 0;
+		output.Length = 0;
+	} else {
+		output.Fast = output.Fast ? output.Fast - 1 : PathFinderOutput::MAX_FAST;
+	}
+	return {PF_WAIT, {0, 0}};
+}
+
 /**
 **  Returns the next element of a path.
 **
@@ -445,14 +629,18 @@ std::pair<int, Vec2i> NextPathElement(CUnit &unit)
 		if (result == PF_REACHED) {
 			return {result, {}};
 		}
-	} else {
+	} else if (!IsPathRepairEnabled() || output.Fast == 0) {
+		// With path repair, a blocked step is tried again after waiting
 		output.Length--;
 	}
 
-	Vec2i dir(Heading2X[(int) output.Path[output.Length - 1]],
-	          Heading2Y[(int) output.Path[output.Length - 1]]);
+	Vec2i dir(Heading2X[(int) output.GetPath()[output.Length - 1]],
+	          Heading2Y[(int) output.GetPath()[output.Length - 1]]);
 	int result = output.Length;
 	if (!UnitCanBeAt(unit, unit.tilePos + dir)) {
+		if (IsPathRepairEnabled()) {
+			return RepairedPathElement(unit, input, output);
+		}
 		// If obstructing unit is moving, wait for a bit.
 		if (output.Fast) {
 			output.Fast--;
@@ -467,8 +655,8 @@ std::pair<int, Vec2i> NextPathElement(CUnit &unit)
 			AstarDebugPrint("WAIT expired\n");
 			result = NewPath(input, output);
 			if (result > 0) {
-				dir.x = Heading2X[(int)output.Path[output.Length - 1]];
-				dir.y = Heading2Y[(int)output.Path[output.Length - 1]];
+				dir.x = Heading2X[(int)output.GetPath()[output.Length - 1]];
+				dir.y = Heading2Y[(int)output.GetPath()[output.Length - 1]];
 				if (!UnitCanBeAt(unit, unit.tilePos + dir)) {
 					// There may be unit in the way, Astar may allow you to walk onto it.
 					result = PF_UNREACHABLE;
@@ -81,6 +81,10 @@ static int CclAStar(lua_State *l)
 			AStarKnowUnseenTerrain = true;
 		} else if (value == "dont-know-unseen-terrain") {
 			AStarKnowUnseenTerrain = false;
+		} else if (value == "uniform-shortcut") {
+			AStarUniformShortcut = true;
+		} else if (value == "no-uniform-shortcut") {
+			AStarUniformShortcut = false;
 		} else if (value == "unseen-terrain-cost") {
 			++j;
 			i = LuaToNumber(l, j + 1);
@@ -89,6 +93,15 @@ static int CclAStar(lua_State *l)
 			} else {
 				AStarUnknownTerrainCost = i;
 			}
+		} else if (value == "stored-path-length") {
+			++j;
+			i = LuaToNumber(l, j + 1);
+			if (i < PathFinderOutput::MAX_PATH_LENGTH || i > PathFinderOutput::MAX_STORED_PATH_LENGTH) {
+				LuaError(l, "Stored path length must be between %d and %d\n",
+				         PathFinderOutput::MAX_PATH_LENGTH, PathFinderOutput::MAX_STORED_PATH_LENGTH);
+			} else {
+				AStarStoredPathLength = i;
+			}
 		} else if (value == "max-search-iterations") {
 			++j;
 			i = LuaToNumber(l, j + 1);
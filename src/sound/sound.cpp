@@ -451,6 +451,26 @@ std::shared_ptr<CSound> RegisterTwoGroups(CSound *first, CSound *second)
 	return id;
 }
 
+/**
+**  Start decoding the samples of a sound, so its first play doesn't wait.
+**
+**  @param sound  Sound (or group of sounds) to prefetch.
+*/
+void PrefetchSound(const CSound *sound)
+{
+	if (sound == nullptr) {
+		return;
+	}
+	if (auto *chunks = std::get_if<std::vector<sdl2::ChunkPtr>>(&sound->Sound)) {
+		for (const auto &sample : *chunks) {
+			PrefetchSample(sample.get());
+		}
+	} else if (auto *p = std::get_if<std::pair<CSound *, CSound *>>(&sound->Sound)) {
+		PrefetchSound(p->first);
+		PrefetchSound(p->second);
+	}
+}
+
 /**
 **  Lookup the sound id's for the game sounds.
 */
@@ -51,6 +51,14 @@
 #include <SDL.h>
 #include <SDL_mixer.h>
 
+#ifdef DYNAMIC_LOAD
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#endif
+
 #ifdef _MSC_VER
 # include <Shlobj.h>
 #endif
@@ -411,6 +419,165 @@ static sdl2::ChunkPtr ForceLoadSample(const char *name)
 	return sdl2::ChunkPtr{Mix_LoadWAV_RW(CFile::to_SDL_RWops(std::move(f)), 1)};
 }
 
+#ifdef DYNAMIC_LOAD
+/**
+**  Decode the not yet loaded samples in background threads.
+**
+**  The workers only decode, the placeholder is replaced by the decoded
+**  sample in the game thread (see Finish), so a sample never changes
+**  while it may be played.
+*/
+class CSampleLoader
+{
+public:
+	~CSampleLoader() { Stop(); }
+
+	void Start(unsigned int threadCount);
+	void Stop();
+	bool Prefetch(Mix_Chunk &sample);
+	void Cancel(Mix_Chunk &sample);
+	void Finish();
+
+private:
+	struct Job
+	{
+		Mix_Chunk *Sample;  /// Placeholder to replace
+		unsigned int Id;    /// Tell apart a placeholder allocated at the same address
+		std::string Name;   /// File to decode
+	};
+
+	void Work();
+
+	std::mutex Mutex;
+	std::condition_variable Wake;
+	std::vector<std::thread> Threads;
+	std::deque<Job> Queue;
+	/// Samples queued or being decoded, 0 when the decoding failed
+	std::unordered_map<Mix_Chunk *, unsigned int> Requested;
+	std::vector<std::pair<Job, sdl2::ChunkPtr>> Done;
+	unsigned int LastId = 0;
+	bool Stopping = false;
+};
+
+static CSampleLoader SampleLoader;
+
+void CSampleLoader::Start(unsigned int threadCount)
+{
+	Stopping = false;
+	for (unsigned int i = 0; i != threadCount; ++i) {
+		Threads.emplace_back([this]() { Work(); });
+	}
+}
+
+void CSampleLoader::Stop()
+{
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		Stopping = true;
+	}
+	Wake.notify_all();
+	for (auto &thread : Threads) {
+		thread.join();
+	}
+	Threads.clear();
+
+	decltype(Done) done;
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		Queue.clear();
+		Requested.clear();
+		done.swap(Done);
+	}
+}
+
+void CSampleLoader::Work()
+{
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(Mutex);
+			Wake.wait(lock, [this]() { return Stopping || !Queue.empty(); });
+			if (Stopping) {
+				return;
+			}
+			job = std::move(Queue.front());
+			Queue.pop_front();
+		}
+		sdl2::ChunkPtr chunk = ForceLoadSample(job.Name.c_str());
+
+		std::unique_lock<std::mutex> lock(Mutex);
+		Done.emplace_back(std::move(job), std::move(chunk));
+	}
+}
+
+/**
+**  Queue the decoding of a not yet loaded sample.
+**
+**  @return  false if there is no worker to decode it.
+*/
+bool CSampleLoader::Prefetch(Mix_Chunk &sample)
+{
+	Assert(sample.allocated == NotYetLoadedMagic);
+	if (Threads.empty()) {
+		return false;
+	}
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		if (!Requested.try_emplace(&sample, ++LastId).second) {
+			return true;
+		}
+		Queue.push_back({&sample, LastId, reinterpret_cast<char *>(sample.abuf)});
+	}
+	Wake.notify_one();
+	return true;
+}
+
+/**
+**  Forget a placeholder which is freed.
+*/
+void CSampleLoader::Cancel(Mix_Chunk &sample)
+{
+	std::unique_lock<std::mutex> lock(Mutex);
+
+	// A decoding already running or done is dropped by Finish
+	if (Requested.erase(&sample) != 0) {
+		Queue.erase(std::remove_if(Queue.begin(), Queue.end(), [&](const Job &job) { return job.Sample == &sample; }),
+		            Queue.end());
+	}
+}
+
+/**
+**  Replace the placeholders by the samples decoded so far.
+*/
+void CSampleLoader::Finish()
+{
+	decltype(Done) done;
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		if (Done.empty()) {
+			return;
+		}
+		done.swap(Done);
+		for (auto &[job, chunk] : done) {
+			auto it = Requested.find(job.Sample);
+			if (it == Requested.end() || it->second != job.Id) {
+				job.Sample = nullptr; // Freed meanwhile
+			} else if (chunk) {
+				Requested.erase(it);
+			} else {
+				it->second = 0; // Don't try again
+			}
+		}
+	}
+	// The placeholders are freed with the swapped chunks, without the lock held
+	for (auto &[job, chunk] : done) {
+		if (job.Sample && chunk) {
+			std::swap(*job.Sample, *chunk);
+		}
+	}
+}
+#endif
+
 static sdl2::ChunkPtr LoadSample(const char *name)
 {
 #ifdef DYNAMIC_LOAD
@@ -473,6 +640,9 @@ void FreeSample(Mix_Chunk *sample)
 	}
 #ifdef DYNAMIC_LOAD
 	if (sample->allocated == NotYetLoadedMagic) {
+		if (SoundInitialized) {
+			SampleLoader.Cancel(*sample);
+		}
 		free(sample->abuf);
 		SDL_free(sample);
 		return;
@@ -496,7 +666,12 @@ static int PlaySample(Mix_Chunk *sample, Origin *origin, void (*callback)(int ch
 	if (SoundEnabled() && EffectsEnabled && sample) {
 		DebugPrint("play sample %d\n", sample->volume);
 #ifdef DYNAMIC_LOAD
+		SampleLoader.Finish();
 		if (sample->allocated == NotYetLoadedMagic) {
+			if (SampleLoader.Prefetch(*sample)) {
+				// Still decoding: skip this play rather than stall the game
+				return -1;
+			}
 			char *name = (char*)(sample->abuf);
 			if (auto loadedSample = ForceLoadSample(name)) {
 				std::swap(*sample, *loadedSample);
@@ -519,6 +694,24 @@ static int PlaySample(Mix_Chunk *sample, Origin *origin, void (*callback)(int ch
 	return channel;
 }
 
+/**
+**  Start decoding a sample in the background so it is ready when played.
+**
+**  Only not yet loaded samples (DYNAMIC_LOAD) are concerned.
+**
+**  @param sample  Sample to decode.
+*/
+void PrefetchSample(Mix_Chunk *sample)
+{
+#ifdef DYNAMIC_LOAD
+	if (sample && sample->allocated == NotYetLoadedMagic) {
+		SampleLoader.Prefetch(*sample);
+	}
+#else
+	(void) sample;
+#endif
+}
+
 int PlaySample(Mix_Chunk *sample, Origin *origin)
 {
 	return PlaySample(sample, origin, nullptr);
@@ -744,6 +937,10 @@ bool InitSound()
 	Mix_AllocateChannels(MaxChannels);
 	Mix_ChannelFinished(ChannelFinished);
 
+#ifdef DYNAMIC_LOAD
+	SampleLoader.Start(std::clamp(std::thread::hardware_concurrency() / 2, 1u, 2u));
+#endif
+
 	// Now we're ready for the callback to run
 	Mix_ResumeMusic();
 	Mix_Resume(-1);
@@ -755,6 +952,9 @@ bool InitSound()
 */
 void QuitSound()
 {
+#ifdef DYNAMIC_LOAD
+	SampleLoader.Stop();
+#endif
 	Mix_CloseAudio();
 	Mix_Quit();
 	SoundInitialized = false;
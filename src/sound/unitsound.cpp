@@ -44,6 +44,7 @@
 #include "sound.h"
 #include "sound_server.h"
 #include "unit.h"
+#include "unit_manager.h"
 #include "unittype.h"
 #include "video.h"
 
@@ -155,4 +156,38 @@ void MapUnitSounds()
 	}
 }
 
+/**
+**  Start decoding the voices of the unit types present on the map.
+**
+**  Only useful with DYNAMIC_LOAD, where the samples are decoded the
+**  first time they are played.
+*/
+void PrefetchUnitSounds()
+{
+	if (SoundEnabled() == false) {
+		return;
+	}
+	std::vector<bool> done(getUnitTypes().size());
+	for (const CUnit *unit : UnitManager->GetUnits()) {
+		const CUnitType &type = *unit->Type;
+		if (done[type.Slot]) {
+			continue;
+		}
+		done[type.Slot] = true;
+
+		const CUnitSound &sounds = type.MapSound;
+		for (const SoundConfig *config : {&sounds.Selected, &sounds.Acknowledgement, &sounds.Attack,
+		                                  &sounds.Build, &sounds.Ready, &sounds.Repair,
+		                                  &sounds.Help, &sounds.WorkComplete}) {
+			PrefetchSound(config->Sound.get());
+		}
+		for (const auto &soundConfig : sounds.Harvest) {
+			PrefetchSound(soundConfig.Sound.get());
+		}
+		for (const auto &soundConfig : sounds.Dead) {
+			PrefetchSound(soundConfig.Sound.get());
+		}
+	}
+}
+
 //@}
@@ -48,6 +48,7 @@
 #include "spell/spell_spawnportal.h"
 #include "spell/spell_summon.h"
 #include "spell/spell_teleport.h"
+#include "ident_table.h"
 #include "luacallback.h"
 #include "script_sound.h"
 #include "script.h"
@@ -335,14 +336,15 @@ static int CclDefineSpell(lua_State *l)
 	const int args = lua_gettop(l);
 	std::string_view identname = LuaToString(l, 1);
 
-	const auto it = ranges::find(SpellTypeTable, identname, &SpellType::Ident);
+	const int slot = IdentTable.Find(EIdentKind::SpellType, identname);
 	SpellType *spell = nullptr;
-	if (it != SpellTypeTable.end()) {
-		spell = it->get();
+	if (slot != -1) {
+		spell = SpellTypeTable[slot].get();
 		LuaDebugPrint(l, "Redefining spell-type '%s'\n", identname.data());
 	} else {
 		SpellTypeTable.push_back(std::make_unique<SpellType>(SpellTypeTable.size(), std::string{identname}));
 		spell = SpellTypeTable.back().get();
+		IdentTable.Add(EIdentKind::SpellType, identname, spell->Slot);
 		for (CUnitType *unitType : getUnitTypes()) { // adjust array for caster already defined
 			if (!unitType->CanCastSpell.empty()) {
 				unitType->CanCastSpell.resize(SpellTypeTable.size());
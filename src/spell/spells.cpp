@@ -48,6 +48,7 @@
 
 #include "actions.h"
 #include "commands.h"
+#include "ident_table.h"
 #include "map.h"
 #include "sound.h"
 #include "unit.h"
@@ -385,9 +386,8 @@ void InitSpells()
 */
 SpellType &SpellTypeByIdent(const std::string_view &ident)
 {
-	auto it = ranges::find(SpellTypeTable, ident, &SpellType::Ident);
-	if (it != SpellTypeTable.end()) {
-		return **it;
+	if (const int slot = IdentTable.Find(EIdentKind::SpellType, ident); slot != -1) {
+		return *SpellTypeTable[slot];
 	}
 	ErrorPrint("Unknown spellType '%s'\n", ident.data());
 	ExitFatal(1);
@@ -548,6 +548,7 @@ void CleanSpells()
 {
 	DebugPrint("Cleaning spells.\n");
 	SpellTypeTable.clear();
+	IdentTable.Clear(EIdentKind::SpellType);
 }
 
 //@}
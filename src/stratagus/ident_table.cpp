@@ -0,0 +1,95 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name ident_table.cpp - The interned identifiers. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "stratagus.h"
+
+#include "ident_table.h"
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+CIdentTable IdentTable;
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+/**
+**  Intern the identifier of a new object.
+**
+**  @param kind    Kind of the object.
+**  @param ident   Identifier of the object.
+**  @param handle  Index of the object in the table of its kind.
+*/
+void CIdentTable::Add(EIdentKind kind, std::string_view ident, int handle)
+{
+	Table &table = Tables[static_cast<size_t>(kind)];
+
+	if (auto it = table.Handles.find(ident); it != table.Handles.end()) {
+		it->second = handle;
+		return;
+	}
+	const std::string &interned = table.Idents.emplace_back(ident);
+	table.Handles.emplace(interned, handle);
+}
+
+/**
+**  Find the handle of an identifier.
+**
+**  @param kind   Kind of the object.
+**  @param ident  Identifier of the object.
+**
+**  @return       Handle of the object, or -1 if not defined.
+*/
+int CIdentTable::Find(EIdentKind kind, std::string_view ident) const
+{
+	const Table &table = Tables[static_cast<size_t>(kind)];
+	const auto it = table.Handles.find(ident);
+
+	return it != table.Handles.end() ? it->second : -1;
+}
+
+/**
+**  Forget the identifiers of a kind, when its objects are cleaned.
+*/
+void CIdentTable::Clear(EIdentKind kind)
+{
+	Table &table = Tables[static_cast<size_t>(kind)];
+
+	table.Handles.clear();
+	table.Idents.clear();
+}
+
+//@}
@@ -44,8 +44,11 @@
 #include "missile.h"
 #include "network.h"
 #include "particle.h"
+#include "profiler.h"
 #include "replay.h"
+#include "retained_ui.h"
 #include "results.h"
+#include "script.h"
 #include "sound.h"
 #include "translate.h"
 #include "trigger.h"
@@ -59,6 +62,8 @@
 #endif
 
 void DrawGuichanWidgets();
+bool IsMenuScreenShown();
+bool GetGuichanWidgetsArea(int &x, int &y, int &w, int &h);
 
 
 enum CallPeriod { cEvery2nd   = 0b1,
@@ -176,6 +181,87 @@ void DrawMapArea(const fieldHighlightChecker highlightChecker = nullptr)
 	}
 }
 
+/**
+**  Draw the panels of the user interface around the map area.
+**
+**  In the retained mode, the panels whose state didn't change are
+**  copied from their cache.
+*/
+static void DrawPanels()
+{
+	static std::vector<CRetainedPanel> fillerPanels;
+	static CRetainedPanel menuButtonPanel;
+	static CRetainedPanel userButtonsPanel;
+	static CRetainedPanel minimapPanel;
+	static CRetainedPanel infoPanel;
+	static CRetainedPanel resourcesPanel;
+	static CRetainedPanel statusLinePanel;
+	static CRetainedPanel buttonPanel;
+
+	fillerPanels.resize(UI.Fillers.size());
+	for (std::size_t i = 0; i != UI.Fillers.size(); ++i) {
+		const CFiller &filler = UI.Fillers[i];
+		RetainedUI.DrawPanel(fillerPanels[i], [&filler]() {
+			CPanelState state;
+			state.AddArea(filler.X, filler.Y, filler.G->Width, filler.G->Height);
+			state << filler.G.get();
+			return state;
+		}, [&filler]() {
+			filler.G->DrawSubClip(0, 0, filler.G->Width, filler.G->Height, filler.X, filler.Y);
+		});
+	}
+	RetainedUI.DrawPanel(menuButtonPanel, GetMenuButtonAreaState, DrawMenuButtonArea);
+	RetainedUI.DrawPanel(userButtonsPanel, GetUserDefinedButtonsState, DrawUserDefinedButtons);
+
+	RetainedUI.DrawPanel(minimapPanel, []() { return UI.Minimap.GetState(); }, []() {
+		UI.Minimap.Draw();
+		for (std::size_t i = 0; i != UI.NumViewports; ++i) {
+			UI.Minimap.DrawViewportArea(UI.Viewports[i],
+			                            UI.SelectedViewport == &UI.Viewports[i] ? 255 : 128);
+		}
+	});
+
+	RetainedUI.DrawPanel(infoPanel, []() { return UI.InfoPanel.GetState(); }, []() { UI.InfoPanel.Draw(); });
+	RetainedUI.DrawPanel(resourcesPanel, GetResourcesState, DrawResources);
+	RetainedUI.DrawPanel(statusLinePanel, []() { return UI.StatusLine.GetState(); }, []() {
+		UI.StatusLine.Draw();
+		UI.StatusLine.DrawCosts();
+	});
+	RetainedUI.DrawPanel(buttonPanel, []() { return UI.ButtonPanel.GetState(); }, []() {
+		UI.ButtonPanel.DrawButtons();
+	});
+	// The popup of the hovered button may be anywhere
+	if (ButtonAreaUnderCursor == ButtonArea::Button && ButtonUnderCursor != -1) {
+		RetainedUI.PresentAll();
+	}
+	UI.ButtonPanel.DrawHoveredButton();
+}
+
+/**
+**  Mark what is drawn over the panels to be presented.
+*/
+static void AddOverlayDamage()
+{
+	// Messages are drawn from the map area to the right of the screen
+	RetainedUI.AddDamage(UI.MapArea.X, UI.MapArea.Y,
+	                     Video.Width - UI.MapArea.X, UI.MapArea.EndY - UI.MapArea.Y + 1);
+	if (GameTimer.Init && UI.Timer.Font) {
+		RetainedUI.AddDamage(UI.Timer.X, UI.Timer.Y, UI.Timer.Font->Width("88:88:88"), UI.Timer.Font->Height());
+	}
+	if (!Preference.HardwareCursor && GameCursor && GameCursor->G) {
+		const PixelPos pos = CursorScreenPos - GameCursor->HotPos;
+		RetainedUI.AddDamage(pos.x, pos.y, GameCursor->G->getWidth(), GameCursor->G->getHeight());
+	}
+	// The widgets set up by the game scripts are drawn over the panels
+	int x, y, w, h;
+	if (GetGuichanWidgetsArea(x, y, w, h)) {
+		RetainedUI.AddDamage(x, y, w, h);
+	}
+	if (CursorState == CursorStates::PieMenu || Profiler.IsOverlayShown()) {
+		RetainedUI.PresentAll();
+	}
+}
+
 /**
 **  Display update.
 **
@@ -184,10 +270,16 @@ void DrawMapArea(const fieldHighlightChecker highlightChecker = nullptr)
 */
 void UpdateDisplay()
 {
+	RetainedUI.BeginFrame(Preference.RetainedUI && GameRunning && Editor.Running == EditorNotRunning
+	                      && !BigMapMode && !IsMenuScreenShown());
+
 	if (GameRunning || Editor.Running == EditorEditing) {
 		// to prevent empty spaces in the UI
 		Video.FillRectangleClip(ColorBlack, 0, 0, Video.Width, Video.Height);
-		DrawMapArea();
+		{
+			const CProfileScope profile("Viewports");
+			DrawMapArea();
+		}
 		// TODO: for e.g. environmental effects, we want to push to the renderer here with appropriate shaders set,
 		// then do the rest.
 		DrawMessages();
@@ -198,26 +290,12 @@ void UpdateDisplay()
 
 		if ((Preference.BigScreen && !BigMapMode) || (!Preference.BigScreen && BigMapMode)) {
 			UiToggleBigMap();
+			RetainedUI.Reset();
 		}
 
 		if (!BigMapMode) {
-			for (auto &filler : UI.Fillers) {
-				filler.G->DrawSubClip(0, 0, filler.G->Width, filler.G->Height, filler.X, filler.Y);
-			}
-			DrawMenuButtonArea();
-			DrawUserDefinedButtons();
-
-			UI.Minimap.Draw();
-			for (std::size_t i = 0; i != UI.NumViewports; ++i) {
-				UI.Minimap.DrawViewportArea(UI.Viewports[i],
-				                            UI.SelectedViewport == &UI.Viewports[i] ? 255 : 128);
-			}
-
-			UI.InfoPanel.Draw();
-			DrawResources();
-			UI.StatusLine.Draw();
-			UI.StatusLine.DrawCosts();
-			UI.ButtonPanel.Draw();
+			const CProfileScope profile("UI");
+			DrawPanels();
 		}
 
 		DrawTimer();
@@ -227,6 +305,8 @@ void UpdateDisplay()
 
 	DrawGuichanWidgets();
 
+	Profiler.Draw();
+
 	if (CursorState != CursorStates::Rectangle) {
 		DrawCursor();
 	}
@@ -234,7 +314,10 @@ void UpdateDisplay()
 	//
 	// Update changes to display.
 	//
-	Invalidate();
+	if (RetainedUI.IsActive()) {
+		AddOverlayDamage();
+	}
+	RetainedUI.EndFrame();
 }
 
 static void InitGameCallbacks()
@@ -251,6 +334,8 @@ static void InitGameCallbacks()
 
 static void GameLogicLoop()
 {
+	const CProfileScope profile("GameLogic");
+
 	// Can't find a better place.
 	// FIXME: We need find better place!
 	SaveGameLoading = false;
@@ -262,11 +347,26 @@ static void GameLogicLoop()
 		SinglePlayerReplayEachCycle();
 		++GameCycle;
 		MultiPlayerReplayEachCycle();
-		NetworkCommands(); // Get network commands
-		TriggersEachCycle();// handle triggers
-		UnitActions();      // handle units
-		MissileActions();   // handle missiles
-		PlayersEachCycle(); // handle players
+		{
+			const CProfileScope profile("NetworkCommands");
+			NetworkCommands(); // Get network commands
+		}
+		{
+			const CProfileScope profile("Triggers");
+			TriggersEachCycle();// handle triggers
+		}
+		{
+			const CProfileScope profile("UnitActions");
+			UnitActions();      // handle units
+		}
+		{
+			const CProfileScope profile("MissileActions");
+			MissileActions();   // handle missiles
+		}
+		{
+			const CProfileScope profile("Players/AI");
+			PlayersEachCycle(); // handle players
+		}
 		UpdateTimer();      // update game timer
 
 
@@ -308,6 +408,7 @@ static void GameLogicLoop()
 				int player = (GameCycle % CYCLES_PER_SECOND) - 7;
 				Assert(player >= 0);
 				if (player < NumPlayers) {
+					const CProfileScope profile("PlayersEachSecond");
 					PlayersEachSecond(player);
 				}
 			}
@@ -324,6 +425,7 @@ static void GameLogicLoop()
 	ParticleManager.update(); // handle particles
 
 	if (FastForwardCycle <= GameCycle || !(GameCycle & CallPeriod::cEvery256th)) {
+		const CProfileScope profile("WaitEvents");
 		WaitEventsOneFrame();
 	}
 
@@ -338,6 +440,8 @@ static void GameLogicLoop()
 
 static void DisplayLoop()
 {
+	const CProfileScope profile("Display");
+
 	/* update only if viewmode changed */
 	CheckViewportMode();
 
@@ -346,6 +450,7 @@ static void DisplayLoop()
 	 *	FIXME: still not secure
 	 */
 	if (UI.Minimap.UpdateCache) {
+		const CProfileScope profile("Minimap");
 		UI.Minimap.Update();
 		UI.Minimap.UpdateCache = false;
 	}
@@ -362,18 +467,28 @@ static void DisplayLoop()
 		// program, as we now still have a game on the background and
 		// need to go through the game-menu or supply a map file
 
-		FogOfWar->Update(FastForwardCycle > GameCycle);
-
-		UpdateDisplay();
-		RealizeVideoMemory();
+		{
+			const CProfileScope profile("FogOfWar");
+			FogOfWar->Update(FastForwardCycle > GameCycle);
+		}
+		{
+			const CProfileScope profile("UpdateDisplay");
+			UpdateDisplay();
+		}
+		{
+			const CProfileScope profile("RealizeVideoMemory");
+			RealizeVideoMemory();
+		}
 	}
 }
 
 static void SingleGameLoop()
 {
 	while (GameRunning) {
+		Profiler.BeginFrame();
 		DisplayLoop();
 		GameLogicLoop();
+		Profiler.EndFrame();
 	}
 }
 
@@ -405,11 +520,17 @@ void GameMainLoop()
 
 	CclCommand("if (GameStarting ~= nil) then GameStarting() end");
 
+	if (Parameters::Instance.benchmark) {
+		Profiler.Clear();
+		Profiler.SetCollect(true);
+	}
 	long ticks = SDL_GetTicks();
 
 	MultiPlayerReplayEachCycle();
 
+	LuaGarbageCollectBeginGame();
 	SingleGameLoop();
+	LuaGarbageCollectEndGame();
 
 	//
 	// Game over
@@ -418,6 +539,8 @@ void GameMainLoop()
 		OnlineContextHandler->reportGameResult();
 	}
 
+	Profiler.StopTrace();
+
 	if (GameResult == GameExit) {
 		Exit(0);
 		return;
@@ -435,6 +558,8 @@ void GameMainLoop()
 		           ticks,
 		           FrameCounter,
 		           GameCycle);
+		Profiler.Print();
+		Profiler.SetCollect(false);
 	}
 
 	GameCycle = 0;
@@ -40,12 +40,16 @@
 #include "action/action_upgradeto.h"
 #include "actions.h"
 #include "ai.h"
+#include "depend.h"
+#include "influence_map.h"
 #include "iolib.h"
 #include "map.h"
 #include "network.h"
 #include "netconnect.h"
 #include "sound.h"
 #include "translate.h"
+#include "trigger.h"
+#include "unit_area_count.h"
 #include "unitsound.h"
 #include "unittype.h"
 #include "unit.h"
@@ -635,6 +639,7 @@ void CreatePlayer(PlayerTypes type)
 void CPlayer::Init(PlayerTypes type)
 {
 	std::vector<CUnit *>().swap(this->Units);
+	std::vector<std::vector<CUnit *>>().swap(this->UnitsByType);
 	std::vector<CUnit *>().swap(this->FreeWorkers);
 
 	//  Take first slot for person on this computer,
@@ -753,6 +758,8 @@ void CPlayer::Init(PlayerTypes type)
 
 	ranges::fill(this->UnitTypesCount, 0);
 	ranges::fill(this->UnitTypesAiActiveCount, 0);
+	AvailabilityChanged();
+	UpdateAvailability(*this);
 
 	this->Supply = 0;
 	this->Demand = 0;
@@ -809,9 +816,12 @@ void CPlayer::Clear()
 	ranges::fill(Revenue, 0);
 	ranges::fill(UnitTypesCount, 0);
 	ranges::fill(UnitTypesAiActiveCount, 0);
+	AvailabilityChanged();
+	UpdateAvailability(*this);
 	AiEnabled = false;
 	Ai = nullptr;
 	this->Units.resize(0);
+	this->UnitsByType.clear();
 	this->FreeWorkers.resize(0);
 	NumBuildings = 0;
 	Supply = 0;
@@ -855,6 +865,9 @@ void CPlayer::AddUnit(CUnit &unit)
 	this->Units.push_back(&unit);
 	unit.Player = this;
 	Assert(this->Units[unit.PlayerSlot] == &unit);
+	AddUnitOfType(unit);
+	UnitAreaCount.Update(unit);
+	InfluenceMap.Update(unit);
 }
 
 void CPlayer::RemoveUnit(CUnit &unit)
@@ -862,6 +875,8 @@ void CPlayer::RemoveUnit(CUnit &unit)
 	Assert(unit.Player == this);
 	Assert(this->Units[unit.PlayerSlot] == &unit);
 
+	RemoveUnitOfType(unit);
+
 	//	unit.Player = nullptr; // we can remove dying unit...
 	CUnit *last = this->Units.back();
 
@@ -872,6 +887,53 @@ void CPlayer::RemoveUnit(CUnit &unit)
 	Assert(last == &unit || this->Units[last->PlayerSlot] == last);
 }
 
+/**
+**  Get the units of this player of a type.
+**
+**  @param type  Unit type.
+**
+**  @return      The units, including the unusable ones.
+*/
+const std::vector<CUnit *> &CPlayer::GetUnitsOfType(const CUnitType &type) const
+{
+	static const std::vector<CUnit *> none;
+
+	if (type.Slot >= static_cast<int>(this->UnitsByType.size())) {
+		return none;
+	}
+	return this->UnitsByType[type.Slot];
+}
+
+/**
+**  Add the unit to the type list, done by AddUnit and when the unit changes its type.
+*/
+void CPlayer::AddUnitOfType(CUnit &unit)
+{
+	Assert(unit.PlayerTypeSlot == static_cast<size_t>(-1));
+	const int slot = unit.Type->Slot;
+	if (slot >= static_cast<int>(this->UnitsByType.size())) {
+		this->UnitsByType.resize(slot + 1);
+	}
+	auto &units = this->UnitsByType[slot];
+	unit.PlayerTypeSlot = units.size();
+	units.push_back(&unit);
+}
+
+/**
+**  Remove the unit from the type list, done by RemoveUnit and when the unit changes its type.
+*/
+void CPlayer::RemoveUnitOfType(CUnit &unit)
+{
+	auto &units = this->UnitsByType[unit.Type->Slot];
+	Assert(units[unit.PlayerTypeSlot] == &unit);
+
+	CUnit *last = units.back();
+	units[unit.PlayerTypeSlot] = last;
+	last->PlayerTypeSlot = unit.PlayerTypeSlot;
+	units.pop_back();
+	unit.PlayerTypeSlot = static_cast<size_t>(-1);
+}
+
 void CPlayer::UpdateFreeWorkers()
 {
 	FreeWorkers.clear();
@@ -932,6 +994,9 @@ int CPlayer::GetResource(const int resource, const EStoreType type)
 */
 void CPlayer::ChangeResource(const int resource, const int value, const bool store)
 {
+	if (value != 0) {
+		TriggerNotifyEvent(ETriggerEvent::ResourceChanged);
+	}
 	if (value < 0) {
 		const int fromStore = std::min(this->StoredResources[resource], abs(value));
 		this->StoredResources[resource] -= fromStore;
@@ -955,6 +1020,7 @@ void CPlayer::ChangeResource(const int resource, const int value, const bool sto
 */
 void CPlayer::SetResource(const int resource, const int value, const EStoreType type)
 {
+	TriggerNotifyEvent(ETriggerEvent::ResourceChanged);
 	switch (type) {
 		case EStoreType::Both:
 		{
@@ -1011,6 +1077,19 @@ int CPlayer::GetUnitTotalCount(const CUnitType &type) const
 	return count;
 }
 
+/**
+**  Change the count of units of a type.
+**
+**  @param type   Type of the units.
+**  @param delta  Number of units added, negative when removed.
+*/
+void CPlayer::ChangeUnitTypeCount(const CUnitType &type, int delta)
+{
+	UnitTypesCount[type.Slot] += delta;
+	AvailabilityChanged();
+	UpdateUnitTypeAvailability(*this, type.Slot);
+}
+
 /**
 **  Check if the unit-type didn't break any unit limits.
 **
@@ -0,0 +1,363 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name profiler.cpp - The frame time profiler. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "stratagus.h"
+
+#include "profiler.h"
+
+#include "font.h"
+#include "iolib.h"
+#include "parameters.h"
+#include "script.h"
+#include "settings.h"
+#include "ui.h"
+#include "video.h"
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+CProfiler Profiler;  /// Main loop profiler
+
+/// Upper bound of recorded trace events, a trace is written out when reached
+static constexpr size_t MAX_TRACE_EVENTS = 2000000;
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+static double ToMilliseconds(CProfiler::Clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/**
+**  Find the section with the given name inside parent, create it if missing.
+*/
+int CProfiler::FindSection(const char *name, int parent)
+{
+	for (size_t i = 0; i != Sections.size(); ++i) {
+		if (Sections[i].Parent == parent && std::string_view(Sections[i].Name) == name) {
+			return i;
+		}
+	}
+	ProfileSection section;
+	section.Name = name;
+	section.Parent = parent;
+	section.Depth = parent == -1 ? 0 : Sections[parent].Depth + 1;
+
+	// Keep children right after their parent (and its older children) for the overlay
+	size_t pos = Sections.size();
+	if (parent != -1) {
+		pos = parent + 1;
+		while (pos < Sections.size() && Sections[pos].Depth > Sections[parent].Depth) {
+			++pos;
+		}
+	}
+	Sections.insert(Sections.begin() + pos, section);
+	for (auto &s : Sections) {
+		if (s.Parent >= int(pos)) {
+			++s.Parent;
+		}
+	}
+	for (auto &scope : Stack) {
+		if (scope.Section >= int(pos)) {
+			++scope.Section;
+		}
+	}
+	return pos;
+}
+
+void CProfiler::AddTraceEvent(const char *name, Clock::time_point start, Clock::time_point end)
+{
+	using std::chrono::microseconds;
+	using std::chrono::duration_cast;
+
+	TraceEvents.push_back({name,
+	                       duration_cast<microseconds>(start - TraceStart).count(),
+	                       duration_cast<microseconds>(end - start).count()});
+}
+
+/**
+**  Start timing a section, nested in the currently open one.
+*/
+void CProfiler::Begin(const char *name)
+{
+	const int parent = Stack.empty() ? -1 : Stack.back().Section;
+	const int section = FindSection(name, parent);
+	Stack.push_back({section, Clock::now()});
+}
+
+/**
+**  Stop timing the innermost open section.
+*/
+void CProfiler::End()
+{
+	if (Stack.empty()) {
+		return;
+	}
+	const auto now = Clock::now();
+	const OpenScope scope = Stack.back();
+	Stack.pop_back();
+
+	ProfileSection &section = Sections[scope.Section];
+	section.Current += ToMilliseconds(now - scope.Start);
+	++section.CurrentCalls;
+	if (Tracing) {
+		AddTraceEvent(section.Name, scope.Start, now);
+	}
+}
+
+/**
+**  Start a new frame of the main loop.
+*/
+void CProfiler::BeginFrame()
+{
+	InFrame = Enabled;
+	if (InFrame) {
+		FrameStart = Clock::now();
+	}
+}
+
+/**
+**  Finish the frame of the main loop and update the statistics.
+*/
+void CProfiler::EndFrame()
+{
+	if (!InFrame) {
+		return;
+	}
+	InFrame = false;
+	const auto now = Clock::now();
+	const double frameTime = ToMilliseconds(now - FrameStart);
+
+	FrameWindowSum += frameTime;
+	++Frames;
+	const bool windowDone = ++FramesInWindow >= CYCLES_PER_SECOND;
+	for (auto &section : Sections) {
+		section.Last = section.Current;
+		section.Calls = section.CurrentCalls;
+		section.Total += section.Current;
+		section.WindowSum += section.Current;
+		section.WindowMax = std::max(section.WindowMax, section.Current);
+		section.Current = 0;
+		section.CurrentCalls = 0;
+		if (windowDone) {
+			section.Average = section.WindowSum / FramesInWindow;
+			section.Max = section.WindowMax;
+			section.WindowSum = 0;
+			section.WindowMax = 0;
+		}
+	}
+	if (windowDone) {
+		FrameTime = FrameWindowSum / FramesInWindow;
+		FrameWindowSum = 0;
+		FramesInWindow = 0;
+	}
+	if (Tracing) {
+		AddTraceEvent("Frame", FrameStart, now);
+		if (TraceEvents.size() >= MAX_TRACE_EVENTS) {
+			ErrorPrint("Profiler trace is full, writing it to '%s'\n", TraceFile.u8string().c_str());
+			StopTrace();
+		}
+	}
+}
+
+/**
+**  Forget all collected statistics.
+*/
+void CProfiler::Clear()
+{
+	Sections.clear();
+	Stack.clear();
+	InFrame = false;
+	FrameTime = 0;
+	FrameWindowSum = 0;
+	FramesInWindow = 0;
+	Frames = 0;
+}
+
+/**
+**  Start recording every timed section into a Chrome trace file.
+**
+**  @param filename  File the trace is written to when it is stopped.
+*/
+void CProfiler::StartTrace(const fs::path &filename)
+{
+	if (Tracing) {
+		StopTrace();
+	}
+	TraceFile = filename;
+	TraceStart = Clock::now();
+	TraceEvents.clear();
+	Tracing = true;
+	UpdateEnabled();
+}
+
+/**
+**  Convert the recorded events to the Chrome trace event format.
+**
+**  The result can be loaded in chrome://tracing or Perfetto.
+*/
+std::string CProfiler::TraceToJson() const
+{
+	std::string json = "{\"traceEvents\":[\n";
+	for (size_t i = 0; i != TraceEvents.size(); ++i) {
+		const TraceEvent &event = TraceEvents[i];
+		json += Format("{\"name\":\"%s\",\"cat\":\"stratagus\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":1}%s\n",
+		               event.Name,
+		               static_cast<long long>(event.Start),
+		               static_cast<long long>(event.Duration),
+		               i + 1 != TraceEvents.size() ? "," : "");
+	}
+	json += "],\"displayTimeUnit\":\"ms\"}\n";
+	return json;
+}
+
+/**
+**  Stop recording and write the trace file.
+*/
+void CProfiler::StopTrace()
+{
+	if (!Tracing) {
+		return;
+	}
+	Tracing = false;
+	UpdateEnabled();
+
+	try {
+		auto file = CreateFileWriter(TraceFile);
+		file->write(TraceToJson());
+	} catch (const FileException &) {
+		ErrorPrint("Can't write profiler trace '%s'\n", TraceFile.u8string().c_str());
+	}
+	TraceEvents.clear();
+	TraceEvents.shrink_to_fit();
+}
+
+/**
+**  Print the time spent in each section since the statistics were cleared.
+*/
+void CProfiler::Print() const
+{
+	if (Frames == 0) {
+		return;
+	}
+	ErrorPrint("PROFILE: %-28s %12s %12s\n", "section", "total ms", "ms/frame");
+	for (const auto &section : Sections) {
+		const std::string name = std::string(2 * section.Depth, ' ') + section.Name;
+		ErrorPrint("PROFILE: %-28s %12.1f %12.3f\n", name.c_str(), section.Total, section.Total / Frames);
+	}
+}
+
+/**
+**  Draw the profiler overlay on top of the map area.
+**
+**  Sections taking more than the time of a game cycle are highlighted.
+*/
+void CProfiler::Draw() const
+{
+	if (!ShowOverlay) {
+		return;
+	}
+	const CFont &font = GetSmallFont();
+	const CLabel label(font, "white", "red");
+	const double budget = 1000.0 / std::max(CyclesPerSecond, 1);
+	const int lineHeight = font.Height() + 1;
+	const int x = UI.MapArea.X + 4;
+	int y = UI.MapArea.Y + 4;
+	const int width = 220;
+	const int height = (Sections.size() + 2) * lineHeight + 4;
+
+	Video.FillTransRectangleClip(ColorBlack, x - 2, y - 2, width, height, 160);
+	label.DrawClip(x, y, Format("frame %.2f ms (budget %.2f ms)", FrameTime, budget));
+	for (const auto &section : Sections) {
+		y += lineHeight;
+		const int indent = x + 8 * section.Depth;
+		const std::string_view highlight = section.Max > budget ? "~<" : "";
+		label.DrawClip(indent, y, Format("%s%s", highlight.data(), section.Name));
+		label.DrawClip(x + 120, y, Format("%s%6.2f %6.2f", highlight.data(), section.Average, section.Max));
+	}
+	const LuaGCStatistics &luaGC = GetLuaGCStatistics();
+	y += lineHeight;
+	label.DrawClip(x, y, Format("lua heap %d KB, idle gc %.2f ms", luaGC.HeapKB, luaGC.LastTime));
+}
+
+/**
+**  Show or hide the profiler overlay.
+**
+**  @param l  Lua state.
+*/
+static int CclSetProfilerOverlay(lua_State *l)
+{
+	LuaCheckArgs(l, 1);
+	Profiler.SetOverlay(LuaToBoolean(l, 1));
+	return 0;
+}
+
+/**
+**  Start recording a Chrome trace of the main loop.
+**
+**  @param l  Lua state.
+*/
+static int CclStartProfilerTrace(lua_State *l)
+{
+	LuaCheckArgs(l, 1);
+	const fs::path filename = Parameters::Instance.GetUserDirectory() / LuaToString(l, 1);
+	Profiler.StartTrace(filename);
+	return 0;
+}
+
+/**
+**  Stop recording the trace and write it.
+**
+**  @param l  Lua state.
+*/
+static int CclStopProfilerTrace(lua_State *l)
+{
+	LuaCheckArgs(l, 0);
+	Profiler.StopTrace();
+	return 0;
+}
+
+/**
+**  Register CCL features for the profiler.
+*/
+void ProfilerCclRegister()
+{
+	lua_register(Lua, "SetProfilerOverlay", CclSetProfilerOverlay);
+	lua_register(Lua, "StartProfilerTrace", CclStartProfilerTrace);
+	lua_register(Lua, "StopProfilerTrace", CclStopProfilerTrace);
+}
+
+//@}
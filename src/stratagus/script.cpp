@@ -42,12 +42,14 @@
 #include "iolib.h"
 #include "map.h"
 #include "parameters.h"
+#include "profiler.h"
 #include "stratagus.h"
 #include "translate.h"
 #include "trigger.h"
 #include "ui.h"
 #include "unit.h"
 
+#include <chrono>
 #include <optional>
 #include <signal.h>
 #include <variant>
@@ -69,6 +71,14 @@ std::unique_ptr<INumberDesc> Damage; /// Damage calculation for missile.
 static int NumberCounter = 0; /// Counter for lua function.
 static int StringCounter = 0; /// Counter for lua function.
 
+static bool LuaGCFrameMode = false;  /// Collect in the idle time of the frames during the game
+static bool LuaGCStopped = false;    /// Automatic steps of the collector are stopped
+static bool LuaGCInCycle = false;    /// A collection cycle is running
+static int LuaGCCycleEndKB = 0;      /// Heap size at the end of the last cycle
+static int LuaGCLastKB = 0;          /// Heap size after the last step
+static int LuaGCStepKB = 16;         /// Size of the steps done in the idle time
+static LuaGCStatistics LuaGCStats;
+
 /// Useful for getComponent.
 using UStrInt = std::variant<int, const char *>;
 
@@ -205,6 +215,9 @@ int LuaCall(lua_State *L, int narg, int nresults, int base, bool exitOnError)
 
 /**
 **  Get the (uncompressed) content of the file into a string
+**
+**  Plain files are read with a single allocation of their size,
+**  compressed ones grow the buffer until their end.
 */
 static std::optional<std::string> GetFileContent(const fs::path& file)
 {
@@ -216,21 +229,272 @@ static std::optional<std::string> GetFileContent(const fs::path& file)
 		return std::nullopt;
 	}
 
-	const int size = 10000;
-	std::vector<char> buf;
-	buf.resize(size);
-	int location = 0;
+	std::error_code ec;
+	const auto fileSize = fs::is_regular_file(file, ec) ? fs::file_size(file, ec) : 0;
+	std::string content(ec ? 0 : fileSize, '\0');
+	size_t location = 0;
 	for (;;) {
-		int read = fp.read(&buf[location], size);
-		if (read != size) {
+		if (location == content.size()) {
+			// A plain file ends at its size, only a compressed one has more
+			char more[4096];
+			const int read = fp.read(more, sizeof(more));
+			if (read <= 0) {
+				break;
+			}
+			content.resize(std::max<size_t>(content.size() * 2, location + read + 10000));
+			std::copy_n(more, read, &content[location]);
 			location += read;
+			continue;
+		}
+		const int read = fp.read(&content[location], content.size() - location);
+		if (read <= 0) {
 			break;
 		}
 		location += read;
-		buf.resize(buf.size() + size);
 	}
 	fp.close();
-	return std::string(&buf[0], location);
+	content.resize(location);
+	return content;
+}
+
+/**
+**  Compiled chunks of LuaLoadFile, kept on disk between launches.
+**
+**  A cache file starts with a CLuaChunkCacheHeader, followed by the
+**  path of the script and the bytecode given by lua_dump.
+**  It is used only if the path, size, modification time and content
+**  hash of the script are still the same, else the script is compiled
+**  again from its source and the cache file rewritten.
+**  Save games are never cached, and the oldest cache files are removed
+**  when the cache grows over LuaChunkCacheMaxSize: the cache directory is
+**  scanned at the first save of a run, then the size written is counted
+**  until it goes over the limit again.
+*/
+namespace
+{
+
+struct CLuaChunkCacheHeader
+{
+	char Magic[8] = {'S', 'T', 'G', 'L', 'U', 'A', 'C', '1'};
+	uint32_t LuaVersion = LUA_VERSION_NUM;
+	uint32_t PathSize = 0;
+	uint64_t Size = 0;
+	int64_t ModificationTime = 0;
+	uint64_t Hash = 0;
+};
+
+} // namespace
+
+static bool LuaChunkCacheEnabled = true;
+static constexpr uintmax_t LuaChunkCacheMaxSize = 32 * 1024 * 1024; /// Size of all the cache files
+static std::optional<uintmax_t> LuaChunkCacheSize; /// Size of the cache files, unknown until the first save
+
+/**
+**  64 bits FNV-1a hash of the whole content.
+*/
+static uint64_t LuaChunkHash(std::string_view content)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (const unsigned char c : content) {
+		hash = (hash ^ c) * 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+/**
+**  Name of the cache file of a script, empty when not cacheable.
+*/
+static fs::path LuaChunkCacheFile(const std::string &path)
+{
+	const fs::path &userDirectory = Parameters::Instance.GetUserDirectory();
+	if (userDirectory.empty()) {
+		return {};
+	}
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.luac", static_cast<unsigned long long>(LuaChunkHash(path)));
+	return userDirectory / "cache" / "lua" / name;
+}
+
+/**
+**  Fill the header describing the current state of a script.
+**
+**  @return  false if the script is not a plain file and can't be cached.
+*/
+static bool LuaChunkCacheMakeHeader(const fs::path &file, const std::string &path,
+                                    std::string_view content, CLuaChunkCacheHeader &header)
+{
+	std::error_code ec;
+	if (!fs::is_regular_file(file, ec)) {
+		return false;
+	}
+	const auto modificationTime = fs::last_write_time(file, ec);
+	if (ec) {
+		return false;
+	}
+	header.PathSize = path.size();
+	header.Size = content.size();
+	header.ModificationTime = modificationTime.time_since_epoch().count();
+	header.Hash = LuaChunkHash(content);
+	return true;
+}
+
+/**
+**  Load the cached chunk of a script on the stack.
+**
+**  @return  true if the cache was valid and the chunk loaded.
+*/
+static bool LuaChunkCacheLoad(const fs::path &cacheFile, const std::string &path,
+                              const CLuaChunkCacheHeader &expected, const std::string &chunkName)
+{
+	FILE *fd = fopen(cacheFile.string().c_str(), "rb");
+	if (fd == nullptr) {
+		return false;
+	}
+	std::error_code ec;
+	const auto cacheSize = fs::file_size(cacheFile, ec);
+	CLuaChunkCacheHeader header;
+	std::string data;
+	bool valid = !ec && cacheSize > sizeof(header) + path.size()
+	             && fread(&header, sizeof(header), 1, fd) == 1
+	             && memcmp(&header, &expected, sizeof(header)) == 0;
+	if (valid) {
+		data.resize(cacheSize - sizeof(header));
+		valid = fread(data.data(), data.size(), 1, fd) == 1
+		        && data.compare(0, path.size(), path) == 0;
+	}
+	fclose(fd);
+	if (!valid) {
+		return false;
+	}
+	const std::string_view bytecode = std::string_view(data).substr(path.size());
+	if (luaL_loadbuffer(Lua, bytecode.data(), bytecode.size(), chunkName.c_str())) {
+		DebugPrint("Invalid cached chunk '%s': %s\n", cacheFile.u8string().c_str(), lua_tostring(Lua, -1));
+		lua_pop(Lua, 1);
+		return false;
+	}
+	return true;
+}
+
+/**
+**  Remove the least recently written cache files while the cache is
+**  larger than LuaChunkCacheMaxSize.
+**
+**  @return  the size of the cache files left.
+*/
+static uintmax_t LuaChunkCacheTrim(const fs::path &cacheDirectory)
+{
+	std::vector<std::pair<fs::file_time_type, fs::path>> files;
+	uintmax_t totalSize = 0;
+	std::error_code ec;
+
+	for (fs::directory_iterator it(cacheDirectory, ec), end; !ec && it != end; it.increment(ec)) {
+		const uintmax_t size = it->file_size(ec);
+		if (ec) {
+			continue;
+		}
+		totalSize += size;
+		files.emplace_back(it->last_write_time(ec), it->path());
+	}
+	if (totalSize <= LuaChunkCacheMaxSize) {
+		return totalSize;
+	}
+	ranges::sort(files);
+	for (const auto &[time, file] : files) {
+		const uintmax_t size = fs::file_size(file, ec);
+		if (!ec && fs::remove(file, ec)) {
+			totalSize -= size;
+		}
+		if (totalSize <= LuaChunkCacheMaxSize) {
+			break;
+		}
+	}
+	return totalSize;
+}
+
+static int LuaChunkCacheWriter(lua_State *, const void *p, size_t size, void *userData)
+{
+	static_cast<std::string *>(userData)->append(static_cast<const char *>(p), size);
+	return 0;
+}
+
+/**
+**  Save the chunk on the top of the stack in the cache.
+*/
+static void LuaChunkCacheSave(const fs::path &cacheFile, const std::string &path,
+                              const CLuaChunkCacheHeader &header)
+{
+	std::string bytecode;
+#if LUA_VERSION_NUM >= 503
+	const int status = lua_dump(Lua, LuaChunkCacheWriter, &bytecode, 0);
+#else
+	const int status = lua_dump(Lua, LuaChunkCacheWriter, &bytecode);
+#endif
+	if (status != 0 || bytecode.empty()) {
+		return;
+	}
+	std::error_code ec;
+	fs::create_directories(cacheFile.parent_path(), ec);
+	if (!LuaChunkCacheSize) {
+		LuaChunkCacheSize = LuaChunkCacheTrim(cacheFile.parent_path());
+	}
+	// Write another file and rename it, so a cache file is never seen half written
+	fs::path tmpFile = cacheFile;
+	tmpFile += ".tmp";
+	FILE *fd = fopen(tmpFile.string().c_str(), "wb");
+	if (fd == nullptr) {
+		DebugPrint("Can't write Lua chunk cache '%s', disabling it\n", tmpFile.u8string().c_str());
+		LuaChunkCacheEnabled = false;
+		return;
+	}
+	const bool written = fwrite(&header, sizeof(header), 1, fd) == 1
+	                     && fwrite(path.data(), path.size(), 1, fd) == 1
+	                     && fwrite(bytecode.data(), bytecode.size(), 1, fd) == 1;
+	if (fclose(fd) == 0 && written) {
+		const uintmax_t fileSize = fs::file_size(cacheFile, ec);
+		const uintmax_t replacedSize = ec ? 0 : fileSize;
+		fs::rename(tmpFile, cacheFile, ec);
+		if (!ec) {
+			*LuaChunkCacheSize += sizeof(header) + path.size() + bytecode.size();
+			*LuaChunkCacheSize -= std::min(*LuaChunkCacheSize, replacedSize);
+		}
+	}
+	if (ec || !written) {
+		fs::remove(tmpFile, ec);
+	}
+	if (*LuaChunkCacheSize > LuaChunkCacheMaxSize) {
+		LuaChunkCacheSize = LuaChunkCacheTrim(cacheFile.parent_path());
+	}
+}
+
+/**
+**  Compile a script, from its cached chunk when still up to date.
+**
+**  @return  status of luaL_loadbuffer, the chunk or the error is on the stack.
+*/
+static int LuaLoadChunk(const fs::path &file, const std::string &content)
+{
+	const std::string chunkName = file.string();
+	CLuaChunkCacheHeader header;
+	std::string path;
+	fs::path cacheFile;
+
+	// a save game is only loaded once
+	if (LuaChunkCacheEnabled && !SaveGameLoading) {
+		path = fs::absolute(file).generic_u8string();
+		cacheFile = LuaChunkCacheFile(path);
+		if (!cacheFile.empty() && LuaChunkCacheMakeHeader(file, path, content, header)) {
+			if (LuaChunkCacheLoad(cacheFile, path, header, chunkName)) {
+				return 0;
+			}
+		} else {
+			cacheFile.clear();
+		}
+	}
+	const int status = luaL_loadbuffer(Lua, content.c_str(), content.size(), chunkName.c_str());
+	if (status == 0 && !cacheFile.empty()) {
+		LuaChunkCacheSave(cacheFile, path, header);
+	}
+	return status;
 }
 
 /**
@@ -256,7 +520,7 @@ int LuaLoadFile(const fs::path &file, const std::string &strArg, bool exitOnErro
 	// save the current __file__
 	lua_getglobal(Lua, "__file__");
 
-	const int status = luaL_loadbuffer(Lua, content->c_str(), content->size(), file.string().c_str());
+	const int status = LuaLoadChunk(file, *content);
 
 	if (!status) {
 		lua_pushstring(Lua, fs::absolute(fs::path(file)).generic_u8string().c_str());
@@ -451,6 +715,12 @@ void LuaGarbageCollect()
 	DebugPrint("Garbage collect (before): %d\n", lua_gc(Lua, LUA_GCCOUNT, 0));
 	lua_gc(Lua, LUA_GCCOLLECT, 0);
 	DebugPrint("Garbage collect (after): %d\n", lua_gc(Lua, LUA_GCCOUNT, 0));
+	if (LuaGCStopped) {
+		// a full collection restarts the automatic steps of lua 5.1
+		lua_gc(Lua, LUA_GCSTOP, 0);
+		LuaGCCycleEndKB = lua_gc(Lua, LUA_GCCOUNT, 0);
+		LuaGCInCycle = false;
+	}
 #else
 	DebugPrint("Garbage collect (before): %d/%d\n", lua_getgccount(Lua), lua_getgcthreshold(Lua));
 	lua_setgcthreshold(Lua, 0);
@@ -458,6 +728,168 @@ void LuaGarbageCollect()
 #endif
 }
 
+/**
+**  Stop the automatic steps of the lua collector for the game,
+**  when the frame mode is selected.
+**
+**  The collector then only works in LuaGarbageCollectStep.
+*/
+void LuaGarbageCollectBeginGame()
+{
+#if LUA_VERSION_NUM >= 501
+	if (LuaGCFrameMode && !LuaGCStopped) {
+		lua_gc(Lua, LUA_GCSTOP, 0);
+		LuaGCStopped = true;
+		LuaGCInCycle = true;
+		LuaGCCycleEndKB = lua_gc(Lua, LUA_GCCOUNT, 0);
+		LuaGCLastKB = LuaGCCycleEndKB;
+	}
+#endif
+}
+
+/**
+**  Give back the collection to the automatic steps of lua.
+*/
+void LuaGarbageCollectEndGame()
+{
+#if LUA_VERSION_NUM >= 501
+	if (LuaGCStopped) {
+		lua_gc(Lua, LUA_GCRESTART, 0);
+		LuaGCStopped = false;
+	}
+#endif
+}
+
+/**
+**  Do some work of the lua collector in the idle time of a frame.
+**
+**  Work proportional to the memory allocated since the last call is
+**  always done, so the heap can't grow without bound when there is no
+**  idle time. Then steps go on while the idle time lasts, until the
+**  current cycle ends. A new cycle starts when the heap has doubled
+**  since the end of the last one.
+**
+**  @param idleMs  Time left before the next frame (ms).
+*/
+void LuaGarbageCollectStep(unsigned int idleMs)
+{
+#if LUA_VERSION_NUM >= 501
+	if (!LuaGCStopped) {
+		return;
+	}
+	const CProfileScope profile("LuaGC");
+	const auto start = std::chrono::steady_clock::now();
+	const auto deadline = start + std::chrono::milliseconds(idleMs > 1 ? idleMs - 1 : 0);
+	const int heapKB = lua_gc(Lua, LUA_GCCOUNT, 0);
+
+	if (!LuaGCInCycle && heapKB >= 2 * std::max(LuaGCCycleEndKB, 256)) {
+		LuaGCInCycle = true;
+	}
+	if (LuaGCInCycle) {
+		// lua multiplies the step size by its step multiplier itself
+		const int owed = std::max(heapKB - LuaGCLastKB, 0);
+		bool finished = owed > 0 && lua_gc(Lua, LUA_GCSTEP, owed) == 1;
+
+		while (!finished && std::chrono::steady_clock::now() < deadline) {
+			finished = lua_gc(Lua, LUA_GCSTEP, LuaGCStepKB) == 1;
+		}
+		if (finished) {
+			LuaGCInCycle = false;
+			LuaGCCycleEndKB = lua_gc(Lua, LUA_GCCOUNT, 0);
+			++LuaGCStats.Cycles;
+		}
+		// a step restarts the automatic steps of lua 5.1
+		lua_gc(Lua, LUA_GCSTOP, 0);
+	}
+	LuaGCLastKB = lua_gc(Lua, LUA_GCCOUNT, 0);
+
+	const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	LuaGCStats.LastTime = elapsed;
+	LuaGCStats.TotalTime += elapsed;
+#endif
+}
+
+/**
+**  Get the size of the lua heap and the time spent by the frame mode.
+*/
+const LuaGCStatistics &GetLuaGCStatistics()
+{
+#if LUA_VERSION_NUM >= 501
+	LuaGCStats.HeapKB = lua_gc(Lua, LUA_GCCOUNT, 0);
+#endif
+	return LuaGCStats;
+}
+
+/**
+**  Select how the lua collector works during the game.
+**
+**  "automatic" lets lua collect when scripts allocate, "frame" only
+**  collects in the idle time of the frames.
+**
+**  @param l  Lua state.
+*/
+static int CclSetLuaGCMode(lua_State *l)
+{
+	const int args = lua_gettop(l);
+	if (args < 1 || args > 2) {
+		LuaError(l, "incorrect argument");
+	}
+	const std::string_view mode = LuaToString(l, 1);
+	if (mode == "automatic") {
+		LuaGCFrameMode = false;
+	} else if (mode == "frame") {
+		LuaGCFrameMode = true;
+	} else {
+		LuaError(l, "Unsupported lua gc mode: %s", mode.data());
+	}
+	if (args == 2) {
+		LuaGCStepKB = std::max(LuaToNumber(l, 2), 1);
+	}
+	if (GameRunning) {
+		if (LuaGCFrameMode) {
+			LuaGarbageCollectBeginGame();
+		} else {
+			LuaGarbageCollectEndGame();
+		}
+	}
+	return 0;
+}
+
+/**
+**  Enable or disable the cache of the compiled scripts.
+**
+**  @param l  Lua state.
+*/
+static int CclSetLuaChunkCache(lua_State *l)
+{
+	LuaCheckArgs(l, 1);
+	LuaChunkCacheEnabled = LuaToBoolean(l, 1);
+	return 0;
+}
+
+/**
+**  Get the size of the lua heap and the time spent collecting it.
+**
+**  @param l  Lua state.
+**
+**  @return   Table with HeapKB, LastTime, TotalTime and Cycles.
+*/
+static int CclGetLuaGCStats(lua_State *l)
+{
+	LuaCheckArgs(l, 0);
+	const LuaGCStatistics &stats = GetLuaGCStatistics();
+	lua_newtable(l);
+	lua_pushnumber(l, stats.HeapKB);
+	lua_setfield(l, -2, "HeapKB");
+	lua_pushnumber(l, stats.LastTime);
+	lua_setfield(l, -2, "LastTime");
+	lua_pushnumber(l, stats.TotalTime);
+	lua_setfield(l, -2, "TotalTime");
+	lua_pushnumber(l, stats.Cycles);
+	lua_setfield(l, -2, "Cycles");
+	return 1;
+}
+
 // ////////////////////
 
 /**
@@ -2471,6 +2903,9 @@ void ScriptRegister()
 	lua_register(Lua, "SetDamageFormula", CclSetDamageFormula);
 
 	lua_register(Lua, "SavePreferences", CclSavePreferences);
+	lua_register(Lua, "SetLuaGCMode", CclSetLuaGCMode);
+	lua_register(Lua, "SetLuaChunkCache", CclSetLuaChunkCache);
+	lua_register(Lua, "GetLuaGCStats", CclGetLuaGCStats);
 	lua_register(Lua, "Load", CclLoad);
 	lua_register(Lua, "LoadBuffer", CclLoadBuffer);
 
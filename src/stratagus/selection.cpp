@@ -232,6 +232,7 @@ bool SelectUnit(CUnit &unit)
 
 	Selected.push_back(&unit);
 	unit.Selected = 1;
+	UI.Minimap.UpdateUnit(unit);
 	if (Selected.size() > 1) {
 		Selected[0]->LastGroup = unit.LastGroup = GroupId;
 	}
@@ -289,6 +290,7 @@ void UnSelectUnit(CUnit &unit)
 		}
 	}
 	unit.Selected = 0;
+	UI.Minimap.UpdateUnit(unit);
 
 	//Turn track unit mode off
 	UI.SelectedViewport->Unit = nullptr;
@@ -45,6 +45,7 @@
 #include "interface.h"
 #include "map.h"
 #include "player.h"
+#include "retained_ui.h"
 #include "settings.h"
 #include "sound.h"
 #include "spells.h"
@@ -79,6 +80,36 @@ std::vector<std::unique_ptr<ButtonAction>> UnitButtonTable;
 /// Pointer to current buttons
 std::vector<ButtonAction> CurrentButtons;
 
+/// What the checks of the buttons read of a selected unit
+struct ButtonCheckInput
+{
+	const CUnit *Unit = nullptr;
+	const CUnitType *Type = nullptr;
+	const CPlayer *Player = nullptr;
+	unsigned int AvailabilityEpoch = 0; /// Counts, allows and upgrade timers of the player
+	UnitAction Action = UnitAction::NoAction;
+	int CurrentResource = 0;
+	int ResourcesHeld = 0;
+	int BoardCount = 0;
+
+	bool operator==(const ButtonCheckInput &rhs) const
+	{
+		return Unit == rhs.Unit && Type == rhs.Type && Player == rhs.Player
+			   && AvailabilityEpoch == rhs.AvailabilityEpoch && Action == rhs.Action
+			   && CurrentResource == rhs.CurrentResource && ResourcesHeld == rhs.ResourcesHeld
+			   && BoardCount == rhs.BoardCount;
+	}
+	bool operator!=(const ButtonCheckInput &rhs) const { return !(*this == rhs); }
+};
+/// Inputs of the selected units the gray buttons were computed with
+static std::vector<ButtonCheckInput> GrayButtonsInputs;
+/// Buttons of CurrentButtons which a selected unit can't use
+static std::vector<bool> GrayButtons;
+/// Incremented each time CurrentButtons is computed again
+static unsigned int CurrentButtonsVersion;
+/// CurrentButtonsVersion the gray buttons were computed for
+static unsigned int GrayButtonsVersion = -1;
+
 /*----------------------------------------------------------------------------
 --  Functions
 ----------------------------------------------------------------------------*/
@@ -695,12 +726,43 @@ void DrawPopup(const ButtonAction &button, const CUIButton &uibutton, int x, int
 #endif
 }
 
+/**
+**  Get the highest cooldown of the spell of a button in the selection.
+**
+**  @param button  Button to check.
+**
+**  @return        Highest cooldown of the spell of the button, 0 if none.
+*/
+static int GetButtonCooldown(const ButtonAction &button)
+{
+	int cooldown = 0;
+	if (button.Action != ButtonCmd::SpellCast) {
+		return 0;
+	}
+	for (const CUnit *unit : Selected) {
+		if (unit->SpellCoolDownTimers[SpellTypeTable[button.Value]->Slot]) {
+			Assert(SpellTypeTable[button.Value]->CoolDown > 0);
+			cooldown = std::max(cooldown, unit->SpellCoolDownTimers[SpellTypeTable[button.Value]->Slot]);
+		}
+	}
+	return cooldown;
+}
+
 /**
 **  Draw button panel.
 **
 **  Draw all action buttons.
 */
 void CButtonPanel::Draw()
+{
+	DrawButtons();
+	DrawHoveredButton();
+}
+
+/**
+**  Draw the background and the icons of the action buttons.
+*/
+void CButtonPanel::DrawButtons()
 {
 	//  Draw background
 	if (UI.ButtonPanel.G) {
@@ -714,6 +776,7 @@ void CButtonPanel::Draw()
 		return;
 	}
 	std::vector<ButtonAction> &buttons(CurrentButtons);
+	const std::vector<bool> &grayButtons = GetGrayButtons();
 
 	Assert(!Selected.empty());
 
@@ -723,20 +786,9 @@ void CButtonPanel::Draw()
 			continue;
 		}
 		Assert(buttons[i].Pos == i + 1);
-		bool gray = false;
-		bool cooldownSpell = false;
-		int maxCooldown = 0;
-		for (CUnit *unit : Selected) {
-			if (!IsButtonAllowed(*unit, buttons[i])) {
-				gray = true;
-				break;
-			} else if (buttons[i].Action == ButtonCmd::SpellCast
-					   && unit->SpellCoolDownTimers[SpellTypeTable[buttons[i].Value]->Slot]) {
-				Assert(SpellTypeTable[buttons[i].Value]->CoolDown > 0);
-				cooldownSpell = true;
-				maxCooldown = std::max(maxCooldown, unit->SpellCoolDownTimers[SpellTypeTable[buttons[i].Value]->Slot]);
-			}
-		}
+		const bool gray = grayButtons[i];
+		const int maxCooldown = gray ? 0 : GetButtonCooldown(buttons[i]);
+		const bool cooldownSpell = maxCooldown != 0;
 		//
 		//  Tutorial show command key in icons
 		//
@@ -769,9 +821,18 @@ void CButtonPanel::Draw()
 											   pos, text, GameSettings.Presets[player].PlayerColor);
 		}
 	}
-	//
-	//  Update status line for this button and draw popups
-	//
+}
+
+/**
+**  Update the status line for the button under the cursor and draw its popup.
+*/
+void CButtonPanel::DrawHoveredButton()
+{
+	if (CurrentButtons.empty()) {
+		return;
+	}
+	std::vector<ButtonAction> &buttons(CurrentButtons);
+
 	for (int i = 0; i < (int) UI.ButtonPanel.Buttons.size(); ++i) {
 		if (ButtonAreaUnderCursor == ButtonArea::Button &&
 			ButtonUnderCursor == i && KeyState != EKeyState::Input) {
@@ -784,6 +845,46 @@ void CButtonPanel::Draw()
 	}
 }
 
+/**
+**  Get the area and the key of the background and the icons of the
+**  action buttons.
+*/
+CPanelState CButtonPanel::GetState() const
+{
+	CPanelState state;
+
+	if (UI.ButtonPanel.G) {
+		state.AddArea(UI.ButtonPanel.X, UI.ButtonPanel.Y, UI.ButtonPanel.G->Width, UI.ButtonPanel.G->Height);
+	}
+	for (const CUIButton &button : UI.ButtonPanel.Buttons) {
+		state.AddArea(button);
+	}
+	state << ShowCommandKey << ButtonUnderCursor << CurrentButtons.size();
+	if (CurrentButtons.empty()) {
+		return state;
+	}
+	state << Selected[0]->IsAlive() << Selected[0]->Player << Selected[0]->RescuedFrom;
+	const std::vector<bool> &grayButtons = GetGrayButtons();
+	for (int i = 0; i < (int) UI.ButtonPanel.Buttons.size(); ++i) {
+		const ButtonAction &button = CurrentButtons[i];
+
+		state << button.Pos;
+		if (button.Pos == -1) {
+			continue;
+		}
+		const bool gray = grayButtons[i];
+		const int cooldown = gray ? 0 : GetButtonCooldown(button);
+		state << gray << button.Icon.Icon << button.Key;
+		if (!gray && cooldown != 0) {
+			// the cooldown is drawn in percent
+			state << cooldown * 100 / SpellTypeTable[button.Value]->CoolDown;
+		} else {
+			state << GetButtonStatus(button, ButtonUnderCursor);
+		}
+	}
+	return state;
+}
+
 /**
 **  Update the status line with hints from the button
 **
@@ -917,6 +1018,51 @@ bool IsButtonAllowed(const CUnit &unit, const ButtonAction &buttonaction)
 	return res;
 }
 
+/**
+**  Get the buttons of CurrentButtons which a selected unit can't use.
+**
+**  The checks are only done again when the buttons, the selection or
+**  what the checks read of the selected units and their players changed,
+**  except for the checks of unit variables which change too often.
+**
+**  @return  true for each button a selected unit can't use.
+*/
+const std::vector<bool> &GetGrayButtons()
+{
+	bool changed = GrayButtonsVersion != CurrentButtonsVersion || GrayButtonsInputs.size() != Selected.size();
+
+	GrayButtonsInputs.resize(Selected.size());
+	for (size_t i = 0; i != Selected.size(); ++i) {
+		const CUnit &unit = *Selected[i];
+		ButtonCheckInput input;
+
+		input.Unit = &unit;
+		input.Type = unit.Type;
+		input.Player = unit.Player;
+		input.AvailabilityEpoch = unit.Player->GetAvailabilityEpoch();
+		input.Action = unit.CurrentAction();
+		input.CurrentResource = unit.CurrentResource;
+		input.ResourcesHeld = unit.ResourcesHeld;
+		input.BoardCount = unit.BoardCount;
+		if (input != GrayButtonsInputs[i]) {
+			GrayButtonsInputs[i] = input;
+			changed = true;
+		}
+	}
+	GrayButtonsVersion = CurrentButtonsVersion;
+	GrayButtons.resize(CurrentButtons.size());
+	for (size_t i = 0; i != CurrentButtons.size(); ++i) {
+		const ButtonAction &button = CurrentButtons[i];
+
+		if (button.Pos == -1) {
+			GrayButtons[i] = false;
+		} else if (changed || button.Allowed == ButtonCheckUnitVariable) {
+			GrayButtons[i] = ranges::any_of(Selected, [&](const CUnit *unit) { return !IsButtonAllowed(*unit, button); });
+		}
+	}
+	return GrayButtons;
+}
+
 /**
 **  Update bottom panel for multiple units.
 **
@@ -1036,6 +1182,7 @@ static void UpdateButtonPanelSingleUnit(const CUnit &unit, std::vector<ButtonAct
 */
 void CButtonPanel::Update()
 {
+	++CurrentButtonsVersion;
 	if (Selected.empty()) {
 		CurrentButtons.clear();
 		return;
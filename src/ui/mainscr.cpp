@@ -47,6 +47,7 @@
 #include "menus.h"
 #include "network.h"
 #include "player.h"
+#include "retained_ui.h"
 #include "settings.h"
 #include "sound.h"
 #include "spells.h"
@@ -134,6 +135,43 @@ void DrawUserDefinedButtons()
 	}
 }
 
+/**
+**  Get the area and the key of the menu button area.
+*/
+CPanelState GetMenuButtonAreaState()
+{
+	CPanelState state;
+	const bool network = IsNetworkGame();
+
+	state << network << ButtonAreaUnderCursor.has_value() << ButtonAreaUnderCursor.value_or(ButtonArea::Menu)
+		  << ButtonUnderCursor << GameMenuButtonClicked << GameDiplomacyButtonClicked;
+	if (!network) {
+		state.AddArea(UI.MenuButton);
+		state << UI.MenuButton.Text;
+	} else {
+		state.AddArea(UI.NetworkMenuButton);
+		state.AddArea(UI.NetworkDiplomacyButton);
+		state << UI.NetworkMenuButton.Text << UI.NetworkDiplomacyButton.Text;
+	}
+	return state;
+}
+
+/**
+**  Get the area and the key of the user defined buttons.
+*/
+CPanelState GetUserDefinedButtonsState()
+{
+	CPanelState state;
+
+	state << ButtonAreaUnderCursor.has_value() << ButtonAreaUnderCursor.value_or(ButtonArea::Menu)
+		  << ButtonUnderCursor;
+	for (const CUIUserButton &button : UI.UserButtons) {
+		state.AddArea(button.Button);
+		state << button.Clicked << button.Button.Text;
+	}
+	return state;
+}
+
 /*----------------------------------------------------------------------------
 --  Icons
 ----------------------------------------------------------------------------*/
@@ -642,6 +680,62 @@ void DrawResources()
 	}
 }
 
+/**
+**  Get the area and the key of the resource line.
+*/
+CPanelState GetResourcesState()
+{
+	CPanelState state;
+	const auto addIcon = [&state](const CResourceInfo &info) {
+		if (info.G) {
+			state.AddArea(info.IconX, info.IconY, info.G->Width, info.G->Height);
+		}
+	};
+	const auto addText = [&state](int x, int y, const CFont &font, std::string_view text) {
+		state.AddArea(x, y, font.Width(text), font.Height() + 3);
+		state << text;
+	};
+
+	for (int i = 0; i < FreeWorkersCount; ++i) {
+		addIcon(UI.Resources[i]);
+	}
+	for (int i = 0; i < MaxCosts; ++i) {
+		if (UI.Resources[i].TextX != -1) {
+			const int resourceAmount = ThisPlayer->Resources[i];
+
+			if (ThisPlayer->MaxResources[i] != -1) {
+				const int resAmount = ThisPlayer->StoredResources[i] + ThisPlayer->Resources[i];
+				char tmp[256];
+				snprintf(tmp, sizeof(tmp), "%d (%d)", resAmount, ThisPlayer->MaxResources[i] - ThisPlayer->StoredResources[i]);
+				addText(UI.Resources[i].TextX, UI.Resources[i].TextY, GetSmallFont(), tmp);
+			} else {
+				addText(UI.Resources[i].TextX, UI.Resources[i].TextY,
+				        resourceAmount > 99999 ? GetSmallFont() : GetGameFont(), std::to_string(resourceAmount));
+			}
+		}
+	}
+	if (UI.Resources[FoodCost].TextX != -1) {
+		char tmp[256];
+		snprintf(tmp, sizeof(tmp), "%d/%d", ThisPlayer->Demand, ThisPlayer->Supply);
+		addText(UI.Resources[FoodCost].TextX, UI.Resources[FoodCost].TextY, GetGameFont(), tmp);
+	}
+	if (UI.Resources[ScoreCost].TextX != -1) {
+		const int score = ThisPlayer->Score;
+		addText(UI.Resources[ScoreCost].TextX, UI.Resources[ScoreCost].TextY,
+		        score > 99999 ? GetSmallFont() : GetGameFont(), std::to_string(score));
+	}
+	if (UI.Resources[FreeWorkersCount].TextX != -1) {
+		const size_t freeWorkers = ThisPlayer->GetFreeWorkers().size();
+		const int textX = std::abs(UI.Resources[FreeWorkersCount].TextX);
+
+		if (UI.Resources[FreeWorkersCount].TextX > 0 || freeWorkers != 0) {
+			addIcon(UI.Resources[FreeWorkersCount]);
+			addText(textX, UI.Resources[FreeWorkersCount].TextY, GetGameFont(), std::to_string(freeWorkers));
+		}
+	}
+	return state;
+}
+
 /*----------------------------------------------------------------------------
 --  MESSAGE
 ----------------------------------------------------------------------------*/
@@ -1224,6 +1318,79 @@ void CInfoPanel::Draw()
 	}
 }
 
+/**
+**  Add what the info panel shows of a unit to its key.
+*/
+static void AddUnitInfoState(CPanelState &state, CUnit &unit)
+{
+	UpdateUnitVariables(unit);
+	state << &unit << unit.Type << unit.Player << unit.RescuedFrom << unit.ResourcesHeld
+		  << unit.CurrentResource << unit.BoardCount << IsOnlySelected(unit);
+	for (const CVariable &variable : unit.Variable) {
+		state << variable.Value << variable.Max << variable.Increase << variable.Enable;
+	}
+	state << unit.Orders.size();
+	for (const auto &order : unit.Orders) {
+		state << order.get() << order->Action;
+	}
+	for (const CUnit *inside : unit.InsideUnits) {
+		state << inside << inside->Boarded << inside->Variable[HP_INDEX].Value << inside->Variable[MANA_INDEX].Value;
+	}
+#ifdef USE_MNG
+	if (!unit.Type->Portrait.Mngs.empty()) {
+		// animated portrait
+		state << FrameCounter;
+	}
+#endif
+}
+
+/**
+**  Get the area and the key of the info panel.
+*/
+CPanelState CInfoPanel::GetState() const
+{
+	CPanelState state;
+
+	if (this->G) {
+		state.AddArea(this->X, this->Y, this->G->Width, this->G->Height);
+	}
+	for (const CUIButton *button : {UI.SingleSelectedButton, UI.SingleTrainingButton,
+	                                UI.UpgradingButton, UI.ResearchingButton}) {
+		if (button) {
+			state.AddArea(*button);
+		}
+	}
+	for (const auto *buttons : {&UI.SelectedButtons, &UI.TrainingButtons, &UI.TransportingButtons}) {
+		for (const CUIButton &button : *buttons) {
+			state.AddArea(button);
+		}
+	}
+
+	state << ThisPlayer << ReplayRevealMap << CurrentButtonLevel << (MouseButtons & LeftButton)
+		  << ButtonAreaUnderCursor.has_value() << ButtonAreaUnderCursor.value_or(ButtonArea::Menu)
+		  << ButtonUnderCursor << Selected.size();
+	if (UnitUnderCursor && Selected.empty()) {
+		state << UnitUnderCursor->IsVisible(*ThisPlayer);
+		AddUnitInfoState(state, *UnitUnderCursor);
+	} else if (Selected.size() == 1) {
+		AddUnitInfoState(state, *Selected[0]);
+	} else if (Selected.empty()) {
+		if (Preference.ShowNoSelectionStats) {
+			// the cycle, the speed and the scores
+			state << GameCycle << CyclesPerSecond;
+			for (int i = 0; i < PlayerMax - 1; ++i) {
+				state << Players[i].Score;
+			}
+		}
+	} else {
+		for (size_t i = 0; i != std::min(Selected.size(), UI.SelectedButtons.size()); ++i) {
+			state << Selected[i] << Selected[i]->Type << Selected[i]->Variable[HP_INDEX].Value
+				  << Selected[i]->Variable[HP_INDEX].Max;
+		}
+	}
+	return state;
+}
+
 /*----------------------------------------------------------------------------
 --  TIMER
 ----------------------------------------------------------------------------*/
@@ -1245,10 +1412,14 @@ void DrawTimer()
 
 /**
 **  Update the timer
+**
+**  The triggers waiting for the timer are woken up each time its second
+**  changes and when it expires.
 */
 void UpdateTimer()
 {
 	if (GameTimer.Running) {
+		const long oldCycles = GameTimer.Cycles;
 		if (GameTimer.Increasing) {
 			GameTimer.Cycles += GameCycle - GameTimer.LastUpdate;
 		} else {
@@ -1256,6 +1427,10 @@ void UpdateTimer()
 			GameTimer.Cycles = std::max(GameTimer.Cycles, 0l);
 		}
 		GameTimer.LastUpdate = GameCycle;
+		if (GameTimer.Cycles / CYCLES_PER_SECOND != oldCycles / CYCLES_PER_SECOND
+			|| (GameTimer.Cycles == 0 && oldCycles != 0)) {
+			TriggerNotifyEvent(ETriggerEvent::Timer);
+		}
 	}
 }
 
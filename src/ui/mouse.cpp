@@ -2247,14 +2247,14 @@ void DrawPieMenu()
 									CursorStartScreenPos.x - UI.PieMenu.G->Width / 2,
 									CursorStartScreenPos.y - UI.PieMenu.G->Height / 2);
 	}
+	const std::vector<bool> &grayButtons = GetGrayButtons();
 	for (int i = 0; i < (int)UI.ButtonPanel.Buttons.size() && i < 9; ++i) {
 		if (buttons[i].Pos != -1) {
 			int x = CursorStartScreenPos.x - ICON_SIZE_X / 2 + UI.PieMenu.X[i];
 			int y = CursorStartScreenPos.y - ICON_SIZE_Y / 2 + UI.PieMenu.Y[i];
 			const PixelPos pos(x, y);
 
-			const bool gray = ranges::any_of(
-				Selected, [&](const CUnit *unit) { return !IsButtonAllowed(*unit, buttons[i]); });
+			const bool gray = grayButtons[i];
 			// Draw icon
 			if (gray) {
 				buttons[i].Icon.Icon->DrawGrayscaleIcon(pos);
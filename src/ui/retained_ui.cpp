@@ -0,0 +1,277 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name retained_ui.cpp - The retained mode of the user interface. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+/*
+**  UpdateDisplay still composes the whole screen each frame, but a panel
+**  whose state is unchanged is copied from its cache instead of being
+**  drawn again. Then only the damaged areas of the screen are uploaded
+**  to the renderer: the map area, the panels drawn again in this or the
+**  last frame and what is drawn over the panels (cursor, timer...).
+**
+**  A panel is drawn clipped to its area so its cache holds all it
+**  shows. A panel overlapping the map area is always drawn, as the map
+**  below it changes. What a panel shows but is not in its state is
+**  caught up by drawing every panel again at least once per second.
+*/
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "stratagus.h"
+
+#include "retained_ui.h"
+
+#include "ui.h"
+#include "video.h"
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+CRetainedUI RetainedUI;
+
+/// Display frames after which a panel is drawn again even if its state didn't change
+/// (about a second at 60 frames per second, FrameCounter doesn't count game cycles)
+static constexpr unsigned long PanelMaxAge = 60;
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+/**
+**  Add a rectangle of the screen to the area of the panel.
+*/
+void CPanelState::AddArea(int x, int y, int w, int h)
+{
+	const SDL_Rect rect{x, y, w, h};
+	if (w <= 0 || h <= 0) {
+		return;
+	}
+	if (SDL_RectEmpty(&Area)) {
+		Area = rect;
+	} else {
+		SDL_UnionRect(&Area, &rect, &Area);
+	}
+}
+
+/**
+**  Add a button to the area of the panel.
+*/
+void CPanelState::AddArea(const CUIButton &button)
+{
+	if (button.X != -1 && button.Style) {
+		AddArea(button.X, button.Y, button.Style->Width, button.Style->Height);
+	}
+}
+
+/**
+**  Mix bytes of the state into the key (FNV-1a).
+*/
+void CPanelState::Mix(const void *data, size_t size)
+{
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	for (size_t i = 0; i != size; ++i) {
+		Key = (Key ^ bytes[i]) * 0x100000001b3ULL;
+	}
+}
+
+/**
+**  Start a new frame.
+**
+**  @param active  Use the retained mode in this frame, else the whole
+**                 screen is drawn and presented.
+*/
+void CRetainedUI::BeginFrame(bool active)
+{
+	Active = active;
+	Damage.clear();
+	Painted.clear();
+	if (!Active) {
+		FullPresent = true;
+		return;
+	}
+	AddDamage(UI.MapArea.X, UI.MapArea.Y, UI.MapArea.EndX - UI.MapArea.X + 1, UI.MapArea.EndY - UI.MapArea.Y + 1);
+}
+
+/**
+**  Check if a rectangle overlaps the map area or a panel drawn again.
+*/
+bool CRetainedUI::Overlaps(const SDL_Rect &rect) const
+{
+	const SDL_Rect mapArea{UI.MapArea.X, UI.MapArea.Y, UI.MapArea.EndX - UI.MapArea.X + 1, UI.MapArea.EndY - UI.MapArea.Y + 1};
+	if (SDL_HasIntersection(&rect, &mapArea)) {
+		return true;
+	}
+	for (const SDL_Rect &painted : Painted) {
+		if (SDL_HasIntersection(&rect, &painted)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+**  Draw a panel, or copy it from its cache when its state didn't change.
+**
+**  @param panel     Cache of the panel.
+**  @param getState  Function getting the area and the key of what the
+**                   panel shows now, only called in the retained mode.
+**  @param draw      Function drawing the panel on the screen.
+*/
+void CRetainedUI::DrawPanel(CRetainedPanel &panel, const std::function<CPanelState()> &getState,
+                            const std::function<void()> &draw)
+{
+	if (!Active) {
+		draw();
+		panel.Invalidate();
+		return;
+	}
+	const CPanelState state = getState();
+	const SDL_Rect screen{0, 0, Video.Width, Video.Height};
+	SDL_Rect area{0, 0, 0, 0};
+	const bool visible = SDL_IntersectRect(&state.GetArea(), &screen, &area);
+
+	if (!visible || Overlaps(area)) {
+		// A panel without visible area draws nothing
+		draw();
+		if (visible) {
+			AddDamage(area);
+			Painted.push_back(area);
+		}
+		panel.Invalidate();
+		return;
+	}
+	if (panel.Valid && panel.Generation == Generation && panel.Key == state.GetKey()
+		&& SDL_RectEquals(&panel.Area, &area) && FrameCounter - panel.PaintFrame < PanelMaxAge) {
+		SDL_Rect drect = area;
+		SDL_BlitSurface(panel.Surface.get(), nullptr, TheScreen, &drect);
+		if (panel.SetsStatusLine) {
+			UI.StatusLine.Set(panel.StatusLine);
+		}
+		return;
+	}
+
+	// Draw it again, the old area must be presented too
+	if (panel.Valid) {
+		AddDamage(panel.Area);
+	}
+	AddDamage(area);
+	Painted.push_back(area);
+
+	const unsigned int statusLineSets = UI.StatusLine.GetSetCount();
+	SDL_Rect oldClipRect;
+	SDL_GetClipRect(TheScreen, &oldClipRect);
+	SDL_SetClipRect(TheScreen, &area);
+	PushClipping();
+	SetClipping(area.x, area.y, area.x + area.w - 1, area.y + area.h - 1);
+	draw();
+	PopClipping();
+	SDL_SetClipRect(TheScreen, &oldClipRect);
+
+	panel.SetsStatusLine = UI.StatusLine.GetSetCount() != statusLineSets;
+	panel.StatusLine = panel.SetsStatusLine ? UI.StatusLine.Get() : std::string();
+	if (!panel.Surface || panel.Surface->w != area.w || panel.Surface->h != area.h) {
+		panel.Surface.reset(SDL_CreateRGBSurface(SDL_SWSURFACE, area.w, area.h,
+		                                         TheScreen->format->BitsPerPixel,
+		                                         TheScreen->format->Rmask,
+		                                         TheScreen->format->Gmask,
+		                                         TheScreen->format->Bmask,
+		                                         TheScreen->format->Amask));
+	}
+	SDL_Rect srect = area;
+	SDL_BlitSurface(TheScreen, &srect, panel.Surface.get(), nullptr);
+	panel.Area = area;
+	panel.Key = state.GetKey();
+	panel.PaintFrame = FrameCounter;
+	panel.Generation = Generation;
+	panel.Valid = true;
+}
+
+/**
+**  Mark an area of the screen to be presented in this frame.
+*/
+void CRetainedUI::AddDamage(int x, int y, int w, int h)
+{
+	const SDL_Rect screen{0, 0, Video.Width, Video.Height};
+	const SDL_Rect rect{x, y, w, h};
+	SDL_Rect clipped;
+
+	if (SDL_IntersectRect(&rect, &screen, &clipped)) {
+		Damage.push_back(clipped);
+	}
+}
+
+/**
+**  Send the damaged areas of this and the last frame to the renderer.
+**
+**  The areas of the last frame are presented again, so what was drawn
+**  over the panels there is removed.
+*/
+void CRetainedUI::EndFrame()
+{
+	PartialPresent = Active && !FullPresent;
+	if (FullPresent || !Active) {
+		Invalidate();
+		FullPresent = !Active;
+	} else {
+		for (const SDL_Rect &rect : Damage) {
+			InvalidateArea(rect.x, rect.y, rect.w, rect.h);
+		}
+		for (const SDL_Rect &rect : LastDamage) {
+			InvalidateArea(rect.x, rect.y, rect.w, rect.h);
+		}
+	}
+	std::swap(Damage, LastDamage);
+}
+
+/**
+**  Check if only the damaged areas of the last frame were invalidated,
+**  so the screen texture must only be updated there. Only true once
+**  per frame.
+*/
+bool CRetainedUI::TakePartialPresent()
+{
+	const bool partial = PartialPresent;
+	PartialPresent = false;
+	return partial;
+}
+
+/**
+**  Forget the cached panels and present the whole screen next frame.
+*/
+void CRetainedUI::Reset()
+{
+	++Generation;
+	FullPresent = true;
+	Damage.clear();
+	LastDamage.clear();
+}
+
+//@}
@@ -39,6 +39,7 @@
 
 #include "font.h"
 #include "interface.h"
+#include "retained_ui.h"
 #include "ui.h"
 #include "video.h"
 
@@ -56,6 +57,30 @@ void CStatusLine::Draw()
 	}
 }
 
+/**
+**  Get the area and the key of the status line and its costs.
+*/
+CPanelState CStatusLine::GetState() const
+{
+	CPanelState state;
+	const int x = this->TextX + 268;
+	int height = GetGameFont().Height();
+
+	state.AddArea(this->TextX, this->TextY, this->Width, this->Font ? this->Font->Height() : 0);
+	state << this->StatusLine << this->Font;
+	for (int i = 0; i <= ManaResCost; ++i) {
+		state << this->Costs[i];
+		if (this->Costs[i] && UI.Resources[i].G) {
+			height = std::max(height, UI.Resources[i].G->Height);
+		}
+	}
+	if (ranges::any_of(this->Costs, [](int cost) { return cost != 0; })) {
+		// the costs are drawn until the end of the screen
+		state.AddArea(x, this->TextY, Video.Width - x, height);
+	}
+	return state;
+}
+
 /**
 **  Change status line to new text.
 **
@@ -65,6 +90,7 @@ void CStatusLine::Set(const std::string &status)
 {
 	if (KeyState != EKeyState::Input) {
 		this->StatusLine = status;
+		++this->SetCount;
 	}
 }
 
@@ -245,6 +245,31 @@ void DrawGuichanWidgets()
 	}
 }
 
+/**
+**  Check if a menu is shown over the game.
+*/
+bool IsMenuScreenShown()
+{
+	return Gui && dynamic_cast<MenuScreen *>(Gui->getTop()) != nullptr;
+}
+
+/**
+**  Get the area of the screen the guichan widgets are drawn in.
+**
+**  @return  true if the widgets are shown.
+*/
+bool GetGuichanWidgetsArea(int &x, int &y, int &w, int &h)
+{
+	gcn::Widget *top = Gui ? Gui->getTop() : nullptr;
+	if (top == nullptr || !top->isVisible()) {
+		return false;
+	}
+	top->getAbsolutePosition(x, y);
+	w = top->getWidth();
+	h = top->getHeight();
+	return true;
+}
+
 /*----------------------------------------------------------------------------
 --  LuaActionListener
 ----------------------------------------------------------------------------*/
@@ -46,6 +46,8 @@
 #include "unittype.h"
 #include "upgrade.h"
 
+#include <bitset>
+
 namespace
 {
 class DependRule
@@ -149,6 +151,28 @@ class DependOrRule
 public:
 	std::vector<DependAndRule> rules;
 };
+
+/// Number of nodes of the compiled graph: the unit types, then the upgrades
+constexpr int DependNodeMax = UnitTypeMax + UpgradeMax;
+
+/// Node of a unit type in the compiled graph
+int UnitTypeNode(int slot) { return slot; }
+/// Node of an upgrade in the compiled graph
+int UpgradeNode(int id) { return UnitTypeMax + id; }
+
+/// Requirement of a compiled rule
+struct CompiledRequirement
+{
+	int Node = 0;     /// Unit type counted or upgrade researched
+	int Expected = 0; /// Units needed (0 means at least one), or 0 if the upgrade must not be researched
+};
+
+/// Compiled rules of a unit type or an upgrade
+struct CompiledTarget
+{
+	/// Requirements of each or-rule, an or-rule is met when all of them are
+	std::vector<std::vector<CompiledRequirement>> Rules;
+};
 } // namespace
 /*----------------------------------------------------------------------------
 --  Variables
@@ -157,6 +181,17 @@ class DependOrRule
 /// All dependencies hash
 static std::map<std::string, DependOrRule, std::less<>> Depends;
 
+/// Rules of the dependencies by node, compiled from Depends
+static std::vector<CompiledTarget> CompiledTargets;
+/// Nodes whose rules read a node
+static std::vector<std::vector<int>> DependentNodes;
+/// CompiledTargets and DependentNodes are up to date with Depends
+static bool DependsCompiled = false;
+/// Available is kept up to date for the players, between InitDependencies and CleanDependencies
+static bool AvailabilityTracked = false;
+/// Unit types and upgrades available to each player
+static std::bitset<DependNodeMax> Available[PlayerMax];
+
 /*----------------------------------------------------------------------------
 --  Functions
 ----------------------------------------------------------------------------*/
@@ -195,6 +230,102 @@ std::string PrintDependencies(const CPlayer &player, const ButtonAction &button)
 	return it->second.getRequirementString(player);
 }
 
+/**
+**  Compile the rules of Depends into integer indexed nodes.
+*/
+static void CompileDependencies()
+{
+	CompiledTargets.assign(DependNodeMax, CompiledTarget());
+	DependentNodes.assign(DependNodeMax, std::vector<int>());
+
+	for (const auto &[target, orRule] : Depends) {
+		const int node = starts_with(target, "unit-") ? UnitTypeNode(UnitTypeByIdent(target).Slot)
+		                                              : UpgradeNode(CUpgrade::Get(target)->ID);
+		auto &rules = CompiledTargets[node].Rules;
+
+		for (const DependAndRule &andRule : orRule.rules) {
+			auto &requirements = rules.emplace_back();
+			for (const DependRule &rule : andRule.rules) {
+				CompiledRequirement requirement;
+
+				if (auto *type = std::get_if<const CUnitType *>(&rule.typeVar)) {
+					requirement.Node = UnitTypeNode((*type)->Slot);
+				} else {
+					requirement.Node = UpgradeNode(std::get<const CUpgrade *>(rule.typeVar)->ID);
+				}
+				requirement.Expected = static_cast<int>(rule.expected);
+				requirements.push_back(requirement);
+
+				auto &dependents = DependentNodes[requirement.Node];
+				if (ranges::find(dependents, node) == dependents.end()) {
+					dependents.push_back(node);
+				}
+			}
+		}
+	}
+	DependsCompiled = true;
+}
+
+/**
+**  Check if a requirement of a compiled rule is met.
+*/
+static bool IsRequirementMet(const CPlayer &player, const CompiledRequirement &requirement)
+{
+	if (requirement.Node < UnitTypeMax) {
+		const int count = player.HaveUnitTypeByType(*getUnitTypes()[requirement.Node]);
+		return requirement.Expected != 0 ? count >= requirement.Expected : count != 0;
+	}
+	const bool researched = UpgradeIdAllowed(player, requirement.Node - UnitTypeMax) == 'R';
+	return requirement.Expected ? researched : !researched;
+}
+
+/**
+**  Evaluate if a unit type or an upgrade is available, from its allow
+**  and its compiled rules.
+*/
+static bool IsNodeAvailable(const CPlayer &player, int node)
+{
+	// first have to check, if target is allowed itself
+	if (node < UnitTypeMax) {
+		if (UnitIdAllowed(player, node) == 0) {
+			return false;
+		}
+	} else if (UpgradeIdAllowed(player, node - UnitTypeMax) != 'A') {
+		return false;
+	}
+	if (!DependsCompiled) {
+		CompileDependencies();
+	}
+	const auto &rules = CompiledTargets[node].Rules;
+	if (rules.empty()) { // No rules
+		return true;
+	}
+	return ranges::any_of(rules, [&](const auto &requirements) {
+		return ranges::all_of(requirements, [&](const CompiledRequirement &requirement) {
+			return IsRequirementMet(player, requirement);
+		});
+	});
+}
+
+/**
+**  Check if the availability of a player is tracked.
+*/
+static bool IsAvailabilityTracked(const CPlayer &player)
+{
+	return AvailabilityTracked && &player == &Players[player.Index];
+}
+
+/**
+**  Check if a unit type or an upgrade is available.
+*/
+static bool CheckDependByNode(const CPlayer &player, int node)
+{
+	if (IsAvailabilityTracked(player)) {
+		return Available[player.Index][node];
+	}
+	return IsNodeAvailable(player, node);
+}
+
 /**
 **  Check if this upgrade or unit is available.
 **
@@ -205,24 +336,13 @@ std::string PrintDependencies(const CPlayer &player, const ButtonAction &button)
 */
 bool CheckDependByIdent(const CPlayer &player, std::string_view target)
 {
-	// first have to check, if target is allowed itself
 	if (starts_with(target, "unit-")) {
-		if (UnitIdAllowed(player, UnitTypeByIdent(target).Slot) == 0) {
-			return false;
-		}
+		return CheckDependByNode(player, UnitTypeNode(UnitTypeByIdent(target).Slot));
 	} else if (starts_with(target, "upgrade-")) {
-		if (UpgradeIdAllowed(player, CUpgrade::Get(target)->ID) != 'A') {
-			return false;
-		}
-	} else {
-		ErrorPrint("target '%s' should be unit-type or upgrade\n", target.data());
-		return false;
+		return CheckDependByNode(player, UpgradeNode(CUpgrade::Get(target)->ID));
 	}
-	auto it = Depends.find(target);
-	if (it == Depends.end()) { // No rules
-		return true;
-	}
-	return it->second.isValid(player);
+	ErrorPrint("target '%s' should be unit-type or upgrade\n", target.data());
+	return false;
 }
 
 /**
@@ -235,14 +355,94 @@ bool CheckDependByIdent(const CPlayer &player, std::string_view target)
 */
 bool CheckDependByType(const CPlayer &player, const CUnitType &type)
 {
-	return CheckDependByIdent(player, type.Ident);
+	return CheckDependByNode(player, UnitTypeNode(type.Slot));
+}
+
+/**
+**  Check if this upgrade is available.
+**
+**  @param player   For this player available.
+**  @param upgrade  Upgrade.
+**
+**  @return         True if available, false otherwise.
+*/
+bool CheckDependByUpgrade(const CPlayer &player, const CUpgrade &upgrade)
+{
+	return CheckDependByNode(player, UpgradeNode(upgrade.ID));
+}
+
+/**
+**  Evaluate again the availability of a node and of the nodes depending on it.
+*/
+static void UpdateNodeAvailability(const CPlayer &player, int node)
+{
+	auto &available = Available[player.Index];
+
+	available[node] = IsNodeAvailable(player, node);
+	for (int dependent : DependentNodes[node]) {
+		available[dependent] = IsNodeAvailable(player, dependent);
+	}
+}
+
+/**
+**  Evaluate again the availability of all unit types and upgrades for a player.
+**
+**  @param player  Player whose counts or allows were reset.
+*/
+void UpdateAvailability(const CPlayer &player)
+{
+	if (!IsAvailabilityTracked(player)) {
+		return;
+	}
+	auto &available = Available[player.Index];
+
+	available.reset();
+	for (size_t i = 0; i != getUnitTypes().size(); ++i) {
+		available[UnitTypeNode(i)] = IsNodeAvailable(player, UnitTypeNode(i));
+	}
+	for (size_t i = 0; i != AllUpgrades.size(); ++i) {
+		available[UpgradeNode(i)] = IsNodeAvailable(player, UpgradeNode(i));
+	}
+}
+
+/**
+**  Evaluate again what depends on the count or the allow of a unit type.
+**
+**  @param player  Player whose count or allow changed.
+**  @param slot    Slot of the unit type.
+*/
+void UpdateUnitTypeAvailability(const CPlayer &player, int slot)
+{
+	if (IsAvailabilityTracked(player)) {
+		UpdateNodeAvailability(player, UnitTypeNode(slot));
+	}
+}
+
+/**
+**  Evaluate again what depends on the allow of an upgrade.
+**
+**  @param player  Player whose allow changed.
+**  @param id      Identifier of the upgrade.
+*/
+void UpdateUpgradeAvailability(const CPlayer &player, int id)
+{
+	if (IsAvailabilityTracked(player)) {
+		UpdateNodeAvailability(player, UpgradeNode(id));
+	}
 }
 
 /**
 **  Initialize unit and upgrade dependencies.
+**
+**  Compile the rules and track the availability of the players from now.
 */
 void InitDependencies()
 {
+	CompileDependencies();
+	AvailabilityTracked = true;
+	for (const CPlayer &player : Players) {
+		UpdateAvailability(player);
+	}
 }
 
 /**
@@ -251,6 +451,10 @@ void InitDependencies()
 void CleanDependencies()
 {
 	Depends.clear();
+	CompiledTargets.clear();
+	DependentNodes.clear();
+	DependsCompiled = false;
+	AvailabilityTracked = false;
 }
 
 /*----------------------------------------------------------------------------
@@ -312,6 +516,11 @@ static int CclDefineDependency(lua_State *l)
 			}
 		}
 	}
+	DependsCompiled = false;
+	if (AvailabilityTracked) {
+		// defined while playing
+		InitDependencies();
+	}
 	return 0;
 }
 
@@ -257,10 +257,11 @@ void PathFinderOutput::Load(lua_State *l)
 				LuaError(l, "incorrect argument _");
 			}
 			const int subargs = lua_rawlen(l, -1);
-			if (subargs <= PathFinderOutput::MAX_PATH_LENGTH)
+			if (subargs <= PathFinderOutput::MAX_STORED_PATH_LENGTH)
 			{
+				this->SetCapacity(subargs);
 				for (int k = 0; k < subargs; ++k) {
-					this->Path[k] = LuaToNumber(l, -1, k + 1);
+					this->GetPath()[k] = LuaToNumber(l, -1, k + 1);
 				}
 				this->Length = subargs;
 			}
@@ -579,7 +580,7 @@ static int CclUnit(lua_State *l)
 			if (unit->CurrentAction() == UnitAction::Built) {
 				LuaDebugPrint(l, "HACK: the building is not ready yet\n");
 				// HACK: the building is not ready yet
-				unit->Player->UnitTypesCount[type->Slot]--;
+				unit->Player->ChangeUnitTypeCount(*type, -1);
 				if (unit->Active) {
 					unit->Player->UnitTypesAiActiveCount[type->Slot]--;
 				}
@@ -1279,12 +1280,10 @@ static int CclGetUnitVariable(lua_State *l)
 		}
 	} else if (value == "IndividualUpgrade") {
 		LuaCheckArgs(l, 3);
-		std::string_view upgrade_ident = LuaToString(l, 3);
-		if (CUpgrade::Get(upgrade_ident)) {
-			lua_pushboolean(l, unit->IndividualUpgrades[CUpgrade::Get(upgrade_ident)->ID]);
-		} else {
-			LuaError(l, "Individual upgrade \"%s\" doesn't exist.", upgrade_ident.data());
-		}
+		lua_pushvalue(l, 3);
+		const CUpgrade *upgrade = CclGetUpgrade(l);
+		lua_pop(l, 1);
+		lua_pushboolean(l, unit->IndividualUpgrades[upgrade->ID]);
 		return 1;
 	} else if (value == "Active") {
 		lua_pushboolean(l, unit->Active);
@@ -1400,16 +1399,14 @@ static int CclSetUnitVariable(lua_State *l)
 		}
 	} else if (name == "IndividualUpgrade") {
 		LuaCheckArgs(l, 4);
-		std::string_view upgrade_ident = LuaToString(l, 3);
+		lua_pushvalue(l, 3);
+		const CUpgrade *upgrade = CclGetUpgrade(l);
+		lua_pop(l, 1);
 		bool has_upgrade = LuaToBoolean(l, 4);
-		if (CUpgrade::Get(upgrade_ident)) {
-			if (has_upgrade && unit->IndividualUpgrades[CUpgrade::Get(upgrade_ident)->ID] == false) {
-				IndividualUpgradeAcquire(*unit, CUpgrade::Get(upgrade_ident));
-			} else if (!has_upgrade && unit->IndividualUpgrades[CUpgrade::Get(upgrade_ident)->ID]) {
-				IndividualUpgradeLost(*unit, CUpgrade::Get(upgrade_ident));
-			}
-		} else {
-			LuaError(l, "Individual upgrade \"%s\" doesn't exist.", upgrade_ident.data());
+		if (has_upgrade && unit->IndividualUpgrades[upgrade->ID] == false) {
+			IndividualUpgradeAcquire(*unit, upgrade);
+		} else if (!has_upgrade && unit->IndividualUpgrades[upgrade->ID]) {
+			IndividualUpgradeLost(*unit, upgrade);
 		}
 	} else if (name == "Active") {
 		bool ai_active = LuaToBoolean(l, 3);
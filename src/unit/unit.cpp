@@ -45,6 +45,7 @@
 #include "construct.h"
 #include "editor.h"
 #include "game.h"
+#include "influence_map.h"
 #include "interface.h"
 #include "luacallback.h"
 #include "map.h"
@@ -58,7 +59,9 @@
 #include "spells.h"
 #include "tileset.h"
 #include "translate.h"
+#include "trigger.h"
 #include "ui.h"
+#include "unit_area_count.h"
 #include "unit_find.h"
 #include "unit_manager.h"
 #include "unitsound.h"
@@ -390,6 +393,7 @@ void CUnit::Init()
 	Refs = 0;
 	ReleaseCycle = 0;
 	PlayerSlot = static_cast<size_t>(-1);
+	PlayerTypeSlot = static_cast<size_t>(-1);
 	InsideUnits.clear();
 	BoardCount = 0;
 	Container = nullptr;
@@ -576,12 +580,12 @@ void CUnit::Init(const CUnitType &type)
 	//  Set refs to 1. This is the "I am alive ref", lost in ReleaseUnit.
 	Refs = 1;
 
-	//  Build all unit table
-	UnitManager->Add(this);
-
 	//  Initialise unit structure (must be zero filled!)
 	Type = &type;
 
+	//  Build all unit table (indexed by type too)
+	UnitManager->Add(this);
+
 	Seen.Frame = UnitNotSeen; // Unit isn't yet seen
 
 	Frame = type.StillFrame;
@@ -670,6 +674,31 @@ bool CUnit::CanStoreOrder(COrder *order)
 	return true;
 }
 
+/**
+**  Change the type of the unit.
+**
+**  Only the type lists of the unit manager and of the owner are updated,
+**  the caller takes care of the stats and of the counts.
+**
+**  @param type  New unit type.
+*/
+void CUnit::SetType(const CUnitType &type)
+{
+	const bool inPlayerList = PlayerTypeSlot != static_cast<size_t>(-1);
+
+	if (inPlayerList) {
+		Player->RemoveUnitOfType(*this);
+	}
+	UnitManager->RemoveUnitOfType(*this);
+	Type = const_cast<CUnitType *>(&type);
+	UnitManager->AddUnitOfType(*this);
+	if (inPlayerList) {
+		Player->AddUnitOfType(*this);
+	}
+	UnitAreaCount.Update(*this);
+	InfluenceMap.Update(*this);
+}
+
 /**
 **  Assigns a unit to a player, adjusting buildings, food and totals
 **
@@ -694,7 +723,7 @@ void CUnit::AssignToPlayer(CPlayer &player)
 				player.TotalUnits++;
 			}
 		}
-		player.UnitTypesCount[type.Slot]++;
+		player.ChangeUnitTypeCount(type, 1);
 		if (Active) {
 			player.UnitTypesAiActiveCount[type.Slot]++;
 		}
@@ -746,6 +775,7 @@ CUnit *MakeUnit(const CUnitType &type, CPlayer *player)
 		&& unit->Type->BoolFlag[NORANDOMPLACING_INDEX].value == false && (MyRand() & 1) != 0) {
 		unit->Frame = -unit->Frame - 1;
 	}
+	TriggerNotifyEvent(ETriggerEvent::UnitCreated);
 	return unit;
 }
 
@@ -1089,6 +1119,7 @@ void CUnit::MoveToXY(const Vec2i &pos)
 	Assert(UnitCanBeAt(*this, pos));
 	// Move the unit.
 	UnitInXY(*this, pos);
+	TriggerNotifyUnitEntered(*this);
 
 	Map.Insert(*this);
 	MarkUnitFieldFlags(*this);
@@ -1115,6 +1146,7 @@ void CUnit::Place(const Vec2i &pos)
 	}
 	Removed = 0;
 	UnitInXY(*this, pos);
+	TriggerNotifyUnitEntered(*this);
 	// Pathfinding info.
 	MarkUnitFieldFlags(*this);
 	// Tha cache list.
@@ -1300,7 +1332,7 @@ void UnitLost(CUnit &unit)
 			}
 		}
 		if (unit.CurrentAction() != UnitAction::Built) {
-			player.UnitTypesCount[type.Slot]--;
+			player.ChangeUnitTypeCount(type, -1);
 			if (unit.Active) {
 				player.UnitTypesAiActiveCount[type.Slot]--;
 			}
@@ -1780,6 +1812,7 @@ void CUnit::ChangeOwner(CPlayer &newplayer)
 
 	MapUnmarkUnitSight(*this);
 	newplayer.AddUnit(*this);
+	UI.Minimap.UpdateUnit(*this);
 	Stats = const_cast<CUnitStats *>(&Type->Stats[newplayer.Index]);
 	UpdateUnitSightRange(*this);
 	MapMarkUnitSight(*this);
@@ -1799,7 +1832,7 @@ void CUnit::ChangeOwner(CPlayer &newplayer)
 	if (Type->Building && !Type->BoolFlag[WALL_INDEX].value) {
 		newplayer.NumBuildings++;
 	}
-	newplayer.UnitTypesCount[Type->Slot]++;
+	newplayer.ChangeUnitTypeCount(*Type, 1);
 	if (Active) {
 		newplayer.UnitTypesAiActiveCount[Type->Slot]++;
 	}
@@ -2318,6 +2351,7 @@ void LetUnitDie(CUnit &unit, bool suicide)
 	unit.Moving = 0;
 	unit.TTL = 0;
 	unit.Anim.Unbreakable = 0;
+	TriggerNotifyEvent(ETriggerEvent::UnitDied);
 
 	const CUnitType *type = unit.Type;
 
@@ -2685,6 +2719,9 @@ static void HitUnit_LastAttack(const CUnit *attacker, CUnit &target)
 	const unsigned long lastattack = target.Attacked;
 
 	target.Attacked = GameCycle ? GameCycle : 1;
+	if (target.Player == ThisPlayer) {
+		UI.Minimap.UpdateUnit(target);
+	}
 	if (target.Type->BoolFlag[WALL_INDEX].value || (lastattack && GameCycle <= lastattack + 2 * CYCLES_PER_SECOND)) {
 		return;
 	}
@@ -3386,6 +3423,8 @@ void CleanUnits()
 	}
 
 	UnitManager->Init();
+	UnitAreaCount.Clear();
+	InfluenceMap.Clear();
 
 	FancyBuildings = false;
 	HelpMeLastCycle = 0;
@@ -0,0 +1,364 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name unit_area_count.cpp - The unit area count index. */
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+//@{
+
+/*----------------------------------------------------------------------------
+--  Includes
+----------------------------------------------------------------------------*/
+
+#include "stratagus.h"
+
+#include "unit_area_count.h"
+
+#include "map.h"
+#include "player.h"
+#include "unit.h"
+#include "unittype.h"
+
+/*----------------------------------------------------------------------------
+--  Variables
+----------------------------------------------------------------------------*/
+
+CUnitAreaCount UnitAreaCount;  /// Unit counts of map areas
+
+/*----------------------------------------------------------------------------
+--  Functions
+----------------------------------------------------------------------------*/
+
+CAreaCountTree::CAreaCountTree(int width, int height) :
+	Width(width),
+	Height(height),
+	Cells((width + 1) * (height + 1), 0)
+{
+}
+
+/**
+**  Add delta points at pos.
+*/
+void CAreaCountTree::Add(const Vec2i &pos, int delta)
+{
+	Assert(0 <= pos.x && pos.x < Width && 0 <= pos.y && pos.y < Height);
+
+	for (int y = pos.y + 1; y <= Height; y += y & -y) {
+		for (int x = pos.x + 1; x <= Width; x += x & -x) {
+			Cells[y * (Width + 1) + x] += delta;
+		}
+	}
+}
+
+/**
+**  Number of points with a coordinate lower than (x, y).
+*/
+int CAreaCountTree::Prefix(int x, int y) const
+{
+	int res = 0;
+	for (int j = y; j > 0; j -= j & -j) {
+		for (int i = x; i > 0; i -= i & -i) {
+			res += Cells[j * (Width + 1) + i];
+		}
+	}
+	return res;
+}
+
+/**
+**  Number of points in the rectangle, bounds included.
+**
+**  The rectangle is clipped to the grid.
+*/
+int CAreaCountTree::Count(Vec2i minPos, Vec2i maxPos) const
+{
+	minPos.x = std::max<int>(minPos.x, 0);
+	minPos.y = std::max<int>(minPos.y, 0);
+	maxPos.x = std::min<int>(maxPos.x, Width - 1);
+	maxPos.y = std::min<int>(maxPos.y, Height - 1);
+	if (minPos.x > maxPos.x || minPos.y > maxPos.y) {
+		return 0;
+	}
+	return Prefix(maxPos.x + 1, maxPos.y + 1) - Prefix(minPos.x, maxPos.y + 1)
+	     - Prefix(maxPos.x + 1, minPos.y) + Prefix(minPos.x, minPos.y);
+}
+
+/**
+**  Forget all units and trees, done when the units are cleaned.
+*/
+void CUnitAreaCount::Clear()
+{
+	Entries.clear();
+	TypeTrees.clear();
+	Categories.clear();
+	Tracking = false;
+	MapWidth = 0;
+	MapHeight = 0;
+}
+
+CUnitAreaCount::Entry CUnitAreaCount::MakeEntry(const CUnit &unit, bool onMap) const
+{
+	Entry entry;
+	entry.OnMap = onMap;
+	entry.Counted = onMap && unit.Type && unit.Player && unit.IsAlive();
+	if (entry.Counted) {
+		entry.Building = unit.Type->Building;
+		entry.Constructed = unit.Constructed;
+		entry.Player = unit.Player->Index;
+		entry.TypeSlot = unit.Type->Slot;
+		entry.Width = unit.Type->TileWidth;
+		entry.Height = unit.Type->TileHeight;
+		entry.Pos = unit.tilePos;
+	}
+	return entry;
+}
+
+bool CUnitAreaCount::Entry::operator==(const Entry &rhs) const
+{
+	return OnMap == rhs.OnMap && Counted == rhs.Counted && Building == rhs.Building
+	    && Constructed == rhs.Constructed && Player == rhs.Player
+	    && TypeSlot == rhs.TypeSlot && Pos == rhs.Pos;
+}
+
+/**
+**  Replace what the index knows of the unit.
+*/
+void CUnitAreaCount::Set(const CUnit &unit, const Entry &entry)
+{
+	const int slot = UnitNumber(unit);
+	if (slot < 0) {
+		return;
+	}
+	if (slot >= static_cast<int>(Entries.size())) {
+		Entries.resize(slot + 1);
+	}
+	Entry &old = Entries[slot];
+	if (old == entry) {
+		return;
+	}
+	if (Tracking) {
+		CheckMapSize(); // drops the trees of a previous map
+		Apply(old, -1);
+		Apply(entry, 1);
+	}
+	old = entry;
+}
+
+/**
+**  Add the unit described by entry to the trees it belongs to.
+*/
+void CUnitAreaCount::Apply(const Entry &entry, int delta)
+{
+	if (!entry.Counted) {
+		return;
+	}
+	if (!entry.Constructed) {
+		if (CAreaCountTree *tree = FindTypeTree(entry.Player, entry.TypeSlot)) {
+			tree->Add(entry.Pos, delta);
+		}
+	}
+	const size_t index = entry.Player * 2 + entry.Building;
+	if (index < Categories.size() && Categories[index].Tracked) {
+		FindSizeTree(Categories[index], entry.Width, entry.Height).Add(entry.Pos, delta);
+	}
+}
+
+/**
+**  Called when the unit is inserted in the map unit cache.
+*/
+void CUnitAreaCount::OnMapInsert(const CUnit &unit)
+{
+	Set(unit, MakeEntry(unit, true));
+}
+
+/**
+**  Called when the unit is removed from the map unit cache.
+*/
+void CUnitAreaCount::OnMapRemove(const CUnit &unit)
+{
+	Set(unit, MakeEntry(unit, false));
+}
+
+/**
+**  Called when the owner, type, construction or death state of the unit change.
+*/
+void CUnitAreaCount::Update(const CUnit &unit)
+{
+	const int slot = UnitNumber(unit);
+	const bool onMap = 0 <= slot && slot < static_cast<int>(Entries.size()) && Entries[slot].OnMap;
+
+	Set(unit, MakeEntry(unit, onMap));
+}
+
+CAreaCountTree *CUnitAreaCount::FindTypeTree(int player, int typeSlot) const
+{
+	if (player >= static_cast<int>(TypeTrees.size())
+	    || typeSlot >= static_cast<int>(TypeTrees[player].size())) {
+		return nullptr;
+	}
+	return TypeTrees[player][typeSlot].get();
+}
+
+CAreaCountTree &CUnitAreaCount::FindSizeTree(Category &category, int width, int height)
+{
+	for (auto &size : category.Sizes) {
+		if (size.Width == width && size.Height == height) {
+			return size.Tree;
+		}
+	}
+	category.Sizes.push_back({width, height, CAreaCountTree(MapWidth, MapHeight)});
+	return category.Sizes.back().Tree;
+}
+
+/**
+**  Get the tree of the finished units of type of player, build it if needed.
+*/
+CAreaCountTree &CUnitAreaCount::TrackType(int player, const CUnitType &type)
+{
+	if (TypeTrees.size() < PlayerMax) {
+		TypeTrees.resize(PlayerMax);
+	}
+	auto &trees = TypeTrees[player];
+	if (type.Slot >= static_cast<int>(trees.size())) {
+		trees.resize(type.Slot + 1);
+	}
+	if (trees[type.Slot] == nullptr) {
+		trees[type.Slot] = std::make_unique<CAreaCountTree>(MapWidth, MapHeight);
+		Tracking = true;
+		for (const Entry &entry : Entries) {
+			if (entry.Counted && !entry.Constructed && entry.Player == player
+			    && entry.TypeSlot == type.Slot) {
+				trees[type.Slot]->Add(entry.Pos, 1);
+			}
+		}
+	}
+	return *trees[type.Slot];
+}
+
+/**
+**  Get the trees of the buildings or units of player, build them if needed.
+*/
+CUnitAreaCount::Category &CUnitAreaCount::TrackCategory(int player, bool building)
+{
+	if (Categories.size() < 2 * PlayerMax) {
+		Categories.resize(2 * PlayerMax);
+	}
+	Category &category = Categories[player * 2 + building];
+	if (!category.Tracked) {
+		category.Tracked = true;
+		Tracking = true;
+		for (const Entry &entry : Entries) {
+			if (entry.Counted && entry.Player == player && entry.Building == building) {
+				FindSizeTree(category, entry.Width, entry.Height).Add(entry.Pos, 1);
+			}
+		}
+	}
+	return category;
+}
+
+int CUnitAreaCount::CountCategory(int player, bool building, const Vec2i &minPos, const Vec2i &maxPos)
+{
+	int res = 0;
+	for (const auto &size : TrackCategory(player, building).Sizes) {
+		const Vec2i extent(size.Width - 1, size.Height - 1);
+		res += size.Tree.Count(minPos - extent, maxPos);
+	}
+	return res;
+}
+
+/**
+**  Drop the trees built for another map size.
+*/
+void CUnitAreaCount::CheckMapSize()
+{
+	if (MapWidth == Map.Info.MapWidth && MapHeight == Map.Info.MapHeight) {
+		return;
+	}
+	TypeTrees.clear();
+	Categories.clear();
+	Tracking = false;
+	MapWidth = Map.Info.MapWidth;
+	MapHeight = Map.Info.MapHeight;
+}
+
+/**
+**  Count the alive units overlapping a rectangle of the map.
+**
+**  @param player  Owner of the units, -1 for any player.
+**  @param kind    Which units are counted.
+**  @param type    Unit type counted when kind is EUnitCountKind::Type.
+**  @param minPos  Top left tile of the rectangle.
+**  @param maxPos  Bottom right tile of the rectangle.
+**
+**  @return        Number of units.
+*/
+int CUnitAreaCount::Count(int player, EUnitCountKind kind, const CUnitType *type, const Vec2i &minPos, const Vec2i &maxPos)
+{
+	CheckMapSize();
+	if (player == -1) {
+		int res = 0;
+		for (int i = 0; i != PlayerMax; ++i) {
+			res += Count(i, kind, type, minPos, maxPos);
+		}
+		return res;
+	}
+	if (player < 0 || player >= PlayerMax) {
+		return 0;
+	}
+	switch (kind) {
+		case EUnitCountKind::Any:
+			return CountCategory(player, false, minPos, maxPos) + CountCategory(player, true, minPos, maxPos);
+		case EUnitCountKind::Units: return CountCategory(player, false, minPos, maxPos);
+		case EUnitCountKind::Buildings: return CountCategory(player, true, minPos, maxPos);
+		case EUnitCountKind::Type: {
+			Assert(type);
+			const Vec2i extent(type->TileWidth - 1, type->TileHeight - 1);
+			return TrackType(player, *type).Count(minPos - extent, maxPos);
+		}
+	}
+	return 0;
+}
+
+/**
+**  Check if the unit is one of the units Count would count.
+*/
+bool CUnitAreaCount::IsCounted(const CUnit &unit, int player, EUnitCountKind kind, const CUnitType *type) const
+{
+	const int slot = UnitNumber(unit);
+	if (slot < 0 || slot >= static_cast<int>(Entries.size())) {
+		return false;
+	}
+	const Entry &entry = Entries[slot];
+	if (!entry.Counted || (player != -1 && entry.Player != player)) {
+		return false;
+	}
+	switch (kind) {
+		case EUnitCountKind::Any: return true;
+		case EUnitCountKind::Units: return !entry.Building;
+		case EUnitCountKind::Buildings: return entry.Building;
+		case EUnitCountKind::Type: return !entry.Constructed && entry.TypeSlot == type->Slot;
+	}
+	return false;
+}
+
+//@}
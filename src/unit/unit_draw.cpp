@@ -34,6 +34,9 @@
 --  Includes
 ----------------------------------------------------------------------------*/
 
+#include <limits>
+#include <map>
+#include <tuple>
 #include <vector>
 
 #include "stratagus.h"
@@ -55,6 +58,7 @@
 #include "translate.h"
 #include "unit.h"
 #include "unit_find.h"
+#include "unit_manager.h"
 #include "unitsound.h"
 #include "unittype.h"
 #include "ui.h"
@@ -1034,32 +1038,52 @@ void CUnit::Draw(const CViewport &vp) const
 }
 
 /**
-**  Compare what order 2 units should be drawn on the map
-**
-**  @param c1  First Unit to compare (*Unit)
-**  @param c2  Second Unit to compare (*Unit)
+**  Order in which units are drawn on the map.
 **
+**  Units are drawn by draw level, then by their Y position (bottom of
+**  sprite), then by X position and slot.
 */
-static inline bool DrawLevelCompare(const CUnit *c1, const CUnit *c2)
+struct UnitDrawKey
 {
-	int drawlevel1 = c1->GetDrawLevel();
-	int drawlevel2 = c2->GetDrawLevel();
-
-	if (drawlevel1 == drawlevel2) {
-		// diffpos compares unit's Y positions (bottom of sprite) on the map
-		// and uses X position in case Y positions are equal.
-		const int pos1 = (c1->tilePos.y + c1->Type->TileHeight - 1) * PixelTileSize.y + c1->IY;
-		const int pos2 = (c2->tilePos.y + c2->Type->TileHeight - 1) * PixelTileSize.y + c2->IY;
-		return pos1 == pos2 ?
-			   (c1->tilePos.x != c2->tilePos.x ? c1->tilePos.x < c2->tilePos.x : UnitNumber(*c1) < UnitNumber(*c2)) : pos1 < pos2;
-	} else {
-		return drawlevel1 < drawlevel2;
+	int DrawLevel;
+	int Bottom;
+	int X;
+	int Slot;
+
+	bool operator<(const UnitDrawKey &rhs) const
+	{
+		return std::tie(DrawLevel, Bottom, X, Slot) < std::tie(rhs.DrawLevel, rhs.Bottom, rhs.X, rhs.Slot);
 	}
+};
+
+static UnitDrawKey GetUnitDrawKey(const CUnit &unit)
+{
+	const int bottom = (unit.tilePos.y + unit.Type->TileHeight - 1) * PixelTileSize.y + unit.IY;
+	return {unit.GetDrawLevel(), bottom, unit.tilePos.x, int(UnitNumber(unit))};
 }
 
+struct UnitDrawEntry
+{
+	UnitDrawKey Key;
+	CUnit *Unit;
+
+	bool operator<(const UnitDrawEntry &rhs) const { return Key < rhs.Key; }
+};
+
+/// Units drawn in each viewport during the last frame, in draw order
+static std::map<const CViewport *, std::vector<UnitDrawEntry>> UnitDrawOrders;
+/// Per unit slot: UnitDrawMark if selected for the running frame, UnitDrawMark + 1 once placed
+static std::vector<unsigned int> UnitDrawMarks;
+static unsigned int UnitDrawMark = 0;
+
 /**
 **  Find all units to draw in viewport.
 **
+**  The draw order of the previous frame is kept per viewport and only
+**  repaired: units rarely overtake each other between two frames, so
+**  only the units out of their last order and the units entering the
+**  viewport are sorted, then merged with the others.
+**
 **  @param vp     Viewport to be drawn.
 **  @return Table of units to return in sorted order
 **
@@ -1074,7 +1098,53 @@ std::vector<CUnit *> FindAndSortUnits(const CViewport &vp)
 	std::vector<CUnit *> table =
 		Select(minPos, maxPos, [&](const CUnit *unit) { return unit->IsVisibleInViewport(vp); });
 
-	ranges::sort(table, DrawLevelCompare);
+	if (UnitDrawMark >= std::numeric_limits<unsigned int>::max() - 2) {
+		ranges::fill(UnitDrawMarks, 0);
+		UnitDrawMark = 0;
+	}
+	UnitDrawMark += 2;
+	if (UnitDrawMarks.size() < UnitManager->GetUsedSlotCount()) {
+		UnitDrawMarks.resize(UnitManager->GetUsedSlotCount(), 0);
+	}
+	for (const CUnit *unit : table) {
+		UnitDrawMarks[UnitNumber(*unit)] = UnitDrawMark;
+	}
+
+	// Keep the units still shown and still in their last order, with updated keys.
+	// The units which moved out of it are sorted again with the entering ones.
+	static std::vector<UnitDrawEntry> moved;
+	std::vector<UnitDrawEntry> &order = UnitDrawOrders[&vp];
+	size_t kept = 0;
+	moved.clear();
+	for (const UnitDrawEntry &entry : order) {
+		const int slot = entry.Key.Slot;
+		if (size_t(slot) < UnitDrawMarks.size() && UnitDrawMarks[slot] == UnitDrawMark) {
+			UnitDrawMarks[slot] = UnitDrawMark + 1;
+			CUnit &unit = UnitManager->GetSlotUnit(slot);
+			const UnitDrawEntry updated{GetUnitDrawKey(unit), &unit};
+			if (kept != 0 && updated < order[kept - 1]) {
+				moved.push_back(updated);
+			} else {
+				order[kept++] = updated;
+			}
+		}
+	}
+	order.resize(kept);
+
+	// Merge in the units entering the viewport.
+	for (CUnit *unit : table) {
+		if (UnitDrawMarks[UnitNumber(*unit)] == UnitDrawMark) {
+			moved.push_back({GetUnitDrawKey(*unit), unit});
+		}
+	}
+	std::sort(moved.begin(), moved.end());
+	order.insert(order.end(), moved.begin(), moved.end());
+	std::inplace_merge(order.begin(), order.begin() + kept, order.end());
+
+	table.clear();
+	for (const UnitDrawEntry &entry : order) {
+		table.push_back(entry.Unit);
+	}
 	return table;
 }
 
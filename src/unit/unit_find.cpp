@@ -522,8 +522,8 @@ CUnit *FindIdleWorker(const CPlayer &player, const CUnit *last)
 std::vector<CUnit *> FindUnitsByType(const CUnitType &type, bool everybody)
 {
 	std::vector<CUnit *> units;
-	for (CUnit *unit : UnitManager->GetUnits()) {
-		if (unit->Type == &type && !unit->IsUnusable(everybody)) {
+	for (CUnit *unit : UnitManager->GetUnitsOfType(type)) {
+		if (!unit->IsUnusable(everybody)) {
 			units.push_back(unit);
 		}
 	}
@@ -557,10 +557,7 @@ std::vector<CUnit *> FindPlayerUnitsByType(const CPlayer &player, const CUnitTyp
 	}
 	std::vector<CUnit *> table;
 
-	for (CUnit *unit : player.GetUnits()) {
-		if (unit->Type != &type) {
-			continue;
-		}
+	for (CUnit *unit : player.GetUnitsOfType(type)) {
 		if (!unit->IsUnusable()) {
 			table.push_back(unit);
 		}
@@ -37,6 +37,7 @@
 
 #include "unit_manager.h"
 #include "unit.h"
+#include "unittype.h"
 #include "iolib.h"
 #include "script.h"
 
@@ -59,6 +60,7 @@ void CUnitManager::Init()
 	lastCreated = nullptr;
 	//Assert(units.empty());
 	units.clear();
+	unitsByType.clear();
 	// Release memory of units in release list.
 	while (!releasedUnits.empty()) {
 		CUnit *unit = releasedUnits.front();
@@ -85,6 +87,7 @@ CUnit *CUnitManager::AllocUnit()
 		unit->Init();
 		unit->UnitManagerData.slot = slot;
 		unit->UnitManagerData.unitSlot = -1;
+		unit->UnitManagerData.typeSlot = -1;
 		return unit;
 	} else {
 		CUnit *unit = new CUnit;
@@ -114,6 +117,9 @@ void CUnitManager::ReleaseUnit(CUnit &unit)
 		unit.UnitManagerData.unitSlot = -1;
 		units.pop_back();
 	}
+	if (unit.UnitManagerData.typeSlot != -1) {
+		RemoveUnitOfType(unit);
+	}
 	Assert(unit.PlayerSlot == static_cast<size_t>(-1));
 	releasedUnits.push_back(&unit);
 	unit.ReleaseCycle = GameCycle + 500; // can be reused after this time
@@ -145,6 +151,52 @@ void CUnitManager::Add(CUnit *unit)
 	lastCreated = unit;
 	unit->UnitManagerData.unitSlot = static_cast<int>(units.size());
 	units.push_back(unit);
+	AddUnitOfType(*unit);
+}
+
+/**
+**  Get the allocated units of a type (no specific order).
+**
+**  @param type  Unit type.
+*/
+const std::vector<CUnit *> &CUnitManager::GetUnitsOfType(const CUnitType &type) const
+{
+	static const std::vector<CUnit *> none;
+
+	if (type.Slot >= static_cast<int>(unitsByType.size())) {
+		return none;
+	}
+	return unitsByType[type.Slot];
+}
+
+/**
+**  Add the unit to the list of its type.
+*/
+void CUnitManager::AddUnitOfType(CUnit &unit)
+{
+	Assert(unit.UnitManagerData.typeSlot == -1);
+	const int slot = unit.Type->Slot;
+	if (slot >= static_cast<int>(unitsByType.size())) {
+		unitsByType.resize(slot + 1);
+	}
+	auto &typeUnits = unitsByType[slot];
+	unit.UnitManagerData.typeSlot = static_cast<int>(typeUnits.size());
+	typeUnits.push_back(&unit);
+}
+
+/**
+**  Remove the unit from the list of its type.
+*/
+void CUnitManager::RemoveUnitOfType(CUnit &unit)
+{
+	auto &typeUnits = unitsByType[unit.Type->Slot];
+	Assert(typeUnits[unit.UnitManagerData.typeSlot] == &unit);
+
+	CUnit *temp = typeUnits.back();
+	temp->UnitManagerData.typeSlot = unit.UnitManagerData.typeSlot;
+	typeUnits[unit.UnitManagerData.typeSlot] = temp;
+	unit.UnitManagerData.typeSlot = -1;
+	typeUnits.pop_back();
 }
 
 /**
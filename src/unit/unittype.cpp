@@ -39,6 +39,7 @@
 #include "animation/animation_exactframe.h"
 #include "animation/animation_frame.h"
 #include "construct.h"
+#include "ident_table.h"
 #include "iolib.h"
 #include "luacallback.h"
 #include "map.h"
@@ -759,9 +760,8 @@ void SaveUnitTypes(CFile &file)
 */
 CUnitType &UnitTypeByIdent(std::string_view ident)
 {
-	auto ret = UnitTypeMap.find(ident);
-	if (ret != UnitTypeMap.end()) {
-		return *(*ret).second;
+	if (const int slot = IdentTable.Find(EIdentKind::UnitType, ident); slot != -1) {
+		return *UnitTypes[slot];
 	}
 	ErrorPrint("Unknown unitType '%s'\n", ident.data());
 	ExitFatal(1);
@@ -776,8 +776,8 @@ CUnitType &UnitTypeByIdent(std::string_view ident)
 */
 std::pair<CUnitType *, bool> NewUnitTypeSlot(std::string_view ident)
 {
-	if (auto ret = UnitTypeMap.find(ident); ret != UnitTypeMap.end()) {
-		return {(*ret).second.get(), true};
+	if (const int slot = IdentTable.Find(EIdentKind::UnitType, ident); slot != -1) {
+		return {UnitTypes[slot], true};
 	}
 
 	size_t new_bool_size = UnitTypeVar.GetNumberBoolFlag();
@@ -790,6 +790,7 @@ std::pair<CUnitType *, bool> NewUnitTypeSlot(std::string_view ident)
 	type->DefaultStat.Variables = UnitTypeVar.Variable;
 
 	UnitTypes.push_back(type.get());
+	IdentTable.Add(EIdentKind::UnitType, ident, type->Slot);
 
 	UnitTypeMap[std::string(ident)] = std::move(type);
 	return {UnitTypes.back(), false};
@@ -1012,6 +1013,7 @@ void CleanUnitTypes()
 	// Clean all unit-types
 	UnitTypes.clear();
 	UnitTypeMap.clear();
+	IdentTable.Clear(EIdentKind::UnitType);
 	UnitTypeVar.Clear();
 
 	// Clean hardcoded unit types.
@@ -36,7 +36,6 @@
 
 #include <string>
 #include <vector>
-#include <map>
 
 #include "stratagus.h"
 
@@ -45,6 +44,7 @@
 #include "action/action_train.h"
 #include "commands.h"
 #include "depend.h"
+#include "ident_table.h"
 #include "interface.h"
 #include "iolib.h"
 #include "map.h"
@@ -72,8 +72,6 @@ std::unique_ptr<CUpgradeModifier> UpgradeModifiers[UPGRADE_MODIFIERS_MAX];
 /// Number of upgrades modifiers used
 int NumUpgradeModifiers;
 
-static std::map<std::string, CUpgrade *, std::less<>> Upgrades;
-
 /*----------------------------------------------------------------------------
 --  Functions
 ----------------------------------------------------------------------------*/
@@ -114,14 +112,14 @@ CUpgrade::CUpgrade(std::string ident) :
 */
 /* static */ CUpgrade *CUpgrade::New(std::string ident)
 {
-	CUpgrade *&upgrade = Upgrades[ident];
-	if (upgrade) {
-		return upgrade;
+	if (const int id = IdentTable.Find(EIdentKind::Upgrade, ident); id != -1) {
+		return AllUpgrades[id].get();
 	} else {
 		auto ptr = std::make_unique<CUpgrade>(ident);
-		upgrade = ptr.get();
+		CUpgrade *upgrade = ptr.get();
 		upgrade->ID = AllUpgrades.size();
 		AllUpgrades.push_back(std::move(ptr));
+		IdentTable.Add(EIdentKind::Upgrade, upgrade->Ident, upgrade->ID);
 		return upgrade;
 	}
 }
@@ -135,12 +133,12 @@ CUpgrade::CUpgrade(std::string ident) :
 */
 /* static */ CUpgrade *CUpgrade::Get(std::string_view ident)
 {
-	auto it = Upgrades.find(ident);
-	if (it == Upgrades.end()) {
+	const int id = IdentTable.Find(EIdentKind::Upgrade, ident);
+	if (id == -1) {
 		ErrorPrint("upgrade not found: '%s'\n", ident.data());
 		ExitFatal(-1);
 	}
-	return it->second;
+	return AllUpgrades[id].get();
 }
 
 /**
@@ -155,7 +153,7 @@ void InitUpgrades()
 */
 void CleanUpgrades()
 {
-	Upgrades.clear();
+	IdentTable.Clear(EIdentKind::Upgrade);
 
 	//
 	//  Free the upgrade modifiers.
@@ -275,20 +273,32 @@ static int CclDefineModifier(lua_State *l)
 			const std::string_view value = LuaToString(l, j + 1, 2);
 
 			if (starts_with(value, "unit-")) {
-				um->ChangeUnits[UnitTypeByIdent(value).Slot] = LuaToNumber(l, j + 1, 3);
+				const int slot = UnitTypeByIdent(value).Slot;
+				if (ranges::find(um->ChangedUnitTypes, slot) == um->ChangedUnitTypes.end()) {
+					um->ChangedUnitTypes.push_back(slot);
+				}
+				um->ChangeUnits[slot] = LuaToNumber(l, j + 1, 3);
 			} else {
 				LuaError(l, "unit expected");
 			}
 		} else if (key == "allow") {
 			const std::string_view value = LuaToString(l, j + 1, 2);
 			if (starts_with(value, "upgrade-")) {
-				um->ChangeUpgrades[UpgradeIdByIdent(value)] = LuaToNumber(l, j + 1, 3);
+				const int id = UpgradeIdByIdent(value);
+				if (ranges::find(um->ChangedUpgrades, id) == um->ChangedUpgrades.end()) {
+					um->ChangedUpgrades.push_back(id);
+				}
+				um->ChangeUpgrades[id] = LuaToNumber(l, j + 1, 3);
 			} else {
 				LuaError(l, "upgrade expected");
 			}
 		} else if (key == "apply-to") {
 			const std::string_view value = LuaToString(l, j + 1, 2);
-			um->ApplyTo[UnitTypeByIdent(value).Slot] = 'X';
+			const int slot = UnitTypeByIdent(value).Slot;
+			if (um->ApplyTo[slot] != 'X') {
+				um->ApplyToTypes.push_back(slot);
+			}
+			um->ApplyTo[slot] = 'X';
 		} else if (key == "convert-to") {
 			const std::string_view value = LuaToString(l, j + 1, 2);
 			um->ConvertTo = &UnitTypeByIdent(value);
@@ -398,6 +408,46 @@ static int CclDefineAllow(lua_State *l)
 	return 0;
 }
 
+/**
+**  Access upgrade object
+**
+**  @param l  Lua state.
+*/
+CUpgrade *CclGetUpgrade(lua_State *l)
+{
+	// Be kind allow also strings or symbols
+	if (lua_isstring(l, -1)) {
+		return CUpgrade::Get(LuaToString(l, -1));
+	} else if (lua_isuserdata(l, -1)) {
+		LuaUserData *data = (LuaUserData *)lua_touserdata(l, -1);
+		if (data->Type == LuaUpgradeType) {
+			return (CUpgrade *)data->Data;
+		}
+	}
+	LuaError(l, "CclGetUpgrade: not an upgrade");
+	return nullptr;
+}
+
+/**
+**  Get upgrade structure.
+**
+**  Scripts may keep it instead of the identifier, to skip its lookup.
+**
+**  @param l  Lua state.
+**
+**  @return   Upgrade structure.
+*/
+static int CclUpgrade(lua_State *l)
+{
+	LuaCheckArgs(l, 1);
+
+	CUpgrade *upgrade = CUpgrade::Get(LuaToString(l, 1));
+	LuaUserData *data = (LuaUserData *)lua_newuserdata(l, sizeof(LuaUserData));
+	data->Type = LuaUpgradeType;
+	data->Data = upgrade;
+	return 1;
+}
+
 /**
 **  Register CCL features for upgrades.
 */
@@ -406,6 +456,7 @@ void UpgradesCclRegister()
 	lua_register(Lua, "DefineModifier", CclDefineModifier);
 	lua_register(Lua, "DefineAllow", CclDefineAllow);
 	lua_register(Lua, "DefineUnitAllow", CclDefineUnitAllow);
+	lua_register(Lua, "Upgrade", CclUpgrade);
 }
 
 /*----------------------------------------------------------------------------
@@ -465,6 +516,56 @@ static void ConvertUnitTypeTo(CPlayer &player, const CUnitType &src, CUnitType &
 	}
 }
 
+/// Sight range of a unit to change
+struct SightRangeChange
+{
+	CUnit *Unit = nullptr;
+	int OldRange = 0;
+	int NewRange = 0;
+};
+
+/**
+**  Add the units of a player of a type to the sight ranges to change.
+**
+**  @param changes  Sight ranges to change.
+**  @param player   Owner of the units.
+**  @param type     Type of the units.
+**  @param range    New sight range of the units.
+*/
+static void AddSightRangeChanges(std::vector<SightRangeChange> &changes, const CPlayer &player,
+                                 const CUnitType &type, int range)
+{
+	for (CUnit *unit : player.GetUnitsOfType(type)) {
+		if (!unit->IsUnusable() && unit->CurrentSightRange != range) {
+			changes.push_back({unit, unit->CurrentSightRange, range});
+		}
+	}
+}
+
+/**
+**  Change the sight range of units as one update of the vision table.
+**
+**  The new ranges of all the units are marked before the old ones are
+**  unmarked, so the tiles seen before and after the change never go
+**  under the fog in between, and the units on them aren't hidden and
+**  shown again. The whole sight of each unit is still walked twice: with
+**  shadow casting the tiles only seen in one range aren't a ring.
+**
+**  @param changes  Sight ranges to change.
+*/
+static void ChangeSightRanges(const std::vector<SightRangeChange> &changes)
+{
+	for (const SightRangeChange &change : changes) {
+		change.Unit->CurrentSightRange = change.NewRange;
+		MapMarkUnitSight(*change.Unit);
+	}
+	for (const SightRangeChange &change : changes) {
+		change.Unit->CurrentSightRange = change.OldRange;
+		MapUnmarkUnitSight(*change.Unit);
+		change.Unit->CurrentSightRange = change.NewRange;
+	}
+}
+
 /**
 **  Apply the modifiers of an upgrade.
 **
@@ -478,11 +579,14 @@ static void ApplyUpgradeModifier(CPlayer &player, const CUpgradeModifier &um)
 {
 	int pn = player.Index;
 
-	for (int z = 0; z < UpgradeMax; ++z) {
+	player.AvailabilityChanged();
+
+	for (int z : um.ChangedUpgrades) {
 		// allow/forbid upgrades for player.  only if upgrade is not acquired
 
 		// FIXME: check if modify is allowed
 
+		const char oldAllow = player.Allow.Upgrades[z];
 		if (player.Allow.Upgrades[z] != 'R') {
 			if (um.ChangeUpgrades[z] == 'A') {
 				player.Allow.Upgrades[z] = 'A';
@@ -495,131 +599,127 @@ static void ApplyUpgradeModifier(CPlayer &player, const CUpgradeModifier &um)
 				player.Allow.Upgrades[z] = 'R';
 			}
 		}
+		if (player.Allow.Upgrades[z] != oldAllow) {
+			UpdateUpgradeAvailability(player, z);
+		}
 	}
 
-	for (size_t z = 0; z < getUnitTypes().size(); ++z) {
-		CUnitStats &stat = getUnitTypes()[z]->Stats[pn];
+	for (int z : um.ChangedUnitTypes) {
 		// add/remove allowed units
 
 		// FIXME: check if modify is allowed
 
 		player.Allow.Units[z] += um.ChangeUnits[z];
+		UpdateUnitTypeAvailability(player, z);
+	}
 
-		Assert(um.ApplyTo[z] == '?' || um.ApplyTo[z] == 'X');
+	// If Sight range is upgraded, we need to change EVERY unit
+	// to the new range, otherwise the counters get confused.
+	if (um.Modifier.Variables[SIGHTRANGE_INDEX].Value) {
+		std::vector<SightRangeChange> changes;
 
-		// this modifier should be applied to unittype id == z
-		if (um.ApplyTo[z] == 'X') {
+		for (int z : um.ApplyToTypes) {
+			const CUnitStats &stat = getUnitTypes()[z]->Stats[pn];
+			AddSightRangeChanges(changes, player, *getUnitTypes()[z],
+			                     stat.Variables[SIGHTRANGE_INDEX].Max
+			                     + um.Modifier.Variables[SIGHTRANGE_INDEX].Value);
+		}
+		ChangeSightRanges(changes);
+	}
 
-			// If Sight range is upgraded, we need to change EVERY unit
-			// to the new range, otherwise the counters get confused.
-			if (um.Modifier.Variables[SIGHTRANGE_INDEX].Value) {
-				std::vector<CUnit *> unitupgrade = FindUnitsByType(*getUnitTypes()[z]);
+	// this modifier should be applied to these unit types
+	for (int z : um.ApplyToTypes) {
+		CUnitType &type = *getUnitTypes()[z];
+		CUnitStats &stat = type.Stats[pn];
 
-				for (CUnit *unit : unitupgrade) {
-					if (unit->Player->Index == pn && !unit->Removed) {
-						MapUnmarkUnitSight(*unit);
-						unit->CurrentSightRange = stat.Variables[SIGHTRANGE_INDEX].Max
-						                        + um.Modifier.Variables[SIGHTRANGE_INDEX].Value;
-						MapMarkUnitSight(*unit);
-					}
+		// if a unit type's supply is changed, we need to update the player's supply accordingly
+		if (um.Modifier.Variables[SUPPLY_INDEX].Value) {
+			for (const CUnit *unit : player.GetUnitsOfType(type)) {
+				if (!unit->IsUnusable()) {
+					player.Supply += um.Modifier.Variables[SUPPLY_INDEX].Value;
 				}
 			}
+		}
 
-			// if a unit type's supply is changed, we need to update the player's supply accordingly
-			if (um.Modifier.Variables[SUPPLY_INDEX].Value) {
-				std::vector<CUnit *> unitupgrade = FindUnitsByType(*getUnitTypes()[z]);
-
-				for (CUnit *unit : unitupgrade) {
-					if (unit->Player->Index == pn && unit->IsAlive()) {
-						unit->Player->Supply += um.Modifier.Variables[SUPPLY_INDEX].Value;
-					}
+		// if a unit type's demand is changed, we need to update the player's demand accordingly
+		if (um.Modifier.Variables[DEMAND_INDEX].Value) {
+			for (const CUnit *unit : player.GetUnitsOfType(type)) {
+				if (!unit->IsUnusable()) {
+					player.Demand += um.Modifier.Variables[DEMAND_INDEX].Value;
 				}
 			}
+		}
 
-			// if a unit type's demand is changed, we need to update the player's demand accordingly
-			if (um.Modifier.Variables[DEMAND_INDEX].Value) {
-				std::vector<CUnit *> unitupgrade = FindUnitsByType(*getUnitTypes()[z]);
-
-				for (CUnit *unit : unitupgrade) {
-					if (unit->Player->Index == pn && unit->IsAlive()) {
-						unit->Player->Demand += um.Modifier.Variables[DEMAND_INDEX].Value;
-					}
+		// upgrade costs :)
+		for (unsigned int j = 0; j < MaxCosts; ++j) {
+			stat.Costs[j] += um.Modifier.Costs[j];
+			stat.Storing[j] += um.Modifier.Storing[j];
+			if (um.Modifier.ImproveIncomes[j]) {
+				if (!stat.ImproveIncomes[j]) {
+					stat.ImproveIncomes[j] += DefaultIncomes[j] + um.Modifier.ImproveIncomes[j];
+				} else {
+					stat.ImproveIncomes[j] += um.Modifier.ImproveIncomes[j];
 				}
-			}
-
-			// upgrade costs :)
-			for (unsigned int j = 0; j < MaxCosts; ++j) {
-				stat.Costs[j] += um.Modifier.Costs[j];
-				stat.Storing[j] += um.Modifier.Storing[j];
-				if (um.Modifier.ImproveIncomes[j]) {
-					if (!stat.ImproveIncomes[j]) {
-						stat.ImproveIncomes[j] += DefaultIncomes[j] + um.Modifier.ImproveIncomes[j];
-					} else {
-						stat.ImproveIncomes[j] += um.Modifier.ImproveIncomes[j];
-					}
-					//update player's income
-					std::vector<CUnit *> unitupgrade = FindUnitsByType(*getUnitTypes()[z]);
-					if (unitupgrade.size() > 0) {
-						player.Incomes[j] = std::max(player.Incomes[j], stat.ImproveIncomes[j]);
-					}
+				//update player's income
+				const auto &units = player.GetUnitsOfType(type);
+				if (ranges::any_of(units, [](const CUnit *unit) { return !unit->IsUnusable(); })) {
+					player.Incomes[j] = std::max(player.Incomes[j], stat.ImproveIncomes[j]);
 				}
 			}
+		}
 
-			bool varModified = false;
-			for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
-				varModified |= (um.Modifier.Variables[j].Value != 0)
-							   | (um.Modifier.Variables[j].Max != 0)
-							   | (um.Modifier.Variables[j].Increase != 0)
-							   | (um.Modifier.Variables[j].IncreaseFrequency != 0)
-							   | um.Modifier.Variables[j].Enable
-							   | (um.ModifyPercent[j] != 0);
-				stat.Variables[j].Enable |= um.Modifier.Variables[j].Enable;
-				if (um.ModifyPercent[j]) {
-					stat.Variables[j].Value += stat.Variables[j].Value * um.ModifyPercent[j] / 100;
-					stat.Variables[j].Max += stat.Variables[j].Max * um.ModifyPercent[j] / 100;
-				} else {
-					stat.Variables[j].Value += um.Modifier.Variables[j].Value;
-					stat.Variables[j].Max += um.Modifier.Variables[j].Max;
-					stat.Variables[j].Increase += um.Modifier.Variables[j].Increase;
-					stat.Variables[j].IncreaseFrequency += um.Modifier.Variables[j].IncreaseFrequency;
-				}
-
-				stat.Variables[j].Max = std::max(stat.Variables[j].Max, 0);
-				clamp(&stat.Variables[j].Value, 0, stat.Variables[j].Max);
+		bool varModified = false;
+		for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
+			varModified |= (um.Modifier.Variables[j].Value != 0)
+						   | (um.Modifier.Variables[j].Max != 0)
+						   | (um.Modifier.Variables[j].Increase != 0)
+						   | (um.Modifier.Variables[j].IncreaseFrequency != 0)
+						   | um.Modifier.Variables[j].Enable
+						   | (um.ModifyPercent[j] != 0);
+			stat.Variables[j].Enable |= um.Modifier.Variables[j].Enable;
+			if (um.ModifyPercent[j]) {
+				stat.Variables[j].Value += stat.Variables[j].Value * um.ModifyPercent[j] / 100;
+				stat.Variables[j].Max += stat.Variables[j].Max * um.ModifyPercent[j] / 100;
+			} else {
+				stat.Variables[j].Value += um.Modifier.Variables[j].Value;
+				stat.Variables[j].Max += um.Modifier.Variables[j].Max;
+				stat.Variables[j].Increase += um.Modifier.Variables[j].Increase;
+				stat.Variables[j].IncreaseFrequency += um.Modifier.Variables[j].IncreaseFrequency;
 			}
 
-			// And now modify ingame units
-			if (varModified) {
-				std::vector<CUnit *> unitupgrade = FindUnitsByType(*getUnitTypes()[z], true);
+			stat.Variables[j].Max = std::max(stat.Variables[j].Max, 0);
+			clamp(&stat.Variables[j].Value, 0, stat.Variables[j].Max);
+		}
 
-				for (CUnit *unitPtr : unitupgrade) {
-					CUnit &unit = *unitPtr;
+		// And now modify ingame units
+		if (varModified) {
+			for (CUnit *unitPtr : player.GetUnitsOfType(type)) {
+				CUnit &unit = *unitPtr;
 
-					if (unit.Player->Index != player.Index) {
-						continue;
+				if (unit.IsUnusable(true)) {
+					continue;
+				}
+				for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
+					unit.Variable[j].Enable |= um.Modifier.Variables[j].Enable;
+					if (um.ModifyPercent[j]) {
+						unit.Variable[j].Value += unit.Variable[j].Value * um.ModifyPercent[j] / 100;
+						unit.Variable[j].Max += unit.Variable[j].Max * um.ModifyPercent[j] / 100;
+					} else {
+						unit.Variable[j].Value += um.Modifier.Variables[j].Value;
+						unit.Variable[j].Increase += um.Modifier.Variables[j].Increase;
+						unit.Variable[j].IncreaseFrequency += um.Modifier.Variables[j].IncreaseFrequency;
 					}
-					for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
-						unit.Variable[j].Enable |= um.Modifier.Variables[j].Enable;
-						if (um.ModifyPercent[j]) {
-							unit.Variable[j].Value += unit.Variable[j].Value * um.ModifyPercent[j] / 100;
-							unit.Variable[j].Max += unit.Variable[j].Max * um.ModifyPercent[j] / 100;
-						} else {
-							unit.Variable[j].Value += um.Modifier.Variables[j].Value;
-							unit.Variable[j].Increase += um.Modifier.Variables[j].Increase;
-							unit.Variable[j].IncreaseFrequency += um.Modifier.Variables[j].IncreaseFrequency;
-						}
 
-						unit.Variable[j].Max += um.Modifier.Variables[j].Max;
-						unit.Variable[j].Max = std::max(unit.Variable[j].Max, 0);
-						if (unit.Variable[j].Max > 0) {
-							clamp(&unit.Variable[j].Value, 0, unit.Variable[j].Max);
-						}
+					unit.Variable[j].Max += um.Modifier.Variables[j].Max;
+					unit.Variable[j].Max = std::max(unit.Variable[j].Max, 0);
+					if (unit.Variable[j].Max > 0) {
+						clamp(&unit.Variable[j].Value, 0, unit.Variable[j].Max);
 					}
 				}
 			}
-			if (um.ConvertTo) {
-				ConvertUnitTypeTo(player, *getUnitTypes()[z], *um.ConvertTo);
-			}
+		}
+		if (um.ConvertTo) {
+			ConvertUnitTypeTo(player, type, *um.ConvertTo);
 		}
 	}
 }
@@ -637,15 +737,18 @@ static void RemoveUpgradeModifier(CPlayer &player, const CUpgradeModifier &um)
 {
 	int pn = player.Index;
 
+	player.AvailabilityChanged();
+
 	if (um.SpeedResearch != 0) {
 		player.SpeedResearch -= um.SpeedResearch;
 	}
 
-	for (int z = 0; z < UpgradeMax; ++z) {
+	for (int z : um.ChangedUpgrades) {
 		// allow/forbid upgrades for player.  only if upgrade is not acquired
 
 		// FIXME: check if modify is allowed
 
+		const char oldAllow = player.Allow.Upgrades[z];
 		if (player.Allow.Upgrades[z] != 'R') {
 			if (um.ChangeUpgrades[z] == 'A') {
 				player.Allow.Upgrades[z] = 'F';
@@ -658,125 +761,121 @@ static void RemoveUpgradeModifier(CPlayer &player, const CUpgradeModifier &um)
 				player.Allow.Upgrades[z] = 'A';
 			}
 		}
+		if (player.Allow.Upgrades[z] != oldAllow) {
+			UpdateUpgradeAvailability(player, z);
+		}
 	}
 
-	for (size_t z = 0; z < getUnitTypes().size(); ++z) {
-		CUnitStats &stat = getUnitTypes()[z]->Stats[pn];
+	for (int z : um.ChangedUnitTypes) {
 		// add/remove allowed units
 
 		// FIXME: check if modify is allowed
 
 		player.Allow.Units[z] -= um.ChangeUnits[z];
+		UpdateUnitTypeAvailability(player, z);
+	}
 
-		Assert(um.ApplyTo[z] == '?' || um.ApplyTo[z] == 'X');
-
-		// this modifier should be applied to unittype id == z
-		if (um.ApplyTo[z] == 'X') {
-
-			// If Sight range is upgraded, we need to change EVERY unit
-			// to the new range, otherwise the counters get confused.
-			if (um.Modifier.Variables[SIGHTRANGE_INDEX].Value) {
-				std::vector<CUnit *> unitupgrade = FindUnitsByType(*getUnitTypes()[z]);
+	// If Sight range is upgraded, we need to change EVERY unit
+	// to the new range, otherwise the counters get confused.
+	if (um.Modifier.Variables[SIGHTRANGE_INDEX].Value) {
+		std::vector<SightRangeChange> changes;
 
-				for (CUnit *unit : unitupgrade) {
-					if (unit->Player->Index == pn && !unit->Removed) {
-						MapUnmarkUnitSight(*unit);
-						unit->CurrentSightRange = stat.Variables[SIGHTRANGE_INDEX].Max
-						                        - um.Modifier.Variables[SIGHTRANGE_INDEX].Value;
-						MapMarkUnitSight(*unit);
-					}
-				}
-			}
+		for (int z : um.ApplyToTypes) {
+			const CUnitStats &stat = getUnitTypes()[z]->Stats[pn];
+			AddSightRangeChanges(changes, player, *getUnitTypes()[z],
+			                     stat.Variables[SIGHTRANGE_INDEX].Max
+			                     - um.Modifier.Variables[SIGHTRANGE_INDEX].Value);
+		}
+		ChangeSightRanges(changes);
+	}
 
-			// if a unit type's supply is changed, we need to update the player's supply accordingly
-			if (um.Modifier.Variables[SUPPLY_INDEX].Value) {
-				std::vector<CUnit *> unitupgrade = FindUnitsByType(*getUnitTypes()[z]);
+	// this modifier should be applied to these unit types
+	for (int z : um.ApplyToTypes) {
+		CUnitType &type = *getUnitTypes()[z];
+		CUnitStats &stat = type.Stats[pn];
 
-				for (CUnit *unit : unitupgrade) {
-					if (unit->Player->Index == pn && unit->IsAlive()) {
-						unit->Player->Supply -= um.Modifier.Variables[SUPPLY_INDEX].Value;
-					}
+		// if a unit type's supply is changed, we need to update the player's supply accordingly
+		if (um.Modifier.Variables[SUPPLY_INDEX].Value) {
+			for (const CUnit *unit : player.GetUnitsOfType(type)) {
+				if (!unit->IsUnusable()) {
+					player.Supply -= um.Modifier.Variables[SUPPLY_INDEX].Value;
 				}
 			}
+		}
 
-			// if a unit type's demand is changed, we need to update the player's demand accordingly
-			if (um.Modifier.Variables[DEMAND_INDEX].Value) {
-				std::vector<CUnit *> unitupgrade = FindUnitsByType(*getUnitTypes()[z]);
-
-				for (CUnit *unit : unitupgrade) {
-					if (unit->Player->Index == pn && unit->IsAlive()) {
-						unit->Player->Demand -= um.Modifier.Variables[DEMAND_INDEX].Value;
-					}
+		// if a unit type's demand is changed, we need to update the player's demand accordingly
+		if (um.Modifier.Variables[DEMAND_INDEX].Value) {
+			for (const CUnit *unit : player.GetUnitsOfType(type)) {
+				if (!unit->IsUnusable()) {
+					player.Demand -= um.Modifier.Variables[DEMAND_INDEX].Value;
 				}
 			}
+		}
 
-			// upgrade costs :)
-			for (unsigned int j = 0; j < MaxCosts; ++j) {
-				stat.Costs[j] -= um.Modifier.Costs[j];
-				stat.Storing[j] -= um.Modifier.Storing[j];
-				stat.ImproveIncomes[j] -= um.Modifier.ImproveIncomes[j];
-				//if this was the highest improve income, search for another
-				if (player.Incomes[j] && (stat.ImproveIncomes[j] + um.Modifier.ImproveIncomes[j]) == player.Incomes[j]) {
-					int m = DefaultIncomes[j];
-
-					for (const CUnit* unit : player.GetUnits()) {
-						m = std::max(m, unit->Type->Stats[player.Index].ImproveIncomes[j]);
-					}
-					player.Incomes[j] = m;
+		// upgrade costs :)
+		for (unsigned int j = 0; j < MaxCosts; ++j) {
+			stat.Costs[j] -= um.Modifier.Costs[j];
+			stat.Storing[j] -= um.Modifier.Storing[j];
+			stat.ImproveIncomes[j] -= um.Modifier.ImproveIncomes[j];
+			//if this was the highest improve income, search for another
+			if (player.Incomes[j] && (stat.ImproveIncomes[j] + um.Modifier.ImproveIncomes[j]) == player.Incomes[j]) {
+				int m = DefaultIncomes[j];
+
+				for (const CUnit* unit : player.GetUnits()) {
+					m = std::max(m, unit->Type->Stats[player.Index].ImproveIncomes[j]);
 				}
+				player.Incomes[j] = m;
 			}
+		}
 
-			bool varModified = false;
-			for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
-				varModified |= (um.Modifier.Variables[j].Value != 0)
-					| (um.Modifier.Variables[j].Max != 0)
-					| (um.Modifier.Variables[j].Increase != 0)
-					| um.Modifier.Variables[j].Enable
-					| (um.ModifyPercent[j] != 0);
-				stat.Variables[j].Enable |= um.Modifier.Variables[j].Enable;
-				if (um.ModifyPercent[j]) {
-					stat.Variables[j].Value = stat.Variables[j].Value * 100 / (100 + um.ModifyPercent[j]);
-					stat.Variables[j].Max = stat.Variables[j].Max * 100 / (100 + um.ModifyPercent[j]);
-				} else {
-					stat.Variables[j].Value -= um.Modifier.Variables[j].Value;
-					stat.Variables[j].Max -= um.Modifier.Variables[j].Max;
-					stat.Variables[j].Increase -= um.Modifier.Variables[j].Increase;
-				}
-
-				stat.Variables[j].Max = std::max(stat.Variables[j].Max, 0);
-				clamp(&stat.Variables[j].Value, 0, stat.Variables[j].Max);
+		bool varModified = false;
+		for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
+			varModified |= (um.Modifier.Variables[j].Value != 0)
+				| (um.Modifier.Variables[j].Max != 0)
+				| (um.Modifier.Variables[j].Increase != 0)
+				| um.Modifier.Variables[j].Enable
+				| (um.ModifyPercent[j] != 0);
+			stat.Variables[j].Enable |= um.Modifier.Variables[j].Enable;
+			if (um.ModifyPercent[j]) {
+				stat.Variables[j].Value = stat.Variables[j].Value * 100 / (100 + um.ModifyPercent[j]);
+				stat.Variables[j].Max = stat.Variables[j].Max * 100 / (100 + um.ModifyPercent[j]);
+			} else {
+				stat.Variables[j].Value -= um.Modifier.Variables[j].Value;
+				stat.Variables[j].Max -= um.Modifier.Variables[j].Max;
+				stat.Variables[j].Increase -= um.Modifier.Variables[j].Increase;
 			}
 
-			// And now modify ingame units
-			if (varModified) {
-				std::vector<CUnit *> unitupgrade = FindUnitsByType(*getUnitTypes()[z], true);
+			stat.Variables[j].Max = std::max(stat.Variables[j].Max, 0);
+			clamp(&stat.Variables[j].Value, 0, stat.Variables[j].Max);
+		}
 
-				for (CUnit *unitPtr : unitupgrade) {
-					CUnit &unit = *unitPtr;
+		// And now modify ingame units
+		if (varModified) {
+			for (CUnit *unitPtr : player.GetUnitsOfType(type)) {
+				CUnit &unit = *unitPtr;
 
-					if (unit.Player->Index != player.Index) {
-						continue;
+				if (unit.IsUnusable(true)) {
+					continue;
+				}
+				for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
+					unit.Variable[j].Enable |= um.Modifier.Variables[j].Enable;
+					if (um.ModifyPercent[j]) {
+						unit.Variable[j].Value = unit.Variable[j].Value * 100 / (100 + um.ModifyPercent[j]);
+						unit.Variable[j].Max = unit.Variable[j].Max * 100 / (100 + um.ModifyPercent[j]);
+					} else {
+						unit.Variable[j].Value -= um.Modifier.Variables[j].Value;
+						unit.Variable[j].Increase -= um.Modifier.Variables[j].Increase;
 					}
-					for (unsigned int j = 0; j < UnitTypeVar.GetNumberVariable(); j++) {
-						unit.Variable[j].Enable |= um.Modifier.Variables[j].Enable;
-						if (um.ModifyPercent[j]) {
-							unit.Variable[j].Value = unit.Variable[j].Value * 100 / (100 + um.ModifyPercent[j]);
-							unit.Variable[j].Max = unit.Variable[j].Max * 100 / (100 + um.ModifyPercent[j]);
-						} else {
-							unit.Variable[j].Value -= um.Modifier.Variables[j].Value;
-							unit.Variable[j].Increase -= um.Modifier.Variables[j].Increase;
-						}
 
-						unit.Variable[j].Max -= um.Modifier.Variables[j].Max;
-						unit.Variable[j].Max = std::max(unit.Variable[j].Max, 0);
+					unit.Variable[j].Max -= um.Modifier.Variables[j].Max;
+					unit.Variable[j].Max = std::max(unit.Variable[j].Max, 0);
 
-						clamp(&unit.Variable[j].Value, 0, unit.Variable[j].Max);
-					}
+					clamp(&unit.Variable[j].Value, 0, unit.Variable[j].Max);
 				}
 			}
-			if (um.ConvertTo) {
-				ConvertUnitTypeTo(player, *um.ConvertTo, *getUnitTypes()[z]);
-			}
+		}
+		if (um.ConvertTo) {
+			ConvertUnitTypeTo(player, *um.ConvertTo, type);
 		}
 	}
 }
@@ -885,6 +984,7 @@ void UpgradeAcquire(CPlayer &player, const CUpgrade *upgrade)
 void UpgradeLost(CPlayer &player, int id)
 {
 	player.UpgradeTimers.Upgrades[id] = 0;
+	player.AvailabilityChanged();
 
 	for (int z = 0; z < NumUpgradeModifiers; ++z) {
 		if (UpgradeModifiers[z]->UpgradeId == id) {
@@ -932,6 +1032,7 @@ void IndividualUpgradeAcquire(CUnit &unit, const CUpgrade *upgrade)
 	int id = upgrade->ID;
 	unit.Player->UpgradeTimers.Upgrades[id] = upgrade->Costs[TimeCost];
 	unit.IndividualUpgrades[id] = true;
+	unit.Player->AvailabilityChanged();
 
 	for (int z = 0; z < NumUpgradeModifiers; ++z) {
 		if (UpgradeModifiers[z]->UpgradeId == id) {
@@ -952,6 +1053,7 @@ void IndividualUpgradeLost(CUnit &unit, const CUpgrade *upgrade)
 	int id = upgrade->ID;
 	unit.Player->UpgradeTimers.Upgrades[id] = 0;
 	unit.IndividualUpgrades[id] = false;
+	unit.Player->AvailabilityChanged();
 
 	for (int z = 0; z < NumUpgradeModifiers; ++z) {
 		if (UpgradeModifiers[z]->UpgradeId == id) {
@@ -983,6 +1085,8 @@ void IndividualUpgradeLost(CUnit &unit, const CUpgrade *upgrade)
 static void AllowUnitId(CPlayer &player, int id, int units)
 {
 	player.Allow.Units[id] = units;
+	player.AvailabilityChanged();
+	UpdateUnitTypeAvailability(player, id);
 }
 
 /**
@@ -996,6 +1100,8 @@ void AllowUpgradeId(CPlayer &player, int id, char af)
 {
 	Assert(af == 'A' || af == 'F' || af == 'R');
 	player.Allow.Upgrades[id] = af;
+	player.AvailabilityChanged();
+	UpdateUpgradeAvailability(player, id);
 }
 
 /**
@@ -41,7 +41,10 @@
 #include "video.h"
 
 #include <guisan/sdl/sdlinput.hpp>
+#include <functional>
+#include <list>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
 /*----------------------------------------------------------------------------
@@ -64,6 +67,114 @@ static std::string DefaultReverseColorIndex; /// Default reverse color index
 static CFont *SmallFont;  /// Small font used in stats
 static CFont *GameFont;   /// Normal font used in game
 
+/// Glyphs of a font pre-rendered in one color, in the screen pixel format
+struct GlyphAtlas
+{
+	const SDL_Surface *Source = nullptr;                /// Font graphic the atlas was built from
+	std::array<SDL_Color, MaxFontColors> Colors{};      /// Font colors the atlas was built with
+	sdl2::SurfacePtr Surface;                           /// Converted glyphs
+};
+
+using GlyphAtlasMap = std::map<std::pair<const CFont *, const CFontColor *>, GlyphAtlas>;
+static GlyphAtlasMap GlyphAtlases;  /// Glyph atlases by font and color
+
+/// Laid out string: width and, once drawn repeatedly, the rendered glyph run
+struct CachedText
+{
+	const CFont *Font = nullptr;
+	const CFontColor *Color = nullptr;     /// Color the text starts with
+	const CFontColor *Reverse = nullptr;   /// Reverse color of the label
+	std::string Text;
+	int Width = 0;
+	int Uses = 0;                          /// Number of draws since the entry was created
+	const CFontColor *LastColor = nullptr; /// LastTextColor after drawing, if the text sets it
+	sdl2::SurfacePtr Surface;              /// Rendered glyph run
+
+	bool Matches(const CFont *font, const CFontColor *color, const CFontColor *reverse, std::string_view text) const
+	{
+		return Font == font && Color == color && Reverse == reverse && Text == text;
+	}
+};
+
+/**
+**  Least recently used cache of laid out strings.
+*/
+template <typename T>
+class CTextCache
+{
+public:
+	explicit CTextCache(size_t capacity) : Capacity(capacity) {}
+
+	/**
+	**  Find a cached entry and mark it as most recently used.
+	**
+	**  @param hash     Hash of the entry.
+	**  @param matches  Predicate to tell hash collisions apart.
+	**
+	**  @return         The cached entry or nullptr if not found.
+	*/
+	template <typename Pred>
+	T *Find(size_t hash, Pred matches)
+	{
+		auto it = Index.find(hash);
+		if (it == Index.end() || !matches(it->second->second)) {
+			return nullptr;
+		}
+		Entries.splice(Entries.begin(), Entries, it->second);
+		return &it->second->second;
+	}
+
+	/**
+	**  Add an entry, evicting the least recently used one if the cache is full.
+	**
+	**  @param hash   Hash of the entry.
+	**  @param value  Entry to add, replaces any entry with the same hash.
+	**
+	**  @return       The cached entry.
+	*/
+	T &Insert(size_t hash, T &&value)
+	{
+		auto it = Index.find(hash);
+		if (it != Index.end()) {
+			Entries.erase(it->second);
+			Index.erase(it);
+		}
+		if (Entries.size() >= Capacity) {
+			Index.erase(Entries.back().first);
+			Entries.pop_back();
+		}
+		Entries.emplace_front(hash, std::move(value));
+		Index[hash] = Entries.begin();
+		return Entries.front().second;
+	}
+
+	void Clear()
+	{
+		Index.clear();
+		Entries.clear();
+	}
+
+private:
+	size_t Capacity;
+	std::list<std::pair<size_t, T>> Entries;
+	std::unordered_map<size_t, typename std::list<std::pair<size_t, T>>::iterator> Index;
+};
+
+static CTextCache<CachedText> TextCache(512);      /// Laid out strings drawn by CLabel
+static CTextCache<CachedText> TextWidthCache(512); /// Widths measured by CFont::Width
+
+/// A string needs to be drawn this many times before its glyph run is cached
+static constexpr int TEXT_CACHE_MIN_USES = 2;
+
+static size_t HashText(const CFont *font, const CFontColor *color, const CFontColor *reverse, std::string_view text)
+{
+	size_t hash = std::hash<std::string_view>{}(text);
+	for (const void *ptr : {(const void *)font, (const void *)color, (const void *)reverse}) {
+		hash ^= std::hash<const void *>{}(ptr) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	}
+	return hash;
+}
+
 /**
 **	@brief	Format a number using commas
 **
@@ -173,13 +284,57 @@ void CFont::drawString(
 **  @param x   X screen position
 **  @param y   Y screen position
 */
-static void VideoDrawChar(const CGraphic &g,
-						  int gx, int gy, int w, int h, int x, int y, const CFontColor &fc)
+static void VideoDrawChar(SDL_Surface *atlas,
+						  int gx, int gy, int w, int h, int x, int y, SDL_Surface *target)
 {
 	SDL_Rect srect = {Sint16(gx), Sint16(gy), Uint16(w), Uint16(h)};
 	SDL_Rect drect = {Sint16(x), Sint16(y), 0, 0};
-	SDL_SetPaletteColors(g.getSurface()->format->palette, fc.Colors.data(), 0, fc.Colors.size());
-	SDL_BlitSurface(g.getSurface(), &srect, TheScreen, &drect);
+	SDL_BlitSurface(atlas, &srect, target, &drect);
+}
+
+/**
+**  Get the glyphs of a font rendered with a font color.
+**
+**  The 8 bit font graphic is converted once per color into the screen
+**  format, so drawing a glyph needs neither a palette change nor a
+**  converting blit.
+**
+**  @param font  Font to get the glyphs of
+**  @param g     Graphic of the font
+**  @param fc    Font color
+**
+**  @return      Surface with all glyphs of the font in the given color
+*/
+static SDL_Surface *GetGlyphAtlas(const CFont &font, const CGraphic &g, const CFontColor &fc)
+{
+	GlyphAtlas &atlas = GlyphAtlases[{&font, &fc}];
+	SDL_Surface *source = g.getSurface();
+
+	if (atlas.Surface && atlas.Source == source
+		&& !memcmp(atlas.Colors.data(), fc.Colors.data(), sizeof(SDL_Color) * fc.Colors.size())) {
+		return atlas.Surface.get();
+	}
+	SDL_SetPaletteColors(source->format->palette, fc.Colors.data(), 0, fc.Colors.size());
+	atlas.Surface.reset(SDL_ConvertSurfaceFormat(source, SDL_MasksToPixelFormatEnum(32, RMASK, GMASK, BMASK, AMASK), 0));
+	if (!atlas.Surface) {
+		ErrorPrint("Can't create glyph atlas for font color '%s': %s\n", fc.Ident.c_str(), SDL_GetError());
+		ExitFatal(-1);
+	}
+	SDL_SetSurfaceBlendMode(atlas.Surface.get(), SDL_BLENDMODE_BLEND);
+	SDL_SetSurfaceRLE(atlas.Surface.get(), 1);
+	atlas.Source = source;
+	atlas.Colors = fc.Colors;
+	return atlas.Surface.get();
+}
+
+/**
+**  Forget all glyph atlases and laid out strings.
+*/
+static void ClearFontCaches()
+{
+	GlyphAtlases.clear();
+	TextCache.Clear();
+	TextWidthCache.Clear();
 }
 
 /**
@@ -465,13 +620,22 @@ int CFont::Width(const int number) const
 */
 int CFont::Width(std::string_view text) const
 {
+	DynamicLoad();
+
+	const size_t hash = HashText(this, nullptr, nullptr, text);
+	const CachedText *cached = TextWidthCache.Find(hash, [&](const CachedText &entry) {
+		return entry.Matches(this, nullptr, nullptr, text);
+	});
+	if (cached) {
+		return cached->Width;
+	}
+
 	int width = 0;
 	bool isformat = false;
 	int utf8;
 	size_t pos = 0;
 	size_t subpos = 0;
 
-	DynamicLoad();
 	while ((utf8 = CodepageIndexFromUTF8(text, pos, subpos))) {
 		if (utf8 == '~' && !subpos) {
 			if (text[pos] == '|') {
@@ -500,6 +664,11 @@ int CFont::Width(std::string_view text) const
 			width += this->CharWidth[utf8 - 32] + 1;
 		}
 	}
+	CachedText entry;
+	entry.Font = this;
+	entry.Text = text;
+	entry.Width = width;
+	TextWidthCache.Insert(hash, std::move(entry));
 	return width;
 }
 
@@ -543,19 +712,19 @@ int GetHotKey(const std::string &text)
 **  @param x   X screen position
 **  @param y   Y screen position
 */
-static void VideoDrawCharClip(const CGraphic &g, int gx, int gy, int w, int h,
-							  int x, int y, const CFontColor &fc)
+static void VideoDrawCharClip(SDL_Surface *atlas, int gx, int gy, int w, int h,
+							  int x, int y, SDL_Surface *target)
 {
 	int ox;
 	int oy;
 	[[maybe_unused]]int ex;
 	CLIP_RECTANGLE_OFS(x, y, w, h, ox, oy, ex);
-	VideoDrawChar(g, gx + ox, gy + oy, w, h, x, y, fc);
+	VideoDrawChar(atlas, gx + ox, gy + oy, w, h, x, y, target);
 }
 
 
 template<bool CLIP>
-unsigned int CFont::DrawChar(CGraphic &g, int utf8, int x, int y, const CFontColor &fc) const
+unsigned int CFont::DrawChar(SDL_Surface *target, int utf8, int x, int y, const CFontColor &fc) const
 {
 	int c = utf8 - 32;
 	Assert(c >= 0);
@@ -568,10 +737,11 @@ unsigned int CFont::DrawChar(CGraphic &g, int utf8, int x, int y, const CFontCol
 	const int gx = (c % ipr) * this->G->Width;
 	const int gy = (c / ipr) * this->G->Height;
 
+	SDL_Surface *atlas = GetGlyphAtlas(*this, *this->G, fc);
 	if (CLIP) {
-		VideoDrawCharClip(g, gx, gy, w, this->G->Height, x , y, fc);
+		VideoDrawCharClip(atlas, gx, gy, w, this->G->Height, x , y, target);
 	} else {
-		VideoDrawChar(g, gx, gy, w, this->G->Height, x, y, fc);
+		VideoDrawChar(atlas, gx, gy, w, this->G->Height, x, y, target);
 	}
 	return w + 1;
 }
@@ -582,7 +752,7 @@ std::shared_ptr<CGraphic> CFont::GetGraphic() const
 }
 
 /**
-**  Draw text with font at x,y clipped/unclipped.
+**  Lay out text, handling the format characters.
 **
 **  ~    is special prefix.
 **  ~~   is the ~ character self.
@@ -590,16 +760,19 @@ std::shared_ptr<CGraphic> CFont::GetGraphic() const
 **  ~<   start reverse.
 **  ~>   switch back to last used color.
 **
-**  @param x     X screen position
-**  @param y     Y screen position
-**  @param font  Font number
-**  @param text  Text to be displayed.
-**  @param clip  Flag if TRUE clip, otherwise not.
+**  @param font       Font of the text.
+**  @param text       Text to be laid out.
+**  @param fc         Color the text starts with.
+**  @param reverse    Reverse color.
+**  @param ok         Set to false if the text is badly formatted.
+**  @param drawGlyph  Called for each glyph with its codepage index, x offset and color,
+**                    returns the advance of the glyph.
 **
-**  @return      The length of the printed text.
+**  @return      The length of the laid out text.
 */
-template <const bool CLIP>
-int CLabel::DoDrawText(int x, int y, std::string_view text, const CFontColor *fc) const
+template <typename F>
+static int LayoutText(const CFont &font, std::string_view text, const CFontColor *fc,
+					  const CFontColor *reverse, bool &ok, F drawGlyph)
 {
 	int widths = 0;
 	const int tabSize = 4; // FIXME: will be removed when text system will be rewritten
@@ -607,9 +780,8 @@ int CLabel::DoDrawText(int x, int y, std::string_view text, const CFontColor *fc
 	size_t subpos = 0;
 	const CFontColor *backup = fc;
 	bool isColor = false;
-	font->DynamicLoad();
-	auto g = font->GetGraphic();
 
+	ok = true;
 	while (int utf8 = CodepageIndexFromUTF8(text.data(), text.size(), pos, subpos)) {
 		bool tab = false;
 		if (utf8 == '\t') {
@@ -618,6 +790,7 @@ int CLabel::DoDrawText(int x, int y, std::string_view text, const CFontColor *fc
 			switch (text[pos]) {
 				case '\0':  // wrong formatted string.
 					ErrorPrint("oops, format your ~: for \"%s\"\n", text.data());
+					ok = false;
 					return widths;
 				case '~':
 					++pos;
@@ -649,6 +822,7 @@ int CLabel::DoDrawText(int x, int y, std::string_view text, const CFontColor *fc
 					auto end = text.find('~', pos);
 					if (end == std::string_view::npos) {
 						ErrorPrint("oops, format your ~ for \"%s\"\n", text.data());
+						ok = false;
 						return widths;
 					}
 					std::string_view color = text.substr(pos, end - pos);
@@ -665,10 +839,10 @@ int CLabel::DoDrawText(int x, int y, std::string_view text, const CFontColor *fc
 		}
 		if (tab) {
 			for (int tabs = 0; tabs < tabSize; ++tabs) {
-				widths += font->DrawChar<CLIP>(*g, ' ', x + widths, y, *fc);
+				widths += drawGlyph(' ', widths, *fc);
 			}
 		} else {
-			widths += font->DrawChar<CLIP>(*g, utf8, x + widths, y, *fc);
+			widths += drawGlyph(utf8, widths, *fc);
 		}
 
 		if (isColor == false && fc != backup) {
@@ -678,6 +852,104 @@ int CLabel::DoDrawText(int x, int y, std::string_view text, const CFontColor *fc
 	return widths;
 }
 
+/**
+**  Draw a cached glyph run clipped/unclipped.
+*/
+template <const bool CLIP>
+static void DrawTextRun(SDL_Surface *run, int x, int y)
+{
+	int w = run->w;
+	int h = run->h;
+	int ox = 0;
+	int oy = 0;
+	if (CLIP) {
+		[[maybe_unused]]int ex;
+		CLIP_RECTANGLE_OFS(x, y, w, h, ox, oy, ex);
+	}
+	SDL_Rect srect = {ox, oy, w, h};
+	SDL_Rect drect = {x, y, 0, 0};
+	SDL_BlitSurface(run, &srect, TheScreen, &drect);
+}
+
+/**
+**  Draw text with font at x,y clipped/unclipped.
+**
+**  Strings drawn repeatedly are rendered once into a glyph run which is
+**  then drawn with a single blit. Texts switching back to the last used
+**  color (~>) depend on the previous draws and are never cached.
+**
+**  @param x     X screen position
+**  @param y     Y screen position
+**  @param text  Text to be displayed.
+**  @param fc    Color the text starts with.
+**
+**  @return      The length of the printed text.
+*/
+template <const bool CLIP>
+int CLabel::DoDrawText(int x, int y, std::string_view text, const CFontColor *fc) const
+{
+	font->DynamicLoad();
+	auto g = font->GetGraphic();
+	const auto drawOnScreen = [&](int utf8, int offset, const CFontColor &color) {
+		return font->DrawChar<CLIP>(TheScreen, utf8, x + offset, y, color);
+	};
+	bool ok;
+
+	if (text.find("~>") != std::string_view::npos) {
+		return LayoutText(*font, text, fc, reverse, ok, drawOnScreen);
+	}
+
+	const size_t hash = HashText(font, fc, reverse, text);
+	CachedText *cached = TextCache.Find(hash, [&](const CachedText &entry) {
+		return entry.Matches(font, fc, reverse, text);
+	});
+	if (!cached) {
+		const CFontColor *lastTextColor = LastTextColor;
+		LastTextColor = nullptr;
+		const int width = LayoutText(*font, text, fc, reverse, ok, drawOnScreen);
+		const CFontColor *lastColor = LastTextColor;
+		LastTextColor = lastColor ? lastColor : lastTextColor;
+		if (ok) {
+			CachedText entry;
+			entry.Font = font;
+			entry.Color = fc;
+			entry.Reverse = reverse;
+			entry.Text = text;
+			entry.Width = width;
+			entry.Uses = 1;
+			entry.LastColor = lastColor;
+			TextCache.Insert(hash, std::move(entry));
+		}
+		return width;
+	}
+
+	if (!cached->Surface && ++cached->Uses >= TEXT_CACHE_MIN_USES && cached->Width > 0) {
+		// Render the glyph run once, it is drawn often enough
+		cached->Surface.reset(SDL_CreateRGBSurface(SDL_SWSURFACE, cached->Width, g->Height, 32,
+		                                           RMASK, GMASK, BMASK, AMASK));
+		if (cached->Surface) {
+			SDL_Surface *run = cached->Surface.get();
+			SDL_FillRect(run, nullptr, 0);
+			const CFontColor *lastTextColor = LastTextColor;
+			LayoutText(*font, text, fc, reverse, ok, [&](int utf8, int offset, const CFontColor &color) {
+				return font->DrawChar<false>(run, utf8, offset, 0, color);
+			});
+			LastTextColor = lastTextColor;
+			SDL_SetSurfaceBlendMode(run, SDL_BLENDMODE_BLEND);
+			SDL_SetSurfaceRLE(run, 1);
+		}
+	}
+	if (cached->Surface) {
+		DrawTextRun<CLIP>(cached->Surface.get(), x, y);
+	} else {
+		LayoutText(*font, text, fc, reverse, ok, drawOnScreen);
+	}
+	if (cached->LastColor) {
+		LastTextColor = cached->LastColor;
+	}
+	return cached->Width;
+}
+
 
 CLabel::CLabel(const CFont &f) :
 	normal(DefaultTextColor),
@@ -839,6 +1111,9 @@ void CFont::MeasureWidths()
 {
 	const int maxy = G->NumFrames;
 
+	TextWidthCache.Clear();
+	TextCache.Clear();
+
 	CharWidth.resize(maxy);
 	std::fill(std::begin(CharWidth), std::end(CharWidth), 0);
 	CharWidth[0] = G->Width / 2;  // a reasonable value for SPACE
@@ -884,6 +1159,8 @@ void CFont::Load()
 	}
 
 	if (this->G) {
+		// Glyphs are drawn from the atlases built from the paletted surface
+		this->G->KeepPalette = true;
 		this->G->Load();
 		this->MeasureWidths();
 	}
@@ -927,6 +1204,7 @@ void LoadFonts()
 		font.reset(new CFont(ident));
 	}
 	font->G = g;
+	ClearFontCaches();
 	return font.get();
 }
 
@@ -1001,6 +1279,7 @@ void LoadFonts()
 */
 void CleanFonts()
 {
+	ClearFontCaches();
 	Fonts.clear();
 
 	FontColors.clear();
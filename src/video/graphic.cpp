@@ -93,7 +93,7 @@ void CGraphic::DrawSub(int gx, int gy, int w, int h, int x, int y,
 	SDL_Rect srect = {Sint16(gx), Sint16(gy), Uint16(w), Uint16(h)};
 	SDL_Rect drect = {Sint16(x), Sint16(y), 0, 0};
 
-	SDL_BlitSurface(mSurface, &srect, surface, &drect);
+	SDL_BlitSurface(GetDrawSurface(), &srect, surface, &drect);
 }
 
 /**
@@ -162,7 +162,7 @@ void CGraphic::DrawSubClip(int gx, int gy, int w, int h, int x, int y,
 
 	SDL_Rect srect = {Sint16(gx), Sint16(gy), Uint16(w), Uint16(h)};
 	SDL_Rect drect = {Sint16(x), Sint16(y), 0, 0};
-	SDL_BlitSurface(mSurface, &srect, surface, &drect);
+	SDL_BlitSurface(GetDrawSurface(), &srect, surface, &drect);
 }
 
 /**
@@ -183,11 +183,10 @@ void CGraphic::DrawSubTrans(int gx, int gy, int w, int h, int x, int y,
 {
 	Assert(surface);
 
-	Uint8 oldalpha = 0xff;
-	SDL_GetSurfaceAlphaMod(mSurface, &oldalpha);
-	SDL_SetSurfaceAlphaMod(mSurface, alpha);
-	DrawSub(gx, gy, w, h, x, y, surface);
-	SDL_SetSurfaceAlphaMod(mSurface, oldalpha);
+	SDL_Rect srect = {Sint16(gx), Sint16(gy), Uint16(w), Uint16(h)};
+	SDL_Rect drect = {Sint16(x), Sint16(y), 0, 0};
+
+	BlitTrans(srect, drect, alpha, surface);
 }
 
 /**
@@ -322,7 +321,7 @@ void CGraphic::DrawFrameX(unsigned frame, int x, int y,
 	SDL_Rect srect = {frameFlip_map[frame].x, frameFlip_map[frame].y, Uint16(Width), Uint16(Height)};
 	SDL_Rect drect = {Sint16(x), Sint16(y), 0, 0};
 
-	SDL_BlitSurface(SurfaceFlip, &srect, surface, &drect);
+	SDL_BlitSurface(GetDrawSurface(true), &srect, surface, &drect);
 }
 
 /**
@@ -346,7 +345,7 @@ void CGraphic::DrawFrameClipX(unsigned frame, int x, int y,
 
 	SDL_Rect drect = {Sint16(x), Sint16(y), 0, 0};
 
-	SDL_BlitSurface(SurfaceFlip, &srect, surface, &drect);
+	SDL_BlitSurface(GetDrawSurface(true), &srect, surface, &drect);
 }
 
 void CGraphic::DrawFrameTransX(unsigned frame, int x, int y, int alpha,
@@ -354,12 +353,8 @@ void CGraphic::DrawFrameTransX(unsigned frame, int x, int y, int alpha,
 {
 	SDL_Rect srect = {frameFlip_map[frame].x, frameFlip_map[frame].y, Uint16(Width), Uint16(Height)};
 	SDL_Rect drect = {Sint16(x), Sint16(y), 0, 0};
-	Uint8 oldalpha = 0xff;
-	SDL_GetSurfaceAlphaMod(SurfaceFlip, &oldalpha);
 
-	SDL_SetSurfaceAlphaMod(SurfaceFlip, alpha);
-	SDL_BlitSurface(SurfaceFlip, &srect, surface, &drect);
-	SDL_SetSurfaceAlphaMod(SurfaceFlip, oldalpha);
+	BlitTrans(srect, drect, alpha, surface, true);
 }
 
 void CGraphic::DrawFrameClipTransX(unsigned frame, int x, int y, int alpha,
@@ -374,12 +369,8 @@ void CGraphic::DrawFrameClipTransX(unsigned frame, int x, int y, int alpha,
 	srect.y += y - oldy;
 
 	SDL_Rect drect = {Sint16(x), Sint16(y), 0, 0};
-	Uint8 oldalpha = 0xff;
-	SDL_GetSurfaceAlphaMod(SurfaceFlip, &oldalpha);
 
-	SDL_SetSurfaceAlphaMod(SurfaceFlip, alpha);
-	SDL_BlitSurface(SurfaceFlip, &srect, surface, &drect);
-	SDL_SetSurfaceAlphaMod(SurfaceFlip, oldalpha);
+	BlitTrans(srect, drect, alpha, surface, true);
 }
 
 /**
@@ -683,6 +674,167 @@ void CGraphic::Load(bool grayscale)
 	}
 
 	GenFramesMap();
+	PrepareDrawSurfaces();
+}
+
+/**
+**  Check if a surface already has the pixel layout of the screen.
+*/
+static bool HasScreenLayout(const SDL_Surface &surface)
+{
+	const SDL_PixelFormat &format = *surface.format;
+	return format.BitsPerPixel == 32
+		&& format.Rmask == RMASK && format.Gmask == GMASK && format.Bmask == BMASK
+		&& (format.Amask == AMASK || format.Amask == 0);
+}
+
+/**
+**  Convert a surface to the pixel layout of the screen.
+**
+**  Transparent surfaces (alpha channel or color key) get an alpha channel,
+**  the others are converted to the screen format itself.
+**
+**  @param surface  Surface to convert.
+**  @param rle      RLE encode the converted surface.
+**
+**  @return  the converted surface, nullptr on failure.
+*/
+static SDL_Surface *ConvertToScreenLayout(SDL_Surface &surface, bool rle = true)
+{
+	Uint32 ckey;
+	const bool transparent = surface.format->Amask != 0 || SDL_GetColorKey(&surface, &ckey) == 0;
+	const Uint32 format = SDL_MasksToPixelFormatEnum(32, RMASK, GMASK, BMASK, transparent ? AMASK : 0);
+	SDL_Surface *converted = SDL_ConvertSurfaceFormat(&surface, format, 0);
+	if (converted == nullptr) {
+		return nullptr;
+	}
+	SDL_BlendMode blendMode;
+	SDL_GetSurfaceBlendMode(&surface, &blendMode);
+	SDL_SetSurfaceBlendMode(converted, blendMode);
+	SDL_SetSurfaceRLE(converted, rle);
+	return converted;
+}
+
+/**
+**  Prepare the surfaces blitted when drawing.
+**
+**  Surfaces not stored like the screen would be converted at each blit,
+**  so a copy in the screen layout is made once. The original surface is
+**  kept for the pixel level operations (resize, shadows, palette).
+**  Paletted graphics whose palette changes while the game runs (player
+**  colors, color cycling, fonts) can't use a converted copy.
+*/
+void CGraphic::PrepareDrawSurfaces()
+{
+	DrawSurface.reset();
+	DrawSurfaceFlip.reset();
+	TransDrawSurface.reset();
+	TransDrawSurfaceFlip.reset();
+	if (mSurface == nullptr || HasScreenLayout(*mSurface)
+	    || (KeepPalette && mSurface->format->BytesPerPixel == 1)) {
+		return;
+	}
+	DrawSurface.reset(ConvertToScreenLayout(*mSurface));
+	if (DrawSurface == nullptr) {
+		ErrorPrint("Can't convert the graphic '%s': %s\n", File.u8string().c_str(), SDL_GetError());
+		return;
+	}
+	if (SurfaceFlip) {
+		DrawSurfaceFlip.reset(ConvertToScreenLayout(*SurfaceFlip));
+	}
+}
+
+/**
+**  Get the surface to blit.
+**
+**  @param flipped  Get the flipped surface.
+*/
+SDL_Surface *CGraphic::GetDrawSurface(bool flipped /* = false */) const
+{
+	SDL_Surface *converted = flipped ? DrawSurfaceFlip.get() : DrawSurface.get();
+	if (converted && !IsSurfaceColorCycled(*mSurface)) {
+		return converted;
+	}
+	return flipped ? SurfaceFlip : mSurface;
+}
+
+/**
+**  Blit the graphic with an alpha modulation.
+**
+**  Changing the alpha modulation of the RLE encoded converted surfaces
+**  would make SDL encode them again at the next blit, so the translucent
+**  draws use a copy which isn't RLE encoded, made at the first translucent
+**  draw, and whose alpha modulation is only changed when it differs.
+**  Graphics blitted from their original surface modulate it for the blit.
+**
+**  @param srect    Area of the graphic to blit.
+**  @param drect    Position on the target surface.
+**  @param alpha    Alpha modulation.
+**  @param surface  Target surface.
+**  @param flipped  Blit the flipped surface.
+*/
+void CGraphic::BlitTrans(SDL_Rect &srect, SDL_Rect &drect, unsigned char alpha, SDL_Surface *surface,
+                         bool flipped /* = false */) const
+{
+	SDL_Surface *drawSurface = GetDrawSurface(flipped);
+	if (drawSurface != (flipped ? SurfaceFlip : mSurface)) {
+		sdl2::SurfacePtr &transSurface = flipped ? TransDrawSurfaceFlip : TransDrawSurface;
+		if (transSurface == nullptr) {
+			transSurface.reset(ConvertToScreenLayout(flipped ? *SurfaceFlip : *mSurface, false));
+		}
+		if (transSurface != nullptr) {
+			Uint8 oldalpha = 0xff;
+			SDL_GetSurfaceAlphaMod(transSurface.get(), &oldalpha);
+			if (oldalpha != alpha) {
+				SDL_SetSurfaceAlphaMod(transSurface.get(), alpha);
+			}
+			SDL_BlitSurface(transSurface.get(), &srect, surface, &drect);
+			return;
+		}
+	}
+	Uint8 oldalpha = 0xff;
+	SDL_GetSurfaceAlphaMod(drawSurface, &oldalpha);
+	SDL_SetSurfaceAlphaMod(drawSurface, alpha);
+	SDL_BlitSurface(drawSurface, &srect, surface, &drect);
+	SDL_SetSurfaceAlphaMod(drawSurface, oldalpha);
+}
+
+/**
+**  Tell why the graphic is blitted with a pixel format conversion.
+**
+**  @return  the reason, nullptr if the blits don't convert.
+*/
+const char *CGraphic::GetBlitConversion() const
+{
+	if (mSurface == nullptr || HasScreenLayout(*GetDrawSurface())) {
+		return nullptr;
+	}
+	if (IsSurfaceColorCycled(*mSurface)) {
+		return "color cycling";
+	}
+	if (KeepPalette && mSurface->format->BytesPerPixel == 1) {
+		return dynamic_cast<const CPlayerColorGraphic *>(this) ? "player colors" : "palette changes";
+	}
+	return "conversion failed";
+}
+
+/**
+**  Print the loaded graphics which are blitted with a pixel format conversion.
+*/
+void PrintGraphicBlitConversions()
+{
+	for (const auto &[file, cache] : GraphicHash) {
+		const auto graphic = cache.lock();
+		if (graphic == nullptr || !graphic->IsLoaded()) {
+			continue;
+		}
+		if (const char *reason = graphic->GetBlitConversion()) {
+			LogPrint("%s: %d bpp, %s\n",
+			         graphic->File.u8string().c_str(),
+			         graphic->getSurface()->format->BitsPerPixel,
+			         reason);
+		}
+	}
 }
 
 /**
@@ -772,6 +924,10 @@ void CGraphic::Flip()
 		frameFlip_map[frame].x = ((NumFrames - frame - 1) % (SurfaceFlip->w / Width)) * Width;
 		frameFlip_map[frame].y = (frame / (SurfaceFlip->w / Width)) * Height;
 	}
+	if (DrawSurface) {
+		DrawSurfaceFlip.reset(ConvertToScreenLayout(*SurfaceFlip));
+	}
+	TransDrawSurfaceFlip.reset();
 }
 
 /**
@@ -903,6 +1059,7 @@ void CGraphic::Resize(int w, int h)
 	Assert(GetGraphicWidth() / Width * GetGraphicHeight() / Height == NumFrames);
 
 	GenFramesMap();
+	PrepareDrawSurfaces();
 }
 
 void CGraphic::ResizeKeepRatio(int width, int height)
@@ -961,6 +1118,7 @@ void CGraphic::AppendFrames(const sequence_of_images &frames)
 		SDL_BlitSurface(frame.get(), nullptr, mSurface, &dstRect);
 		currFrame++;
 	}
+	PrepareDrawSurfaces();
 }
 
 /**
@@ -1069,6 +1227,7 @@ void CGraphic::SetPaletteColor(int idx, int r, int g, int b) {
 	color.g = g;
 	color.b = b;
 	SDL_SetPaletteColors(mSurface->format->palette, &color, idx, 1);
+	PrepareDrawSurfaces();
 }
 
 void CGraphic::OverlayGraphic(CGraphic *other, bool mask)
@@ -1172,6 +1331,7 @@ void CGraphic::OverlayGraphic(CGraphic *other, bool mask)
 
 	SDL_UnlockSurface(mSurface);
 	SDL_UnlockSurface(other->mSurface);
+	PrepareDrawSurfaces();
 }
 
 static inline void dither(SDL_Surface *Surface) {
@@ -1274,6 +1434,7 @@ void CGraphic::MakeShadow(PixelPos offset)
 	if (SurfaceFlip) {
 		shearSurface(SurfaceFlip, xOffset, yOffset, frameFlip_map, Width, Height);
 	}
+	PrepareDrawSurfaces();
 }
 
 void FreeGraphics()
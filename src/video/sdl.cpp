@@ -40,6 +40,8 @@
 #include "network.h"
 #include "online_service.h"
 #include "parameters.h"
+#include "retained_ui.h"
+#include "script.h"
 #include "sound_server.h"
 #include "translate.h"
 #include "ui.h"
@@ -502,8 +504,15 @@ void InitVideoSdl()
 */
 void InvalidateArea(int x, int y, int w, int h)
 {
-	Assert(NumRects != sizeof(Rects) / sizeof(*Rects));
 	Assert(x >= 0 && y >= 0 && x + w <= Video.Width && y + h <= Video.Height);
+	if (NumRects == sizeof(Rects) / sizeof(*Rects)) {
+		Invalidate();
+		return;
+	}
+	if (NumRects == 1 && Rects[0].w == Video.Width && Rects[0].h == Video.Height) {
+		// whole window already invalidated
+		return;
+	}
 	Rects[NumRects].x = x;
 	Rects[NumRects].y = y;
 	Rects[NumRects].w = w;
@@ -708,6 +717,8 @@ const EventCallback *GetCallbacks()
 void WaitEventsOneFrame()
 {
 	if (dummyRenderer) {
+		// No idle time without a renderer, only the owed collection work
+		LuaGarbageCollectStep(0);
 		return;
 	}
 
@@ -722,6 +733,10 @@ void WaitEventsOneFrame()
 
 	int interrupts = Parameters::Instance.benchmark;
 
+	// Lua collection in frame mode, in the time left before SDL_Delay
+	ticks = SDL_GetTicks();
+	LuaGarbageCollectStep(!interrupts && ticks < NextFrameTicks ? NextFrameTicks - ticks : 0);
+
 	for (;;) {
 		// Time of frame over? This makes the CPU happy. :(
 		ticks = SDL_GetTicks();
@@ -806,12 +821,19 @@ void RealizeVideoMemory()
 		return;
 	}
 	if (NumRects) {
-		//SDL_UpdateWindowSurfaceRects(TheWindow, Rects, NumRects);
-		SDL_UpdateTexture(TheTexture, nullptr, TheScreen->pixels, TheScreen->pitch);
+		if (RetainedUI.TakePartialPresent()) {
+			// the texture keeps what was uploaded before, only the invalidated rectangles are sent
+			for (int i = 0; i < NumRects; ++i) {
+				const Uint8 *pixels = static_cast<const Uint8 *>(TheScreen->pixels)
+				                      + Rects[i].y * TheScreen->pitch
+				                      + Rects[i].x * TheScreen->format->BytesPerPixel;
+				SDL_UpdateTexture(TheTexture, &Rects[i], pixels, TheScreen->pitch);
+			}
+		} else {
+			SDL_UpdateTexture(TheTexture, nullptr, TheScreen->pixels, TheScreen->pitch);
+		}
 		if (!RenderWithShader(TheRenderer, TheWindow, TheTexture)) {
 			SDL_RenderClear(TheRenderer);
-			//for (int i = 0; i < NumRects; i++)
-			//    SDL_UpdateTexture(TheTexture, &Rects[i], TheScreen->pixels, TheScreen->pitch);
 			SDL_RenderCopy(TheRenderer, TheTexture, nullptr, nullptr);
 		}
 		if (Parameters::Instance.benchmark) {
@@ -89,6 +89,7 @@
 #include "font.h"
 #include "iolib.h"
 #include "map.h"
+#include "retained_ui.h"
 #include "ui.h"
 #include "widgets.h"
 
@@ -303,6 +304,7 @@ bool CVideo::ResizeScreen(int w, int h)
 	                               w, h);
 
 	SetClipping(0, 0, w - 1, h - 1);
+	RetainedUI.Reset();
 
 	return true;
 }
@@ -348,9 +350,22 @@ static int CclSetVideoSyncSpeed(lua_State *l)
        return 0;
 }
 
+/**
+**  Print the graphics which are still blitted with a pixel format conversion.
+**
+**  @param l  Lua state.
+*/
+static int CclPrintGraphicBlitConversions(lua_State *l)
+{
+	LuaCheckArgs(l, 0);
+	PrintGraphicBlitConversions();
+	return 0;
+}
+
 void VideoCclRegister()
 {
 	lua_register(Lua, "SetVideoSyncSpeed", CclSetVideoSyncSpeed);
+	lua_register(Lua, "PrintGraphicBlitConversions", CclPrintGraphicBlitConversions);
 }
 
 /*
@@ -483,6 +498,21 @@ void SetColorCycleAll(bool value)
 	CColorCycling::GetInstance().ColorCycleAll = value;
 }
 
+/**
+**  Check if the palette of a surface is cycled by ColorCycle.
+*/
+bool IsSurfaceColorCycled(const SDL_Surface &surface)
+{
+	if (surface.format->BytesPerPixel != 1) {
+		return false;
+	}
+	const CColorCycling &colorCycling = CColorCycling::GetInstance();
+	if (colorCycling.ColorIndexRanges.empty()) {
+		return false;
+	}
+	return colorCycling.ColorCycleAll || (Map.TileGraphic && Map.TileGraphic->getSurface() == &surface);
+}
+
 /**
 **  Color Cycle for particular surface
 */
@@ -0,0 +1,213 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_animation.cpp - Test file for the compiled animations. */
+//
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <doctest.h>
+
+#include "stratagus.h"
+
+#include "animation.h"
+#include "animation/animation_exactframe.h"
+#include "animation/animation_frame.h"
+#include "animation/animation_label.h"
+#include "animation/animation_move.h"
+#include "animation/animation_rotate.h"
+#include "animation/animation_unbreakable.h"
+#include "animation/animation_wait.h"
+#include "unit.h"
+#include "unittype.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+template <typename T>
+void AddStep(std::vector<std::unique_ptr<CAnimation>> &anims, std::string_view s)
+{
+	auto anim = std::make_unique<T>();
+	anim->Init(s, nullptr);
+	anims.push_back(std::move(anim));
+}
+
+std::vector<std::unique_ptr<CAnimation>> MakeWalkAnimation()
+{
+	std::vector<std::unique_ptr<CAnimation>> anims;
+	AddStep<CAnimation_Frame>(anims, "0");
+	AddStep<CAnimation_Move>(anims, "2");
+	AddStep<CAnimation_Wait>(anims, "3");
+	AddStep<CAnimation_ExactFrame>(anims, "5");
+	AddStep<CAnimation_Wait>(anims, "2");
+	AddStep<CAnimation_Label>(anims, "again");
+	AddStep<CAnimation_Rotate>(anims, "1");
+	AddStep<CAnimation_Frame>(anims, "10");
+	AddStep<CAnimation_Wait>(anims, "1");
+	return anims;
+}
+
+std::vector<std::unique_ptr<CAnimation>> MakeAttackAnimation()
+{
+	std::vector<std::unique_ptr<CAnimation>> anims;
+	AddStep<CAnimation_Unbreakable>(anims, "begin");
+	AddStep<CAnimation_Frame>(anims, "15");
+	AddStep<CAnimation_Wait>(anims, "4");
+	AddStep<CAnimation_ExactFrame>(anims, "20");
+	AddStep<CAnimation_Move>(anims, "1");
+	AddStep<CAnimation_Unbreakable>(anims, "end");
+	AddStep<CAnimation_Wait>(anims, "5");
+	return anims;
+}
+
+/// Animation loop calling each step through CAnimation::Action
+int ShowAnimationUncompiled(CUnit &unit, const std::vector<std::unique_ptr<CAnimation>> &anims)
+{
+	if (unit.Anim.CurrAnim != &anims) {
+		unit.Anim.CurrAnim = &anims;
+		unit.Anim.Anim = 0;
+		unit.Anim.Wait = 0;
+	}
+	if (unit.Anim.Wait) {
+		--unit.Anim.Wait;
+		if (!unit.Anim.Wait) {
+			unit.Anim.Anim = (unit.Anim.Anim + 1) % anims.size();
+		}
+		return 0;
+	}
+	int move = 0;
+	while (!unit.Anim.Wait) {
+		anims[unit.Anim.Anim]->Action(unit, move, 8);
+		if (!unit.Anim.Wait) {
+			unit.Anim.Anim = (unit.Anim.Anim + 1) % anims.size();
+		}
+	}
+	--unit.Anim.Wait;
+	if (!unit.Anim.Wait) {
+		unit.Anim.Anim = (unit.Anim.Anim + 1) % anims.size();
+	}
+	return move;
+}
+
+void InitUnit(CUnit &unit, CUnitType &type)
+{
+	unit.Type = &type;
+	unit.Variable.resize(NVARALREADYDEFINED);
+}
+} // namespace
+
+TEST_CASE("Compiled animation matches the animation steps")
+{
+	CUnitType type;
+	type.NumDirections = 8;
+	const auto anims = MakeWalkAnimation();
+
+	const CAnimProgram &program = GetAnimProgram(anims);
+	REQUIRE(program.Ops.size() == anims.size());
+	CHECK(program.Ops[0].Op == EAnimOp::Frame);
+	CHECK(program.Ops[2].Op == EAnimOp::Wait);
+	CHECK(program.Ops[2].Arg == 3);
+	CHECK(program.Ops[5].Op == EAnimOp::Nop);
+	CHECK(program.Ops[6].Op == EAnimOp::Call);
+
+	CUnit compiled;
+	CUnit uncompiled;
+	InitUnit(compiled, type);
+	InitUnit(uncompiled, type);
+	for (int cycle = 0; cycle != 100; ++cycle) {
+		CHECK(UnitShowAnimationScaled(compiled, &anims, 8) == ShowAnimationUncompiled(uncompiled, anims));
+		CHECK(compiled.Frame == uncompiled.Frame);
+		CHECK(compiled.Direction == uncompiled.Direction);
+		CHECK(compiled.Anim.Anim == uncompiled.Anim.Anim);
+		CHECK(compiled.Anim.Wait == uncompiled.Anim.Wait);
+	}
+	FreeAnimations();
+}
+
+TEST_CASE("Compiled animation matches the animation steps when switching sequences")
+{
+	CUnitType type;
+	type.NumDirections = 8;
+	const auto walk = MakeWalkAnimation();
+	const auto attack = MakeAttackAnimation();
+
+	CUnit compiled;
+	CUnit uncompiled;
+	InitUnit(compiled, type);
+	InitUnit(uncompiled, type);
+	for (int cycle = 0; cycle != 200; ++cycle) {
+		// Switch only where the attack can be broken, as the game does
+		const bool attacking = (cycle / 23) % 2 == 1 || uncompiled.Anim.Unbreakable;
+		const auto &anims = attacking ? attack : walk;
+
+		CHECK(UnitShowAnimationScaled(compiled, &anims, 8) == ShowAnimationUncompiled(uncompiled, anims));
+		CHECK(compiled.Frame == uncompiled.Frame);
+		CHECK(compiled.Direction == uncompiled.Direction);
+		CHECK(compiled.Anim.Anim == uncompiled.Anim.Anim);
+		CHECK(compiled.Anim.Wait == uncompiled.Anim.Wait);
+		CHECK(compiled.Anim.Unbreakable == uncompiled.Anim.Unbreakable);
+	}
+	FreeAnimations();
+}
+
+TEST_CASE("Animation cost per unit")
+{
+	constexpr int UnitCount = 5000;
+	constexpr int Cycles = 200;
+	constexpr int Runs = 3;
+	using Clock = std::chrono::steady_clock;
+
+	CUnitType type;
+	type.NumDirections = 8;
+	const auto anims = MakeWalkAnimation();
+	std::vector<CUnit> army(UnitCount);
+
+	// Best of a few runs, so a preempted run doesn't decide the check
+	const auto measure = [&](auto &&show) {
+		double best = 0;
+		for (int run = 0; run != Runs; ++run) {
+			for (auto &unit : army) {
+				InitUnit(unit, type);
+				unit.Anim = {};
+			}
+			const auto start = Clock::now();
+			for (int cycle = 0; cycle != Cycles; ++cycle) {
+				for (auto &unit : army) {
+					show(unit);
+				}
+			}
+			const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+			const double perUnit = elapsed.count() / (UnitCount * Cycles);
+			best = run == 0 ? perUnit : std::min(best, perUnit);
+		}
+		return best;
+	};
+	const double before = measure([&](CUnit &unit) { ShowAnimationUncompiled(unit, anims); });
+	const double after = measure([&](CUnit &unit) { UnitShowAnimationScaled(unit, &anims, 8); });
+
+	MESSAGE("animation ns per unit and cycle: steps " << before << ", compiled " << after);
+	CHECK(after <= before);
+	FreeAnimations();
+}
@@ -39,6 +39,7 @@
 #include "unittype.h"
 #include "unit_manager.h"
 #include "unit.h"
+#include "upgrade.h"
 
 namespace
 {
@@ -363,3 +364,37 @@ TEST_CASE("spell button depend")
 	CleanDependencies();
 	CleanUnitTypes();
 }
+
+TEST_CASE("tracked depends")
+{
+	InitLua_Depend(R"(DefineDependency("unit-main", {"unit-dep1", 2}, "or", {"upgrade-dep1"}))");
+	CPlayer &player = Players[0];
+	const auto &main = UnitTypeByIdent("unit-main");
+	const auto &dep = UnitTypeByIdent("unit-dep1");
+	const auto *upgrade = CUpgrade::Get("upgrade-dep1");
+	player.Allow.Units[main.Slot] = 42;
+	player.Allow.Upgrades[upgrade->ID] = 'A';
+
+	InitDependencies();
+
+	CHECK(!CheckDependByType(player, main));
+	CHECK(CheckDependByUpgrade(player, *upgrade));
+
+	player.ChangeUnitTypeCount(dep, 1);
+	CHECK(!CheckDependByType(player, main));
+
+	player.ChangeUnitTypeCount(dep, 1);
+	CHECK(CheckDependByType(player, main));
+
+	player.ChangeUnitTypeCount(dep, -2);
+	CHECK(!CheckDependByIdent(player, "unit-main"));
+
+	AllowUpgradeId(player, upgrade->ID, 'R');
+	CHECK(CheckDependByIdent(player, "unit-main"));
+	CHECK(!CheckDependByUpgrade(player, *upgrade));
+
+	player.Allow.Units[main.Slot] = 0;
+	player.Allow.Upgrades[upgrade->ID] = '\0';
+	CleanDependencies();
+	CleanUnitTypes();
+}
@@ -0,0 +1,96 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_ident_table.cpp - Test file for the interned identifiers. */
+//
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+
+#include <doctest.h>
+
+#include "stratagus.h"
+
+#include "ident_table.h"
+#include "missile.h"
+#include "script.h"
+#include "upgrade.h"
+#include "upgrade_structs.h"
+
+#include <string>
+
+TEST_CASE("Ident table")
+{
+	CIdentTable table;
+
+	CHECK(table.Find(EIdentKind::UnitType, "unit-a") == -1);
+
+	std::string ident = "unit-a";
+	table.Add(EIdentKind::UnitType, ident, 0);
+	table.Add(EIdentKind::UnitType, "unit-b", 1);
+	table.Add(EIdentKind::Upgrade, "unit-a", 7);
+	ident = "changed"; // the table keeps its own copy
+
+	CHECK(table.Find(EIdentKind::UnitType, "unit-a") == 0);
+	CHECK(table.Find(EIdentKind::UnitType, "unit-b") == 1);
+	CHECK(table.Find(EIdentKind::Upgrade, "unit-a") == 7);
+	CHECK(table.Find(EIdentKind::MissileType, "unit-a") == -1);
+
+	table.Clear(EIdentKind::UnitType);
+
+	CHECK(table.Find(EIdentKind::UnitType, "unit-a") == -1);
+	CHECK(table.Find(EIdentKind::Upgrade, "unit-a") == 7);
+}
+
+TEST_CASE("Lua handles resolve to the objects of their identifiers")
+{
+	InitLua();
+	UpgradesCclRegister();
+	MissileCclRegister();
+	CUpgrade *upgrade = CUpgrade::New("upgrade-handle");
+	MissileType *mtype = NewMissileTypeSlot("missile-handle");
+
+	const std::string script = "return Upgrade(\"upgrade-handle\"), MissileType(\"missile-handle\")";
+	REQUIRE(luaL_loadbuffer(Lua, script.data(), script.size(), "test") == 0);
+	REQUIRE(lua_pcall(Lua, 0, 2, 0) == 0);
+
+	// The handles
+	lua_pushvalue(Lua, -2);
+	CHECK(CclGetUpgrade(Lua) == upgrade);
+	lua_pop(Lua, 1);
+	CHECK(CclGetMissileType(Lua) == mtype);
+	lua_pop(Lua, 2);
+
+	// The identifiers
+	lua_pushstring(Lua, "upgrade-handle");
+	CHECK(CclGetUpgrade(Lua) == upgrade);
+	lua_pop(Lua, 1);
+	lua_pushstring(Lua, "missile-handle");
+	CHECK(CclGetMissileType(Lua) == mtype);
+	lua_pop(Lua, 1);
+
+	CleanMissileTypes();
+	CleanUpgrades();
+	lua_close(Lua);
+	Lua = nullptr;
+}
@@ -0,0 +1,160 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_influence_map.cpp - Test file for the influence map. */
+//
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <doctest.h>
+
+#include "stratagus.h"
+
+#include "actions.h"
+#include "influence_map.h"
+#include "map.h"
+#include "player.h"
+#include "unit.h"
+#include "unit_area_count.h"
+#include "unit_manager.h"
+#include "unittype.h"
+
+TEST_CASE("Influence grid sums the cells overlapping a rectangle")
+{
+	CInfluenceGrid grid;
+	grid.Init(21, 13); // 3x2 cells, the last ones are partial
+
+	grid.Add(0, Vec2i(0, 0), 2);
+	grid.Add(1, Vec2i(9, 1), 3);
+	grid.Add(0, Vec2i(20, 12), 1);
+	grid.Add(2, Vec2i(8, 8), -1);
+
+	CHECK(grid.Sum(1 << 0, Vec2i(0, 0), Vec2i(0, 0)) == 2);
+	CHECK(grid.Sum(1 << 0, Vec2i(7, 7), Vec2i(7, 7)) == 2); // whole cell counted
+	CHECK(grid.Sum((1 << 0) | (1 << 1), Vec2i(7, 0), Vec2i(8, 0)) == 5);
+	CHECK(grid.Sum(0x7, Vec2i(-5, -5), Vec2i(30, 30)) == 5);
+	CHECK(grid.Sum(1 << 2, Vec2i(8, 8), Vec2i(8, 8)) == -1);
+	CHECK(grid.Any(1 << 2, Vec2i(8, 8), Vec2i(8, 8)));
+	CHECK(grid.Sum(1 << 1, Vec2i(16, 0), Vec2i(20, 7)) == 0);
+	CHECK_FALSE(grid.Any(1 << 1, Vec2i(16, 0), Vec2i(20, 7)));
+	// Empty or out of the map
+	CHECK(grid.Sum(0x7, Vec2i(5, 5), Vec2i(4, 4)) == 0);
+	CHECK(grid.Sum(0x7, Vec2i(25, 0), Vec2i(30, 5)) == 0);
+	CHECK_FALSE(grid.Any(0x7, Vec2i(-9, -9), Vec2i(-1, -1)));
+
+	grid.Add(1, Vec2i(9, 1), -3);
+	CHECK_FALSE(grid.Any(1 << 1, Vec2i(8, 0), Vec2i(15, 7)));
+}
+
+TEST_CASE("Influence grid knows full cells")
+{
+	CInfluenceGrid grid;
+	grid.Init(10, 10); // the last row and column of cells have 2 tiles per side
+
+	for (int y = 0; y != 10; ++y) {
+		for (int x = 0; x != 10; ++x) {
+			if (x != 9 || y != 9) {
+				grid.Add(1, Vec2i(x, y), 1);
+			}
+		}
+	}
+	CHECK(grid.IsFull(1, Vec2i(0, 0), Vec2i(7, 7)));
+	CHECK(grid.IsFull(1, Vec2i(3, 0), Vec2i(8, 7)));
+	CHECK_FALSE(grid.IsFull(1, Vec2i(3, 3), Vec2i(8, 8)));
+	CHECK_FALSE(grid.IsFull(0, Vec2i(0, 0), Vec2i(0, 0)));
+	CHECK(grid.IsFull(0, Vec2i(20, 20), Vec2i(30, 30)));
+
+	grid.Add(1, Vec2i(9, 9), 1);
+	CHECK(grid.IsFull(1, Vec2i(-5, -5), Vec2i(15, 15)));
+	CHECK(grid.Any(1 << 1, Vec2i(9, 9), Vec2i(9, 9)));
+	CHECK_FALSE(grid.Any(1 << 0, Vec2i(0, 0), Vec2i(9, 9)));
+}
+
+TEST_CASE("Influence map follows the map hooks")
+{
+	Map.Info.MapWidth = 32;
+	Map.Info.MapHeight = 32;
+	Map.Create();
+	InfluenceMap.Clear();
+	CPlayer *oldThisPlayer = ThisPlayer;
+	Players[0].Index = 0;
+	Players[1].Index = 1;
+	ThisPlayer = &Players[0];
+
+	CUnitType type;
+	type.TileWidth = 2;
+	type.TileHeight = 2;
+	CUnitManager manager;
+	manager.Init();
+	std::unique_ptr<CUnit> owner(manager.AllocUnit()); // the manager doesn't free its units
+	CUnit &unit = *owner;
+	unit.Type = &type;
+	unit.Player = &Players[1];
+	unit.Removed = false;
+	unit.Orders.push_back(COrder::NewActionStill());
+
+	SUBCASE("units inserted and removed")
+	{
+		// Over the corner of 4 cells
+		unit.tilePos = Vec2i(7, 7);
+		unit.Offset = Map.getIndex(unit.tilePos);
+		Map.Insert(unit);
+		CHECK(InfluenceMap.HasUnits(1 << 1, Vec2i(0, 0), Vec2i(0, 0)));
+		CHECK(InfluenceMap.HasUnits(1 << 1, Vec2i(15, 15), Vec2i(15, 15)));
+		CHECK_FALSE(InfluenceMap.HasUnits(1 << 1, Vec2i(16, 0), Vec2i(31, 31)));
+		CHECK_FALSE(InfluenceMap.HasUnits(1 << 0, Vec2i(0, 0), Vec2i(31, 31)));
+
+		Map.Remove(unit);
+		CHECK_FALSE(InfluenceMap.HasUnits(1 << 1, Vec2i(0, 0), Vec2i(31, 31)));
+
+		unit.tilePos = Vec2i(20, 4);
+		unit.Offset = Map.getIndex(unit.tilePos);
+		Map.Insert(unit);
+		CHECK(InfluenceMap.HasUnits(1 << 1, Vec2i(16, 0), Vec2i(23, 7)));
+		CHECK_FALSE(InfluenceMap.HasUnits(1 << 1, Vec2i(0, 0), Vec2i(15, 31)));
+		Map.Remove(unit);
+	}
+
+	SUBCASE("tiles explored")
+	{
+		CHECK_FALSE(InfluenceMap.IsExplored(Players[0], Vec2i(0, 0), Vec2i(7, 7)));
+		for (int y = 0; y != 8; ++y) {
+			for (int x = 0; x != 8; ++x) {
+				MapMarkTileSight(Players[0], Map.getIndex(x, y));
+			}
+		}
+		CHECK(InfluenceMap.IsExplored(Players[0], Vec2i(0, 0), Vec2i(7, 7)));
+		CHECK_FALSE(InfluenceMap.IsExplored(Players[0], Vec2i(0, 0), Vec2i(8, 7)));
+		CHECK_FALSE(InfluenceMap.IsExplored(Players[1], Vec2i(0, 0), Vec2i(7, 7)));
+
+		// Counted again from the map once invalidated
+		InfluenceMap.InvalidateExplored();
+		CHECK(InfluenceMap.IsExplored(Players[0], Vec2i(0, 0), Vec2i(7, 7)));
+	}
+
+	unit.Orders.clear();
+	ThisPlayer = oldThisPlayer;
+	UnitAreaCount.Clear();
+	InfluenceMap.Clear();
+	Map.Fields.clear();
+}
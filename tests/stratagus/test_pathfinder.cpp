@@ -37,6 +37,8 @@
 #include "unit.h"
 #include "unittype.h"
 
+#include <thread>
+
 namespace doctest
 {
 template <typename T>
@@ -60,12 +62,26 @@ Vec2i FollowedPath(const Vec2i &origin, const PathFinderOutput &data)
 {
 	Vec2i res = origin;
 	for (int i = 0; i != data.Length; ++i) {
-		const auto direction = data.Path[data.Length - 1 - i];
+		const auto direction = data.GetPath()[data.Length - 1 - i];
 		res.x += Heading2X[direction];
 		res.y += Heading2Y[direction];
 	}
 	return res;
 }
+
+bool PathGoesThrough(const Vec2i &origin, const PathFinderOutput &data, const Vec2i &tile)
+{
+	Vec2i res = origin;
+	for (int i = 0; i != data.Length; ++i) {
+		const auto direction = data.GetPath()[data.Length - 1 - i];
+		res.x += Heading2X[direction];
+		res.y += Heading2Y[direction];
+		if (res == tile) {
+			return true;
+		}
+	}
+	return false;
+}
 } // namespace
 
 TEST_CASE("PathFinding on clear map 128x128")
@@ -140,6 +156,145 @@ TEST_CASE("PathFinding on clear map 128x128")
 		unit.Orders.clear();
 	}
 
+	SUBCASE("long path (30) with uniform shortcut")
+	{
+		const short dist = 30;
+		const auto dest = unit.tilePos + Vec2i{dist, dist / 2};
+		unit.Orders.push_back(COrder::NewActionMove(dest));
+
+		AStarUniformShortcut = true;
+		const auto [d, dir] = NextPathElement(unit);
+		AStarUniformShortcut = false;
+
+		CHECK(d == std::size(unit.pathFinderData->output.Path));
+		CHECK(unit.pathFinderData->output.Length + unit.pathFinderData->output.OverflowLength == dist);
+		// Diagonally first, then straight
+		CHECK(unit.tilePos + Vec2i(d, dist / 2) == FollowedPath(unit.tilePos, unit.pathFinderData->output));
+
+		unit.Orders.clear();
+	}
+
+	SUBCASE("long path (30) with longer stored paths")
+	{
+		const short dist = 30;
+		const auto dest = unit.tilePos + Vec2i{0, dist};
+		unit.Orders.push_back(COrder::NewActionMove(dest));
+
+		AStarStoredPathLength = 64;
+		const auto [d, dir] = NextPathElement(unit);
+
+		CHECK(d == dist);
+		CHECK(unit.pathFinderData->output.OverflowLength == 0);
+		CHECK(dest == FollowedPath(unit.tilePos, unit.pathFinderData->output));
+
+		AStarStoredPathLength = PathFinderOutput::MAX_PATH_LENGTH;
+		unit.Orders.clear();
+	}
+
+	SUBCASE("blocked path is repaired")
+	{
+		const short dist = 30;
+		const auto dest = unit.tilePos + Vec2i{0, dist};
+		unit.Orders.push_back(COrder::NewActionMove(dest));
+		type.MovementMask = MapFieldUnpassable;
+		AStarKnowUnseenTerrain = true;
+		AStarStoredPathLength = 64;
+
+		const auto [d, dir] = NextPathElement(unit);
+		REQUIRE(dir == Vec2i(0, 1));
+		unit.tilePos += dir;
+
+		// Block the next step
+		const Vec2i blocked = unit.tilePos + Vec2i(0, 1);
+		Map.Field(blocked)->setFlag(MapFieldUnpassable);
+		const auto [repaired, repairedDir] = NextPathElement(unit);
+
+		CHECK(repaired > 0);
+		CHECK(repairedDir != Vec2i(0, 1));
+		CHECK(UnitCanBeAt(unit, unit.tilePos + repairedDir));
+		CHECK(dest == FollowedPath(unit.tilePos, unit.pathFinderData->output));
+		CHECK_FALSE(PathGoesThrough(unit.tilePos, unit.pathFinderData->output, blocked));
+
+		AStarStoredPathLength = PathFinderOutput::MAX_PATH_LENGTH;
+		AStarKnowUnseenTerrain = false;
+		type.MovementMask = 0;
+		unit.Orders.clear();
+	}
+
+	SUBCASE("local search doesn't keep the costs of a previous search")
+	{
+		extern int AStarFindLocalPath(const Vec2i &startPos, const Vec2i &goalPos, int tilesizex, int tilesizey,
+		                              int window, int maxIterations, char *path, int pathlen, const CUnit &unit);
+		type.MovementMask = MapFieldUnpassable;
+		AStarKnowUnseenTerrain = true;
+
+		const Vec2i dest(42, 40);
+		const int before = PlaceReachable(unit, dest, 1, 1, 0, 0, false);
+		REQUIRE(before > 0);
+
+		// Wall across the path found, with a gap on the right side
+		for (int x = 0; x != 110; ++x) {
+			Map.Field(Vec2i(x, 20))->setFlag(MapFieldUnpassable);
+		}
+		// A search in a small window far away resets only what it needs
+		char path[8];
+		CHECK(AStarFindLocalPath(Vec2i(100, 100), Vec2i(104, 104), 2, 2, 4, 256, path, std::size(path), unit) > 0);
+
+		CHECK(PlaceReachable(unit, dest, 1, 1, 0, 0, false) > before);
+
+		AStarKnowUnseenTerrain = false;
+		type.MovementMask = 0;
+	}
+
+	Map.Fields.clear();
+
+	extern void FreeAStar(); // free the a* data structures
+	FreeAStar();
+}
+
+TEST_CASE("Concurrent path searches")
+{
+	CPlayer player;
+	player.Index = 0;
+	CUnitType type;
+	type.TileWidth = 1;
+	type.TileHeight = 1;
+	type.BoolFlag.resize(UnitTypeVar.GetNumberBoolFlag()); // SOLID_INDEX
+	CUnit unit;
+	unit.Player = &player;
+	unit.Type = &type;
+	unit.tilePos = {3, 5};
+
+	Map.Info.MapWidth = 64;
+	Map.Info.MapHeight = 64;
+
+	Map.Create();
+
+	extern void InitAStar(int mapWidth, int mapHeight);
+	InitAStar(Map.Info.MapWidth, Map.Info.MapHeight);
+
+	const Vec2i dests[] = {{60, 5}, {3, 50}, {40, 40}, {10, 62}};
+	int expected[std::size(dests)];
+	for (size_t i = 0; i != std::size(dests); ++i) {
+		expected[i] = PlaceReachable(unit, dests[i], 1, 1, 0, 0, false);
+		REQUIRE(expected[i] > 0);
+	}
+
+	// Each thread searches with its own context
+	int results[std::size(dests)] = {};
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i != std::size(dests); ++i) {
+		threads.emplace_back([&, i]() {
+			results[i] = PlaceReachable(unit, dests[i], 1, 1, 0, 0, false);
+		});
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+	for (size_t i = 0; i != std::size(dests); ++i) {
+		CHECK(results[i] == expected[i]);
+	}
+
 	Map.Fields.clear();
 
 	extern void FreeAStar(); // free the a* data structures
@@ -0,0 +1,108 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_profiler.cpp - Test file for the frame time profiler. */
+//
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <doctest.h>
+
+#include "stratagus.h"
+#include "profiler.h"
+
+#include <cstring>
+
+TEST_CASE("Profiler nested sections")
+{
+	Profiler.Clear();
+	Profiler.SetCollect(true);
+
+	Profiler.BeginFrame();
+	{
+		const CProfileScope logic("Logic");
+		{
+			const CProfileScope units("Units");
+		}
+		{
+			const CProfileScope units("Units");
+		}
+		const CProfileScope missiles("Missiles");
+	}
+	{
+		const CProfileScope display("Display");
+	}
+	Profiler.EndFrame();
+	Profiler.SetCollect(false);
+
+	const auto &sections = Profiler.GetSections();
+	REQUIRE(sections.size() == 4);
+	CHECK(std::strcmp(sections[0].Name, "Logic") == 0);
+	CHECK(sections[0].Depth == 0);
+	CHECK(std::strcmp(sections[1].Name, "Units") == 0);
+	CHECK(sections[1].Depth == 1);
+	CHECK(sections[1].Parent == 0);
+	CHECK(sections[1].Calls == 2);
+	CHECK(std::strcmp(sections[2].Name, "Missiles") == 0);
+	CHECK(sections[2].Parent == 0);
+	CHECK(std::strcmp(sections[3].Name, "Display") == 0);
+	CHECK(sections[3].Depth == 0);
+	CHECK(sections[0].Last >= sections[1].Last);
+}
+
+TEST_CASE("Profiler disabled")
+{
+	Profiler.Clear();
+
+	Profiler.BeginFrame();
+	{
+		const CProfileScope logic("Logic");
+	}
+	Profiler.EndFrame();
+
+	CHECK(Profiler.GetSections().empty());
+}
+
+TEST_CASE("Profiler sections are found by name")
+{
+	Profiler.Clear();
+	Profiler.SetCollect(true);
+
+	// Same name in two buffers, like literals of different translation units
+	const char first[] = "Logic";
+	const char second[] = "Logic";
+
+	Profiler.BeginFrame();
+	{
+		const CProfileScope logic(first);
+	}
+	{
+		const CProfileScope logic(second);
+	}
+	Profiler.EndFrame();
+	Profiler.SetCollect(false);
+
+	const auto &sections = Profiler.GetSections();
+	REQUIRE(sections.size() == 1);
+	CHECK(sections[0].Calls == 2);
+}
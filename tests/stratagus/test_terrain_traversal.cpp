@@ -0,0 +1,89 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_terrain_traversal.cpp - Test file for the terrain traversal. */
+//
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <doctest.h>
+
+#include "stratagus.h"
+
+#include "pathfinder.h"
+
+namespace
+{
+class VisitCounter
+{
+public:
+	VisitResult Visit(TerrainTraversal &, const Vec2i &pos, const Vec2i &)
+	{
+		++visited;
+		return pos == wall ? VisitResult::DeadEnd : VisitResult::Ok;
+	}
+
+	Vec2i wall{-1, -1};
+	int visited = 0;
+};
+} // namespace
+
+TEST_CASE("Terrain traversals reusing pooled buffers start clean")
+{
+	for (int i = 0; i != 3; ++i) {
+		TerrainTraversal traversal;
+		traversal.SetSize(5, 4);
+		traversal.Init();
+		traversal.PushPos(Vec2i(0, 0));
+
+		VisitCounter counter;
+		if (i == 1) {
+			counter.wall = Vec2i(2, 2);
+		}
+		CHECK_FALSE(traversal.Run(counter));
+		CHECK(counter.visited == 20);
+		CHECK(traversal.Get(Vec2i(4, 3)) == 5);
+		CHECK(traversal.Get(Vec2i(-1, 0)) == -1);
+		CHECK(traversal.Get(Vec2i(5, 3)) == -1);
+		CHECK(traversal.IsReached(Vec2i(2, 2)) == (i != 1));
+	}
+}
+
+TEST_CASE("Terrain traversals alive together are independent")
+{
+	TerrainTraversal first;
+	first.SetSize(6, 6);
+	first.Init();
+	first.PushPos(Vec2i(0, 0));
+
+	TerrainTraversal second;
+	second.SetSize(6, 6);
+	second.Init();
+	second.PushPos(Vec2i(5, 5));
+
+	VisitCounter counter;
+	first.Run(counter);
+	CHECK(first.Get(Vec2i(5, 5)) == 6);
+	CHECK(second.Get(Vec2i(5, 5)) == 1);
+	CHECK(second.Get(Vec2i(0, 0)) == 0);
+}
@@ -217,3 +217,40 @@ TEST_CASE("Trigger ActionDraw")
 	CHECK(GamePaused);
 	CHECK(GameResult == GameDraw);
 }
+
+TEST_CASE("Trigger Interval and Events")
+{
+	const auto raii = InitLuaTrigger(R"(
+		AddTrigger(function() l("C1") return false end, function() return false end, {Interval = 2})
+		AddTrigger(function() l("C2") return false end, function() return false end, {Events = {"timer"}, Name = "timer"})
+		AddTrigger(function() l("C3") return false end, function() return false end)
+	)");
+	CHECK(test_getLuaTableSize("_triggers_") == 3 * 2);
+
+	GameCycle = 0;
+	test_setLuaGlobalStr("log", "");
+	TriggersEachCycle();
+	CHECK(test_getLuaGlobalStr("log") == "C1 C3 ");
+
+	GameCycle = 1;
+	test_setLuaGlobalStr("log", "");
+	TriggersEachCycle();
+	CHECK(test_getLuaGlobalStr("log") == "C3 ");
+
+	TriggerNotifyEvent(ETriggerEvent::Timer);
+	GameCycle = 2;
+	test_setLuaGlobalStr("log", "");
+	TriggersEachCycle();
+	CHECK(test_getLuaGlobalStr("log") == "C1 C2 C3 ");
+
+	GameCycle = 3;
+	test_setLuaGlobalStr("log", "");
+	TriggersEachCycle();
+	CHECK(test_getLuaGlobalStr("log") == "C3 ");
+	GameCycle = 0;
+
+	REQUIRE(luaL_dostring(Lua, "stats = GetTriggerStatistics()") == 0);
+	CHECK(test_getLuaTableSize("stats") == 3);
+	REQUIRE(luaL_dostring(Lua, "log = stats[2].Name .. ' ' .. stats[2].Calls .. ' ' .. stats[1].Calls") == 0);
+	CHECK(test_getLuaGlobalStr("log") == "timer 1 2");
+}
@@ -0,0 +1,170 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_unit_area_count.cpp - Test file for the unit area count index. */
+//
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+
+#include <doctest.h>
+
+#include "stratagus.h"
+
+#include "actions.h"
+#include "influence_map.h"
+#include "map.h"
+#include "player.h"
+#include "script.h"
+#include "trigger.h"
+#include "unit.h"
+#include "unit_area_count.h"
+#include "unit_manager.h"
+#include "unittype.h"
+
+#include <numeric>
+#include <string>
+#include <vector>
+
+TEST_CASE("Area count tree matches a naive count")
+{
+	constexpr int Width = 13;
+	constexpr int Height = 7;
+	CAreaCountTree tree(Width, Height);
+	std::vector<int> grid(Width * Height, 0);
+
+	unsigned int seed = 42;
+	const auto next = [&](int n) { seed = seed * 1103515245 + 12345; return int((seed >> 16) % n); };
+	for (int i = 0; i != 200; ++i) {
+		const Vec2i pos(next(Width), next(Height));
+		const int delta = grid[pos.y * Width + pos.x] > 0 && next(3) == 0 ? -1 : 1;
+		tree.Add(pos, delta);
+		grid[pos.y * Width + pos.x] += delta;
+	}
+	for (int i = 0; i != 200; ++i) {
+		const Vec2i minPos(next(Width + 4) - 2, next(Height + 4) - 2);
+		const Vec2i maxPos(next(Width + 4) - 2, next(Height + 4) - 2);
+		int expected = 0;
+		for (int y = std::max<int>(minPos.y, 0); y <= std::min<int>(maxPos.y, Height - 1); ++y) {
+			for (int x = std::max<int>(minPos.x, 0); x <= std::min<int>(maxPos.x, Width - 1); ++x) {
+				expected += grid[y * Width + x];
+			}
+		}
+		CHECK(tree.Count(minPos, maxPos) == expected);
+	}
+	CHECK(tree.Count(Vec2i(0, 0), Vec2i(Width - 1, Height - 1)) == std::accumulate(grid.begin(), grid.end(), 0));
+}
+
+namespace
+{
+int GetNumUnitsAt(const std::string &args)
+{
+	const std::string script = "return GetNumUnitsAt(" + args + ")";
+	REQUIRE(luaL_loadbuffer(Lua, script.data(), script.size(), "test") == 0);
+	REQUIRE(lua_pcall(Lua, 0, 1, 0) == 0);
+	const int res = lua_tonumber(Lua, -1);
+	lua_pop(Lua, 1);
+	return res;
+}
+} // namespace
+
+TEST_CASE("GetNumUnitsAt follows the units inserted in and removed from the map")
+{
+	Map.Info.MapWidth = 32;
+	Map.Info.MapHeight = 32;
+	Map.Create();
+	UnitAreaCount.Clear();
+	Players[0].Index = 0;
+	Players[1].Index = 1;
+	InitLua();
+	TriggerCclRegister();
+
+	CUnitType &footman = *NewUnitTypeSlot("unit-area-footman").first;
+	footman.TileWidth = 1;
+	footman.TileHeight = 1;
+	CUnitType &farm = *NewUnitTypeSlot("unit-area-farm").first;
+	farm.TileWidth = 2;
+	farm.TileHeight = 2;
+	farm.Building = true;
+
+	CUnitManager manager;
+	manager.Init();
+	std::vector<std::unique_ptr<CUnit>> owners; // the manager doesn't free its units
+	const auto makeUnit = [&](CUnitType &type, CPlayer &player, const Vec2i &pos) -> CUnit & {
+		owners.emplace_back(manager.AllocUnit());
+		CUnit &unit = *owners.back();
+		unit.Type = &type;
+		unit.Player = &player;
+		unit.Removed = false;
+		unit.Orders.push_back(COrder::NewActionStill());
+		unit.tilePos = pos;
+		unit.Offset = Map.getIndex(pos);
+		return unit;
+	};
+	CUnit &footman1 = makeUnit(footman, Players[1], Vec2i(3, 3));
+	CUnit &footman2 = makeUnit(footman, Players[1], Vec2i(10, 10));
+	CUnit &enemy = makeUnit(footman, Players[0], Vec2i(4, 4));
+	CUnit &farm1 = makeUnit(farm, Players[1], Vec2i(6, 2));
+
+	// Inserted before and after the first query builds the index
+	Map.Insert(footman1);
+	CHECK(GetNumUnitsAt("1, \"unit-area-footman\", {0, 0}, {5, 5}") == 1);
+	Map.Insert(footman2);
+	Map.Insert(enemy);
+	Map.Insert(farm1);
+
+	CHECK(GetNumUnitsAt("1, \"unit-area-footman\", {0, 0}, {5, 5}") == 1);
+	CHECK(GetNumUnitsAt("1, \"unit-area-footman\", {0, 0}, {31, 31}") == 2);
+	CHECK(GetNumUnitsAt("0, \"unit-area-footman\", {0, 0}, {5, 5}") == 1);
+	CHECK(GetNumUnitsAt("\"any\", \"unit-area-footman\", {0, 0}, {5, 5}") == 2);
+	// The farm overlaps the rectangle with its bottom right tile only
+	CHECK(GetNumUnitsAt("1, \"buildings\", {7, 3}, {9, 9}") == 1);
+	CHECK(GetNumUnitsAt("1, \"buildings\", {8, 4}, {9, 9}") == 0);
+	CHECK(GetNumUnitsAt("1, \"units\", {0, 0}, {31, 31}") == 2);
+	CHECK(GetNumUnitsAt("1, \"any\", {5, 5}, {3, 0}") == 1); // corners in any order
+
+	// Moved
+	Map.Remove(footman1);
+	CHECK(GetNumUnitsAt("1, \"unit-area-footman\", {0, 0}, {5, 5}") == 0);
+	footman1.tilePos = Vec2i(20, 20);
+	footman1.Offset = Map.getIndex(footman1.tilePos);
+	Map.Insert(footman1);
+	CHECK(GetNumUnitsAt("1, \"unit-area-footman\", {20, 20}, {20, 20}") == 1);
+	CHECK(GetNumUnitsAt("1, \"units\", {0, 0}, {31, 31}") == 2);
+
+	Map.Remove(footman1);
+	Map.Remove(footman2);
+	Map.Remove(enemy);
+	Map.Remove(farm1);
+	CHECK(GetNumUnitsAt("\"any\", \"any\", {0, 0}, {31, 31}") == 0);
+
+	for (auto &unit : owners) {
+		unit->Orders.clear();
+	}
+	lua_close(Lua);
+	Lua = nullptr;
+	UnitAreaCount.Clear();
+	InfluenceMap.Clear();
+	CleanUnitTypes();
+	Map.Fields.clear();
+}
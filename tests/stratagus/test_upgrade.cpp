@@ -0,0 +1,133 @@
+//       _________ __                 __
+//      /   _____//  |_____________ _/  |______     ____  __ __  ______
+//      \_____  \\   __\_  __ \__  \\   __\__  \   / ___\|  |  \/  ___/
+//      /        \|  |  |  | \// __ \|  |  / __ \_/ /_/  >  |  /\___ |
+//     /_______  /|__|  |__|  (____  /__| (____  /\___  /|____//____  >
+//             \/                  \/          \//_____/            \/
+//  ______________________                           ______________________
+//                        T H E   W A R   B E G I N S
+//         Stratagus - A free fantasy real time strategy game engine
+//
+/**@name test_upgrade.cpp - Test file for the upgrade modifiers. */
+//
+//
+//      This program is free software; you can redistribute it and/or modify
+//      it under the terms of the GNU General Public License as published by
+//      the Free Software Foundation; only version 2 of the License.
+//
+//      This program is distributed in the hope that it will be useful,
+//      but WITHOUT ANY WARRANTY; without even the implied warranty of
+//      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//      GNU General Public License for more details.
+//
+//      You should have received a copy of the GNU General Public License
+//      along with this program; if not, write to the Free Software
+//      Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+//      02111-1307, USA.
+//
+
+#include <doctest.h>
+
+
+#include "stratagus.h"
+
+#include "actions.h"
+#include "map.h"
+#include "player.h"
+#include "unit.h"
+#include "unit_manager.h"
+#include "unittype.h"
+#include "upgrade.h"
+#include "upgrade_structs.h"
+
+TEST_CASE("Upgrade modifiers are undone when the upgrade is lost")
+{
+	Map.Info.MapWidth = 32;
+	Map.Info.MapHeight = 32;
+	Map.Create();
+	CPlayer *oldThisPlayer = ThisPlayer;
+	Players[0].Index = 0;
+	Players[1].Index = 1;
+	ThisPlayer = &Players[0];
+	CPlayer &player = Players[1];
+	const int oldSupply = player.Supply;
+
+	CUnitType &type = *NewUnitTypeSlot("unit-upgrade-test").first;
+	type.TileWidth = 1;
+	type.TileHeight = 1;
+	type.AirUnit = true; // simple radial sight
+	CUnitStats &stat = type.Stats[player.Index];
+	stat.Variables.resize(UnitTypeVar.GetNumberVariable());
+	stat.Variables[SIGHTRANGE_INDEX].Max = 2;
+	stat.Variables[SIGHTRANGE_INDEX].Value = 2;
+	stat.Variables[SUPPLY_INDEX].Max = 4;
+	stat.Variables[SUPPLY_INDEX].Value = 4;
+
+	CUnitManager manager;
+	manager.Init();
+	std::unique_ptr<CUnit> owner(manager.AllocUnit()); // the manager doesn't free its units
+	CUnit &unit = *owner;
+	unit.Type = &type;
+	unit.Stats = &stat;
+	unit.Player = &player;
+	unit.Variable = stat.Variables;
+	unit.Removed = false;
+	unit.Orders.push_back(COrder::NewActionStill());
+	unit.tilePos = Vec2i(10, 10);
+	unit.CurrentSightRange = 2;
+	player.AddUnitOfType(unit);
+	player.Supply += 4;
+	MapMarkUnitSight(unit);
+
+	std::vector<unsigned short> visible;
+	for (const CMapField &mf : Map.Fields) {
+		visible.push_back(mf.playerInfo.Visible[player.Index]);
+	}
+
+	CUpgrade upgrade("upgrade-test");
+	auto um = std::make_unique<CUpgradeModifier>();
+	um->UpgradeId = upgrade.ID;
+	um->Modifier.Variables.resize(UnitTypeVar.GetNumberVariable());
+	um->ModifyPercent.resize(UnitTypeVar.GetNumberVariable());
+	um->Modifier.Variables[SIGHTRANGE_INDEX].Value = 3;
+	um->Modifier.Variables[SIGHTRANGE_INDEX].Max = 3;
+	um->Modifier.Variables[SUPPLY_INDEX].Value = 2;
+	um->Modifier.Variables[SUPPLY_INDEX].Max = 2;
+	um->ApplyTo[type.Slot] = 'X';
+	um->ApplyToTypes.push_back(type.Slot);
+	UpgradeModifiers[NumUpgradeModifiers++] = std::move(um);
+
+	const char oldAllow = player.Allow.Upgrades[upgrade.ID];
+	const unsigned int far = Map.getIndex(15, 10);
+	CHECK(Map.Field(far)->playerInfo.Visible[player.Index] == 0);
+
+	UpgradeAcquire(player, &upgrade);
+	CHECK(unit.CurrentSightRange == 5);
+	CHECK(Map.Field(far)->playerInfo.Visible[player.Index] == 2);
+	CHECK(Map.Field(unit.tilePos)->playerInfo.Visible[player.Index] == 2);
+	CHECK(player.Supply == oldSupply + 6);
+	std::vector<unsigned short> upgraded;
+	for (const CMapField &mf : Map.Fields) {
+		upgraded.push_back(mf.playerInfo.Visible[player.Index]);
+	}
+
+	UpgradeLost(player, upgrade.ID);
+	CHECK(unit.CurrentSightRange == 2);
+	CHECK(player.Supply == oldSupply + 4);
+	// The counters are back, the tiles seen only with the upgrade stay explored
+	CHECK(Map.Field(far)->playerInfo.Visible[player.Index] == 1);
+	for (size_t i = 0; i != Map.Fields.size(); ++i) {
+		const unsigned short expected = visible[i] ? visible[i] : (upgraded[i] ? 1 : 0);
+		CHECK(Map.Fields[i].playerInfo.Visible[player.Index] == expected);
+	}
+
+	player.RemoveUnitOfType(unit);
+	player.Supply = oldSupply;
+	player.UpgradeTimers.Upgrades[upgrade.ID] = 0;
+	player.Allow.Upgrades[upgrade.ID] = oldAllow;
+	unit.Orders.clear();
+	ThisPlayer = oldThisPlayer;
+	CleanUpgrades();
+	CleanUnitTypes();
+	Map.Fields.clear();
+}